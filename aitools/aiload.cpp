@@ -0,0 +1,46 @@
+#include <QCommandLineParser>
+#include <QGuiApplication>
+#include <QLoggingCategory>
+#include "loadgenerator.h"
+
+int main(int argc, char *argv[])
+{
+    // libai responses decode images, so they need a gui application
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("aiload");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load generator for the Responses API, see aimock.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"url", "Endpoint to post to.", "url", "http://localhost:8080/v1/responses"},
+        {"rate", "Requests per second.", "rate", "10"},
+        {"count", "Number of requests.", "count", "100"},
+        {"model", "Model of the requests.", "model", "gpt-4.1-mini"},
+        {"input", "Input text of the requests.", "text"},
+        {"stream", "Request streamed replies, which measures the time to first token."},
+        {"verbose", "Keep the debug output of libai."},
+    });
+    parser.process(app);
+
+    if (!parser.isSet("verbose"))
+        QLoggingCategory::setFilterRules("default.debug=false");
+
+    LoadGenerator::Options options;
+    options.url = QUrl{parser.value("url")};
+    options.model = parser.value("model");
+    if (parser.isSet("input"))
+        options.input = parser.value("input");
+    options.rate = parser.value("rate").toDouble();
+    options.count = parser.value("count").toInt();
+    options.stream = parser.isSet("stream");
+
+    LoadGenerator generator{options};
+    QObject::connect(&generator, &LoadGenerator::finished, &app, [&generator] {
+        qInfo().noquote() << generator.summary();
+        QCoreApplication::quit();
+    });
+    generator.start();
+
+    return app.exec();
+}
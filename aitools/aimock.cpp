@@ -0,0 +1,46 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include "mockserver.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("aimock");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Deterministic mock of the Responses and Images API.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"port", "Port to listen on.", "port", "8080"},
+        {"recordings", "Directory with responses*.json, responses*.sse and images*.json.", "dir"},
+        {"latency", "Milliseconds before each reply.", "ms", "0"},
+        {"jitter", "Random milliseconds added to the latency.", "ms", "0"},
+        {"chunk-size", "Write JSON bodies in chunks of this many bytes.", "bytes", "0"},
+        {"chunk-delay", "Milliseconds between chunks and stream events.", "ms", "0"},
+        {"error-rate", "Fraction of requests answered with a 500.", "rate", "0"},
+        {"rate-limit", "Requests per minute before answering 429.", "count", "0"},
+        {"seed", "Seed for jitter and injected errors.", "seed", "1"},
+    });
+    parser.process(app);
+
+    MockServer::Options options;
+    options.recordings = parser.value("recordings");
+    options.latency = parser.value("latency").toInt();
+    options.jitter = parser.value("jitter").toInt();
+    options.chunkSize = parser.value("chunk-size").toInt();
+    options.chunkDelay = parser.value("chunk-delay").toInt();
+    options.errorRate = parser.value("error-rate").toDouble();
+    options.rateLimit = parser.value("rate-limit").toInt();
+    options.seed = parser.value("seed").toUInt();
+
+    MockServer server{options};
+    if (!server.listen(QHostAddress::LocalHost, parser.value("port").toUShort())) {
+        qCritical().noquote() << "aimock:" << server.errorString();
+        return 1;
+    }
+
+    qInfo().noquote() << "aimock: listening on" << QStringLiteral("http://localhost:%1/v1/")
+                                                       .arg(server.serverPort());
+
+    return app.exec();
+}
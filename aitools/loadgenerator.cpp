@@ -0,0 +1,153 @@
+#include "loadgenerator.h"
+
+#include <QFile>
+#include <QNetworkReply>
+
+#include <algorithm>
+#include <cmath>
+
+LoadGenerator::LoadGenerator(const Options &options, QObject *parent)
+    : QObject{parent}
+    , mOptions{options}
+{
+    mClient.resetNetworkAccessManager();
+    mClient.setApiUrl(mOptions.url);
+    mClient.setApiKey("mock");
+
+    mTimer.setTimerType(Qt::PreciseTimer);
+    mTimer.setInterval(std::max(1, int(std::lround(1000.0 / std::max(0.001, mOptions.rate)))));
+    connect(&mTimer, &QTimer::timeout, this, &LoadGenerator::sendNext);
+}
+
+void LoadGenerator::start()
+{
+    mReport = {};
+    mReport.latencies.reserve(mOptions.count);
+    mClock.start();
+    mTimer.start();
+    sendNext();
+}
+
+void LoadGenerator::sendNext()
+{
+    if (mReport.sent >= mOptions.count) {
+        mTimer.stop();
+        return;
+    }
+
+    ai::ResponsesRequest request;
+    request.setModel(mOptions.model);
+    request.setInput(mOptions.input);
+    request.setStored(false);
+    if (mOptions.stream)
+        request.setStreaming(true);
+
+    const qint64 started = mClock.elapsed();
+    auto *response = mClient.post(request);
+    ++mReport.sent;
+    if (!response) {
+        ++mReport.failed;
+        finishIfDone();
+        return;
+    }
+    ++mPending;
+
+    connect(response, &ai::Response::readyRead, this, [this, response, started] {
+        if (!mFirstTokens.contains(response))
+            mFirstTokens.insert(response, mClock.elapsed() - started);
+    });
+    connect(response, &ai::Response::finished, this, [this, response, started] {
+        handleFinished(response, started);
+    });
+}
+
+void LoadGenerator::handleFinished(ai::ResponsesResponse *response, qint64 started)
+{
+    const int status = response->reply()
+                           ? response->reply()->attribute(QNetworkRequest::HttpStatusCodeAttribute)
+                                 .toInt()
+                           : 0;
+
+    if (status == 429)
+        ++mReport.rateLimited;
+    if (status == 200 && !response->error().isError())
+        ++mReport.succeeded;
+    else
+        ++mReport.failed;
+
+    mReport.latencies.append(mClock.elapsed() - started);
+    if (const auto firstToken = mFirstTokens.take(response); status == 200 && firstToken > 0)
+        mReport.firstTokens.append(firstToken);
+
+    response->deleteLater();
+
+    --mPending;
+    finishIfDone();
+}
+
+void LoadGenerator::finishIfDone()
+{
+    if (mPending > 0 || mReport.sent < mOptions.count)
+        return;
+
+    mReport.elapsed = mClock.elapsed();
+    readMemory(&mReport.rss, &mReport.peakRss);
+    emit finished();
+}
+
+void LoadGenerator::readMemory(qint64 *rss, qint64 *peakRss)
+{
+    *rss = 0;
+    *peakRss = 0;
+
+    QFile file{"/proc/self/status"};
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    while (!file.atEnd()) {
+        const auto line = file.readLine();
+        if (line.startsWith("VmRSS:"))
+            *rss = line.mid(6).trimmed().split(' ').value(0).toLongLong();
+        else if (line.startsWith("VmHWM:"))
+            *peakRss = line.mid(6).trimmed().split(' ').value(0).toLongLong();
+    }
+}
+
+qint64 LoadGenerator::percentile(QList<qint64> values, double p)
+{
+    if (values.isEmpty())
+        return 0;
+
+    const auto n = std::min(values.size() - 1, qsizetype(std::ceil(p * values.size())) - 1);
+    const auto nth = values.begin() + std::max(qsizetype(0), n);
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+QString LoadGenerator::summary() const
+{
+    const auto &r = mReport;
+    const double seconds = r.elapsed / 1000.0;
+
+    QString s;
+    s += QStringLiteral("requests   %1 sent, %2 ok, %3 failed (%4 rate limited)\n")
+             .arg(r.sent)
+             .arg(r.succeeded)
+             .arg(r.failed)
+             .arg(r.rateLimited);
+    s += QStringLiteral("throughput %1 req/s over %2 s\n")
+             .arg(seconds > 0 ? r.sent / seconds : 0.0, 0, 'f', 1)
+             .arg(seconds, 0, 'f', 2);
+    s += QStringLiteral("latency    p50 %1 ms, p90 %2 ms, p99 %3 ms, max %4 ms\n")
+             .arg(percentile(r.latencies, 0.50))
+             .arg(percentile(r.latencies, 0.90))
+             .arg(percentile(r.latencies, 0.99))
+             .arg(percentile(r.latencies, 1.0));
+    if (!r.firstTokens.isEmpty())
+        s += QStringLiteral("ttft       p50 %1 ms, p90 %2 ms, p99 %3 ms\n")
+                 .arg(percentile(r.firstTokens, 0.50))
+                 .arg(percentile(r.firstTokens, 0.90))
+                 .arg(percentile(r.firstTokens, 0.99));
+    s += QStringLiteral("memory     rss %1 kB, peak %2 kB").arg(r.rss).arg(r.peakRss);
+    return s;
+}
@@ -0,0 +1,69 @@
+#ifndef AITOOLS_LOADGENERATOR_H
+#define AITOOLS_LOADGENERATOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include "libai/responsesclient.h"
+
+// Drives a ResponsesClient at a fixed request rate and collects the latency of each request,
+// the time to its first token and the memory use of the process.
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        QUrl url;
+        QString model = "gpt-4.1-mini";
+        QString input = "Write one sentence about a lighthouse.";
+        double rate = 10;  // requests per second
+        int count = 100;   // requests in total
+        bool stream = false;
+    };
+
+    struct Report
+    {
+        int sent = 0;
+        int succeeded = 0;
+        int failed = 0;
+        int rateLimited = 0;
+        qint64 elapsed = 0; // ms
+        QList<qint64> latencies;
+        QList<qint64> firstTokens;
+        qint64 rss = 0;     // kB
+        qint64 peakRss = 0; // kB
+    };
+
+    explicit LoadGenerator(const Options& options, QObject* parent = nullptr);
+
+    void start();
+
+    [[nodiscard]] const Report& report() const { return mReport; }
+    [[nodiscard]] QString summary() const;
+
+signals:
+    void finished();
+
+protected:
+    void sendNext();
+    void handleFinished(ai::ResponsesResponse* response, qint64 started);
+    void finishIfDone();
+
+    // Reads VmRSS and VmHWM from /proc/self/status, 0 where unavailable.
+    static void readMemory(qint64* rss, qint64* peakRss);
+    [[nodiscard]] static qint64 percentile(QList<qint64> values, double p);
+
+private:
+    Options mOptions;
+    Report mReport;
+    ai::ResponsesClient mClient;
+    QTimer mTimer;
+    QElapsedTimer mClock;
+    QHash<ai::ResponsesResponse*, qint64> mFirstTokens;
+    int mPending = 0;
+};
+
+#endif // AITOOLS_LOADGENERATOR_H
@@ -0,0 +1,370 @@
+#include "mockserver.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+
+// 1x1 transparent PNG, the synthesized image of every images/generations reply
+constexpr auto MockImage = "iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR42mNkYPhf"
+                           "DwAChwGA60e6kgAAAABJRU5ErkJggg==";
+
+constexpr qint64 RateLimitWindow = 60000;
+
+QString lastInputText(const QJsonObject &request)
+{
+    const auto input = request.value(QLatin1StringView{"input"});
+    if (input.isString())
+        return input.toString();
+
+    const auto items = input.toArray();
+    for (qsizetype i = items.size() - 1; i >= 0; --i) {
+        const auto content = items.at(i).toObject().value(QLatin1StringView{"content"});
+        if (content.isString())
+            return content.toString();
+        for (const auto c : content.toArray())
+            if (const auto text = c.toObject().value(QLatin1StringView{"text"}); text.isString())
+                return text.toString();
+    }
+    return {};
+}
+
+QByteArray sseEvent(const QByteArray &type, QJsonObject data)
+{
+    data.insert(QLatin1StringView{"type"}, QLatin1StringView{type});
+    return "event: " + type + "\ndata: " + QJsonDocument{data}.toJson(QJsonDocument::Compact)
+           + "\n\n";
+}
+
+} // namespace
+
+MockServer::MockServer(const Options &options, QObject *parent)
+    : QObject{parent}
+    , mOptions{options}
+    , mRandom{options.seed}
+{
+    connect(&mServer, &QTcpServer::newConnection, this, &MockServer::handleNewConnection);
+    mClock.start();
+}
+
+bool MockServer::listen(const QHostAddress &address, quint16 port)
+{
+    return mServer.listen(address, port);
+}
+
+void MockServer::handleNewConnection()
+{
+    while (auto *socket = mServer.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            handleReadyRead(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            mBuffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockServer::handleReadyRead(QTcpSocket *socket)
+{
+    auto &buffer = mBuffers[socket];
+    buffer.append(socket->readAll());
+
+    // keep-alive connections may carry several requests, answer every complete one
+    for (;;) {
+        const auto headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0)
+            return;
+
+        HttpRequest request;
+        const auto lines = buffer.first(headerEnd).split('\n');
+        const auto requestLine = lines.value(0).trimmed().split(' ');
+        request.method = requestLine.value(0);
+        request.path = requestLine.value(1);
+        for (qsizetype i = 1; i < lines.size(); ++i) {
+            const auto colon = lines.at(i).indexOf(':');
+            if (colon > 0)
+                request.headers.insert(lines.at(i).first(colon).trimmed().toLower(),
+                                       lines.at(i).sliced(colon + 1).trimmed());
+        }
+
+        const qsizetype length = request.headers.value("content-length").toLongLong();
+        if (buffer.size() < headerEnd + 4 + length)
+            return;
+
+        request.body = buffer.sliced(headerEnd + 4, length);
+        buffer.remove(0, headerEnd + 4 + length);
+
+        send(socket, reply(request));
+    }
+}
+
+MockServer::HttpReply MockServer::reply(const HttpRequest &request)
+{
+    ++mRequestCount;
+
+    const qint64 now = mClock.elapsed();
+    while (!mRecentRequests.isEmpty() && now - mRecentRequests.head() >= RateLimitWindow)
+        mRecentRequests.dequeue();
+
+    if (mOptions.rateLimit > 0 && mRecentRequests.size() >= mOptions.rateLimit) {
+        const auto reset = (RateLimitWindow - (now - mRecentRequests.head())) / 1000 + 1;
+        auto r = errorReply(429, "rate_limit_exceeded", QStringLiteral("Rate limit reached"));
+        r.headers.append({"retry-after", QByteArray::number(reset)});
+        r.headers.append({"x-ratelimit-limit-requests", QByteArray::number(mOptions.rateLimit)});
+        r.headers.append({"x-ratelimit-remaining-requests", "0"});
+        r.headers.append({"x-ratelimit-reset-requests", QByteArray::number(reset) + "s"});
+        return r;
+    }
+    mRecentRequests.enqueue(now);
+
+    // drawn for every request, so the error pattern doesn't depend on the rate limit
+    if (mRandom.generateDouble() < mOptions.errorRate)
+        return errorReply(500, "server_error", QStringLiteral("Injected mock server error"));
+
+    if (request.method != "POST")
+        return errorReply(405, "invalid_request_error", QStringLiteral("Only POST is supported"));
+
+    QJsonParseError error;
+    const auto json = QJsonDocument::fromJson(request.body, &error).object();
+    if (error.error != QJsonParseError::NoError)
+        return errorReply(400, "invalid_request_error", error.errorString());
+
+    HttpReply r;
+    if (request.path.endsWith("/v1/responses"))
+        r = responsesReply(json);
+    else if (request.path.endsWith("/v1/images/generations"))
+        r = imagesReply(json);
+    else
+        return errorReply(404, "invalid_request_error", QStringLiteral("Unknown endpoint"));
+
+    if (mOptions.rateLimit > 0) {
+        r.headers.append({"x-ratelimit-limit-requests", QByteArray::number(mOptions.rateLimit)});
+        r.headers.append({"x-ratelimit-remaining-requests",
+                          QByteArray::number(mOptions.rateLimit - mRecentRequests.size())});
+    }
+
+    return r;
+}
+
+MockServer::HttpReply MockServer::responsesReply(const QJsonObject &request)
+{
+    const bool stream = request.value(QLatin1StringView{"stream"}).toBool();
+
+    HttpReply r;
+    r.stream = stream;
+
+    if (stream) {
+        r.contentType = "text/event-stream";
+        if (const auto data = recording(QStringLiteral("responses*.sse")); !data.isEmpty()) {
+            // one part per event, so chunkDelay paces the stream like the real thing
+            for (qsizetype from = 0; from < data.size();) {
+                const auto end = data.indexOf("\n\n", from);
+                const auto to = end < 0 ? data.size() : end + 2;
+                r.parts.append(data.sliced(from, to - from));
+                from = to;
+            }
+            return r;
+        }
+    } else if (const auto data = recording(QStringLiteral("responses*.json")); !data.isEmpty()) {
+        r.parts = chunked(data);
+        return r;
+    }
+
+    const auto n = QString::number(mRequestCount);
+    const auto input = lastInputText(request);
+    const auto text = QStringLiteral("Mock reply %1 to: %2").arg(n, input.left(200));
+    const int inputTokens = int(QJsonDocument{request}.toJson(QJsonDocument::Compact).size() / 4);
+    const int outputTokens = int(text.size() / 4) + 1;
+
+    QJsonObject content{{"type", "output_text"}, {"text", text}, {"annotations", QJsonArray{}}};
+    QJsonObject message{{"type", "message"},
+                        {"id", QStringLiteral("msg_mock_%1").arg(n)},
+                        {"status", "completed"},
+                        {"role", "assistant"},
+                        {"content", QJsonArray{content}}};
+    const auto model = request.value(QLatin1StringView{"model"})
+                           .toString(QStringLiteral("gpt-4.1-mini"));
+    QJsonObject response{
+        {"id", QStringLiteral("resp_mock_%1").arg(n)},
+        {"object", "response"},
+        {"created_at", 1700000000 + mRequestCount},
+        {"status", "completed"},
+        {"model", model},
+        {"output", QJsonArray{message}},
+        {"usage",
+         QJsonObject{{"input_tokens", inputTokens},
+                     {"output_tokens", outputTokens},
+                     {"total_tokens", inputTokens + outputTokens}}}};
+
+    if (!stream) {
+        r.parts = chunked(QJsonDocument{response}.toJson(QJsonDocument::Compact));
+        return r;
+    }
+
+    QJsonObject created = response;
+    created.insert(QLatin1StringView{"status"}, QLatin1StringView{"in_progress"});
+    created.insert(QLatin1StringView{"output"}, QJsonArray{});
+    created.remove(QLatin1StringView{"usage"});
+    r.parts.append(sseEvent("response.created", {{"response", created}}));
+
+    // one delta per word
+    const auto itemId = message.value(QLatin1StringView{"id"});
+    for (const auto &word : text.split(' ')) {
+        const auto delta = r.parts.size() > 1 ? QStringLiteral(" ") + word : word;
+        r.parts.append(sseEvent("response.output_text.delta",
+                                {{"item_id", itemId},
+                                 {"output_index", 0},
+                                 {"content_index", 0},
+                                 {"delta", delta}}));
+    }
+    r.parts.append(sseEvent("response.output_text.done",
+                            {{"item_id", itemId},
+                             {"output_index", 0},
+                             {"content_index", 0},
+                             {"text", text}}));
+    r.parts.append(sseEvent("response.completed", {{"response", response}}));
+
+    return r;
+}
+
+MockServer::HttpReply MockServer::imagesReply(const QJsonObject &request)
+{
+    HttpReply r;
+
+    if (const auto data = recording(QStringLiteral("images*.json")); !data.isEmpty()) {
+        r.parts = chunked(data);
+        return r;
+    }
+
+    const int n = qBound(1, request.value(QLatin1StringView{"n"}).toInt(1), 10);
+    QJsonArray images;
+    for (int i = 0; i < n; ++i)
+        images.append(QJsonObject{{"b64_json", MockImage},
+                                  {"revised_prompt",
+                                   request.value(QLatin1StringView{"prompt"}).toString()}});
+
+    const QJsonObject response{{"created", 1700000000 + mRequestCount}, {"data", images}};
+    r.parts = chunked(QJsonDocument{response}.toJson(QJsonDocument::Compact));
+    return r;
+}
+
+MockServer::HttpReply MockServer::errorReply(int status,
+                                             const QByteArray &type,
+                                             const QString &message)
+{
+    const QJsonObject error{{"message", message},
+                            {"type", QString::fromLatin1(type)},
+                            {"param", QJsonValue::Null},
+                            {"code", QString::fromLatin1(type)}};
+
+    HttpReply r;
+    r.status = status;
+    r.parts.append(QJsonDocument{QJsonObject{{"error", error}}}.toJson(QJsonDocument::Compact));
+    return r;
+}
+
+QList<QByteArray> MockServer::chunked(const QByteArray &body) const
+{
+    if (mOptions.chunkSize <= 0)
+        return {body};
+
+    QList<QByteArray> parts;
+    for (qsizetype i = 0; i < body.size(); i += mOptions.chunkSize)
+        parts.append(body.sliced(i, qMin<qsizetype>(mOptions.chunkSize, body.size() - i)));
+    return parts;
+}
+
+QByteArray MockServer::recording(const QString &pattern)
+{
+    if (mOptions.recordings.isEmpty())
+        return {};
+
+    const QDir dir{mOptions.recordings};
+    auto it = mRecordings.find(pattern);
+    if (it == mRecordings.end())
+        it = mRecordings.insert(pattern, dir.entryList({pattern}, QDir::Files, QDir::Name));
+
+    if (it->isEmpty())
+        return {};
+
+    // round robin, in file name order
+    const auto fileName = it->at(mReplayed[pattern]++ % it->size());
+    QFile file{dir.filePath(fileName)};
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "MockServer: cannot read" << file.fileName();
+        return {};
+    }
+    return file.readAll();
+}
+
+void MockServer::send(QTcpSocket *socket, const HttpReply &reply)
+{
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(reply.status) + ' '
+                      + statusText(reply.status) + "\r\nContent-Type: " + reply.contentType
+                      + "\r\n";
+    for (const auto &[name, value] : reply.headers)
+        head += name + ": " + value + "\r\n";
+
+    if (reply.stream) {
+        // no Content-Length, the end of the stream is the end of the connection
+        head += "Cache-Control: no-cache\r\nConnection: close\r\n\r\n";
+    } else {
+        qsizetype length = 0;
+        for (const auto &part : reply.parts)
+            length += part.size();
+        head += "Content-Length: " + QByteArray::number(length) + "\r\n\r\n";
+    }
+
+    QList<QByteArray> parts = reply.parts;
+    if (parts.isEmpty())
+        parts.append(head);
+    else
+        parts.first().prepend(head);
+
+    const int delay = mOptions.latency
+                      + (mOptions.jitter > 0 ? int(mRandom.bounded(mOptions.jitter + 1)) : 0);
+    QTimer::singleShot(delay, socket, [this, socket, parts, close = reply.stream]() {
+        writeParts(socket, parts, close);
+    });
+}
+
+void MockServer::writeParts(QTcpSocket *socket, QList<QByteArray> parts, bool close)
+{
+    if (parts.isEmpty()) {
+        if (close)
+            socket->disconnectFromHost();
+        return;
+    }
+
+    socket->write(parts.takeFirst());
+
+    if (parts.isEmpty() && !close)
+        return;
+
+    QTimer::singleShot(mOptions.chunkDelay, socket, [this, socket, parts, close]() {
+        writeParts(socket, parts, close);
+    });
+}
+
+QByteArray MockServer::statusText(int status)
+{
+    switch (status) {
+    case 200:
+        return "OK";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 429:
+        return "Too Many Requests";
+    default:
+        return "Internal Server Error";
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef AITOOLS_MOCKSERVER_H
+#define AITOOLS_MOCKSERVER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QQueue>
+#include <QRandomGenerator>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+// A deterministic stand-in for the /v1/responses and /v1/images/generations endpoints, for
+// exercising libai offline and under load.
+//
+// Replies are replayed round robin from the recordings directory (responses*.json,
+// responses*.sse for "stream": true, images*.json) or synthesized when there are none. Latency,
+// chunking, injected errors and rate limiting all derive from seed, so two runs with the same
+// options answer the same requests the same way.
+class MockServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        QString recordings;   // directory, none when empty
+        int latency = 0;      // ms before the status line
+        int jitter = 0;       // ms, uniformly added to latency
+        int chunkSize = 0;    // bytes per write of a JSON body, 0 writes it at once
+        int chunkDelay = 0;   // ms between body chunks and between SSE events
+        double errorRate = 0; // fraction of requests answered with a 500
+        int rateLimit = 0;    // requests per minute before answering 429, 0 is unlimited
+        quint32 seed = 1;
+    };
+
+    explicit MockServer(const Options& options, QObject* parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    [[nodiscard]] quint16 serverPort() const { return mServer.serverPort(); }
+    [[nodiscard]] QString errorString() const { return mServer.errorString(); }
+
+    [[nodiscard]] int requestCount() const { return mRequestCount; }
+
+protected:
+    struct HttpRequest
+    {
+        QByteArray method;
+        QByteArray path;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+    };
+
+    struct HttpReply
+    {
+        int status = 200;
+        QByteArray contentType = "application/json";
+        QList<std::pair<QByteArray, QByteArray>> headers;
+        QList<QByteArray> parts;
+        bool stream = false;
+    };
+
+    void handleNewConnection();
+    void handleReadyRead(QTcpSocket* socket);
+
+    [[nodiscard]] HttpReply reply(const HttpRequest& request);
+    [[nodiscard]] HttpReply responsesReply(const QJsonObject& request);
+    [[nodiscard]] HttpReply imagesReply(const QJsonObject& request);
+    [[nodiscard]] static HttpReply errorReply(int status,
+                                              const QByteArray& type,
+                                              const QString& message);
+
+    // Splits body into chunkSize parts.
+    [[nodiscard]] QList<QByteArray> chunked(const QByteArray& body) const;
+    [[nodiscard]] QByteArray recording(const QString& pattern);
+
+    void send(QTcpSocket* socket, const HttpReply& reply);
+    void writeParts(QTcpSocket* socket, QList<QByteArray> parts, bool close);
+
+    [[nodiscard]] static QByteArray statusText(int status);
+
+private:
+    QTcpServer mServer;
+    Options mOptions;
+    QRandomGenerator mRandom;
+    QHash<QTcpSocket*, QByteArray> mBuffers;
+    QHash<QString, QStringList> mRecordings;
+    QHash<QString, int> mReplayed;
+    QElapsedTimer mClock;
+    QQueue<qint64> mRecentRequests;
+    int mRequestCount = 0;
+};
+
+#endif // AITOOLS_MOCKSERVER_H
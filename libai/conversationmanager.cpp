@@ -0,0 +1,282 @@
+#include "conversationmanager.h"
+#include "responsesresponse.h"
+
+#include <QtMath>
+
+namespace ai {
+
+namespace {
+
+// the same concatenation ResponsesResponse uses for textGenerated
+QString messageText(const OutputMessage &message)
+{
+    QString text;
+    for (const auto &content : message.content()) {
+        if (!text.isEmpty())
+            text += '\n';
+        if (content.isText())
+            text += content.text().text();
+        else if (content.isRefusal())
+            text += content.refusal().refusal();
+    }
+    return text;
+}
+
+} // namespace
+
+ConversationManager::ConversationManager(QObject *parent)
+    : QObject{parent}
+{}
+
+void ConversationManager::addUserMessage(const QString &text)
+{
+    if (text.isEmpty())
+        return;
+
+    Entry entry;
+    entry.role = Message::Role_User;
+    entry.text = text;
+    append(entry);
+}
+
+void ConversationManager::addResponse(ResponsesResponse *response)
+{
+    if (!response)
+        return;
+
+    connect(response, &ResponsesResponse::finished, this, [this, response]() {
+        handleResponseFinished(response);
+    });
+}
+
+ResponsesRequest ConversationManager::prepare(const ResponsesRequest &request)
+{
+    ResponsesRequest r = request;
+
+    // the history replaces both the input and the server side chain
+    r.resetPreviousResponseId();
+
+    // newest first, the latest entry is always sent even if it is over budget on its own
+    int tokens = estimateTokens(r.instructions());
+    qsizetype first = mEntries.size();
+    while (first > 0) {
+        const int t = mEntries.at(first - 1).tokens;
+        if (first < mEntries.size() && tokens + t > mTokenBudget)
+            break;
+        tokens += t;
+        --first;
+    }
+
+    QList<InputItem> items;
+    items.reserve(mEntries.size() - first);
+    mSentChars = r.instructions().size();
+    for (qsizetype i = first; i < mEntries.size(); ++i) {
+        items.append(toInputItem(mEntries.at(i)));
+        mSentChars += mEntries.at(i).text.size();
+    }
+    r.setInput(Input{items});
+
+    return r;
+}
+
+void ConversationManager::clear()
+{
+    if (mSummary) {
+        mSummary->disconnect(this);
+        mSummary = nullptr;
+        emit summarizingChanged(QPrivateSignal{});
+    }
+
+    mEntries.clear();
+    mSentChars = 0;
+    updateContextTokens();
+}
+
+int ConversationManager::estimateTokens(const QString &text) const
+{
+    if (text.isEmpty())
+        return 0;
+
+    // a few tokens of framing per message on top of the text itself
+    return qCeil(text.size() / mCharsPerToken) + 4;
+}
+
+InputItem ConversationManager::toInputItem(const Entry &entry) const
+{
+    // stored output is referenced rather than resent, assistant text can't go in an input_text
+    if (!entry.itemId.isEmpty())
+        return ItemReference{entry.itemId};
+
+    return InputMessage{entry.text, {}, entry.role};
+}
+
+void ConversationManager::append(Entry entry)
+{
+    entry.serial = mNextSerial++;
+    if (!entry.measured)
+        entry.tokens = estimateTokens(entry.text);
+    mEntries.append(entry);
+
+    updateContextTokens();
+    compact();
+}
+
+void ConversationManager::handleResponseFinished(ResponsesResponse *response)
+{
+    QList<qsizetype> added;
+    int estimated = 0;
+
+    for (const auto &output : response->output()) {
+        if (!output.isMessage())
+            continue;
+
+        const auto message = output.message();
+
+        Entry entry;
+        entry.serial = mNextSerial++;
+        entry.role = Message::Role_Assistant;
+        entry.text = messageText(message);
+        if (response->isStored())
+            entry.itemId = message.id();
+        entry.tokens = estimateTokens(entry.text);
+
+        estimated += entry.tokens;
+        added.append(mEntries.size());
+        mEntries.append(entry);
+    }
+
+    const auto usage = response->extra().value(QLatin1StringView{"usage"}).toObject();
+
+    // input_tokens is the exact size of what prepare() sent, use it to calibrate the estimate
+    if (const int input = usage.value(QLatin1StringView{"input_tokens"}).toInt();
+        input > 0 && mSentChars > 0)
+        mCharsPerToken = qBound(1.0, (mCharsPerToken + double(mSentChars) / input) / 2, 8.0);
+
+    // reasoning tokens are billed as output but never become part of the context
+    const int reasoning = usage.value(QLatin1StringView{"output_tokens_details"})
+                              .toObject()
+                              .value(QLatin1StringView{"reasoning_tokens"})
+                              .toInt();
+    if (const int output = usage.value(QLatin1StringView{"output_tokens"}).toInt() - reasoning;
+        output > 0 && estimated > 0) {
+        for (const auto i : std::as_const(added)) {
+            auto &entry = mEntries[i];
+            entry.tokens = qMax(1, int(qint64(entry.tokens) * output / estimated));
+            entry.measured = true;
+        }
+    }
+
+    updateContextTokens();
+    compact();
+}
+
+void ConversationManager::updateContextTokens()
+{
+    int tokens = 0;
+    for (auto &entry : mEntries) {
+        if (!entry.measured)
+            entry.tokens = estimateTokens(entry.text);
+        tokens += entry.tokens;
+    }
+
+    mContextTokens = tokens;
+    emit contextChanged(QPrivateSignal{});
+}
+
+void ConversationManager::compact()
+{
+    if (mSummary || mContextTokens <= mTokenBudget)
+        return;
+
+    // the oldest entries that have to go for the rest to fit, the keepRecent newest always stay
+    const qsizetype available = mEntries.size() - mKeepRecent;
+    qsizetype count = 0;
+    for (int tokens = mContextTokens; count < available && tokens > mTokenBudget; ++count)
+        tokens -= mEntries.at(count).tokens;
+
+    if (count == 0)
+        return;
+
+    if (mCompaction == Compaction_Summarize && mClient)
+        summarize(count);
+    else
+        drop(count);
+}
+
+void ConversationManager::drop(qsizetype count)
+{
+    mEntries.remove(0, qMin(count, mEntries.size()));
+    updateContextTokens();
+}
+
+void ConversationManager::summarize(qsizetype count)
+{
+    QString transcript;
+    for (qsizetype i = 0; i < count; ++i) {
+        const auto &entry = mEntries.at(i);
+        transcript += Message::roleToString(entry.role) + QStringLiteral(": ") + entry.text
+                      + QStringLiteral("\n\n");
+    }
+
+    ResponsesRequest request;
+    request.setInstructions(
+        QStringLiteral("Summarize the conversation below for your own later reference. Keep "
+                       "names, facts, decisions and open questions, leave out pleasantries."));
+    request.setInput(transcript);
+    request.setStored(false);
+
+    mSummary = mClient->post(request);
+    if (!mSummary) {
+        drop(count);
+        return;
+    }
+
+    const quint64 first = mEntries.at(0).serial;
+    const quint64 last = mEntries.at(count - 1).serial;
+    auto *response = mSummary.data();
+    connect(response, &ResponsesResponse::finished, this, [this, response, first, last]() {
+        handleSummaryFinished(response, first, last);
+    });
+
+    emit summarizingChanged(QPrivateSignal{});
+}
+
+void ConversationManager::handleSummaryFinished(ResponsesResponse *response,
+                                                quint64 first,
+                                                quint64 last)
+{
+    if (mSummary != response)
+        return;
+    mSummary = nullptr;
+
+    QString text;
+    for (const auto &output : response->output())
+        if (output.isMessage())
+            text += messageText(output.message());
+
+    const auto begin = std::find_if(mEntries.begin(), mEntries.end(), [first](const Entry &e) {
+        return e.serial >= first;
+    });
+    const auto end = std::find_if(begin, mEntries.end(), [last](const Entry &e) {
+        return e.serial > last;
+    });
+    const auto at = begin - mEntries.begin();
+    mEntries.erase(begin, end);
+
+    // a failed summary still frees the budget, the entries are dropped either way
+    if (!text.isEmpty()) {
+        Entry entry;
+        entry.serial = first;
+        entry.role = Message::Role_System;
+        entry.text = QStringLiteral("Summary of the earlier conversation:\n") + text;
+        entry.tokens = estimateTokens(entry.text);
+        mEntries.insert(at, entry);
+    }
+
+    emit summarizingChanged(QPrivateSignal{});
+
+    updateContextTokens();
+    compact();
+}
+
+} // namespace ai
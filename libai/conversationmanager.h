@@ -0,0 +1,143 @@
+#ifndef LIBAI_CONVERSATIONMANAGER_H
+#define LIBAI_CONVERSATIONMANAGER_H
+
+#include <QObject>
+#include <QPointer>
+#include "responsesclient.h"
+#include "responsesrequest.h"
+#include <qqmlintegration.h>
+
+namespace ai {
+
+// Keeps the input history of a conversation on the client side, instead of chaining turns with
+// previousResponseId, so its size is known and can be kept within tokenBudget.
+//
+// Token counts are estimated from the text length and calibrated with the usage reported by
+// each response. When the context outgrows the budget, the oldest turns (all but keepRecent) are
+// either dropped or, with a client set, replaced by a summary generated by the model.
+class ConversationManager : public QObject
+{
+    Q_OBJECT
+    QML_NAMED_ELEMENT(ConversationManager)
+    Q_PROPERTY(int tokenBudget READ tokenBudget WRITE setTokenBudget RESET resetTokenBudget NOTIFY
+                   tokenBudgetChanged FINAL)
+    Q_PROPERTY(int keepRecent READ keepRecent WRITE setKeepRecent RESET resetKeepRecent NOTIFY
+                   keepRecentChanged FINAL)
+    Q_PROPERTY(Compaction compaction READ compaction WRITE setCompaction RESET resetCompaction
+                   NOTIFY compactionChanged FINAL)
+    Q_PROPERTY(ai::ResponsesClient* client READ client WRITE setClient NOTIFY clientChanged FINAL)
+    Q_PROPERTY(int contextTokens READ contextTokens NOTIFY contextChanged FINAL)
+    Q_PROPERTY(int count READ count NOTIFY contextChanged FINAL)
+    Q_PROPERTY(bool summarizing READ isSummarizing NOTIFY summarizingChanged FINAL)
+
+public:
+    enum Compaction { Compaction_Drop, Compaction_Summarize };
+    Q_ENUM(Compaction)
+
+    explicit ConversationManager(QObject* parent = nullptr);
+
+    [[nodiscard]] int tokenBudget() const { return mTokenBudget; }
+    bool setTokenBudget(int tokenBudget)
+    {
+        if (mTokenBudget == tokenBudget)
+            return false;
+        mTokenBudget = tokenBudget;
+        emit tokenBudgetChanged(QPrivateSignal{});
+        compact();
+        return true;
+    }
+    bool resetTokenBudget() { return setTokenBudget(16000); }
+
+    [[nodiscard]] int keepRecent() const { return mKeepRecent; }
+    bool setKeepRecent(int keepRecent)
+    {
+        if (mKeepRecent == keepRecent)
+            return false;
+        mKeepRecent = keepRecent;
+        emit keepRecentChanged(QPrivateSignal{});
+        return true;
+    }
+    bool resetKeepRecent() { return setKeepRecent(4); }
+
+    [[nodiscard]] Compaction compaction() const { return mCompaction; }
+    bool setCompaction(Compaction compaction)
+    {
+        if (mCompaction == compaction)
+            return false;
+        mCompaction = compaction;
+        emit compactionChanged(QPrivateSignal{});
+        return true;
+    }
+    bool resetCompaction() { return setCompaction(Compaction_Summarize); }
+
+    [[nodiscard]] ResponsesClient* client() const { return mClient; }
+    bool setClient(ResponsesClient* client)
+    {
+        if (mClient == client)
+            return false;
+        mClient = client;
+        emit clientChanged(QPrivateSignal{});
+        return true;
+    }
+
+    [[nodiscard]] int contextTokens() const { return mContextTokens; }
+    [[nodiscard]] int count() const { return mEntries.size(); }
+    [[nodiscard]] bool isSummarizing() const { return !mSummary.isNull(); }
+
+    Q_INVOKABLE void addUserMessage(const QString& text);
+    // Records the output of response once it has finished.
+    Q_INVOKABLE void addResponse(ai::ResponsesResponse* response);
+
+    // Returns request with the history as input, trimmed to tokenBudget.
+    Q_INVOKABLE ai::ResponsesRequest prepare(const ai::ResponsesRequest& request);
+
+    Q_INVOKABLE void clear();
+
+signals:
+    void tokenBudgetChanged(QPrivateSignal);
+    void keepRecentChanged(QPrivateSignal);
+    void compactionChanged(QPrivateSignal);
+    void clientChanged(QPrivateSignal);
+    void contextChanged(QPrivateSignal);
+    void summarizingChanged(QPrivateSignal);
+
+protected:
+    struct Entry
+    {
+        quint64 serial = 0;
+        Message::Role role = Message::Role_User;
+        QString text;
+        QString itemId;
+        int tokens = 0;
+        bool measured = false;
+    };
+
+    [[nodiscard]] int estimateTokens(const QString& text) const;
+    [[nodiscard]] InputItem toInputItem(const Entry& entry) const;
+
+    void append(Entry entry);
+    void handleResponseFinished(ResponsesResponse* response);
+    void updateContextTokens();
+
+    // Brings the context back within tokenBudget, see Compaction.
+    void compact();
+    void drop(qsizetype count);
+    void summarize(qsizetype count);
+    void handleSummaryFinished(ResponsesResponse* response, quint64 first, quint64 last);
+
+private:
+    QList<Entry> mEntries;
+    QPointer<ResponsesClient> mClient;
+    QPointer<ResponsesResponse> mSummary;
+    quint64 mNextSerial = 1;
+    qsizetype mSentChars = 0;
+    double mCharsPerToken = 4.0;
+    int mTokenBudget = 16000;
+    int mKeepRecent = 4;
+    int mContextTokens = 0;
+    Compaction mCompaction = Compaction_Summarize;
+};
+
+} // namespace ai
+
+#endif // LIBAI_CONVERSATIONMANAGER_H
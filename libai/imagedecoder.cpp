@@ -0,0 +1,80 @@
+#include "imagedecoder.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace ai {
+
+namespace {
+
+constexpr bool isJsonSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+} // namespace
+
+bool findJsonString(QByteArrayView json, QByteArrayView key, qsizetype* begin, qsizetype* end)
+{
+    const qsizetype size = json.size();
+    qsizetype from = 0;
+
+    while ((from = json.indexOf(key, from)) >= 0) {
+        qsizetype i = from + key.size();
+        const bool quoted = from > 1 && json[from - 1] == '"' && json[from - 2] != '\\'
+                            && i < size && json[i] == '"';
+        from = i;
+
+        if (!quoted)
+            continue;
+
+        for (++i; i < size && isJsonSpace(json[i]); ++i) {
+        }
+        if (i >= size || json[i] != ':')
+            continue;
+        for (++i; i < size && isJsonSpace(json[i]); ++i) {
+        }
+        if (i >= size || json[i] != '"')
+            return false;
+
+        const qsizetype b = i + 1;
+        const qsizetype e = json.indexOf('"', b);
+        if (e < 0)
+            return false;
+
+        // base64 never needs escaping, but some encoders write '/' as "\/"
+        if (json.sliced(b, e - b).contains('\\'))
+            return false;
+
+        *begin = b;
+        *end = e;
+        return true;
+    }
+
+    return false;
+}
+
+QImage decodeBase64Image(const QByteArray& data, qsizetype begin, qsizetype end)
+{
+    if (begin < 0 || end > data.size() || begin >= end)
+        return {};
+
+    // fromRawData keeps the reply buffer as backing store, only the decoded bytes are allocated
+    const auto base64 = QByteArray::fromRawData(data.constData() + begin, end - begin);
+    const auto decoded = QByteArray::fromBase64Encoding(base64);
+    if (!decoded)
+        return {};
+
+    return QImage::fromData(*decoded);
+}
+
+QImage decodeBase64Image(const QByteArray& base64)
+{
+    return decodeBase64Image(base64, 0, base64.size());
+}
+
+QFuture<QImage> decodeBase64ImageAsync(const QByteArray& data, qsizetype begin, qsizetype end)
+{
+    return QtConcurrent::run([data, begin, end]() { return decodeBase64Image(data, begin, end); });
+}
+
+} // namespace ai
@@ -0,0 +1,27 @@
+#ifndef LIBAI_IMAGEDECODER_H
+#define LIBAI_IMAGEDECODER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFuture>
+#include <QImage>
+
+namespace ai {
+
+// Locates the raw (still escaped) value of the string member `key` in a serialized JSON
+// object, without parsing the document. Returns false when the key is absent or its value
+// contains escapes, in which case the caller should fall back to QJsonDocument.
+bool findJsonString(QByteArrayView json, QByteArrayView key, qsizetype* begin, qsizetype* end);
+
+// Decodes the base64 span [begin, end) of data into a QImage. data is shared, not copied.
+[[nodiscard]] QImage decodeBase64Image(const QByteArray& data, qsizetype begin, qsizetype end);
+[[nodiscard]] QImage decodeBase64Image(const QByteArray& base64);
+
+// Runs decodeBase64Image on the global thread pool.
+[[nodiscard]] QFuture<QImage> decodeBase64ImageAsync(const QByteArray& data,
+                                                     qsizetype begin,
+                                                     qsizetype end);
+
+} // namespace ai
+
+#endif // LIBAI_IMAGEDECODER_H
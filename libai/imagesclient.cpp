@@ -17,13 +17,36 @@ ImagesResponse *ImagesClient::post(const ImagesRequest &request)
     ImagesRequest r = request;
     if (r.apiKey().isEmpty())
         r.setApiKey(apiKey());
+    if (!apiUrl().isEmpty())
+        r.setUrl(apiUrl());
 
     const auto json = r.toJson();
     const auto data = QJsonDocument{json}.toJson();
 
     qDebug().noquote().nospace() << "POST: " << data;
 
-    return new ImagesResponse{request, network->post(r, data), this};
+    auto *response = new ImagesResponse{request, network->post(r, data), this};
+    connect(response,
+            &ImagesResponse::errorOccurred,
+            this,
+            [this, response](const ai::Error &error) {
+                emitResponseErrorOccurred(response, error);
+            });
+    connect(response, &ImagesResponse::requestSent, this, [this, response]() {
+        emitResponseRequestSent(response);
+    });
+    connect(response, &ImagesResponse::readyRead, this, [this, response]() {
+        emitResponseReadyRead(response);
+    });
+    connect(response, &ImagesResponse::finished, this, [this, response]() {
+        emitResponseFinished(response);
+    });
+    connect(response,
+            &ImagesResponse::imageGenerated,
+            this,
+            [this, response](const QImage &image) { emitResponseImageGenerated(response, image); });
+
+    return response;
 }
 
 } // namespace ai
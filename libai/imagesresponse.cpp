@@ -1,7 +1,30 @@
 #include "imagesresponse.h"
+#include "imagedecoder.h"
 
 namespace ai {
 
+bool ImagesResponse::readData(const QByteArray &data, QStringList *errors)
+{
+    qsizetype begin = 0;
+    qsizetype end = 0;
+
+    if (!findJsonString(data, "b64_json", &begin, &end))
+        return Response::readData(data, errors);
+
+    // parse everything but the image payload, which is decoded straight from the reply buffer
+    QByteArray json;
+    json.reserve(data.size() - (end - begin));
+    json.append(QByteArrayView{data}.first(begin));
+    json.append(QByteArrayView{data}.sliced(end));
+
+    if (!Response::readData(json, errors))
+        return false;
+
+    decodeImage(data, begin, end);
+
+    return true;
+}
+
 bool ImagesResponse::readJson(const QJsonObject &json, QStringList *errors)
 {
     if (!Response::readJson(json, errors))
@@ -31,7 +54,12 @@ bool ImagesResponse::readJson(const QJsonObject &json, QStringList *errors)
 
     if (extra().contains(QStringLiteral("data"))) {
         if (const auto v = extra().value(QStringLiteral("data")); v.isObject()) {
-            setData(ImageResponseData::fromJson(v.toObject()));
+            auto data = ImageResponseData::fromJson(v.toObject());
+            if (const auto b64Json = data.b64Json(); !b64Json.isEmpty()) {
+                decodeImage(b64Json.toLatin1());
+                data.setB64Json({});
+            }
+            setData(data);
             extra().remove(QStringLiteral("data"));
         } else if (errors) {
             errors->append(QStringLiteral("data is not an object"));
@@ -121,6 +149,25 @@ ImagesResponse::ImagesResponse(const ImagesRequest &request, QNetworkReply *repl
     , mRequest{request}
 {}
 
+void ImagesResponse::decodeImage(const QByteArray &data, qsizetype begin, qsizetype end)
+{
+    if (!mImageWatcher) {
+        mImageWatcher = new QFutureWatcher<QImage>{this};
+        connect(mImageWatcher, &QFutureWatcher<QImage>::finished, this, [this]() {
+            mImage = mImageWatcher->result();
+            if (mImage.isNull()) {
+                setError({Error::InternalErrorType,
+                          Error::InternalError,
+                          QStringLiteral("Failed to decode image data")});
+                return;
+            }
+            emit imageGenerated(mImage, QPrivateSignal{});
+        });
+    }
+
+    mImageWatcher->setFuture(decodeBase64ImageAsync(data, begin, end < 0 ? data.size() : end));
+}
+
 // bool ImagesResponse::readJson(const QJsonObject &json)
 // {
 //     if (!ai::ImagesResponse::readJson(json))
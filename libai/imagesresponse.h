@@ -4,6 +4,9 @@
 #include "imagesrequest.h"
 #include "response.h"
 
+#include <QFutureWatcher>
+#include <QImage>
+
 namespace ai {
 
 class ImagesClient;
@@ -308,6 +311,7 @@ class ImagesResponse : public ai::Response
     Q_OBJECT
     QML_NAMED_ELEMENT(ImagesResponse)
     QML_UNCREATABLE("ImagesResponse is created internally")
+    Q_PROPERTY(QImage image READ image NOTIFY imageGenerated FINAL)
 
 public:
     ImagesResponse(const ImagesRequest& request, QNetworkReply* reply, Client* client);
@@ -455,10 +459,18 @@ public:
     }
     bool resetUsage() { return setUsage({}); }
 
+    [[nodiscard]] QImage image() const { return mImage; }
+
+signals:
+    void imageGenerated(const QImage& image, QPrivateSignal);
+
 protected:
+    bool readData(const QByteArray& data, QStringList* errors = nullptr) override;
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override;
     bool writeJson(QJsonObject& json, bool full = false) const override;
 
+    void decodeImage(const QByteArray& data, qsizetype begin = 0, qsizetype end = -1);
+
     ImagesRequest mRequest;
     ImagesRequest::Background mBackground = ImagesRequest::Background_Auto;
     int mCreated = 0;
@@ -467,6 +479,8 @@ protected:
     ImagesRequest::Quality mQuality = ImagesRequest::Quality_Auto;
     ImagesRequest::Size mSize = ImagesRequest::Size_Auto;
     ImageResponseUsage mUsage;
+    QImage mImage;
+    QFutureWatcher<QImage>* mImageWatcher = nullptr;
 
     friend class Client;
 };
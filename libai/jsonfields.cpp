@@ -0,0 +1,112 @@
+#include "jsonfields.h"
+
+namespace ai {
+
+void JsonWriter::value(const QJsonValue& value)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        this->value(value.toBool());
+        break;
+    case QJsonValue::Double:
+        this->value(value.toDouble());
+        break;
+    case QJsonValue::String:
+        this->value(value.toString());
+        break;
+    case QJsonValue::Array:
+        this->value(value.toArray());
+        break;
+    case QJsonValue::Object:
+        this->value(value.toObject());
+        break;
+    case QJsonValue::Null:
+    case QJsonValue::Undefined:
+        null();
+        break;
+    }
+}
+
+void JsonWriter::writeEscaped(QStringView string)
+{
+    qsizetype run = 0;
+
+    const auto flush = [this, &string, &run](qsizetype end) {
+        if (end <= run)
+            return;
+        const qsizetype size = mData.size();
+        mData.resize(size + mEncoder.requiredSpace(end - run));
+        char* last = mEncoder.appendToBuffer(mData.data() + size, string.sliced(run, end - run));
+        mData.truncate(last - mData.constData());
+    };
+
+    for (qsizetype i = 0; i < string.size(); ++i) {
+        const char16_t c = string[i].unicode();
+        if (c >= 0x20 && c != u'"' && c != u'\\')
+            continue;
+        flush(i);
+        writeEscape(c);
+        run = i + 1;
+    }
+
+    flush(string.size());
+}
+
+void JsonWriter::writeEscaped(QLatin1StringView string)
+{
+    for (const char ch : string) {
+        const auto c = static_cast<uchar>(ch);
+        if (c >= 0x80) {
+            mData.append(char(0xc0 | (c >> 6)));
+            mData.append(char(0x80 | (c & 0x3f)));
+        } else if (c >= 0x20 && c != '"' && c != '\\')
+            mData.append(ch);
+        else
+            writeEscape(c);
+    }
+}
+
+void JsonWriter::writeEscaped(QUtf8StringView string)
+{
+    for (const char ch : string) {
+        const auto c = static_cast<uchar>(ch);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            mData.append(ch);
+        else
+            writeEscape(c);
+    }
+}
+
+void JsonWriter::writeEscape(char16_t c)
+{
+    switch (c) {
+    case u'"':
+        mData.append("\\\"");
+        break;
+    case u'\\':
+        mData.append("\\\\");
+        break;
+    case u'\b':
+        mData.append("\\b");
+        break;
+    case u'\f':
+        mData.append("\\f");
+        break;
+    case u'\n':
+        mData.append("\\n");
+        break;
+    case u'\r':
+        mData.append("\\r");
+        break;
+    case u'\t':
+        mData.append("\\t");
+        break;
+    default:
+        mData.append("\\u00");
+        mData.append("0123456789abcdef"[(c >> 4) & 0xf]);
+        mData.append("0123456789abcdef"[c & 0xf]);
+        break;
+    }
+}
+
+} // namespace ai
@@ -0,0 +1,515 @@
+#ifndef LIBAI_JSONFIELDS_H
+#define LIBAI_JSONFIELDS_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLocale>
+#include <QStringEncoder>
+#include <QUrl>
+#include <QVarLengthArray>
+#include <QVariantMap>
+#include <QtNumeric>
+
+#include <concepts>
+#include <tuple>
+#include <utility>
+
+namespace ai {
+
+enum JsonValueResult { JsonValue_Read, JsonValue_Unknown, JsonValue_Invalid };
+
+// Streams compact JSON straight into a UTF-8 buffer, without building a QJsonObject tree first.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(qsizetype capacity = 1024) { mData.reserve(capacity); }
+
+    [[nodiscard]] const QByteArray& data() const { return mData; }
+    [[nodiscard]] QByteArray takeData() { return std::exchange(mData, {}); }
+
+    void beginObject()
+    {
+        separate();
+        mData.append('{');
+        mFirst.append(true);
+    }
+    void endObject()
+    {
+        mFirst.removeLast();
+        mData.append('}');
+    }
+
+    void beginArray()
+    {
+        separate();
+        mData.append('[');
+        mFirst.append(true);
+    }
+    void endArray()
+    {
+        mFirst.removeLast();
+        mData.append(']');
+    }
+
+    void key(QAnyStringView key)
+    {
+        separate();
+        writeString(key);
+        mData.append(':');
+        mAfterKey = true;
+    }
+
+    void null()
+    {
+        separate();
+        mData.append("null");
+    }
+    void value(bool value)
+    {
+        separate();
+        mData.append(value ? "true" : "false");
+    }
+    void value(int value)
+    {
+        separate();
+        mData.append(QByteArray::number(value));
+    }
+    void value(qint64 value)
+    {
+        separate();
+        mData.append(QByteArray::number(value));
+    }
+    void value(double value)
+    {
+        separate();
+        if (qIsFinite(value))
+            mData.append(QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+        else
+            mData.append("null");
+    }
+    void value(QAnyStringView value)
+    {
+        separate();
+        writeString(value);
+    }
+    void value(QLatin1StringView value) { this->value(QAnyStringView{value}); }
+    void value(const QString& value) { this->value(QAnyStringView{value}); }
+    void value(const QUrl& value) { this->value(value.toString()); }
+    void value(const char* value) = delete;
+
+    void value(const QJsonValue& value);
+    void value(const QJsonObject& object)
+    {
+        beginObject();
+        members(object);
+        endObject();
+    }
+    void value(const QJsonArray& array)
+    {
+        beginArray();
+        for (const auto v : array)
+            value(v);
+        endArray();
+    }
+    void value(const QVariantMap& map) { value(QJsonObject::fromVariantMap(map)); }
+
+    template<typename T>
+        requires requires(const T& t, JsonWriter& w) { t.writeUtf8(w); }
+    void value(const T& gadget)
+    {
+        gadget.writeUtf8(*this);
+    }
+
+    template<typename T>
+    void value(const QList<T>& list)
+    {
+        beginArray();
+        for (const auto& v : list)
+            value(v);
+        endArray();
+    }
+
+    void members(const QJsonObject& object)
+    {
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            key(it.keyView());
+            value(it.value());
+        }
+    }
+
+private:
+    void separate()
+    {
+        if (mAfterKey) {
+            mAfterKey = false;
+            return;
+        }
+        if (mFirst.isEmpty())
+            return;
+        if (mFirst.last())
+            mFirst.last() = false;
+        else
+            mData.append(',');
+    }
+
+    void writeString(QAnyStringView string)
+    {
+        mData.append('"');
+        string.visit([this](auto s) { writeEscaped(s); });
+        mData.append('"');
+    }
+
+    void writeEscaped(QStringView string);
+    void writeEscaped(QLatin1StringView string);
+    void writeEscaped(QUtf8StringView string);
+    void writeEscape(char16_t c);
+
+    QByteArray mData;
+    QVarLengthArray<bool, 16> mFirst;
+    QStringEncoder mEncoder{QStringEncoder::Utf8, QStringConverter::Flag::Stateless};
+    bool mAfterKey = false;
+};
+
+// Field tables: a gadget lists its keys once, in a static constexpr jsonFields() returning a
+// std::tuple of the descriptors below, and readJsonFields()/writeJsonFields() expand the table
+// into the per-key code of readJsonValue(), writeJson() and writeUtf8Members().
+enum JsonFieldFlag { JsonField_OmitEmpty = 0x0, JsonField_Always = 0x1 };
+
+// Describes a JSON key backed by a data member.
+template<typename T, typename M>
+struct JsonField
+{
+    using Type = M;
+
+    QLatin1StringView key;
+    M T::*member;
+    int flags = JsonField_OmitEmpty;
+
+    [[nodiscard]] const M& get(const T& t) const { return t.*member; }
+    void set(T& t, M&& value) const { t.*member = std::move(value); }
+};
+
+// Describes a JSON key backed by an accessor pair, e.g. the fooAsString()/setFoo(QString)
+// pairs of the enums with a custom fallback.
+template<typename T, typename M>
+struct JsonProperty
+{
+    using Type = M;
+
+    QLatin1StringView key;
+    M (T::*getter)() const;
+    void (T::*setter)(const M&);
+    int flags = JsonField_OmitEmpty;
+
+    [[nodiscard]] M get(const T& t) const { return (t.*getter)(); }
+    void set(T& t, M&& value) const { (t.*setter)(value); }
+};
+
+// Describes a JSON key backed by a getter alone, for a gadget that only writes the key through
+// the table and reads it itself.
+template<typename T, typename M>
+struct JsonGetter
+{
+    using Type = M;
+
+    QLatin1StringView key;
+    M (T::*getter)() const;
+    int flags = JsonField_OmitEmpty;
+
+    [[nodiscard]] M get(const T& t) const { return (t.*getter)(); }
+};
+
+// Like JsonGetter, for a key that is left out at a default other than the empty value, e.g. a
+// temperature of 1.
+template<typename T, typename M, typename D>
+struct JsonDefault
+{
+    using Type = M;
+
+    QLatin1StringView key;
+    M (T::*getter)() const;
+    D fallback;
+    int flags = JsonField_OmitEmpty;
+
+    [[nodiscard]] M get(const T& t) const { return (t.*getter)(); }
+    [[nodiscard]] bool isDefault(const M& value) const { return value == fallback; }
+};
+
+// Describes a JSON key with a fixed value, e.g. the "type" discriminator of a gadget.
+struct JsonConstant
+{
+    using Type = QLatin1StringView;
+
+    QLatin1StringView key;
+    QLatin1StringView value;
+    int flags = JsonField_Always;
+
+    template<typename T>
+    [[nodiscard]] QLatin1StringView get(const T& /*t*/) const
+    {
+        return value;
+    }
+};
+
+template<typename T, typename M>
+constexpr JsonField<T, M> jsonField(const char* key, M T::*member, int flags = JsonField_OmitEmpty)
+{
+    return {QLatin1StringView{key}, member, flags};
+}
+
+template<typename T, typename M>
+constexpr JsonProperty<T, M> jsonProperty(const char* key,
+                                          M (T::*getter)() const,
+                                          void (T::*setter)(const M&),
+                                          int flags = JsonField_OmitEmpty)
+{
+    return {QLatin1StringView{key}, getter, setter, flags};
+}
+
+template<typename T, typename M>
+constexpr JsonGetter<T, M> jsonGetter(const char* key,
+                                      M (T::*getter)() const,
+                                      int flags = JsonField_OmitEmpty)
+{
+    return {QLatin1StringView{key}, getter, flags};
+}
+
+template<typename T, typename M, typename D>
+constexpr JsonDefault<T, M, D> jsonDefault(const char* key,
+                                           M (T::*getter)() const,
+                                           D fallback,
+                                           int flags = JsonField_OmitEmpty)
+{
+    return {QLatin1StringView{key}, getter, fallback, flags};
+}
+
+constexpr JsonConstant jsonConstant(const char* key, const char* value)
+{
+    return {QLatin1StringView{key}, QLatin1StringView{value}};
+}
+
+inline bool fromJsonValue(const QJsonValue& json, QString& value, QStringList*)
+{
+    if (!json.isString())
+        return false;
+    value = json.toString();
+    return true;
+}
+inline bool fromJsonValue(const QJsonValue& json, QUrl& value, QStringList*)
+{
+    if (!json.isString())
+        return false;
+    value = QUrl{json.toString()};
+    return true;
+}
+inline bool fromJsonValue(const QJsonValue& json, bool& value, QStringList*)
+{
+    if (!json.isBool())
+        return false;
+    value = json.toBool();
+    return true;
+}
+inline bool fromJsonValue(const QJsonValue& json, int& value, QStringList*)
+{
+    if (!json.isDouble())
+        return false;
+    value = json.toInt();
+    return true;
+}
+inline bool fromJsonValue(const QJsonValue& json, double& value, QStringList*)
+{
+    if (!json.isDouble())
+        return false;
+    value = json.toDouble();
+    return true;
+}
+template<typename T>
+    requires requires(const QJsonObject& o, QStringList* e) {
+        { T::fromJson(o, e) } -> std::convertible_to<T>;
+    }
+bool fromJsonValue(const QJsonValue& json, T& value, QStringList* errors)
+{
+    if (!json.isObject())
+        return false;
+    value = T::fromJson(json.toObject(), errors);
+    return true;
+}
+template<typename T>
+bool fromJsonValue(const QJsonValue& json, QList<T>& value, QStringList* errors)
+{
+    if (!json.isArray())
+        return false;
+    const auto a = json.toArray();
+    value.clear();
+    value.reserve(a.size());
+    for (const auto v : a)
+        if (!fromJsonValue(v, value.emplaceBack(), errors))
+            return false;
+    return true;
+}
+
+inline QJsonValue toJsonValue(const QString& value)
+{
+    return value;
+}
+inline QJsonValue toJsonValue(QLatin1StringView value)
+{
+    return value;
+}
+inline QJsonValue toJsonValue(const QUrl& value)
+{
+    return value.toString();
+}
+inline QJsonValue toJsonValue(bool value)
+{
+    return value;
+}
+inline QJsonValue toJsonValue(int value)
+{
+    return value;
+}
+inline QJsonValue toJsonValue(double value)
+{
+    return value;
+}
+inline QJsonValue toJsonValue(const QVariantMap& value)
+{
+    return QJsonObject::fromVariantMap(value);
+}
+template<typename T>
+    requires requires(const T& t) {
+        { t.toJson() } -> std::convertible_to<QJsonValue>;
+    }
+QJsonValue toJsonValue(const T& value)
+{
+    return value.toJson();
+}
+template<typename T>
+QJsonValue toJsonValue(const QList<T>& value)
+{
+    QJsonArray a;
+    for (const auto& v : value)
+        a.append(toJsonValue(v));
+    return a;
+}
+
+template<typename T>
+bool isEmptyJsonValue(const T& value)
+{
+    if constexpr (requires { value.isEmpty(); })
+        return value.isEmpty();
+    else
+        return value == T{};
+}
+
+// Whether a field leaves its key out: at the default of a JsonDefault, when empty otherwise.
+template<typename Field, typename V>
+bool isOmittedJsonValue(const Field& field, const V& value)
+{
+    if constexpr (requires { field.isDefault(value); })
+        return field.isDefault(value);
+    else
+        return isEmptyJsonValue(value);
+}
+
+template<typename T, typename Field>
+JsonValueResult readJsonField(T& target,
+                              const Field& field,
+                              const QJsonValue& value,
+                              const char* where,
+                              QStringList* errors)
+{
+    typename Field::Type v{};
+    if (!fromJsonValue(value, v, errors)) {
+        if (errors)
+            errors->append(QStringLiteral("%1::readJson: '%2' has an invalid value")
+                               .arg(QLatin1StringView{where}, field.key));
+        return JsonValue_Invalid;
+    }
+    field.set(target, std::move(v));
+    return JsonValue_Read;
+}
+
+template<typename T>
+JsonValueResult readJsonField(T& /*target*/,
+                              const JsonConstant& field,
+                              const QJsonValue& value,
+                              const char* where,
+                              QStringList* errors)
+{
+    if (value.toString() == field.value)
+        return JsonValue_Read;
+    if (errors)
+        errors->append(QStringLiteral("%1::readJson: '%2' is not '%3'")
+                           .arg(QLatin1StringView{where}, field.key, field.value));
+    return JsonValue_Invalid;
+}
+
+// Dispatches key to the matching entry of a field table, for use in Base::readJsonValue().
+template<typename T, typename... Fields>
+JsonValueResult readJsonFields(T& target,
+                               const std::tuple<Fields...>& fields,
+                               QAnyStringView key,
+                               const QJsonValue& value,
+                               const char* where,
+                               QStringList* errors)
+{
+    JsonValueResult result = JsonValue_Unknown;
+    std::apply(
+        [&](const auto&... field) {
+            (void) ((key == field.key
+                         ? (result = readJsonField(target, field, value, where, errors), true)
+                         : false)
+                    || ...);
+        },
+        fields);
+    return result;
+}
+
+// Writes the keys of a field table, every one of them when full is set.
+template<typename T, typename... Fields>
+void writeJsonFields(const T& source,
+                     const std::tuple<Fields...>& fields,
+                     QJsonObject& json,
+                     bool full = false)
+{
+    std::apply(
+        [&](const auto&... field) {
+            (
+                [&] {
+                    decltype(auto) v = field.get(source);
+                    if (full || (field.flags & JsonField_Always)
+                        || !isOmittedJsonValue(field, v))
+                        json.insert(field.key, toJsonValue(v));
+                }(),
+                ...);
+        },
+        fields);
+}
+
+template<typename T, typename... Fields>
+void writeJsonFields(const T& source,
+                     const std::tuple<Fields...>& fields,
+                     JsonWriter& writer,
+                     bool full = false)
+{
+    std::apply(
+        [&](const auto&... field) {
+            (
+                [&] {
+                    decltype(auto) v = field.get(source);
+                    if (full || (field.flags & JsonField_Always)
+                        || !isOmittedJsonValue(field, v)) {
+                        writer.key(field.key);
+                        writer.value(v);
+                    }
+                }(),
+                ...);
+        },
+        fields);
+}
+
+} // namespace ai
+
+#endif // LIBAI_JSONFIELDS_H
@@ -41,6 +41,16 @@ bool Request::writeJson(QJsonObject& json, bool full) const
     return true;
 }
 
+void Request::writeUtf8Members(JsonWriter &writer, bool full) const
+{
+    if (full) {
+        writer.key(QLatin1StringView{"id"});
+        writer.value(mId);
+        writer.key(QLatin1StringView{"url"});
+        writer.value(url());
+    }
+}
+
 QVariant Request::attribute(Attribute code) const
 {
     switch (code) {
@@ -76,4 +86,9 @@ QByteArray Request::prettyJson(bool full) const
     return QJsonDocument{toJson(full)}.toJson();
 }
 
+QByteArray Request::toUtf8Json(bool full, qsizetype /*capacity*/) const
+{
+    return QJsonDocument{toJson(full)}.toJson(QJsonDocument::Compact);
+}
+
 } // namespace ai
@@ -5,6 +5,7 @@
 #include <QNetworkReply>
 #include <QObject>
 #include <qqmlintegration.h>
+#include "jsonfields.h"
 
 class QNetworkAccessManager;
 class QNetworkRequest;
@@ -81,9 +82,15 @@ public:
     QJsonObject toJson(bool full = false) const;
     QByteArray prettyJson(bool full = false) const;
 
+    // Compact UTF-8 body of the request. The default serializes toJson(); subclasses write
+    // straight into a buffer of capacity bytes.
+    [[nodiscard]] virtual QByteArray toUtf8Json(bool full = false,
+                                                qsizetype capacity = 1024) const;
+
 protected:
     virtual bool readJson(const QJsonObject& json, QStringList* errors = nullptr);
     virtual bool writeJson(QJsonObject& json, bool full = false) const;
+    void writeUtf8Members(JsonWriter& writer, bool full = false) const;
 
     [[nodiscard]] QJsonObject& extra() { return mExtra; }
 
@@ -5,6 +5,18 @@
 
 namespace ai {
 
+bool Response::readData(const QByteArray& data, QStringList* errors)
+{
+    const auto doc = QJsonDocument::fromJson(data);
+    if (!doc.isObject()) {
+        if (errors)
+            errors->append(QStringLiteral("Failed to parse response data"));
+        return false;
+    }
+
+    return readJson(doc.object(), errors);
+}
+
 bool Response::readJson(const QJsonObject& json, QStringList* errors)
 {
     mExtra = json;
@@ -100,24 +112,12 @@ void Response::handleFinished()
         return;
     }
 
-    QJsonDocument doc;
-
     const auto data = mReply->readAll();
 
     qDebug().noquote().nospace() << "RECEIVE: " << data;
 
-    doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        setError({Error::InternalErrorType, Error::InternalError, "Failed to parse response data"});
-        return;
-    }
-
-    const auto json = doc.object();
-
-    // qDebug().noquote() << QJsonDocument{json}.toJson();
-
     QStringList errors;
-    if (!readJson(json, &errors)) {
+    if (!readData(data, &errors)) {
         setError({Error::InternalErrorType, Error::InternalError, errors.join("\n")});
     }
 
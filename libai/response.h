@@ -83,6 +83,7 @@ protected:
     void clearError() { setError({}); }
     void setError(const Error& error);
 
+    virtual bool readData(const QByteArray& data, QStringList* errors = nullptr);
     virtual bool readJson(const QJsonObject& json, QStringList* errors = nullptr);
     virtual bool writeJson(QJsonObject& json, bool full = false) const;
 
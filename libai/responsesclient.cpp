@@ -21,9 +21,12 @@ ResponsesResponse *ResponsesClient::post(const ResponsesRequest &request)
     ResponsesRequest r = request;
     if (r.apiKey().isEmpty())
         r.setApiKey(apiKey());
+    if (!apiUrl().isEmpty())
+        r.setUrl(apiUrl());
 
-    const auto json = r.toJson();
-    const auto data = QJsonDocument{json}.toJson();
+    // sized after the largest body so far, so the writer normally never reallocates
+    const auto data = r.toUtf8Json(false, mRequestSizeHint);
+    mRequestSizeHint = qMax(mRequestSizeHint, data.size() + data.size() / 4);
 
     qDebug().noquote().nospace() << "POST: " << data;
 
@@ -23,6 +23,9 @@ public:
             return setApiKey(tp->apiKey());
         return setApiKey({});
     }
+
+private:
+    qsizetype mRequestSizeHint = 4096;
 };
 
 } // namespace ai
@@ -223,83 +223,22 @@ bool ResponsesRequest::writeJson(QJsonObject &json, bool full) const
     if (!Request::writeJson(json, full))
         return false;
 
-    if (full || mBackground)
-        json[QStringLiteral("background")] = mBackground;
+    writeJsonFields(*this, jsonFields(), json, full);
 
-    if (full || !mConversation.isEmpty())
-        json[QStringLiteral("conversation")] = mConversation.toJson();
-
-    if (full || !mInclude.isEmpty())
-        json[QStringLiteral("include")] = mInclude.toJson();
-
-    if (full || !mInput.isEmpty())
-        json[QStringLiteral("input")] = mInput.toJson();
-
-    if (full || !mInstructions.isEmpty())
-        json[QStringLiteral("instructions")] = mInstructions;
-
-    if (full || mMaxOutputTokens != 0)
-        json[QStringLiteral("max_output_tokens")] = mMaxOutputTokens;
-
-    if (full || mMaxToolCalls != 0)
-        json[QStringLiteral("max_tool_calls")] = mMaxToolCalls;
-
-    if (full || !mMetadata.isEmpty())
-        json[QStringLiteral("metadata")] = QJsonObject::fromVariantMap(mMetadata);
-
-    if (const auto model = modelAsString(); full || !model.isEmpty())
-        json[QStringLiteral("model")] = model;
-
-    if (full || mParallelToolCalls != 0)
-        json[QStringLiteral("parallel_tool_calls")] = mParallelToolCalls;
-
-    if (full || !mPreviousResponseId.isEmpty())
-        json[QStringLiteral("previous_response_id")] = mPreviousResponseId;
-
-    if (full || !mPrompt.isEmpty())
-        json[QStringLiteral("prompt")] = mPrompt.toJson();
-
-    if (full || !mPromptCacheKey.isEmpty())
-        json[QStringLiteral("prompt_cache_key")] = mPromptCacheKey;
-
-    if (full || (!mReasoning.isEmpty() && isReasoningModel()))
-        json[QStringLiteral("reasoning")] = mReasoning.toJson();
-
-    if (full || !mSafetyIdentifier.isEmpty())
-        json[QStringLiteral("safety_identifier")] = mSafetyIdentifier;
-
-    if (full || mServiceTier != ServiceTier_Auto)
-        json[QStringLiteral("service_tier")] = serviceTierAsString();
-
-    if (full || !mStore)
-        json[QStringLiteral("store")] = mStore;
-
-    if (full || mStream)
-        json[QStringLiteral("stream")] = mStream;
-
-    if (full || !mStreamOptions.isEmpty())
-        json[QStringLiteral("stream_options")] = mStreamOptions.toJson();
-
-    if (full || mTemperature != 1.0)
-        json[QStringLiteral("temperature")] = mTemperature;
-
-    if (full || !mTools.isEmpty()) {
-        QJsonArray tools;
-        for (const auto &tool : mTools)
-            tools.append(tool.toJson());
-        json[QStringLiteral("tools")] = tools;
-    }
-
-    if (full || mTopLogprobs != 0)
-        json[QStringLiteral("top_logprobs")] = mTopLogprobs;
+    return true;
+}
 
-    if (full || mTopP != 1.0)
-        json[QStringLiteral("top_p")] = mTopP;
+QByteArray ResponsesRequest::toUtf8Json(bool full, qsizetype capacity) const
+{
+    // the keys of writeJson(), without the QJsonObject tree and the QJsonDocument round trip
+    JsonWriter writer{capacity};
+    writer.beginObject();
 
-    if (full || mTruncation != Truncation_Disabled)
-        json[QStringLiteral("truncation")] = truncationAsString();
+    Request::writeUtf8Members(writer, full);
+    writeJsonFields(*this, jsonFields(), writer, full);
 
-    return true;
+    writer.endObject();
+    return writer.takeData();
 }
 
 const QMap<int, QString> ResponsesRequest::ModelKV{{Model_Gpt5, QStringLiteral("gpt-5")},
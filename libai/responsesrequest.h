@@ -467,7 +467,50 @@ public:
         }
     }
 
+    [[nodiscard]] QByteArray toUtf8Json(bool full = false,
+                                        qsizetype capacity = 1024) const override;
+
 protected:
+    // The keys writeJson() and toUtf8Json() write; readJson() reads them itself.
+    static constexpr auto jsonFields()
+    {
+        using R = ResponsesRequest;
+        return std::tuple{jsonField("background", &R::mBackground),
+                          jsonField("conversation", &R::mConversation),
+                          jsonField("include", &R::mInclude),
+                          jsonField("input", &R::mInput),
+                          jsonField("instructions", &R::mInstructions),
+                          jsonField("max_output_tokens", &R::mMaxOutputTokens),
+                          jsonField("max_tool_calls", &R::mMaxToolCalls),
+                          jsonField("metadata", &R::mMetadata),
+                          jsonGetter("model", &R::modelAsString),
+                          jsonField("parallel_tool_calls", &R::mParallelToolCalls),
+                          jsonField("previous_response_id", &R::mPreviousResponseId),
+                          jsonField("prompt", &R::mPrompt),
+                          jsonField("prompt_cache_key", &R::mPromptCacheKey),
+                          jsonGetter("reasoning", &R::sentReasoning),
+                          jsonField("safety_identifier", &R::mSafetyIdentifier),
+                          jsonDefault("service_tier",
+                                      &R::serviceTierAsString,
+                                      QLatin1StringView{"auto"}),
+                          jsonDefault("store", &R::isStored, true),
+                          jsonField("stream", &R::mStream),
+                          jsonField("stream_options", &R::mStreamOptions),
+                          jsonDefault("temperature", &R::temperature, 1.0),
+                          jsonField("tools", &R::mTools),
+                          jsonField("top_logprobs", &R::mTopLogprobs),
+                          jsonDefault("top_p", &R::topP, 1.0),
+                          jsonDefault("truncation",
+                                      &R::truncationAsString,
+                                      QLatin1StringView{"disabled"})};
+    }
+
+    // The reasoning is only sent to a model that reasons.
+    [[nodiscard]] Reasoning sentReasoning() const
+    {
+        return isReasoningModel() ? mReasoning : Reasoning{};
+    }
+
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override;
     bool writeJson(QJsonObject& json, bool full = false) const override;
 
@@ -3,6 +3,7 @@
 
 #include <QJsonArray>
 #include <QJsonObject>
+#include "jsonfields.h"
 #include "responseutils.h"
 #include <qqmlintegration.h>
 
@@ -38,6 +39,14 @@ public:
         return json;
     }
 
+    // Serializes straight into writer, see writeUtf8Members().
+    virtual void writeUtf8(JsonWriter& writer) const
+    {
+        writer.beginObject();
+        writeUtf8Members(writer);
+        writer.endObject();
+    }
+
     [[nodiscard]] bool operator==(const Base& that) const { return mExtra == that.mExtra; }
 
 protected:
@@ -48,6 +57,75 @@ protected:
         mExtra = json;
         return true;
     }
+
+    // Offered every key of the object by readJsonValues(). Subclasses handle their own keys and
+    // forward the rest to their base class.
+    virtual JsonValueResult readJsonValue(QAnyStringView /*key*/,
+                                          const QJsonValue& /*value*/,
+                                          QStringList* /*errors*/ = nullptr)
+    {
+        return JsonValue_Unknown;
+    }
+
+    // Single pass alternative to readJson(): only keys no readJsonValue() consumed end up in
+    // extra(), so there is no copy of the object followed by a remove() per known key.
+    bool readJsonValues(const QJsonObject& json, QStringList* errors = nullptr)
+    {
+        mExtra = {};
+        for (auto it = json.constBegin(); it != json.constEnd(); ++it) {
+            switch (readJsonValue(it.keyView(), it.value(), errors)) {
+            case JsonValue_Read:
+                break;
+            case JsonValue_Unknown:
+                mExtra.insert(it.key(), it.value());
+                break;
+            case JsonValue_Invalid:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool readJsonType(const QJsonObject& json,
+                             QLatin1StringView type,
+                             const char* where,
+                             QStringList* errors)
+    {
+        if (const auto v = json.value(QLatin1StringView{"type"}); v.toString() != type) {
+            if (errors)
+                errors->append(QStringLiteral("%1::readJson: not a '%2': '%3'")
+                                   .arg(QLatin1StringView{where}, type, v.toString()));
+            return false;
+        }
+        return true;
+    }
+
+    static bool requireJsonValue(const QJsonObject& json,
+                                 QLatin1StringView key,
+                                 const char* where,
+                                 QStringList* errors)
+    {
+        if (!json.contains(key)) {
+            if (errors)
+                errors->append(QStringLiteral("%1::readJson: '%2' is missing")
+                                   .arg(QLatin1StringView{where}, key));
+            return false;
+        }
+        return true;
+    }
+
+    static JsonValueResult invalidJsonValue(QAnyStringView key,
+                                            const char* expected,
+                                            const char* where,
+                                            QStringList* errors)
+    {
+        if (errors)
+            errors->append(QStringLiteral("%1::readJson: '%2' is not %3")
+                               .arg(QLatin1StringView{where},
+                                    key.toString(),
+                                    QLatin1StringView{expected}));
+        return JsonValue_Invalid;
+    }
     virtual bool writeJson(QJsonObject& json, QStringList* /*errors*/ = nullptr) const
     {
         for (auto it = mExtra.constBegin(); it != mExtra.constEnd(); ++it)
@@ -55,6 +133,18 @@ protected:
         return true;
     }
 
+    // Writes the members of the object. The default goes through writeJson(); gadgets with a
+    // field table override it and skip the intermediate QJsonObject.
+    virtual bool writeUtf8Members(JsonWriter& writer, QStringList* errors = nullptr) const
+    {
+        QJsonObject json;
+        if (!writeJson(json, errors))
+            return false;
+        writer.members(json);
+        return true;
+    }
+    void writeExtraUtf8(JsonWriter& writer) const { writer.members(mExtra); }
+
     static QJsonObject& mergeJson(QJsonObject& target, const QJsonObject& source)
     {
         for (auto it = source.constBegin(); it != source.constEnd(); ++it)
@@ -135,43 +225,44 @@ public:
     }
 
 protected:
-    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    static constexpr auto jsonFields()
     {
-        if (!Base::readJson(json, errors))
-            return false;
+        return std::tuple{jsonConstant("type", "conversation"),
+                          jsonField("id", &Conversation::mId)};
+    }
 
-        if (json.value(QStringLiteral("type")).toString() != QStringLiteral("conversation")) {
-            if (errors)
-                errors->append(QStringLiteral("Conversation::readJson: not a conversation"));
+    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    {
+        if (!readJsonType(json, QLatin1StringView{"conversation"}, "Conversation", errors))
             return false;
-        } else
-            extra().remove(QStringLiteral("type"));
 
-        if (json.contains(QStringLiteral("id"))) {
-            if (const auto v = json.value(QStringLiteral("id")); !v.isString()) {
-                if (errors)
-                    errors->append(QStringLiteral("Conversation::readJson: 'id' is not a string"));
-                return false;
-            } else {
-                setId(v.toString());
-                extra().remove(QStringLiteral("id"));
-            }
-        }
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (const auto r = readJsonFields(*this, jsonFields(), key, value, "Conversation", errors);
+            r != JsonValue_Unknown)
+            return r;
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
         if (!Base::writeJson(json, errors))
             return false;
 
-        json.insert(QStringLiteral("type"), QStringLiteral("conversation"));
-
-        if (!mId.isEmpty())
-            json.insert(QStringLiteral("id"), mId);
+        writeJsonFields(*this, jsonFields(), json);
 
         return true;
     }
+    bool writeUtf8Members(JsonWriter& writer, QStringList* /*errors*/ = nullptr) const override
+    {
+        writeExtraUtf8(writer);
+        writeJsonFields(*this, jsonFields(), writer);
+        return true;
+    }
 
 private:
     QString mId;
@@ -278,80 +369,67 @@ public:
     }
 
 protected:
-    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    static constexpr auto jsonFields()
     {
-        if (!Base::readJson(json, errors))
-            return false;
+        return std::tuple{jsonConstant("type", "message"),
+                          jsonProperty("role",
+                                       &Message::roleAsString,
+                                       qOverload<const QString&>(&Message::setRole),
+                                       JsonField_Always),
+                          jsonField("id", &Message::mId)};
+    }
 
-        if (json.value(QStringLiteral("type")).toString() != QStringLiteral("message")) {
-            if (errors)
-                errors->append(QStringLiteral("Message::readJson: not a message"));
+    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    {
+        if (!readJsonType(json, QLatin1StringView{"message"}, "Message", errors))
             return false;
-        } else
-            extra().remove(QStringLiteral("type"));
 
-        if (json.contains(QStringLiteral("role"))) {
-            if (const auto v = json.value(QStringLiteral("role")); !v.isString()) {
-                if (errors)
-                    errors->append(QStringLiteral("Message::readJson: 'role' is not a string"));
-                return false;
-            } else if (const auto r = stringToRole(v.toString()); r == Role::Role_Custom) {
-                if (errors)
-                    errors->append(
-                        QStringLiteral("Message::readJson: 'role' is invalid: '%1'").arg(v.toString()));
-                setRole(v.toString());
-                extra().remove(QStringLiteral("role"));
-            } else {
-                setRole(r);
-                extra().remove(QStringLiteral("role"));
-            }
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (key == QLatin1StringView{"role"} && value.isString()) {
+            const auto v = value.toString();
+            if (stringToRole(v) == Role_Custom && errors)
+                errors->append(
+                    QStringLiteral("Message::readJson: 'role' is invalid: '%1'").arg(v));
         }
 
-        if (json.contains(QStringLiteral("status"))) {
-            if (const auto v = json.value(QStringLiteral("status")); !v.isString()) {
-                if (errors)
-                    errors->append(QStringLiteral("Message::readJson: 'status' is not a string"));
-                return false;
-            } else if (const auto s = stringToStatus(v.toString()); s == Status::Status_Custom) {
-                if (errors)
-                    errors->append(
-                        QStringLiteral("Message::readJson: 'status' is invalid: '%1'").arg(v.toString()));
-                setStatus(v.toString());
-                extra().remove(QStringLiteral("status"));
-            } else {
-                setStatus(s);
-                extra().remove(QStringLiteral("status"));
-            }
+        // status is only ever reported by the server, so it is read but not in the table
+        if (key == QLatin1StringView{"status"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "Message", errors);
+            const auto v = value.toString();
+            if (stringToStatus(v) == Status_Custom && errors)
+                errors->append(
+                    QStringLiteral("Message::readJson: 'status' is invalid: '%1'").arg(v));
+            setStatus(v);
+            return JsonValue_Read;
         }
 
-        if (json.contains(QStringLiteral("id"))) {
-            if (const auto v = json.value(QStringLiteral("id")); !v.isString()) {
-                if (errors)
-                    errors->append(QStringLiteral("Message::readJson: 'id' is not a string"));
-                return false;
-            } else {
-                setId(v.toString());
-                extra().remove(QStringLiteral("id"));
-            }
-        }
+        if (const auto r = readJsonFields(*this, jsonFields(), key, value, "Message", errors);
+            r != JsonValue_Unknown)
+            return r;
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
         if (!Base::writeJson(json, errors))
             return false;
 
-        json.insert(QStringLiteral("type"), QStringLiteral("message"));
-
-        json.insert(QStringLiteral("role"),
-                    mRole != Role_Custom ? roleToString(mRole) : mCustomRole);
-
-        if (!mId.isEmpty())
-            json.insert(QStringLiteral("id"), mId);
+        writeJsonFields(*this, jsonFields(), json);
 
         return true;
     }
+    bool writeUtf8Members(JsonWriter& writer, QStringList* /*errors*/ = nullptr) const override
+    {
+        writeExtraUtf8(writer);
+        writeJsonFields(*this, jsonFields(), writer);
+        return true;
+    }
 
 private:
     QString mId;
@@ -386,6 +464,10 @@ public:
             array.append(item);
         return array;
     }
+    void writeUtf8(JsonWriter& writer) const
+    {
+        writer.value(static_cast<const QStringList&>(*this));
+    }
 
     static StringList fromJson(const QJsonArray& json, bool* ok = nullptr)
     {
@@ -527,32 +609,44 @@ public:
     }
 
 protected:
-    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    static constexpr auto jsonFields()
     {
-        if (!Base::readJson(json, errors))
-            return false;
+        return std::tuple{jsonConstant("type", "input_text"),
+                          jsonField("text", &InputText::mText, JsonField_Always)};
+    }
 
-        if (json.value(QStringLiteral("type")) != QStringLiteral("input_text")) {
-            if (errors)
-                errors->append(QStringLiteral("InputText::readJson: not an 'input_text'"));
+    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    {
+        if (!readJsonType(json, QLatin1StringView{"input_text"}, "InputText", errors))
             return false;
-        }
 
-        setText(json.value(QStringLiteral("text")).toString());
-        extra().remove(QStringLiteral("text"));
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (const auto r = readJsonFields(*this, jsonFields(), key, value, "InputText", errors);
+            r != JsonValue_Unknown)
+            return r;
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
         if (!Base::writeJson(json, errors))
             return false;
 
-        json.insert(QStringLiteral("type"), QStringLiteral("input_text"));
-        json.insert(QStringLiteral("text"), mText);
+        writeJsonFields(*this, jsonFields(), json);
 
         return true;
     }
+    bool writeUtf8Members(JsonWriter& writer, QStringList* /*errors*/ = nullptr) const override
+    {
+        writeExtraUtf8(writer);
+        writeJsonFields(*this, jsonFields(), writer);
+        return true;
+    }
 };
 
 class InputImage : public Base
@@ -662,66 +756,49 @@ public:
     }
 
 protected:
-    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    static constexpr auto jsonFields()
     {
-        if (!Base::readJson(json, errors))
-            return false;
+        return std::tuple{jsonConstant("type", "input_image"),
+                          jsonField("file_id", &InputImage::mFileId),
+                          jsonField("image_url", &InputImage::mImageUrl),
+                          jsonProperty("detail",
+                                       &InputImage::detailAsString,
+                                       qOverload<const QString&>(&InputImage::setDetail),
+                                       JsonField_Always)};
+    }
 
-        if (extra().value(QStringLiteral("type")) != QStringLiteral("input_image")) {
-            if (errors)
-                errors->append(QStringLiteral("InputImage::readJson: not an 'input_image'"));
+    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    {
+        if (!readJsonType(json, QLatin1StringView{"input_image"}, "InputImage", errors))
             return false;
-        }
-
-        if (extra().contains(QStringLiteral("file_id"))) {
-            if (const auto v = extra().value(QStringLiteral("file_id")); !v.isString()) {
-                if (errors)
-                    errors->append(QStringLiteral("'file_id' is not a string"));
-                return false;
-            } else {
-                setFileId(v.toString());
-                extra().remove(QStringLiteral("file_id"));
-            }
-        }
 
-        if (extra().contains(QStringLiteral("image_url"))) {
-            if (const auto v = extra().value(QStringLiteral("image_url")); !v.isString()) {
-                if (errors)
-                    errors->append(QStringLiteral("'image_url' is not a string"));
-                return false;
-            } else {
-                setImageUrl(v.toString());
-                extra().remove(QStringLiteral("image_url"));
-            }
-        }
-
-        if (extra().contains(QStringLiteral("detail"))) {
-            if (const auto v = extra().value(QStringLiteral("detail")); !v.isString()) {
-                if (errors)
-                    errors->append(QStringLiteral("'detail' is not a string"));
-                return false;
-            } else {
-                setDetail(v.toString());
-                extra().remove(QStringLiteral("detail"));
-            }
-        }
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (const auto r = readJsonFields(*this, jsonFields(), key, value, "InputImage", errors);
+            r != JsonValue_Unknown)
+            return r;
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
         if (!Base::writeJson(json, errors))
             return false;
 
-        json.insert(QStringLiteral("type"), QStringLiteral("input_image"));
-        if (!mFileId.isEmpty())
-            json.insert(QStringLiteral("file_id"), mFileId);
-        if (!mImageUrl.isEmpty())
-            json.insert(QStringLiteral("image_url"), mImageUrl.toString());
-        json.insert(QStringLiteral("detail"), detailAsString());
+        writeJsonFields(*this, jsonFields(), json);
 
         return true;
     }
+    bool writeUtf8Members(JsonWriter& writer, QStringList* /*errors*/ = nullptr) const override
+    {
+        writeExtraUtf8(writer);
+        writeJsonFields(*this, jsonFields(), writer);
+        return true;
+    }
 };
 
 class InputFile : public Base
@@ -1058,6 +1135,14 @@ public:
         return content;
     }
 
+    void writeUtf8(JsonWriter& writer) const override
+    {
+        if (!extra().isEmpty())
+            Base::writeUtf8(writer);
+        else
+            std::visit([&writer](const auto& content) { content.writeUtf8(writer); }, mVariant);
+    }
+
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
@@ -1158,43 +1243,36 @@ public:
     }
 
 protected:
+    static constexpr auto jsonFields()
+    {
+        return std::tuple{jsonField("content", &InputMessage::mContent)};
+    }
+
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (const auto r = readJsonFields(*this, jsonFields(), key, value, "InputMessage", errors);
+            r != JsonValue_Unknown)
+            return r;
+
+        return Message::readJsonValue(key, value, errors);
+    }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
         if (!Message::writeJson(json, errors))
             return false;
 
-        if (!mContent.isEmpty()) {
-            QJsonArray a;
-            for (const auto& i : mContent)
-                a.append(i.toJson());
-            json.insert(QStringLiteral("content"), a);
-        }
+        writeJsonFields(*this, jsonFields(), json);
 
         return true;
     }
-
-    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    bool writeUtf8Members(JsonWriter& writer, QStringList* errors = nullptr) const override
     {
-        if (!Message::readJson(json, errors))
+        if (!Message::writeUtf8Members(writer, errors))
             return false;
 
-        if (json.contains(QStringLiteral("content"))) {
-            if (const auto v = json.value(QStringLiteral("content")); !v.isArray()) {
-                if (errors)
-                    errors->append(QStringLiteral("'content' is not an array"));
-                return false;
-            } else {
-                const auto a = v.toArray();
-                QList<InputMessageContent> list;
-                for (const auto& i : a) {
-                    list.append(InputMessageContent::fromJson(i.toObject(), errors));
-                    if (errors && !errors->isEmpty())
-                        return false;
-                }
-                setContent(list);
-                extra().remove(QStringLiteral("content"));
-            }
-        }
+        writeJsonFields(*this, jsonFields(), writer);
 
         return true;
     }
@@ -1243,40 +1321,44 @@ public:
     }
 
 protected:
-    bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
+    static constexpr auto jsonFields()
     {
-        if (!Base::writeJson(json, errors))
-            return false;
-
-        if (!mId.isEmpty())
-            json.insert(QStringLiteral("id"), mId);
-
-        json.insert(QStringLiteral("type"), QStringLiteral("item_reference"));
-
-        return true;
+        return std::tuple{jsonConstant("type", "item_reference"),
+                          jsonField("id", &ItemReference::mId)};
     }
 
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Base::readJson(json, errors))
+        if (!readJsonType(json, QLatin1StringView{"item_reference"}, "ItemReference", errors))
             return false;
 
-        if (const auto v = json.value(QStringLiteral("type")).toString();
-            v != QStringLiteral("item_reference")) {
-            if (errors)
-                errors->append(
-                    QStringLiteral("ItemReference::readJson: not an 'item_reference': '%1'").arg(v));
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (const auto r = readJsonFields(*this, jsonFields(), key, value, "ItemReference", errors);
+            r != JsonValue_Unknown)
+            return r;
+
+        return Base::readJsonValue(key, value, errors);
+    }
+    bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
+    {
+        if (!Base::writeJson(json, errors))
             return false;
-        } else
-            extra().remove(QStringLiteral("type"));
 
-        if (const auto v = json.value(QStringLiteral("id")); v.isString()) {
-            extra().remove(QStringLiteral("id"));
-            setId(v.toString());
-        }
+        writeJsonFields(*this, jsonFields(), json);
 
         return true;
     }
+    bool writeUtf8Members(JsonWriter& writer, QStringList* /*errors*/ = nullptr) const override
+    {
+        writeExtraUtf8(writer);
+        writeJsonFields(*this, jsonFields(), writer);
+        return true;
+    }
 };
 
 class AiItemReference : public AiBase
@@ -1415,6 +1497,14 @@ public:
         return item;
     }
 
+    void writeUtf8(JsonWriter& writer) const override
+    {
+        if (!extra().isEmpty())
+            Base::writeUtf8(writer);
+        else
+            std::visit([&writer](const auto& item) { item.writeUtf8(writer); }, mVariant);
+    }
+
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
@@ -1547,6 +1637,8 @@ public:
         writeJson(json);
         return json;
     }
+    // an array, like toJson(), not the object of Base
+    void writeUtf8(JsonWriter& writer) const override { writer.value(mItems); }
 
     operator QString() const { return QJsonDocument{toJson()}.toJson(); }
 
@@ -1948,54 +2040,45 @@ public:
     }
 
 protected:
+    static constexpr auto jsonFields()
+    {
+        return std::tuple{jsonProperty("effort",
+                                       &Reasoning::effortAsString,
+                                       qOverload<const QString&>(&Reasoning::setEffort),
+                                       JsonField_Always),
+                          jsonProperty("summary",
+                                       &Reasoning::summaryAsString,
+                                       qOverload<const QString&>(&Reasoning::setSummary),
+                                       JsonField_Always)};
+    }
+
+    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    {
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (const auto r = readJsonFields(*this, jsonFields(), key, value, "Reasoning", errors);
+            r != JsonValue_Unknown)
+            return r;
+
+        return Base::readJsonValue(key, value, errors);
+    }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
         if (!Base::writeJson(json, errors))
             return false;
 
-        json.insert(QStringLiteral("effort"), effortAsString());
-
-        json.insert(QStringLiteral("summary"), summaryAsString());
-
-        // json.insert(QStringLiteral("type"), QStringLiteral("reasoning"));
+        writeJsonFields(*this, jsonFields(), json);
 
         return true;
     }
-
-    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    bool writeUtf8Members(JsonWriter& writer, QStringList* /*errors*/ = nullptr) const override
     {
-        if (!Base::readJson(json, errors))
-            return false;
-
-        // if (const auto v = json.value(QStringLiteral("type")).toString();
-        //     v != QStringLiteral("reasoning")) {
-        //     if (errors)
-        //         errors->append(
-        //             QStringLiteral("Reasoning::readJson: not a 'reasoning': '%1'").arg(v));
-        //     return false;
-        // } else
-        //     extra().remove(QStringLiteral("type"));
-
-        if (json.contains(QStringLiteral("effort"))) {
-            if (const auto v = json.value(QStringLiteral("effort")); v.isString()) {
-                setEffort(v.toString());
-                extra().remove(QStringLiteral("effort"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
-        }
-
-        if (json.contains(QStringLiteral("summary"))) {
-            if (const auto v = json.value(QStringLiteral("summary")); v.isString()) {
-                setSummary(v.toString());
-                extra().remove(QStringLiteral("summary"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
-        }
-
+        writeExtraUtf8(writer);
+        writeJsonFields(*this, jsonFields(), writer);
         return true;
     }
 };
@@ -2051,28 +2134,26 @@ protected:
 
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Base::readJson(json, errors))
+        if (!readJsonType(json, QLatin1StringView{"refusal"}, "Refusal", errors))
             return false;
 
-        if (const auto v = json.value(QStringLiteral("type")).toString();
-            v != QStringLiteral("refusal")) {
-            if (errors)
-                errors->append(QStringLiteral("Refusal::readJson: not a 'refusal': '%1'").arg(v));
-            return false;
-        } else
-            extra().remove(QStringLiteral("type"));
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (key == QLatin1StringView{"type"})
+            return JsonValue_Read;
 
-        if (json.contains(QStringLiteral("refusal"))) {
-            if (const auto v = json.value(QStringLiteral("refusal")); v.isString()) {
-                setRefusal(v.toString());
-                extra().remove(QStringLiteral("refusal"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
+        if (key == QLatin1StringView{"refusal"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "Refusal", errors);
+            setRefusal(value.toString());
+            return JsonValue_Read;
         }
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
 };
 
@@ -2417,54 +2498,119 @@ public:
     }
     [[nodiscard]] bool isValid() const override { return !isEmpty(); }
 
-    QJsonObject toJson() const
+    static ImageGenerationTool fromJson(const QJsonObject& json, QStringList* errors = nullptr)
     {
-        QJsonObject json = extra();
-        json.insert(QStringLiteral("type"), QStringLiteral("image_generation"));
-        json.insert(QStringLiteral("background"), toString(background()));
-        json.insert(QStringLiteral("input_fidelity"), toString(inputFidelity()));
-        json.insert(QStringLiteral("model"), toString(model()));
-        json.insert(QStringLiteral("moderation"), toString(moderation()));
-        json.insert(QStringLiteral("output_compression"), outputCompression());
-        json.insert(QStringLiteral("output_format"), toString(outputFormat()));
-        json.insert(QStringLiteral("partial_images"), partialImages());
-        json.insert(QStringLiteral("quality"), toString(quality()));
-        json.insert(QStringLiteral("size"), toString(size()));
-        QJsonObject m;
-        if (!inputImageMaskFile().isEmpty())
-            m.insert(QStringLiteral("file_id"), inputImageMaskFile());
-        if (!inputImageMaskUrl().isEmpty())
-            m.insert(QStringLiteral("image_url"), inputImageMaskUrl());
-        if (!m.isEmpty())
-            json.insert(QStringLiteral("input_image_mask"), m);
-        return json;
+        ImageGenerationTool tool;
+        tool.readJson(json, errors);
+        return tool;
+    }
+
+protected:
+    static constexpr auto jsonFields()
+    {
+        return std::tuple{
+            jsonConstant("type", "image_generation"),
+            jsonProperty("background",
+                         &ImageGenerationTool::backgroundAsString,
+                         qOverload<const QString&>(&ImageGenerationTool::setBackground),
+                         JsonField_Always),
+            jsonProperty("input_fidelity",
+                         &ImageGenerationTool::inptFidelityAsString,
+                         qOverload<const QString&>(&ImageGenerationTool::setInputFidelity),
+                         JsonField_Always),
+            jsonProperty("model",
+                         &ImageGenerationTool::modelAsString,
+                         qOverload<const QString&>(&ImageGenerationTool::setModel),
+                         JsonField_Always),
+            jsonProperty("moderation",
+                         &ImageGenerationTool::moderationAsString,
+                         qOverload<const QString&>(&ImageGenerationTool::setModeration),
+                         JsonField_Always),
+            jsonField("output_compression",
+                      &ImageGenerationTool::mOutputCompression,
+                      JsonField_Always),
+            jsonProperty("output_format",
+                         &ImageGenerationTool::outputFormatAsString,
+                         qOverload<const QString&>(&ImageGenerationTool::setOutputFormat),
+                         JsonField_Always),
+            jsonField("partial_images", &ImageGenerationTool::mPartialImages, JsonField_Always),
+            jsonProperty("quality",
+                         &ImageGenerationTool::qualityAsString,
+                         qOverload<const QString&>(&ImageGenerationTool::setQuality),
+                         JsonField_Always),
+            jsonProperty("size",
+                         &ImageGenerationTool::sizeAsString,
+                         qOverload<const QString&>(&ImageGenerationTool::setSize),
+                         JsonField_Always)};
     }
 
-    static ImageGenerationTool fromJson(const QJsonObject& json, bool* ok = nullptr)
+    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (ok)
-            *ok = true;
+        if (!readJsonType(json,
+                          QLatin1StringView{"image_generation"},
+                          "ImageGenerationTool",
+                          errors))
+            return false;
 
-        if (json.value(QStringLiteral("type")).toString() != QStringLiteral("image_generation")) {
-            if (ok)
-                *ok = false;
-            return {json};
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (key == QLatin1StringView{"input_image_mask"}) {
+            if (!value.isObject())
+                return invalidJsonValue(key, "an object", "ImageGenerationTool", errors);
+            const auto mask = value.toObject();
+            setInputImageMaskFile(mask.value(QLatin1StringView{"file_id"}).toString());
+            setInputImageMaskUrl(mask.value(QLatin1StringView{"image_url"}).toString());
+            return JsonValue_Read;
         }
 
-        QJsonObject x = json;
-        x.remove(QStringLiteral("type"));
+        if (const auto r
+            = readJsonFields(*this, jsonFields(), key, value, "ImageGenerationTool", errors);
+            r != JsonValue_Unknown)
+            return r;
 
-        ImageGenerationTool tool;
+        return Base::readJsonValue(key, value, errors);
+    }
+    bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
+    {
+        if (!Base::writeJson(json, errors))
+            return false;
+
+        writeJsonFields(*this, jsonFields(), json);
 
-        // if (const auto v = json.value(QStringLiteral("background")); v.isString()) {
-        //     tool.b = v.toString();
-        //     x.remove(QStringLiteral("background"));
-        // } else if (ok)
-        //     *ok = false;
+        QJsonObject m;
+        if (!mInputImageMaskFile.isEmpty())
+            m.insert(QStringLiteral("file_id"), mInputImageMaskFile);
+        if (!mInputImageMaskUrl.isEmpty())
+            m.insert(QStringLiteral("image_url"), mInputImageMaskUrl);
+        if (!m.isEmpty())
+            json.insert(QStringLiteral("input_image_mask"), m);
 
-        tool.setExtra(x);
+        return true;
+    }
+    bool writeUtf8Members(JsonWriter& writer, QStringList* /*errors*/ = nullptr) const override
+    {
+        writeExtraUtf8(writer);
+        writeJsonFields(*this, jsonFields(), writer);
 
-        return tool;
+        if (!mInputImageMaskFile.isEmpty() || !mInputImageMaskUrl.isEmpty()) {
+            writer.key(QLatin1StringView{"input_image_mask"});
+            writer.beginObject();
+            if (!mInputImageMaskFile.isEmpty()) {
+                writer.key(QLatin1StringView{"file_id"});
+                writer.value(mInputImageMaskFile);
+            }
+            if (!mInputImageMaskUrl.isEmpty()) {
+                writer.key(QLatin1StringView{"image_url"});
+                writer.value(mInputImageMaskUrl);
+            }
+            writer.endObject();
+        }
+
+        return true;
     }
 
 private:
@@ -2556,12 +2702,35 @@ public:
         return {};
     }
 
+    void writeUtf8(JsonWriter& writer) const override
+    {
+        if (isImageGeneration())
+            std::get<ImageGenerationTool>(mVariant).writeUtf8(writer);
+        else
+            writer.null();
+    }
+
     static Tool fromJson(const QJsonObject& json, QStringList* errors = nullptr)
     {
         Tool tool;
-        tool.fromJson(json, errors);
+        tool.readJson(json, errors);
         return tool;
     }
+
+protected:
+    bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
+    {
+        if (const auto type = json.value(QLatin1StringView{"type"}).toString();
+            type == QLatin1StringView{"image_generation"}) {
+            mVariant = ImageGenerationTool::fromJson(json, errors);
+            return true;
+        } else if (errors)
+            errors->append(QStringLiteral("Tool::readJson: unknown tool type: '%1'").arg(type));
+
+        Base::readJson(json, errors);
+
+        return false;
+    }
 };
 
 } // namespace ai
@@ -5,6 +5,7 @@
 #include <QJsonArray>
 #include <QJsonObject>
 
+#include "imagedecoder.h"
 #include "responsesrequestutils.h"
 
 namespace ai {
@@ -138,77 +139,55 @@ protected:
 
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Base::readJson(json, errors))
+        if (!readJsonType(json, QLatin1StringView{"reasoning"}, "Reasoning", errors))
             return false;
 
-        if (const auto v = json.value(QStringLiteral("type")).toString();
-            v != QStringLiteral("reasoning")) {
-            if (errors)
-                errors->append(
-                    QStringLiteral("Reasoning::readJson: not a 'reasoning': '%1'").arg(v));
-            return false;
-        } else
-            extra().remove(QStringLiteral("type"));
-
-        if (json.contains(QStringLiteral("status"))) {
-            if (const auto v = json.value(QStringLiteral("status")); v.isString()) {
-                setStatus(v.toString());
-                extra().remove(QStringLiteral("status"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
-        }
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (key == QLatin1StringView{"type"})
+            return JsonValue_Read;
 
-        if (json.contains(QStringLiteral("id"))) {
-            if (const auto v = json.value(QStringLiteral("id")); v.isString()) {
-                setId(v.toString());
-                extra().remove(QStringLiteral("id"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
+        if (key == QLatin1StringView{"status"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "Reasoning", errors);
+            setStatus(value.toString());
+            return JsonValue_Read;
         }
 
-        if (json.contains(QStringLiteral("encrypted_content"))) {
-            if (const auto v = json.value(QStringLiteral("encrypted_content")); v.isString()) {
-                setEncryptedContent(v.toString());
-                extra().remove(QStringLiteral("encrypted_content"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
+        if (key == QLatin1StringView{"id"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "Reasoning", errors);
+            setId(value.toString());
+            return JsonValue_Read;
         }
 
-        if (json.contains(QStringLiteral("summary"))) {
-            if (const auto v = json.value(QStringLiteral("summary")); v.isArray()) {
-                QStringList s;
-                const auto a = v.toArray();
-                for (const auto o : a)
-                    s.append(o.toObject().value("text").toString());
-                setSummary(s);
-                extra().remove(QStringLiteral("summary"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
+        if (key == QLatin1StringView{"encrypted_content"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "Reasoning", errors);
+            setEncryptedContent(value.toString());
+            return JsonValue_Read;
         }
 
-        if (json.contains(QStringLiteral("content"))) {
-            if (const auto v = json.value(QStringLiteral("content")); v.isArray()) {
-                QStringList s;
-                const auto a = v.toArray();
-                for (const auto o : a)
-                    s.append(o.toObject().value("text").toString());
+        if (key == QLatin1StringView{"summary"} || key == QLatin1StringView{"content"}) {
+            if (!value.isArray())
+                return invalidJsonValue(key, "an array", "Reasoning", errors);
+            QStringList s;
+            const auto a = value.toArray();
+            s.reserve(a.size());
+            for (const auto o : a)
+                s.append(o.toObject().value(QLatin1StringView{"text"}).toString());
+            if (key == QLatin1StringView{"summary"})
+                setSummary(s);
+            else
                 setContent(s);
-                extra().remove(QStringLiteral("content"));
-            } else if (errors) {
-                errors->append(QStringLiteral(""));
-                return false;
-            }
+            return JsonValue_Read;
         }
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
 };
 
@@ -300,49 +279,48 @@ public:
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Base::readJson(json, errors))
+        if (!readJsonType(json,
+                          QLatin1StringView{"image_generation_call"},
+                          "ImageGenerationCall",
+                          errors))
             return false;
 
-        if (extra().value(QStringLiteral("type")) != QStringLiteral("image_generation_call")) {
-            if (errors)
-                errors->append(QStringLiteral(
-                    "ImageGenerationCall::readJson: not an 'image_generation_call'"));
+        if (!requireJsonValue(json, QLatin1StringView{"id"}, "ImageGenerationCall", errors)
+            || !requireJsonValue(json, QLatin1StringView{"result"}, "ImageGenerationCall", errors)
+            || !requireJsonValue(json, QLatin1StringView{"status"}, "ImageGenerationCall", errors))
             return false;
-        } else
-            extra().remove(QStringLiteral("type"));
 
-        if (const auto v = json.value(QStringLiteral("id")); !v.isString()) {
-            if (errors)
-                errors->append(
-                    QStringLiteral("ImageGenerationCall::readJson: 'id' is not a string"));
-            return false;
-        } else {
-            setId(v.toString());
-            extra().remove(QStringLiteral("id"));
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (key == QLatin1StringView{"type"})
+            return JsonValue_Read;
+
+        if (key == QLatin1StringView{"id"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "ImageGenerationCall", errors);
+            setId(value.toString());
+            return JsonValue_Read;
         }
 
-        if (const auto v = json.value(QStringLiteral("result")); !v.isString()) {
-            if (errors)
-                errors->append(
-                    QStringLiteral("ImageGenerationCall::readJson: 'result' is not a string"));
-            return false;
-        } else {
-            const auto decoded = QByteArray::fromBase64(v.toVariant().toByteArray());
-            setResult(QImage::fromData(decoded));
-            extra().remove(QStringLiteral("result"));
+        if (key == QLatin1StringView{"result"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "ImageGenerationCall", errors);
+            setResult(decodeBase64Image(value.toString().toLatin1()));
+            return JsonValue_Read;
         }
 
-        if (const auto v = json.value(QStringLiteral("status")); !v.isString()) {
-            if (errors)
-                errors->append(
-                    QStringLiteral("ImageGenerationCall::readJson: 'status' is not a string"));
-            return false;
-        } else {
-            setStatus(v.toString());
-            extra().remove(QStringLiteral("status"));
+        if (key == QLatin1StringView{"status"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "ImageGenerationCall", errors);
+            setStatus(value.toString());
+            return JsonValue_Read;
         }
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
@@ -411,26 +389,27 @@ public:
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Base::readJson(json, errors))
+        if (!readJsonType(json, QLatin1StringView{"output_text"}, "OutputText", errors)
+            || !requireJsonValue(json, QLatin1StringView{"text"}, "OutputText", errors))
             return false;
 
-        if (extra().value(QStringLiteral("type")) != QStringLiteral("output_text")) {
-            if (errors)
-                errors->append(QStringLiteral("OutputText::readJson: not an 'output_text'"));
-            return false;
-        } else
-            extra().remove(QStringLiteral("type"));
+        return readJsonValues(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (key == QLatin1StringView{"type"})
+            return JsonValue_Read;
 
-        if (const auto v = json.value(QStringLiteral("text")); !v.isString()) {
-            if (errors)
-                errors->append(QStringLiteral("OutputText::readJson: 'text' is not a string"));
-            return false;
-        } else {
-            setText(v.toString());
-            extra().remove(QStringLiteral("text"));
+        if (key == QLatin1StringView{"text"}) {
+            if (!value.isString())
+                return invalidJsonValue(key, "a string", "OutputText", errors);
+            setText(value.toString());
+            return JsonValue_Read;
         }
 
-        return true;
+        return Base::readJsonValue(key, value, errors);
     }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
@@ -512,14 +491,14 @@ public:
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Base::readJson(json, errors))
-            return false;
+        // the variant owns all keys, including the unknown ones
+        setExtra({});
 
-        if (const auto type = extra().value(QStringLiteral("type")).toString();
-            type == QStringLiteral("output_text")) {
+        if (const auto type = json.value(QLatin1StringView{"type"}).toString();
+            type == QLatin1StringView{"output_text"}) {
             mVariant = OutputText::fromJson(json, errors);
             return true;
-        } else if (type == QStringLiteral("refusal")) {
+        } else if (type == QLatin1StringView{"refusal"}) {
             mVariant = Refusal::fromJson(json, errors);
             return true;
         } else if (errors)
@@ -600,23 +579,27 @@ public:
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Message::readJson(json, errors))
+        if (!requireJsonValue(json, QLatin1StringView{"content"}, "OutputMessage", errors))
             return false;
 
-        if (const auto v = json.value(QStringLiteral("content")); !v.isArray()) {
-            if (errors)
-                errors->append(
-                    QStringLiteral("OutputMessage::readJson: 'content' is not an object"));
-            return false;
-        } else {
+        return Message::readJson(json, errors);
+    }
+    JsonValueResult readJsonValue(QAnyStringView key,
+                                  const QJsonValue& value,
+                                  QStringList* errors = nullptr) override
+    {
+        if (key == QLatin1StringView{"content"}) {
+            if (!value.isArray())
+                return invalidJsonValue(key, "an array", "OutputMessage", errors);
+            const auto a = value.toArray();
             mContent.clear();
-            const auto a = v.toArray();
+            mContent.reserve(a.size());
             for (const auto o : a)
                 mContent.append(OutputMessageContent::fromJson(o.toObject(), errors));
-            extra().remove(QStringLiteral("content"));
+            return JsonValue_Read;
         }
 
-        return true;
+        return Message::readJsonValue(key, value, errors);
     }
     bool writeJson(QJsonObject& json, QStringList* errors = nullptr) const override
     {
@@ -633,6 +616,21 @@ protected:
             json.insert(QStringLiteral("content"), a);
         }
 
+        return true;
+    }
+    bool writeUtf8Members(JsonWriter& writer, QStringList* errors = nullptr) const override
+    {
+        if (!Message::writeUtf8Members(writer, errors))
+            return false;
+
+        writer.key(QLatin1StringView{"status"});
+        writer.value(statusAsString());
+
+        if (!mContent.isEmpty()) {
+            writer.key(QLatin1StringView{"content"});
+            writer.value(mContent);
+        }
+
         return true;
     }
 };
@@ -718,17 +716,17 @@ public:
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override
     {
-        if (!Base::readJson(json, errors))
-            return false;
+        // the variant owns all keys, including the unknown ones
+        setExtra({});
 
-        if (const auto type = extra().value(QStringLiteral("type")).toString();
-            type == QStringLiteral("message")) {
+        if (const auto type = json.value(QLatin1StringView{"type"}).toString();
+            type == QLatin1StringView{"message"}) {
             mVariant = OutputMessage::fromJson(json, errors);
             return true;
-        } else if (type == QStringLiteral("image_generation_call")) {
+        } else if (type == QLatin1StringView{"image_generation_call"}) {
             mVariant = ImageGenerationCall::fromJson(json, errors);
             return true;
-        } else if (type == QStringLiteral("reasoning")) {
+        } else if (type == QLatin1StringView{"reasoning"}) {
             mVariant = ReasoningOutput::fromJson(json, errors);
             return true;
         } else if (errors)
@@ -0,0 +1,329 @@
+#include "aggregates.h"
+#include "storage.h"
+
+void Aggregates::setDatabase(const QSqlDatabase &database)
+{
+    mStatements.clear();
+    mDatabase = database;
+}
+
+bool Aggregates::createSchema()
+{
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS `Aggregate` (\n"
+        "  `node`       INTEGER NOT NULL,\n"
+        "  `words`      INTEGER NOT NULL DEFAULT 0,\n"
+        "  `characters` INTEGER NOT NULL DEFAULT 0,\n"
+        "  `elements`   INTEGER NOT NULL DEFAULT 0,\n"
+        "  PRIMARY KEY(`node`)\n"
+        ")",
+        // the node values that refer to an element, its parents
+        QStringLiteral("CREATE INDEX IF NOT EXISTS idx_Value_node ON `Value`(`value`) WHERE "
+                       "`valueType`=%1")
+            .arg(Value::Type_Node)};
+
+    for (const auto &sql : statements) {
+        QSqlQuery query{mDatabase};
+        if (!query.exec(sql))
+            return handleError(nullptr, "Aggregates::createSchema", query), false;
+    }
+    return true;
+}
+
+Aggregates::Totals Aggregates::totals(int node)
+{
+    QSqlQuery &query = statement(
+        "SELECT `words`,`characters`,`elements` FROM `Aggregate` WHERE `node`=?");
+    query.addBindValue(node);
+    if (!query.exec())
+        return handleError(nullptr, "Aggregates::totals", query), Totals{};
+
+    Totals result;
+    if (query.next())
+        result = {query.value(0).toInt(), query.value(1).toInt(), query.value(2).toInt()};
+    query.finish();
+    return result;
+}
+
+bool Aggregates::update(int node)
+{
+    return refresh(node, 0, true);
+}
+
+QList<int> Aggregates::parents(int node)
+{
+    return parents(node, type(node));
+}
+
+bool Aggregates::refresh(int node, int depth, bool force)
+{
+    const int nodeType = type(node);
+    if (nodeType == Storable::Type_Unknown)
+        return true;
+
+    Totals now;
+    if (!compute(node, nodeType, &now))
+        return false;
+
+    // a node whose totals stay the same leaves its parents as they are, unless its links changed
+    const Totals old = totals(node);
+    if (now == old && !force)
+        return true;
+    if (now != old) {
+        if (!write(node, now))
+            return false;
+        publish(node, now);
+    }
+
+    // a cycle through node values would otherwise never settle
+    if (depth >= MaxDepth)
+        return handleError(QStringLiteral("Aggregates: %1 is nested too deep").arg(node)), true;
+
+    for (const int parent : parents(node, nodeType))
+        if (!refresh(parent, depth + 1, false))
+            return false;
+
+    return true;
+}
+
+bool Aggregates::compute(int node, int type, Totals *totals)
+{
+    QSqlQuery *query = nullptr;
+
+    switch (type) {
+    case Storable::Type_Value: {
+        QSqlQuery &value = statement("SELECT `valueType`,`value` FROM `Value` WHERE `id`=?");
+        value.addBindValue(node);
+        if (!value.exec())
+            return handleError(nullptr, "Aggregates::compute", value), false;
+        if (!value.next())
+            return true;
+
+        const int valueType = value.value(0).toInt();
+        const QString text = value.value(1).toString();
+        value.finish();
+
+        if (valueType == Value::Type_String) {
+            *totals = {countWords(text), int(text.size()), 0};
+        } else if (valueType == Value::Type_Text) {
+            // the chunks are cut between words, so their counts add up
+            QSqlQuery &chunks = statement("SELECT IFNULL(SUM(`words`),0),IFNULL(SUM(`characters`),"
+                                          "0) FROM `ValueChunk` WHERE `value`=?");
+            chunks.addBindValue(node);
+            if (!chunks.exec() || !chunks.next())
+                return handleError(nullptr, "Aggregates::compute", chunks), false;
+            *totals = {chunks.value(0).toInt(), chunks.value(1).toInt(), 0};
+            chunks.finish();
+        } else if (valueType == Value::Type_Node) {
+            // the totals of the element it refers to, 0 for anything else
+            if (this->type(text.toInt()) == Storable::Type_Element
+                || this->type(text.toInt()) == Storable::Type_Project)
+                *totals = this->totals(text.toInt());
+        }
+        return true;
+    }
+    case Storable::Type_Field:
+        query = &statement("SELECT IFNULL(SUM(a.`words`),0),IFNULL(SUM(a.`characters`),0),"
+                           "IFNULL(SUM(a.`elements`),0) FROM `Field_values` fv JOIN `Aggregate` a "
+                           "ON a.`node`=fv.`value` WHERE fv.`field`=?");
+        break;
+    case Storable::Type_Element:
+    case Storable::Type_Project:
+        query = &statement("SELECT IFNULL(SUM(a.`words`),0),IFNULL(SUM(a.`characters`),0),"
+                           "IFNULL(SUM(a.`elements`),0)+1 FROM `Element_fields` ef JOIN "
+                           "`Aggregate` a ON a.`node`=ef.`field` WHERE ef.`element`=?");
+        break;
+    default:
+        return true;
+    }
+
+    query->addBindValue(node);
+    if (!query->exec() || !query->next())
+        return handleError(nullptr, "Aggregates::compute", *query), false;
+    *totals = {query->value(0).toInt(), query->value(1).toInt(), query->value(2).toInt()};
+    query->finish();
+    return true;
+}
+
+bool Aggregates::write(int node, const Totals &totals)
+{
+    QSqlQuery &query = statement("INSERT OR REPLACE INTO `Aggregate` "
+                                 "(`node`,`words`,`characters`,`elements`) VALUES (?,?,?,?)");
+    query.addBindValue(node);
+    query.addBindValue(totals.words);
+    query.addBindValue(totals.characters);
+    query.addBindValue(totals.elements);
+    if (!query.exec())
+        return handleError(nullptr, "Aggregates::write", query), false;
+    return true;
+}
+
+int Aggregates::type(int node)
+{
+    QSqlQuery &query = statement("SELECT `type` FROM `Storable` WHERE `id`=?");
+    query.addBindValue(node);
+    if (!query.exec() || !query.next())
+        return Storable::Type_Unknown;
+    const int result = query.value(0).toInt();
+    query.finish();
+    return result;
+}
+
+QList<int> Aggregates::parents(int node, int type)
+{
+    QSqlQuery *query = nullptr;
+    switch (type) {
+    case Storable::Type_Value:
+        query = &statement("SELECT `field` FROM `Field_values` WHERE `value`=?");
+        break;
+    case Storable::Type_Field:
+        query = &statement("SELECT `element` FROM `Element_fields` WHERE `field`=?");
+        break;
+    case Storable::Type_Element:
+    case Storable::Type_Project:
+        query = &statement(QStringLiteral("SELECT `id` FROM `Value` WHERE `valueType`=%1 AND "
+                                          "`value`=?")
+                               .arg(Value::Type_Node));
+        break;
+    default:
+        return {};
+    }
+
+    query->addBindValue(QString::number(node));
+    if (!query->exec())
+        return handleError(nullptr, "Aggregates::parents", *query), QList<int>{};
+
+    QList<int> result;
+    while (query->next())
+        result.append(query->value(0).toInt());
+    return result;
+}
+
+bool Aggregates::rebuild()
+{
+    QHash<int, int> types;
+    QHash<int, Totals> own;
+    QHash<int, int> references;
+    QHash<int, QList<int>> children;
+
+    const auto select = [this](const QString &sql, const auto &row) {
+        QSqlQuery query{mDatabase};
+        query.setForwardOnly(true);
+        if (!query.exec(sql))
+            return handleError(nullptr, "Aggregates::rebuild", query), false;
+        while (query.next())
+            row(query);
+        return true;
+    };
+
+    const bool ok
+        = select(QStringLiteral("SELECT `id`,`type` FROM `Storable` WHERE `type` IN (%1,%2,%3,%4)")
+                     .arg(Storable::Type_Value)
+                     .arg(Storable::Type_Field)
+                     .arg(Storable::Type_Element)
+                     .arg(Storable::Type_Project),
+                 [&](const QSqlQuery &q) { types.insert(q.value(0).toInt(), q.value(1).toInt()); })
+          && select("SELECT `id`,`valueType`,`value` FROM `Value`",
+                    [&](const QSqlQuery &q) {
+                        const int id = q.value(0).toInt();
+                        const QString text = q.value(2).toString();
+                        if (q.value(1).toInt() == Value::Type_String)
+                            own.insert(id, {countWords(text), int(text.size()), 0});
+                        else if (q.value(1).toInt() == Value::Type_Node)
+                            references.insert(id, text.toInt());
+                    })
+          && select("SELECT `value`,SUM(`words`),SUM(`characters`) FROM `ValueChunk` GROUP BY "
+                    "`value`",
+                    [&](const QSqlQuery &q) {
+                        own.insert(q.value(0).toInt(), {q.value(1).toInt(), q.value(2).toInt(), 0});
+                    })
+          && select("SELECT `field`,`value` FROM `Field_values`",
+                    [&](const QSqlQuery &q) {
+                        children[q.value(0).toInt()].append(q.value(1).toInt());
+                    })
+          && select("SELECT `element`,`field` FROM `Element_fields`", [&](const QSqlQuery &q) {
+                 children[q.value(0).toInt()].append(q.value(1).toInt());
+             });
+    if (!ok)
+        return false;
+
+    // depth first with memo, a node still on the stack counts as empty to break cycles
+    QHash<int, Totals> result;
+    QSet<int> visiting;
+    const auto total = [&](const auto &self, int node) -> Totals {
+        if (const auto it = result.constFind(node); it != result.constEnd())
+            return *it;
+        if (visiting.contains(node))
+            return {};
+        visiting.insert(node);
+
+        const int type = types.value(node, Storable::Type_Unknown);
+        Totals t;
+        if (type == Storable::Type_Value) {
+            if (const auto it = references.constFind(node); it != references.constEnd()) {
+                const int target = types.value(*it);
+                if (target == Storable::Type_Element || target == Storable::Type_Project)
+                    t = self(self, *it);
+            } else {
+                t = own.value(node);
+            }
+        } else {
+            for (const int child : children.value(node)) {
+                const Totals c = self(self, child);
+                t.words += c.words;
+                t.characters += c.characters;
+                t.elements += c.elements;
+            }
+            if (type == Storable::Type_Element || type == Storable::Type_Project)
+                ++t.elements;
+        }
+
+        visiting.remove(node);
+        result.insert(node, t);
+        return t;
+    };
+
+    QSqlQuery clear{mDatabase};
+    if (!clear.exec("DELETE FROM `Aggregate`"))
+        return handleError(nullptr, "Aggregates::rebuild", clear), false;
+
+    for (auto it = types.cbegin(); it != types.cend(); ++it) {
+        const Totals t = total(total, it.key());
+        if (!write(it.key(), t))
+            return false;
+        publish(it.key(), t);
+    }
+
+    return true;
+}
+
+int Aggregates::countWords(const QString &text)
+{
+    int words = 0;
+    bool inWord = false;
+    for (const QChar c : text) {
+        const bool letter = !c.isSpace();
+        if (letter && !inWord)
+            ++words;
+        inWord = letter;
+    }
+    return words;
+}
+
+QSqlQuery &Aggregates::statement(const QString &sql)
+{
+    auto it = mStatements.find(sql);
+    if (it == mStatements.end()) {
+        it = mStatements.insert(sql, QSqlQuery{mDatabase});
+        it->setForwardOnly(true);
+        if (!it->prepare(sql))
+            handleError(nullptr, "Aggregates", *it);
+    }
+    return *it;
+}
+
+void Aggregates::publish(int node, const Totals &totals)
+{
+    if (Element *element = qobject_cast<Element *>(mStorage->loadedNode(node)))
+        element->setCounts(totals.words, totals.characters, totals.elements);
+}
@@ -0,0 +1,69 @@
+#ifndef LIBNOVELIST_AGGREGATES_H
+#define LIBNOVELIST_AGGREGATES_H
+
+#include <QHash>
+#include <QList>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include "errorhandler.h"
+
+class Storage;
+
+// Word, character and element counts of every value, field and element, kept in the Aggregate
+// table so that a chapter or a project knows its totals without loading what is below it.
+//
+// A value counts the words and characters of its text, or holds the totals of the element it
+// refers to; a field sums its values, an element its fields plus one for itself. The storages
+// call update() for the node whose text or links they wrote: it recomputes that node from its
+// children and walks up through Field_values, Element_fields and the node values that refer to
+// an element, recomputing each parent from its children until the totals stop changing. The
+// parents are found through the reverse indexes, so an edit costs the siblings along one path.
+//
+// Loaded elements get their new totals as they change. rebuild() recomputes everything, after a
+// sync or a migration, or when the table can't be trusted.
+class Aggregates : public ErrorHandler
+{
+public:
+    struct Totals
+    {
+        int words = 0;
+        int characters = 0;
+        int elements = 0;
+
+        bool operator==(const Totals&) const = default;
+    };
+
+    explicit Aggregates(Storage* storage)
+        : mStorage{storage}
+    {}
+
+    void setDatabase(const QSqlDatabase& database);
+    bool createSchema();
+
+    [[nodiscard]] Totals totals(int node);
+
+    bool update(int node);
+    // The parents of node, for the callers that are about to delete it.
+    [[nodiscard]] QList<int> parents(int node);
+    bool rebuild();
+
+    [[nodiscard]] static int countWords(const QString& text);
+
+private:
+    static constexpr int MaxDepth = 64;
+
+    bool refresh(int node, int depth, bool force);
+    bool compute(int node, int type, Totals* totals);
+    bool write(int node, const Totals& totals);
+    [[nodiscard]] int type(int node);
+    [[nodiscard]] QList<int> parents(int node, int type);
+    [[nodiscard]] QSqlQuery& statement(const QString& sql);
+    void publish(int node, const Totals& totals);
+
+    Storage* mStorage = nullptr;
+    QSqlDatabase mDatabase;
+    QHash<QString, QSqlQuery> mStatements;
+};
+
+#endif // LIBNOVELIST_AGGREGATES_H
@@ -0,0 +1,197 @@
+#include "backupservice.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+void BackupWorker::copy(const QString &source, const QString &destination)
+{
+    // one connection at a time per worker, removed before the next copy
+    const QString name = QStringLiteral("BackupWorker-%1").arg(quintptr(this), 0, 16);
+
+    const QString error = [&]() -> QString {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", name);
+        database.setDatabaseName(source);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (*mCancelled)
+            return QStringLiteral("cancelled");
+        if (!database.open())
+            return database.lastError().text();
+
+        // the target is an expression, so it is bound rather than quoted
+        QSqlQuery query{database};
+        if (!query.prepare("VACUUM INTO ?"))
+            return query.lastError().text();
+        query.addBindValue(destination);
+        if (!query.exec())
+            return query.lastError().text();
+        return *mCancelled ? QStringLiteral("cancelled") : QString{};
+    }();
+    QSqlDatabase::removeDatabase(name);
+
+    emit finished(error.isEmpty(), destination, error);
+}
+
+BackupService::BackupService(QObject *parent)
+    : QObject{parent}
+{
+    auto *worker = new BackupWorker{&mCancelled};
+    worker->moveToThread(&mThread);
+
+    connect(&mThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(this, &BackupService::copyRequested, worker, &BackupWorker::copy);
+    connect(worker, &BackupWorker::finished, this, &BackupService::handleFinished);
+
+    connect(&mTimer, &QTimer::timeout, this, [this]() {
+        if (mRunning || mDatabaseName.isEmpty())
+            return;
+        mPeriodic = start(mDatabaseName, nextFileName(), false);
+    });
+
+    mThread.setObjectName("backup");
+    mThread.start(QThread::LowPriority);
+}
+
+BackupService::~BackupService()
+{
+    mCancelled = true;
+    mThread.quit();
+    mThread.wait();
+}
+
+void BackupService::setDatabaseName(const QString &databaseName)
+{
+    if (mDatabaseName == databaseName)
+        return;
+    mDatabaseName = databaseName;
+    emit databaseNameChanged(QPrivateSignal{});
+}
+
+void BackupService::setDirectory(const QString &directory)
+{
+    if (mDirectory == directory)
+        return;
+    mDirectory = directory;
+    emit directoryChanged(QPrivateSignal{});
+}
+
+void BackupService::setInterval(int interval)
+{
+    if (mInterval == interval)
+        return;
+    mInterval = interval;
+
+    if (mInterval > 0)
+        mTimer.start(mInterval * 60 * 1000);
+    else
+        mTimer.stop();
+
+    emit intervalChanged(QPrivateSignal{});
+}
+
+void BackupService::setKeep(int keep)
+{
+    if (mKeep == keep)
+        return;
+    mKeep = keep;
+    emit keepChanged(QPrivateSignal{});
+}
+
+bool BackupService::backup(const QString &fileName)
+{
+    if (mDatabaseName.isEmpty())
+        return false;
+    mPeriodic = false;
+    return start(mDatabaseName, fileName.isEmpty() ? nextFileName() : fileName, false);
+}
+
+bool BackupService::restore(const QString &fileName)
+{
+    if (mDatabaseName.isEmpty() || !QFileInfo::exists(fileName))
+        return false;
+    mPeriodic = false;
+    return start(fileName, mDatabaseName, true);
+}
+
+QString BackupService::nextFileName() const
+{
+    const QFileInfo info{mDatabaseName};
+    const QDir dir{mDirectory.isEmpty() ? info.absolutePath() : mDirectory};
+    return dir.filePath(QStringLiteral("%1-backup-%2.sqlite")
+                            .arg(info.completeBaseName(),
+                                 QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss")));
+}
+
+bool BackupService::start(const QString &source, const QString &destination, bool restoring)
+{
+    if (mRunning)
+        return false;
+
+    mTarget = destination;
+    mRestoring = restoring;
+    mCancelled = false;
+    mProgress = 0;
+    emit progressChanged(QPrivateSignal{});
+    setRunning(true);
+
+    // written beside the target and renamed when complete
+    const QString partial = destination + QStringLiteral(".part");
+    QFile::remove(partial);
+    emit copyRequested(source, partial, QPrivateSignal{});
+
+    return true;
+}
+
+void BackupService::handleFinished(bool ok, const QString &destination, const QString &error)
+{
+    QString message = error;
+    if (ok) {
+        QFile::remove(mTarget);
+        if (!QFile::rename(destination, mTarget)) {
+            ok = false;
+            message = QStringLiteral("could not rename %1").arg(destination);
+        }
+    }
+    if (!ok)
+        QFile::remove(destination);
+
+    mProgress = ok ? 1 : 0;
+    emit progressChanged(QPrivateSignal{});
+    setRunning(false);
+
+    if (mRestoring) {
+        emit restored(ok, mTarget, message, QPrivateSignal{});
+    } else {
+        if (ok && mPeriodic)
+            removeOldBackups();
+        emit backedUp(ok, mTarget, message, QPrivateSignal{});
+    }
+}
+
+void BackupService::removeOldBackups()
+{
+    if (mKeep <= 0)
+        return;
+
+    const QFileInfo info{mDatabaseName};
+    QDir dir{mDirectory.isEmpty() ? info.absolutePath() : mDirectory};
+
+    // the timestamps in the names sort oldest first
+    const QStringList backups = dir.entryList({info.completeBaseName() + "-backup-*.sqlite"},
+                                              QDir::Files,
+                                              QDir::Name);
+    for (qsizetype i = 0; i < backups.size() - mKeep; ++i)
+        dir.remove(backups[i]);
+}
+
+void BackupService::setRunning(bool running)
+{
+    if (mRunning == running)
+        return;
+    mRunning = running;
+    emit runningChanged(QPrivateSignal{});
+}
@@ -0,0 +1,117 @@
+#ifndef LIBNOVELIST_BACKUPSERVICE_H
+#define LIBNOVELIST_BACKUPSERVICE_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <qqmlintegration.h>
+
+#include <atomic>
+
+// Copies the database on a worker thread with a QSQLITE connection of its own, so the copy goes
+// through the same SQLite library, and the same file locks, as the editor's connection. The copy
+// is one VACUUM INTO, a consistent snapshot of the file; the editor keeps its connection and can
+// read during a backup, its writes wait for the copy within the driver's busy timeout.
+class BackupWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BackupWorker(std::atomic_bool* cancelled)
+        : mCancelled{cancelled}
+    {}
+
+public slots:
+    void copy(const QString& source, const QString& destination);
+
+signals:
+    void finished(bool ok, const QString& destination, const QString& error);
+
+private:
+    std::atomic_bool* mCancelled = nullptr;
+};
+
+// Periodic and on-demand backups of a project database, and restoring one. Backups are written
+// next to their final name and renamed once complete, so a backup file is never half written.
+class BackupService : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("BackupService is owned by Storage")
+
+public:
+    explicit BackupService(QObject* parent = nullptr);
+    ~BackupService() override;
+
+    [[nodiscard]] QString databaseName() const { return mDatabaseName; }
+    void setDatabaseName(const QString& databaseName);
+
+    // Where the periodic backups go, next to the database when empty.
+    [[nodiscard]] QString directory() const { return mDirectory; }
+    void setDirectory(const QString& directory);
+
+    // Minutes between periodic backups, 0 turns them off.
+    [[nodiscard]] int interval() const { return mInterval; }
+    void setInterval(int interval);
+
+    // How many periodic backups are kept, the oldest are removed.
+    [[nodiscard]] int keep() const { return mKeep; }
+    void setKeep(int keep);
+
+    [[nodiscard]] bool isRunning() const { return mRunning; }
+    // 0 while a copy runs, 1 once it is complete; the copy is one statement.
+    [[nodiscard]] double progress() const { return mProgress; }
+
+    // Starts copying the database to fileName, returns false if a copy is already running.
+    Q_INVOKABLE bool backup(const QString& fileName = {});
+    // Starts copying fileName over the database. The database has to be closed until
+    // restored() is emitted, Storage::restoreBackup() takes care of that.
+    Q_INVOKABLE bool restore(const QString& fileName);
+    // A copy that has started runs to its end, then is thrown away.
+    Q_INVOKABLE void cancel() { mCancelled = true; }
+
+    [[nodiscard]] QString nextFileName() const;
+
+signals:
+    void databaseNameChanged(QPrivateSignal);
+    void directoryChanged(QPrivateSignal);
+    void intervalChanged(QPrivateSignal);
+    void keepChanged(QPrivateSignal);
+    void runningChanged(QPrivateSignal);
+    void progressChanged(QPrivateSignal);
+
+    void backedUp(bool ok, const QString& fileName, const QString& error, QPrivateSignal);
+    void restored(bool ok, const QString& fileName, const QString& error, QPrivateSignal);
+
+    void copyRequested(const QString& source, const QString& destination, QPrivateSignal);
+
+private:
+    bool start(const QString& source, const QString& destination, bool restoring);
+    void handleFinished(bool ok, const QString& destination, const QString& error);
+    void removeOldBackups();
+    void setRunning(bool running);
+
+    QThread mThread;
+    QTimer mTimer;
+    std::atomic_bool mCancelled = false;
+
+    QString mDatabaseName;
+    QString mDirectory;
+    QString mTarget;
+    int mInterval = 0;
+    int mKeep = 5;
+    bool mRunning = false;
+    bool mRestoring = false;
+    bool mPeriodic = false;
+    double mProgress = 0;
+
+    Q_PROPERTY(QString databaseName READ databaseName WRITE setDatabaseName NOTIFY
+                   databaseNameChanged FINAL)
+    Q_PROPERTY(QString directory READ directory WRITE setDirectory NOTIFY directoryChanged FINAL)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged FINAL)
+    Q_PROPERTY(int keep READ keep WRITE setKeep NOTIFY keepChanged FINAL)
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged FINAL)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged FINAL)
+};
+
+#endif // LIBNOVELIST_BACKUPSERVICE_H
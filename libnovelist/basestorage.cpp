@@ -1,6 +1,8 @@
 #include "basestorage.h"
 #include "storage.h"
 
+#include <QElapsedTimer>
+
 BaseStorage::BaseStorage(Storage *parent)
     : QObject{parent}
 {}
@@ -10,33 +12,194 @@ Storage *BaseStorage::storage() const
     return qobject_cast<Storage *>(parent());
 }
 
+bool BaseStorage::isReadOnly() const
+{
+    Storage *s = storage();
+    return s && s->isReadOnly();
+}
+
+bool BaseStorage::needsSchema() const
+{
+    Storage *s = storage();
+    return !s || s->schemaVersion() != SchemaMigrator::CurrentVersion;
+}
+
+PreparedQuery BaseStorage::lazyQuery(const QString &queryString, bool forwardOnly)
+{
+    Storage *s = storage();
+    return PreparedQuery{mDatabase, queryString, forwardOnly, s ? &s->prepareStats() : nullptr};
+}
+
+QSqlQuery &PreparedQuery::query()
+{
+    if (!mPrepared) {
+        QElapsedTimer timer;
+        timer.start();
+
+        mQuery = QSqlQuery{mDatabase};
+        mQuery.prepare(mQueryString);
+        mQuery.setForwardOnly(mForwardOnly);
+        mPrepared = true;
+
+        if (mStats) {
+            ++mStats->prepared;
+            mStats->nsecs += timer.nsecsElapsed();
+        }
+    }
+    return mQuery;
+}
+
 Transaction::Transaction(Mode mode, Node *node, Storage *storage)
     : db(storage->database())
     , node(node)
     , depth(storage->transactionDepth())
-    , owner(depth++ == 0)
+    , failed(storage->transactionFailed())
+    , level(depth++)
     , mode(mode)
 {
-    if (owner) {
-        if (mode & Write)
-            db.transaction();
-        if (node) {
-            (mode & Read) ? node->setLoading(true) : node->setSaving(true);
+    if (mode & Write) {
+        if (level == 0) {
+            failed = false;
+            active = db.transaction();
+            if (!active)
+                handleError(nullptr, "Transaction", db.lastError().text());
+        } else {
+            // without its savepoint the scope's work can't be told from the outer one's
+            active = exec(QStringLiteral("SAVEPOINT %1").arg(savepoint()));
+            if (!active)
+                failed = true;
+        }
+    }
+
+    if (node) {
+        wasBusy = (mode & Read) ? node->isLoading() : node->isSaving();
+        (mode & Read) ? node->setLoading(true) : node->setSaving(true);
+    }
+}
+
+bool Transaction::commit()
+{
+    if (done)
+        return true;
+
+    bool committed = true;
+    if (mode & Write) {
+        if (level > 0) {
+            committed = active && exec(QStringLiteral("RELEASE %1").arg(savepoint()));
+            if (!committed)
+                failed = true;
+        } else if (failed) {
+            handleError(nullptr, "Transaction", "a nested scope failed, rolling back");
+            if (active)
+                db.rollback();
+            committed = false;
+        } else if (active && !db.commit()) {
+            handleError(nullptr, "Transaction", db.lastError().text());
+            db.rollback();
+            committed = false;
+        }
+    }
+
+    finish();
+
+    if (committed && node && (mode & Modified))
+        node->setModified(false);
+
+    return committed;
+}
+
+void Transaction::rollback()
+{
+    if (done)
+        return;
+
+    if (active) {
+        if (level == 0) {
+            db.rollback();
+        } else {
+            // ROLLBACK TO keeps the savepoint open, RELEASE then drops it with nothing in it
+            if (!exec(QStringLiteral("ROLLBACK TO %1").arg(savepoint()))
+                || !exec(QStringLiteral("RELEASE %1").arg(savepoint())))
+                failed = true;
         }
     }
+
+    finish();
+}
+
+bool Transaction::exec(const QString &statement)
+{
+    QSqlQuery query{db};
+    if (!query.exec(statement))
+        return handleError(nullptr, "Transaction", query), false;
+    return true;
 }
 
-void Transaction::commit()
+void Transaction::finish()
 {
-    if (owner && !done) {
-        if (mode & Write)
-            db.commit();
-        done = true;
-        depth = 0;
+    done = true;
+    --depth;
+
+    // an outer scope on the same node keeps it loading or saving
+    if (node)
+        (mode & Read) ? node->setLoading(wasBusy) : node->setSaving(wasBusy);
+}
+
+void BaseTypeStorage::rebuildCatalog()
+{
+    QList<NodeType *> nodeTypes;
+    nodeTypes.reserve(mNodes.size());
+    for (Node *node : std::as_const(mNodes)) {
+        NodeType *nodeType = qobject_cast<NodeType *>(node);
+        if (!nodeType || mCache.contains(node))
+            continue;
+        nodeTypes.append(nodeType);
+        // the snapshot holds the names, so a rename needs a new one
+        connect(nodeType,
+                &Node::nameChanged,
+                this,
+                &BaseTypeStorage::rebuildCatalog,
+                Qt::UniqueConnection);
     }
-    if (done && node) {
-        (mode & Read) ? node->setLoading(false) : node->setSaving(false);
-        if (mode & Modified)
-            node->setModified(false);
+
+    mCatalog = TypeCatalog::Pointer{new TypeCatalog{nodeTypes}};
+}
+
+bool BaseTypeStorage::loadTypeTable(const QString &table, int type)
+{
+    QSqlQuery query = createQuery(
+        QStringLiteral(
+            "SELECT "
+            "s.`id` AS `id`,s.`type` AS `type`,s.`version` AS `version`,s.`createdAt` AS "
+            "`createdAt`,s.`createdBy` AS `createdBy`,s.`updatedAt` AS `updatedAt`,s.`updatedBy` "
+            "AS `updatedBy`,n.`nodeType` AS `nodeType`,n.`name` AS `name`,n.`label` AS "
+            "`label`,n.`info` AS `info`,n.`icon` AS `icon`,t.* FROM `%1` t JOIN `Storable` s ON "
+            "s.`id`=t.`id` JOIN `Node` n ON n.`id`=t.`id` WHERE s.`type`=:type ORDER BY s.`id`")
+            .arg(table),
+        true);
+
+    if (!executeQuery(query, QVariantMap{{":type", type}}))
+        return handleError(this, "loadTypeTable", query), false;
+
+    while (query.next()) {
+        const int rowid = query.value("id").toInt();
+        if (mNodesByRowid.contains(rowid))
+            continue;
+
+        Node *n = node();
+        if (!n)
+            return handleError(this, "loadTypeTable", "could not create node"), false;
+
+        Transaction tx{Transaction::ReadModified, n, storage()};
+
+        storage()->nodeStorage()->readNode(n, query);
+        readType(n, query);
+        mNodesByRowid.insert(rowid, n);
+
+        tx.commit();
+
+        emitNodeLoaded(n);
     }
+
+    return true;
 }
@@ -9,17 +9,26 @@
 
 #include "errorhandler.h"
 #include "node.h"
+#include "typecatalog.h"
 
 class Storage;
 
-class Transaction
+// A unit of work on the database. The outermost scope is a transaction, the scopes nested in it
+// are savepoints, so a nested scope that fails rolls back its own work and leaves the outer one
+// to decide. A scope that is neither committed nor rolled back rolls back when it ends.
+// A savepoint that can't be opened or released fails the whole transaction: commit() of every
+// scope from there on returns false and the outermost one rolls back instead.
+class Transaction : public ErrorHandler
 {
 protected:
     QSqlDatabase db;
     Node* node;
     int& depth;
-    bool owner = false;
+    bool& failed;
+    int level = 0;
+    bool active = false;
     bool done = false;
+    bool wasBusy = false;
     int mode;
 
 public:
@@ -32,24 +41,62 @@ public:
     };
 
     Transaction(Mode mode, Node* node, Storage* storage);
-    void commit();
-    void rollback()
-    {
-        if (owner && !done) {
-            if (mode & Write)
-                db.rollback();
-            done = true;
-            depth = 0;
-        }
-    }
-    ~Transaction()
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+    ~Transaction() { rollback(); }
+
+    [[nodiscard]] bool isOutermost() const { return level == 0; }
+
+    // False if the work is not kept, the scope is closed either way.
+    bool commit();
+    void rollback();
+
+private:
+    [[nodiscard]] QString savepoint() const { return QStringLiteral("tx%1").arg(level); }
+    bool exec(const QString& statement);
+    void finish();
+};
+
+// Counts the statements of the storages and the time spent preparing them.
+struct PrepareStats
+{
+    int statements = 0;
+    int prepared = 0;
+    qint64 nsecs = 0;
+};
+
+// A statement that is prepared on its first use instead of when the database is set, most of
+// them are not needed until the user edits something. Used like the QSqlQuery it holds.
+class PreparedQuery
+{
+public:
+    PreparedQuery() = default;
+    PreparedQuery(const QSqlDatabase& database,
+                  const QString& queryString,
+                  bool forwardOnly = false,
+                  PrepareStats* stats = nullptr)
+        : mDatabase{database}
+        , mQueryString{queryString}
+        , mForwardOnly{forwardOnly}
+        , mStats{stats}
     {
-        if (owner && !done) {
-            if (mode & Write)
-                db.rollback();
-            depth = 0;
-        }
+        if (mStats)
+            ++mStats->statements;
     }
+
+    [[nodiscard]] bool isPrepared() const { return mPrepared; }
+
+    QSqlQuery& query();
+    QSqlQuery* operator->() { return &query(); }
+    operator QSqlQuery&() { return query(); }
+
+private:
+    QSqlDatabase mDatabase;
+    QString mQueryString;
+    QSqlQuery mQuery;
+    bool mForwardOnly = false;
+    bool mPrepared = false;
+    PrepareStats* mStats = nullptr;
 };
 
 class BaseStorage : public QObject, public ErrorHandler
@@ -66,6 +113,15 @@ public:
     [[nodiscard]] QSqlDatabase database() const { return mDatabase; }
     virtual void setDatabase(const QSqlDatabase& database) = 0;
 
+    // While a snapshot is open, see Storage::openSnapshot(): nodes are neither loaded, created,
+    // saved nor removed, the project is read through the snapshot.
+    [[nodiscard]] bool isReadOnly() const;
+
+    // The node with rowid if it is loaded, without loading it.
+    [[nodiscard]] Node* loadedNode(int rowid) const { return mNodesByRowid.value(rowid); }
+    // The rowids of the loaded nodes.
+    [[nodiscard]] QList<int> loadedRowids() const { return mNodesByRowid.keys(); }
+
 signals:
     void nodeCreated(Node* node, QPrivateSignal);
     void nodeRecycled(Node* node, QPrivateSignal);
@@ -89,6 +145,8 @@ protected:
 
     [[nodiscard]] Node* node()
     {
+        if (isReadOnly())
+            return handleError(this, "node", "storage is read-only"), nullptr;
         if (Node* e = reviveNode())
             return e;
         if (Node* n = createNode()) {
@@ -96,6 +154,13 @@ protected:
         }
         return nullptr;
     }
+    // A node that is new and not the revived one node() might give, for the create functions.
+    [[nodiscard]] Node* newNode()
+    {
+        if (isReadOnly())
+            return handleError(this, "newNode", "storage is read-only"), nullptr;
+        return createNode();
+    }
     [[nodiscard]] Node* node(int rowid)
     {
         if (Node* e = mNodesByRowid.value(rowid))
@@ -133,6 +198,8 @@ protected:
     {
         if (!node)
             return false;
+        if (isReadOnly())
+            return handleError(this, "saveNode", "storage is read-only"), false;
         if (!node->isModified())
             return true;
         return newVersion || node->rowid() <= 0 ? insertNode(node) : updateNode(node);
@@ -153,6 +220,11 @@ protected:
         return n;
     }
 
+    // False when the file already carries the current schema, which setDatabase() then
+    // doesn't create again.
+    [[nodiscard]] bool needsSchema() const;
+    [[nodiscard]] PreparedQuery lazyQuery(const QString& queryString, bool forwardOnly = false);
+
     QSqlQuery createQuery(const QString& queryString, bool forwardOnly = false)
     {
         QSqlQuery query{mDatabase};
@@ -185,6 +257,20 @@ protected:
             query.bindValue(it.key(), it.value());
         return executeQuery(query);
     }
+    // Runs query once per row of values, which map each placeholder to a list of equal length.
+    bool executeBatch(QSqlQuery& query, const QVariantMap& values)
+    {
+        query.finish();
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it)
+            query.bindValue(it.key(), it.value());
+        if (!query.execBatch()) {
+            handleError({query.lastQuery(),
+                         query.lastError().driverText(),
+                         query.lastError().databaseText()});
+            return false;
+        }
+        return true;
+    }
     bool executeQuery(const QString& queryString)
     {
         QSqlQuery query{mDatabase};
@@ -205,6 +291,7 @@ protected:
     }
 
     void emitDatabaseChanged() { emit databaseChanged(QPrivateSignal{}); }
+    void emitNodeLoaded(Node* node) { emit nodeLoaded(node, QPrivateSignal{}); }
 
     template<typename T>
     QString itemsToString(const QList<T*>& items)
@@ -252,15 +339,46 @@ class BaseTypeStorage : public BaseStorage
 public:
     explicit BaseTypeStorage(Storage* parent = nullptr)
         : BaseStorage{parent}
+        , mCatalog{new TypeCatalog}
     {}
 
     [[nodiscard]] Q_INVOKABLE NodeType* nodeType(const QString& name)
     {
-        return mNodesByName.value(name);
+        return mCatalog->nodeType(name);
     }
 
+    [[nodiscard]] TypeCatalog::Pointer catalog() const { return mCatalog; }
+
 protected:
-    QHash<QString, NodeType*> mNodesByName;
+    TypeCatalog::Pointer mCatalog;
+
+    // Replaces the catalog by a snapshot of the current types.
+    void rebuildCatalog();
+
+    // Loads every type of table with one query, instead of a reloadNode() per type. Only rows
+    // whose Storable type is type are loaded, the tables of derived types share ids.
+    bool loadTypeTable(const QString& table, int type);
+    // Reads the columns of table other than id, for loadTypeTable().
+    virtual void readType(Node* node, const QSqlQuery& query)
+    {
+        Q_UNUSED(node);
+        Q_UNUSED(query);
+    }
+
+    [[nodiscard]] Node* loadNode(int rowid) override
+    {
+        Node* n = BaseStorage::loadNode(rowid);
+        if (n && mCatalog->id(rowid) < 0)
+            rebuildCatalog();
+        return n;
+    }
+    bool recycleNode(Node* node) override
+    {
+        if (!BaseStorage::recycleNode(node))
+            return false;
+        rebuildCatalog();
+        return true;
+    }
 
     template<typename T>
     static QList<T*> toDerived(const QList<Node*>& nodes)
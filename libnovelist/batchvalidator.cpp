@@ -0,0 +1,263 @@
+#include "batchvalidator.h"
+#include "storage.h"
+#include "textcodec.h"
+#include "validator.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <atomic>
+
+namespace {
+
+// a connection per run, a reader never shares one with the GUI thread or another reader
+QString connectionName()
+{
+    static std::atomic_int runs = 0;
+    return QStringLiteral("BatchValidator-%1").arg(++runs);
+}
+
+} // namespace
+
+BatchValidator::BatchValidator(QObject *parent)
+    : QObject{parent}
+{
+    connect(&mWatcher,
+            &QFutureWatcher<Result>::finished,
+            this,
+            &BatchValidator::handleFinished);
+}
+
+BatchValidator::~BatchValidator()
+{
+    mWatcher.cancel();
+    mWatcher.waitForFinished();
+}
+
+void BatchValidator::setStorage(Storage *storage)
+{
+    if (mStorage == storage)
+        return;
+
+    // the rows of a running check belong to the old database
+    cancel();
+
+    mStorage = storage;
+    emit storageChanged(QPrivateSignal{});
+}
+
+bool BatchValidator::validateProject()
+{
+    if (!mStorage)
+        return handleError(this, "validateProject", "storage is null"), false;
+    return run(mStorage->fieldTypeStorage()->allFieldTypes());
+}
+
+bool BatchValidator::validateFieldType(FieldType *fieldType)
+{
+    if (!fieldType)
+        return handleError(this, "validateFieldType", "fieldType is null"), false;
+    return run({fieldType});
+}
+
+void BatchValidator::cancel()
+{
+    if (mWatcher.isRunning())
+        mWatcher.cancel();
+}
+
+QList<int> BatchValidator::invalidValues() const
+{
+    QList<int> values;
+    values.reserve(mDiagnostics.size());
+    for (const Diagnostic &diagnostic : mDiagnostics)
+        values.append(diagnostic.value);
+    return values;
+}
+
+QString BatchValidator::message(int value) const
+{
+    const auto it = mIndex.constFind(value);
+    return it == mIndex.constEnd() ? QString{} : mDiagnostics.at(*it).message;
+}
+
+bool BatchValidator::run(const QList<FieldType *> &fieldTypes)
+{
+    if (!mStorage || !mStorage->database().isOpen())
+        return handleError(this, "run", "database is not open"), false;
+
+    if (mWatcher.isRunning())
+        return handleError(this, "run", "a check is running"), false;
+
+    // compiled on this thread, the workers only read them
+    Validators validators;
+    QStringList ids;
+    for (FieldType *fieldType : fieldTypes) {
+        if (fieldType->rowid() <= 0)
+            continue;
+        if (auto validator = fieldType->compiledValidator()) {
+            validators.insert(fieldType->rowid(), validator);
+            ids.append(QString::number(fieldType->rowid()));
+        }
+    }
+
+    if (validators.isEmpty()) {
+        mDiagnostics.clear();
+        mIndex.clear();
+        mChecked = 0;
+        emit resultsChanged(QPrivateSignal{});
+        emit finished(0, 0, QPrivateSignal{});
+        return true;
+    }
+
+    mWatcher.setFuture(QtConcurrent::run(
+        [this, databaseName = mStorage->databaseName(), ids = ids.join(','), validators](
+            QPromise<Result> &promise) { read(promise, databaseName, ids, validators); }));
+
+    emit runningChanged(QPrivateSignal{});
+
+    return true;
+}
+
+void BatchValidator::handleFinished()
+{
+    emit runningChanged(QPrivateSignal{});
+
+    if (mWatcher.isCanceled() || mWatcher.future().resultCount() == 0)
+        return;
+
+    const Result result = mWatcher.result();
+    mDiagnostics = result.diagnostics;
+    mChecked = result.checked;
+
+    mIndex.clear();
+    mIndex.reserve(mDiagnostics.size());
+    for (qsizetype i = 0; i < mDiagnostics.size(); ++i)
+        mIndex.insert(mDiagnostics.at(i).value, i);
+
+    emit resultsChanged(QPrivateSignal{});
+    emit finished(mChecked, int(mDiagnostics.size()), QPrivateSignal{});
+}
+
+void BatchValidator::read(QPromise<Result> &promise,
+                          const QString &databaseName,
+                          const QString &fieldTypes,
+                          const Validators &validators)
+{
+    Result result;
+    QList<QFuture<QList<Diagnostic>>> checks;
+
+    const QString name = connectionName();
+    const bool ok = [&] {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", name);
+        database.setDatabaseName(databaseName);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (!database.open())
+            return handleError(nullptr, "BatchValidator::read", "could not open " + databaseName),
+                   false;
+
+        // the stored text, not the Value nodes: loading those would cost more than the checks
+        QSqlQuery query{database};
+        query.setForwardOnly(true);
+        if (!query.exec(QStringLiteral("SELECT fv.`value`,fv.`field`,f.`nodeType`,v.`valueType`,"
+                                       "v.`value` FROM `Field_values` fv "
+                                       "JOIN `Node` f ON f.`id`=fv.`field` "
+                                       "JOIN `Value` v ON v.`id`=fv.`value` "
+                                       "WHERE f.`nodeType` IN (%1)")
+                            .arg(fieldTypes)))
+            return handleError(nullptr, "BatchValidator::read", query), false;
+
+        Rows rows;
+        const auto submit = [&] {
+            if (!readText(database, rows))
+                return false;
+            checks.append(QtConcurrent::run(&BatchValidator::check, rows, validators));
+            result.checked += int(rows.size());
+            rows.clear();
+            return true;
+        };
+
+        // each chunk is checked while the next one is read
+        while (!promise.isCanceled() && query.next()) {
+            rows.append({query.value(0).toInt(),
+                         query.value(1).toInt(),
+                         query.value(2).toInt(),
+                         query.value(3).toInt(),
+                         query.value(4)});
+            if (rows.size() == ChunkSize && !submit())
+                return false;
+        }
+        if (promise.isCanceled())
+            return false;
+        if (query.lastError().isValid())
+            return handleError(nullptr, "BatchValidator::read", query), false;
+        return rows.isEmpty() || submit();
+    }();
+    QSqlDatabase::removeDatabase(name);
+
+    // in the order they were read; a check not started yet runs on this thread
+    for (auto &check : checks)
+        result.diagnostics.append(check.result());
+
+    if (ok)
+        promise.addResult(std::move(result));
+}
+
+bool BatchValidator::readText(const QSqlDatabase &database, Rows &rows)
+{
+    QStringList ids;
+    for (const Row &row : std::as_const(rows))
+        if (row.valueType == Value::Type_Text)
+            ids.append(QString::number(row.value));
+    if (ids.isEmpty())
+        return true;
+
+    QSqlQuery query{database};
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT `value`,`text`,`packed` FROM `ValueChunk` WHERE "
+                                   "`value` IN (%1) ORDER BY `value`,`index`")
+                        .arg(ids.join(','))))
+        return handleError(nullptr, "BatchValidator::readText", query), false;
+
+    QHash<int, QVariantList> parts;
+    while (query.next())
+        parts[query.value(0).toInt()].append(query.isNull(2) ? query.value(1) : query.value(2));
+
+    for (Row &row : rows)
+        if (row.valueType == Value::Type_Text)
+            row.stored = parts.value(row.value);
+    return true;
+}
+
+QList<BatchValidator::Diagnostic> BatchValidator::check(const Rows &rows,
+                                                        const Validators &validators)
+{
+    QList<Diagnostic> diagnostics;
+    QStringList messages;
+
+    for (const Row &row : rows) {
+        const novelist::Validator *validator = validators.value(row.fieldType).get();
+        if (!validator)
+            continue;
+
+        // as Value::setStoredValue() and setStoredText() have it after a reload
+        QVariant value = row.stored;
+        if (row.valueType == Value::Type_Text) {
+            QString text;
+            for (const QVariant &part : row.stored.toList())
+                text += part.typeId() == QMetaType::QByteArray
+                            ? TextCodec::unpack(part.toByteArray())
+                            : part.toString();
+            value = text;
+        } else if (Value::typeIdToType(value.typeId()) != row.valueType) {
+            const QMetaType target{Value::typeToTypeId(row.valueType)};
+            if (QMetaType::canConvert(value.metaType(), target))
+                value.convert(target);
+        }
+
+        messages.clear();
+        if (!validator->validate(value, &messages))
+            diagnostics.append({row.value, row.field, messages.join(' ')});
+    }
+
+    return diagnostics;
+}
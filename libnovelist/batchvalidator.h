@@ -0,0 +1,119 @@
+#ifndef LIBNOVELIST_BATCHVALIDATOR_H
+#define LIBNOVELIST_BATCHVALIDATOR_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QPromise>
+#include <QSharedPointer>
+#include <qqmlintegration.h>
+
+#include "errorhandler.h"
+
+namespace novelist {
+class Validator;
+}
+
+class FieldType;
+class Storage;
+
+Q_MOC_INCLUDE("fieldtype.h")
+Q_MOC_INCLUDE("storage.h")
+
+// Checks the stored values of fields against the validators of their field types, a whole
+// project or one field type at a time, without loading a single Value node.
+//
+// The validators are compiled on the calling thread; everything else runs on the global
+// QThreadPool. A reader task opens a connection of its own to the project file and hands the rows
+// on in chunks as it reads them, each checked by a task of its own with the field type's compiled
+// validator, which is const and shared by all of them. The reader sees what is committed, not the
+// changes of a transaction still open on the Storage's connection. Only the values that fail come
+// back, as Diagnostics, and only once the run is done; finished() is emitted then. A run can be
+// cancelled, its results are dropped, as are those of a run that could not read the values.
+class BatchValidator : public QObject, public ErrorHandler
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+public:
+    struct Diagnostic
+    {
+        int value = 0;
+        int field = 0;
+        QString message;
+    };
+
+    explicit BatchValidator(QObject *parent = nullptr);
+    ~BatchValidator() override;
+
+    [[nodiscard]] Storage *storage() const { return mStorage; }
+    void setStorage(Storage *storage);
+
+    [[nodiscard]] bool isRunning() const { return mWatcher.isRunning(); }
+    // Values checked and found invalid by the last run that finished.
+    [[nodiscard]] int checked() const { return mChecked; }
+    [[nodiscard]] int invalidCount() const { return int(mDiagnostics.size()); }
+    [[nodiscard]] QList<Diagnostic> diagnostics() const { return mDiagnostics; }
+
+    // Start a run, false if one is running or there is no database to read.
+    Q_INVOKABLE bool validateProject();
+    Q_INVOKABLE bool validateFieldType(FieldType *fieldType);
+    Q_INVOKABLE void cancel();
+
+    // The rowids of the invalid values, and what is wrong with one of them.
+    [[nodiscard]] Q_INVOKABLE QList<int> invalidValues() const;
+    [[nodiscard]] Q_INVOKABLE QString message(int value) const;
+
+    // Values per task; small enough to spread over the pool, large enough to not be all overhead.
+    static constexpr int ChunkSize = 4096;
+
+signals:
+    void storageChanged(QPrivateSignal);
+    void runningChanged(QPrivateSignal);
+    void resultsChanged(QPrivateSignal);
+    void finished(int checked, int invalid, QPrivateSignal);
+
+private:
+    struct Row
+    {
+        int value = 0;
+        int field = 0;
+        int fieldType = 0;
+        int valueType = 0;
+        // The value column, the parts of the chunks for long text, see readText().
+        QVariant stored;
+    };
+    using Rows = QList<Row>;
+    using Validators = QHash<int, QSharedPointer<const novelist::Validator>>;
+    struct Result
+    {
+        int checked = 0;
+        QList<Diagnostic> diagnostics;
+    };
+
+    bool run(const QList<FieldType *> &fieldTypes);
+    void handleFinished();
+
+    // The reader task; adds no result when cancelled or when the values could not be read.
+    void read(QPromise<Result> &promise,
+              const QString &databaseName,
+              const QString &fieldTypes,
+              const Validators &validators);
+    // Replaces the start of each long text in rows with the text and packed parts of its chunks,
+    // in order; check() unpacks and joins them.
+    bool readText(const QSqlDatabase &database, Rows &rows);
+    static QList<Diagnostic> check(const Rows &rows, const Validators &validators);
+
+    Storage *mStorage = nullptr;
+    QFutureWatcher<Result> mWatcher;
+    QList<Diagnostic> mDiagnostics;
+    QHash<int, qsizetype> mIndex;
+    int mChecked = 0;
+
+    Q_PROPERTY(Storage *storage READ storage WRITE setStorage NOTIFY storageChanged FINAL)
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged FINAL)
+    Q_PROPERTY(int checked READ checked NOTIFY resultsChanged FINAL)
+    Q_PROPERTY(int invalidCount READ invalidCount NOTIFY resultsChanged FINAL)
+};
+
+#endif // LIBNOVELIST_BATCHVALIDATOR_H
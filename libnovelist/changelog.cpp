@@ -0,0 +1,349 @@
+#include "changelog.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+namespace {
+
+constexpr quint32 Magic = 0x4e564353; // NVCS
+constexpr quint16 FormatVersion = 1;
+
+} // namespace
+
+const QList<ChangeLog::Table> ChangeLog::Tables = {
+    {"Storable", "id", false},
+    {"Node", "id", false},
+    {"NodeType", "id", false},
+    {"Element", "id", false},
+    {"ElementType", "id", false},
+    {"Field", "id", false},
+    {"FieldType", "id", false},
+    {"Value", "id", false},
+    {"ValueType", "id", false},
+    {"Project", "id", false},
+    {"ProjectType", "id", false},
+    {"Element_fields", "element", true},
+    {"Field_values", "field", true},
+    {"ValueChunk", "value", true},
+    {"Field_allowedTypes", "field", true},
+    {"FieldType_valueTypes", "fieldType", true},
+    {"FieldType_allowedTypes", "fieldType", true},
+    {"ElementType_fieldTypes", "elementType", true},
+};
+
+bool ChangeLog::createSchema()
+{
+    // `index` has no type: it holds the positions of the type links as well as the order keys of
+    // Element_fields, Field_values and ValueChunk, which INTEGER affinity would turn into numbers
+    QStringList statements = {"CREATE TABLE IF NOT EXISTS `ChangeLog` (\n"
+                              "  `seq`     INTEGER NOT NULL,\n"
+                              "  `table`   TEXT NOT NULL,\n"
+                              "  `key`     INTEGER NOT NULL,\n"
+                              "  `index`,\n"
+                              "  `version` INTEGER,\n"
+                              "  PRIMARY KEY(`seq`)\n"
+                              ")",
+                              "CREATE INDEX IF NOT EXISTS idx_ChangeLog_table ON "
+                              "`ChangeLog`(`table`,`seq`)"};
+
+    for (const Table &table : Tables) {
+        const QString name = QString::fromLatin1(table.name);
+
+        // a deleted Storable leaves its version, apply() weighs the delete by it
+        const auto log = [&](const QString &row, bool deleted) {
+            return QStringLiteral("INSERT INTO `ChangeLog` (`table`,`key`,`index`,`version`) "
+                                  "VALUES ('")
+                   + name + "'," + row + ".`" + table.key + "`,"
+                   + (table.link ? row + ".`index`" : QStringLiteral("NULL")) + ","
+                   + (deleted && name == "Storable" ? QStringLiteral("OLD.`version`")
+                                                    : QStringLiteral("NULL"))
+                   + ");";
+        };
+
+        const QString trigger = QStringLiteral("CREATE TRIGGER IF NOT EXISTS `ChangeLog_%1_%2` "
+                                               "AFTER %3 ON `%1` BEGIN %4 END");
+
+        // the key of a link row can change, then the old one is gone
+        statements.append(trigger.arg(name, "insert", "INSERT", log("NEW", false)));
+        statements.append(
+            trigger.arg(name,
+                        "update",
+                        "UPDATE",
+                        table.link ? log("OLD", false) + " " + log("NEW", false)
+                                   : log("NEW", false)));
+        statements.append(trigger.arg(name, "delete", "DELETE", log("OLD", true)));
+    }
+
+    for (const auto &statement : std::as_const(statements)) {
+        QSqlQuery query{mDatabase};
+        if (!query.exec(statement))
+            return handleError(nullptr, "ChangeLog::createSchema", query), false;
+    }
+
+    return true;
+}
+
+qint64 ChangeLog::version()
+{
+    QSqlQuery query{mDatabase};
+    if (!query.exec("SELECT IFNULL(MAX(`seq`),0) FROM `ChangeLog`") || !query.next())
+        return handleError(nullptr, "ChangeLog::version", query), 0;
+    return query.value(0).toLongLong();
+}
+
+QByteArray ChangeLog::changes(qint64 since)
+{
+    struct Section
+    {
+        QString name;
+        QStringList columns;
+        QList<QVariantList> upserts;
+        QList<QVariantList> deletes;
+    };
+    QList<Section> sections;
+
+    const qint64 until = version();
+
+    for (const Table &table : Tables) {
+        Section section{QString::fromLatin1(table.name), columns(table.name), {}, {}};
+        const qsizetype key = section.columns.indexOf(table.key);
+        if (key < 0)
+            continue;
+
+        // one row per key, whatever the number of times it changed
+        QSqlQuery query{mDatabase};
+        query.setForwardOnly(true);
+        query.prepare(QStringLiteral("SELECT c.`key`,c.`index`,c.`version`,t.* FROM (SELECT "
+                                     "`key`,`index`,`version`,MAX(`seq`) FROM `ChangeLog` WHERE "
+                                     "`table`=:table AND `seq`>:since AND `seq`<=:until GROUP BY "
+                                     "`key`,`index`) c LEFT JOIN `%1` t ON t.`%2`=c.`key`%3")
+                          .arg(section.name,
+                               table.key,
+                               table.link ? QStringLiteral(" AND t.`index`=c.`index`")
+                                          : QString{}));
+        query.bindValue(":table", section.name);
+        query.bindValue(":since", since);
+        query.bindValue(":until", until);
+        if (!query.exec())
+            return handleError(nullptr, "ChangeLog::changes", query), QByteArray{};
+
+        while (query.next()) {
+            if (query.isNull(3 + int(key))) {
+                section.deletes.append({query.value(0), query.value(1), query.value(2)});
+                continue;
+            }
+            QVariantList values;
+            values.reserve(section.columns.size());
+            for (int i = 0; i < section.columns.size(); ++i)
+                values.append(query.value(3 + i));
+            section.upserts.append(values);
+        }
+
+        if (!section.upserts.isEmpty() || !section.deletes.isEmpty())
+            sections.append(section);
+    }
+
+    QByteArray changeset;
+    QDataStream out{&changeset, QIODevice::WriteOnly};
+    out.setVersion(QDataStream::Qt_6_5);
+
+    out << Magic << FormatVersion << since << until << quint32(sections.size());
+    for (const Section &section : std::as_const(sections))
+        out << section.name << section.columns << section.upserts << section.deletes;
+
+    return changeset;
+}
+
+ChangeLog::Result ChangeLog::apply(const QByteArray &changeset, Resolution resolution)
+{
+    Result result;
+
+    QDataStream in{changeset};
+    in.setVersion(QDataStream::Qt_6_5);
+
+    quint32 magic = 0;
+    quint16 format = 0;
+    qint64 since = 0;
+    qint64 until = 0;
+    quint32 sectionCount = 0;
+    in >> magic >> format >> since >> until >> sectionCount;
+    if (in.status() != QDataStream::Ok || magic != Magic || format != FormatVersion)
+        return handleError("ChangeLog::apply: not a changeset"), result;
+
+    // the version of a local Storable, -1 if there is none, and when and by whom it was created
+    struct Local
+    {
+        int version = -1;
+        qint64 createdAt = 0;
+        QString createdBy;
+    };
+    QSqlQuery localRow{mDatabase};
+    localRow.prepare("SELECT `version`,`createdAt`,`createdBy` FROM `Storable` WHERE `id`=:id");
+    const auto localOf = [&](int id) {
+        localRow.bindValue(":id", id);
+        if (!localRow.exec() || !localRow.next())
+            return Local{};
+        const Local local{localRow.value(0).toInt(),
+                          localRow.value(1).toLongLong(),
+                          localRow.value(2).toString()};
+        localRow.finish();
+        return local;
+    };
+
+    // the rows of a Storable whose change was refused, or that needs none, stay as they are in
+    // every table
+    QSet<int> refused;
+
+    for (quint32 s = 0; s < sectionCount; ++s) {
+        QString name;
+        QStringList remoteColumns;
+        QList<QVariantList> upserts;
+        QList<QVariantList> deletes;
+        in >> name >> remoteColumns >> upserts >> deletes;
+        if (in.status() != QDataStream::Ok)
+            return handleError("ChangeLog::apply: changeset is truncated"), result;
+
+        const auto table = std::find_if(Tables.cbegin(), Tables.cend(), [&](const Table &t) {
+            return name == QLatin1String(t.name);
+        });
+        if (table == Tables.cend())
+            return handleError("ChangeLog::apply: unknown table " + name), result;
+
+        const bool storable = name == QLatin1String("Storable");
+        const qsizetype key = remoteColumns.indexOf(table->key);
+        const qsizetype version = remoteColumns.indexOf("version");
+        const qsizetype createdAt = remoteColumns.indexOf("createdAt");
+        const qsizetype createdBy = remoteColumns.indexOf("createdBy");
+        if (key < 0 || (storable && version < 0))
+            return handleError("ChangeLog::apply: " + name + " has no key"), result;
+
+        // a replica on another schema version only gets the columns both know
+        const QStringList localColumns = columns(name);
+        QList<qsizetype> shared;
+        QStringList names;
+        for (qsizetype i = 0; i < remoteColumns.size(); ++i)
+            if (localColumns.contains(remoteColumns[i])) {
+                shared.append(i);
+                names.append('`' + remoteColumns[i] + '`');
+            }
+
+        QSqlQuery upsert{mDatabase};
+        upsert.prepare(QStringLiteral("INSERT OR REPLACE INTO `%1` (%2) VALUES (%3)")
+                           .arg(name,
+                                names.join(','),
+                                QStringList(names.size(), QStringLiteral("?")).join(',')));
+
+        QSqlQuery remove{mDatabase};
+        remove.prepare(QStringLiteral("DELETE FROM `%1` WHERE `%2`=?%3")
+                           .arg(name,
+                                table->key,
+                                table->link ? QStringLiteral(" AND `index`=?") : QString{}));
+
+        for (const QVariantList &values : std::as_const(upserts)) {
+            const int id = values.value(key).toInt();
+
+            if (storable) {
+                const Local local = localOf(id);
+                const int remote = values.value(version).toInt();
+                // both replicas gave the next free id to a Storable of their own, their versions
+                // say nothing about which is newer
+                const bool clash = local.version >= 0 && createdAt >= 0 && createdBy >= 0
+                                   && (values.value(createdAt).toLongLong() != local.createdAt
+                                       || values.value(createdBy).toString() != local.createdBy);
+                if (clash) {
+                    ++result.conflicts;
+                    handleError(QStringLiteral("ChangeLog::apply: %1 was created on both "
+                                               "replicas")
+                                    .arg(id));
+                    if (resolution != KeepRemote) {
+                        refused.insert(id);
+                        continue;
+                    }
+                } else if (local.version == remote) {
+                    refused.insert(id);
+                    continue;
+                } else if (local.version >= 0) {
+                    ++result.conflicts;
+                    if (!accept(local.version, remote, resolution)) {
+                        refused.insert(id);
+                        continue;
+                    }
+                }
+            } else if (refused.contains(id)) {
+                continue;
+            }
+
+            for (const qsizetype i : std::as_const(shared))
+                upsert.addBindValue(values.value(i));
+            if (!upsert.exec())
+                return handleError(nullptr, "ChangeLog::apply", upsert), result;
+
+            ++result.applied;
+            result.changed.insert(id);
+        }
+
+        for (const QVariantList &removed : std::as_const(deletes)) {
+            const int id = removed.value(0).toInt();
+
+            if (storable) {
+                const int local = localOf(id).version;
+                if (local < 0)
+                    continue;
+                if (local != removed.value(2).toInt()) {
+                    ++result.conflicts;
+                    if (!accept(local, removed.value(2).toInt(), resolution)) {
+                        refused.insert(id);
+                        continue;
+                    }
+                }
+            } else if (refused.contains(id)) {
+                continue;
+            }
+
+            remove.addBindValue(id);
+            if (table->link)
+                remove.addBindValue(removed.value(1));
+            if (!remove.exec())
+                return handleError(nullptr, "ChangeLog::apply", remove), result;
+
+            ++result.applied;
+            (table->link ? result.changed : result.removed).insert(id);
+        }
+
+        if (name.endsWith(QLatin1String("Type")) || name.startsWith(QLatin1String("FieldType_"))
+            || name.startsWith(QLatin1String("ElementType_")))
+            result.typesChanged = true;
+    }
+
+    for (const int id : std::as_const(result.removed))
+        result.changed.remove(id);
+
+    result.ok = true;
+    return result;
+}
+
+QStringList ChangeLog::columns(const QString &table)
+{
+    QSqlQuery query{mDatabase};
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("PRAGMA table_info(`%1`)").arg(table)))
+        return handleError(nullptr, "ChangeLog::columns", query), QStringList{};
+
+    QStringList result;
+    while (query.next())
+        result.append(query.value("name").toString());
+    return result;
+}
+
+bool ChangeLog::accept(int localVersion, int remoteVersion, Resolution resolution) const
+{
+    switch (resolution) {
+    case KeepNewer:
+        return remoteVersion > localVersion;
+    case KeepLocal:
+        return false;
+    case KeepRemote:
+        return true;
+    }
+    return false;
+}
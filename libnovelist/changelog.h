@@ -0,0 +1,77 @@
+#ifndef LIBNOVELIST_CHANGELOG_H
+#define LIBNOVELIST_CHANGELOG_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+#include <QSqlDatabase>
+
+#include "errorhandler.h"
+
+// Records which rows of the novelist tables change, so that a replica can be brought up to date
+// with the rows changed since the last sync instead of a copy of the whole file.
+//
+// Triggers append the key of every inserted, updated or deleted row to the ChangeLog table, whose
+// seq is the change version of the file. changes() turns the keys logged after a version into a
+// changeset: the current state of each row that still exists and the key of each that doesn't,
+// so a row edited a hundred times is sent once. apply() writes a changeset into another file,
+// deciding conflicts by the version of the Storable rows. The rows that depend on a Storable,
+// its Node row, links and chunks, follow its decision.
+//
+// Applied changes are logged like local ones, so they pass on to replicas further down a chain;
+// sending them back is harmless, the versions are equal and nothing is written.
+//
+// Replicas give out ids on their own, so two of them can create different Storables under one
+// id. apply() tells them apart by createdAt and createdBy, and keeps the local one unless the
+// resolution is KeepRemote; either way it counts as a conflict.
+class ChangeLog : public ErrorHandler
+{
+public:
+    // What apply() does with a row whose local Storable version differs from the remote one, or
+    // that is another Storable under the same id.
+    enum Resolution {
+        KeepNewer,  // the higher version wins, the local row on a tie
+        KeepLocal,  // local rows that differ stay
+        KeepRemote, // the changeset wins
+    };
+
+    struct Result
+    {
+        bool ok = false;
+        int applied = 0;
+        int conflicts = 0;
+        QSet<int> changed;
+        QSet<int> removed;
+        bool typesChanged = false;
+    };
+
+    explicit ChangeLog(const QSqlDatabase& database)
+        : mDatabase{database}
+    {}
+
+    bool createSchema();
+
+    // The seq of the last logged change, 0 when there is none.
+    [[nodiscard]] qint64 version();
+    [[nodiscard]] QByteArray changes(qint64 since);
+    // Has to run inside a transaction, a failed apply() leaves rows half written.
+    [[nodiscard]] Result apply(const QByteArray& changeset, Resolution resolution = KeepNewer);
+
+    // The tables that hold a project, in an order that inserts owners before their links.
+    struct Table
+    {
+        const char* name;
+        const char* key;
+        bool link;
+    };
+    static const QList<Table> Tables;
+
+    [[nodiscard]] QStringList columns(const QString& table);
+
+private:
+    [[nodiscard]] bool accept(int localVersion, int remoteVersion, Resolution resolution) const;
+
+    QSqlDatabase mDatabase;
+};
+
+#endif // LIBNOVELIST_CHANGELOG_H
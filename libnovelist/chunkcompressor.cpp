@@ -0,0 +1,155 @@
+#include "chunkcompressor.h"
+#include "storage.h"
+#include "textcodec.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+ChunkCompressor::ChunkCompressor(QObject *parent)
+    : QObject{parent}
+{
+    connect(&mWatcher, &QFutureWatcher<Rows>::finished, this, &ChunkCompressor::handleFinished);
+}
+
+ChunkCompressor::~ChunkCompressor()
+{
+    mWatcher.cancel();
+    mWatcher.waitForFinished();
+}
+
+void ChunkCompressor::setStorage(Storage *storage)
+{
+    if (mStorage == storage)
+        return;
+
+    // the rows of a running job belong to the old database
+    cancel();
+
+    mStorage = storage;
+    emit storageChanged(QPrivateSignal{});
+}
+
+bool ChunkCompressor::compressProject()
+{
+    if (!mStorage || !mStorage->database().isOpen())
+        return handleError(this, "compressProject", "database is not open"), false;
+
+    if (mWatcher.isRunning())
+        return handleError(this, "compressProject", "a job is running"), false;
+
+    // plain chunks long enough to pack, and packed ones of another codec than the current
+    QSqlQuery query{mStorage->database()};
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT `value`,`index`,`text`,`packed` FROM `ValueChunk` "
+                                   "WHERE (`packed` IS NULL AND `characters`>=%1) OR (`packed` IS "
+                                   "NOT NULL AND hex(substr(`packed`,1,1))<>'%2')")
+                        .arg(TextCodec::Threshold)
+                        .arg(int(TextCodec::Current), 2, 16, QChar('0'))))
+        return handleError(this, "compressProject", query), false;
+
+    QList<Rows> batches;
+    while (query.next()) {
+        if (batches.isEmpty() || batches.last().size() == BatchSize)
+            batches.append(Rows{});
+        batches.last().append({query.value(0).toInt(),
+                               query.value(1).toString(),
+                               query.value(2).toString(),
+                               query.value(3).toByteArray(),
+                               {}});
+    }
+
+    mWatcher.setFuture(QtConcurrent::mappedReduced<Rows>(
+        batches,
+        &ChunkCompressor::pack,
+        [](Rows &result, const Rows &part) { result.append(part); },
+        QtConcurrent::UnorderedReduce));
+
+    emit runningChanged(QPrivateSignal{});
+
+    return true;
+}
+
+void ChunkCompressor::cancel()
+{
+    if (mWatcher.isRunning())
+        mWatcher.cancel();
+}
+
+void ChunkCompressor::handleFinished()
+{
+    emit runningChanged(QPrivateSignal{});
+
+    if (mWatcher.isCanceled())
+        return;
+
+    if (!write(mWatcher.result()))
+        return;
+
+    emit resultsChanged(QPrivateSignal{});
+    emit finished(mPacked, mSavedBytes, QPrivateSignal{});
+}
+
+bool ChunkCompressor::write(const Rows &rows)
+{
+    mPacked = 0;
+    mSavedBytes = 0;
+
+    if (!mStorage || !mStorage->database().isOpen())
+        return handleError(this, "write", "database is not open"), false;
+
+    Transaction tx{Transaction::Write, nullptr, mStorage};
+
+    // only over the chunk as it was read, an edit since then wins
+    QSqlQuery query{mStorage->database()};
+    if (!query.prepare("UPDATE `ValueChunk` SET `text`=:text,`packed`=:packed WHERE "
+                       "`value`=:value AND `index`=:index AND (`text`=:oldText OR "
+                       "`packed`=:oldPacked)"))
+        return handleError(this, "write", query), false;
+
+    const QVariant nullText{QMetaType::fromType<QString>()};
+    const QVariant nullBlob{QMetaType::fromType<QByteArray>()};
+
+    for (const Row &row : rows) {
+        const bool wasPlain = row.stored.isEmpty();
+        const bool isPlain = row.packed.isEmpty();
+
+        query.bindValue(":text", isPlain ? QVariant{row.text} : nullText);
+        query.bindValue(":packed", isPlain ? nullBlob : QVariant{row.packed});
+        query.bindValue(":value", row.value);
+        query.bindValue(":index", row.index);
+        query.bindValue(":oldText", wasPlain ? QVariant{row.text} : nullText);
+        query.bindValue(":oldPacked", wasPlain ? nullBlob : QVariant{row.stored});
+        if (!query.exec())
+            return handleError(this, "write", query), false;
+        if (query.numRowsAffected() <= 0)
+            continue;
+
+        const qint64 utf8 = (wasPlain || isPlain) ? row.text.toUtf8().size() : 0;
+        ++mPacked;
+        mSavedBytes += (wasPlain ? utf8 : row.stored.size()) - (isPlain ? utf8 : row.packed.size());
+    }
+
+    return tx.commit();
+}
+
+ChunkCompressor::Rows ChunkCompressor::pack(const Rows &rows)
+{
+    Rows packed;
+
+    for (Row row : rows) {
+        if (!row.stored.isEmpty()) {
+            row.text = TextCodec::unpack(row.stored);
+            // damaged, better left as it is than written over
+            if (row.text.isNull())
+                continue;
+        }
+
+        row.packed = TextCodec::pack(row.text);
+        // a plain chunk that doesn't get smaller stays as it is
+        if (row.stored.isEmpty() && row.packed.isEmpty())
+            continue;
+
+        packed.append(row);
+    }
+
+    return packed;
+}
@@ -0,0 +1,79 @@
+#ifndef LIBNOVELIST_CHUNKCOMPRESSOR_H
+#define LIBNOVELIST_CHUNKCOMPRESSOR_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <qqmlintegration.h>
+
+#include "errorhandler.h"
+
+class Storage;
+
+Q_MOC_INCLUDE("storage.h")
+
+// Packs the chunks of long text that are stored plain but could be packed, as those of a project
+// from before the packed column, and packs again the ones of an older codec, see TextCodec.
+//
+// The rows are read in one query on the calling thread, packed in batches on the global
+// QThreadPool and written back in one transaction once the run is done; finished() is emitted
+// then. A chunk that was edited in the meantime is left as the edit wrote it. A run can be
+// cancelled, nothing is written then.
+class ChunkCompressor : public QObject, public ErrorHandler
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+public:
+    explicit ChunkCompressor(QObject *parent = nullptr);
+    ~ChunkCompressor() override;
+
+    [[nodiscard]] Storage *storage() const { return mStorage; }
+    void setStorage(Storage *storage);
+
+    [[nodiscard]] bool isRunning() const { return mWatcher.isRunning(); }
+    // Chunks packed by the last run that finished, and the bytes that saved.
+    [[nodiscard]] int packed() const { return mPacked; }
+    [[nodiscard]] qint64 savedBytes() const { return mSavedBytes; }
+
+    // Start a run, false if one is running or the chunks could not be read.
+    Q_INVOKABLE bool compressProject();
+    Q_INVOKABLE void cancel();
+
+    // Chunks per task.
+    static constexpr int BatchSize = 256;
+
+signals:
+    void storageChanged(QPrivateSignal);
+    void runningChanged(QPrivateSignal);
+    void resultsChanged(QPrivateSignal);
+    void finished(int packed, qint64 savedBytes, QPrivateSignal);
+
+private:
+    // A chunk as read, and packed by a worker.
+    struct Row
+    {
+        int value = 0;
+        QString index;
+        QString text;
+        QByteArray stored;
+        QByteArray packed;
+    };
+    using Rows = QList<Row>;
+
+    void handleFinished();
+    bool write(const Rows &rows);
+
+    static Rows pack(const Rows &rows);
+
+    Storage *mStorage = nullptr;
+    QFutureWatcher<Rows> mWatcher;
+    int mPacked = 0;
+    qint64 mSavedBytes = 0;
+
+    Q_PROPERTY(Storage *storage READ storage WRITE setStorage NOTIFY storageChanged FINAL)
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged FINAL)
+    Q_PROPERTY(int packed READ packed NOTIFY resultsChanged FINAL)
+    Q_PROPERTY(qint64 savedBytes READ savedBytes NOTIFY resultsChanged FINAL)
+};
+
+#endif // LIBNOVELIST_CHUNKCOMPRESSOR_H
@@ -0,0 +1,276 @@
+#include "computedfields.h"
+#include "storage.h"
+
+ComputedFields::ComputedFields(Storage *storage)
+    : QObject{storage}
+    , mStorage{storage}
+{
+    for (BaseStorage *s : QList<BaseStorage *>{storage->elementStorage(),
+                                               storage->fieldStorage(),
+                                               storage->valueStorage()})
+        connect(s, &BaseStorage::nodeRecycled, this, [this](Node *node) { forget(node); });
+}
+
+QVariant ComputedFields::value(Field *field)
+{
+    if (!field || !field->fieldType() || field->fieldType()->formula().isEmpty())
+        return {};
+
+    if (const auto it = mValues.constFind(field); it != mValues.constEnd()
+                                                  && !mDirty.contains(field))
+        return *it;
+
+    return compute(field);
+}
+
+void ComputedFields::forget(QObject *node)
+{
+    // called from destroyed() as well, so only the address is used
+    invalidate(node);
+
+    if (mWatched.remove(node))
+        disconnect(node, nullptr, this, nullptr);
+    for (Field *dependant : mDependants.take(node))
+        mSources[dependant].remove(node);
+
+    Field *field = static_cast<Field *>(node);
+    mValues.remove(field);
+    mDirty.removeAll(field);
+    for (QObject *source : mSources.take(field))
+        mDependants[source].remove(field);
+}
+
+QVariant ComputedFields::compute(Field *field)
+{
+    mDirty.removeAll(field);
+
+    if (mComputing.contains(field))
+        return handleError(field, "ComputedFields", "the formula depends on itself"), QVariant{};
+
+    // the sources are recorded anew, a formula may read other things this time
+    for (QObject *source : mSources.take(field))
+        mDependants[source].remove(field);
+
+    // a copy, computing the fields this one reads may add to mFormulas
+    const Formula f = formula(field->fieldType()->formula());
+    read(field->fieldType(), field);
+
+    Element *owner = field->elements().value(0);
+
+    mComputing.insert(field);
+    const QVariant result = f.isValid() && owner ? evaluate(f, f.root(), owner, field)
+                                                 : QVariant{};
+    mComputing.remove(field);
+
+    const auto old = mValues.constFind(field);
+    const bool changed = old != mValues.constEnd() && *old != result;
+    mValues.insert(field, result);
+
+    if (changed) {
+        emit field->computedValueChanged(Field::QPrivateSignal{});
+        invalidate(field);
+    }
+
+    return result;
+}
+
+QVariant ComputedFields::evaluate(const Formula &formula,
+                                  int index,
+                                  Element *element,
+                                  Field *field)
+{
+    const Formula::Term &term = formula.terms()[index];
+
+    switch (term.kind) {
+    case Formula::Term::Number:
+        return term.number;
+    case Formula::Term::Call: {
+        QList<Leaf> leaves;
+        collect(element, term.path, 0, field, &leaves);
+        return call(term.function, leaves);
+    }
+    default:
+        break;
+    }
+
+    bool ok = false;
+    const double left = evaluate(formula, term.left, element, field).toDouble(&ok);
+    if (!ok)
+        return {};
+    if (term.kind == Formula::Term::Negate)
+        return -left;
+
+    const double right = evaluate(formula, term.right, element, field).toDouble(&ok);
+    if (!ok)
+        return {};
+
+    switch (term.kind) {
+    case Formula::Term::Add:
+        return left + right;
+    case Formula::Term::Subtract:
+        return left - right;
+    case Formula::Term::Multiply:
+        return left * right;
+    case Formula::Term::Divide:
+        return right == 0 ? QVariant{} : QVariant{left / right};
+    default:
+        return {};
+    }
+}
+
+QVariant ComputedFields::call(const QString &function, const QList<Leaf> &leaves) const
+{
+    if (function == "count")
+        return int(leaves.size());
+
+    if (function == "value")
+        return leaves.isEmpty() ? QVariant{} : leaves.first().value;
+
+    if (function == "sum" || function == "words" || function == "characters") {
+        double sum = 0;
+        for (const Leaf &leaf : leaves) {
+            if (function == "words")
+                sum += Aggregates::countWords(leaf.value.toString());
+            else if (function == "characters")
+                sum += leaf.value.toString().size();
+            else
+                sum += leaf.value.toDouble();
+        }
+        return sum;
+    }
+
+    if (function == "min" || function == "max") {
+        const auto order = function == "min" ? QPartialOrdering::Less : QPartialOrdering::Greater;
+        QVariant result;
+        for (const Leaf &leaf : leaves)
+            if (leaf.value.isValid()
+                && (!result.isValid() || QVariant::compare(leaf.value, result) == order))
+                result = leaf.value;
+        return result;
+    }
+
+    if (function == "latest") {
+        // a computed field has no update time of its own, its value may be one
+        QDateTime latest;
+        for (const Leaf &leaf : leaves) {
+            const QDateTime at = leaf.updatedAt.isValid() ? leaf.updatedAt
+                                                          : leaf.value.toDateTime();
+            if (at.isValid() && (!latest.isValid() || at > latest))
+                latest = at;
+        }
+        return latest.isValid() ? QVariant{latest} : QVariant{};
+    }
+
+    return {};
+}
+
+void ComputedFields::collect(
+    Element *element, const QStringList &path, int depth, Field *field, QList<Leaf> *leaves)
+{
+    read(element, field);
+
+    Field *source = element->field(path[depth]);
+    if (!source)
+        return;
+
+    const bool last = depth == path.size() - 1;
+
+    // pulled first, so that its change doesn't mark field while field is computed
+    if (source->fieldType() && !source->fieldType()->formula().isEmpty()) {
+        const QVariant v = value(source);
+        read(source, field);
+        if (last)
+            leaves->append({v, {}});
+        return;
+    }
+
+    read(source, field);
+    for (Value *v : source->values()) {
+        read(v, field);
+        if (last)
+            leaves->append({v->value(), v->updatedAt()});
+        else if (Element *e = this->element(v->value(), v->valueType()))
+            collect(e, path, depth + 1, field, leaves);
+    }
+}
+
+Element *ComputedFields::element(const QVariant &value, int valueType)
+{
+    if (Node *node = value.value<Node *>())
+        return qobject_cast<Element *>(node);
+    if (valueType == Value::Type_Node && value.toInt() > 0)
+        return mStorage->element(value.toInt());
+    return nullptr;
+}
+
+const Formula &ComputedFields::formula(const QString &text)
+{
+    auto it = mFormulas.find(text);
+    if (it == mFormulas.end()) {
+        it = mFormulas.insert(text, Formula::parse(text));
+        if (!it->isValid())
+            handleError(QStringLiteral("ComputedFields: '%1': %2").arg(text, it->error()));
+    }
+    return *it;
+}
+
+void ComputedFields::read(QObject *source, Field *field)
+{
+    mDependants[source].insert(field);
+    mSources[field].insert(source);
+    watch(source);
+}
+
+void ComputedFields::watch(QObject *source)
+{
+    if (mWatched.contains(source))
+        return;
+    mWatched.insert(source);
+
+    const auto changed = [this, source]() { invalidate(source); };
+
+    if (Value *value = qobject_cast<Value *>(source)) {
+        connect(value, &Value::valueChanged, this, changed);
+        connect(value, &Value::valueTypeChanged, this, changed);
+        connect(value, &Value::updatedAtChanged, this, changed);
+        connect(value, &Value::textChanged, this, changed);
+    } else if (Field *field = qobject_cast<Field *>(source)) {
+        connect(field, &Field::valuesChanged, this, changed);
+    } else if (Element *element = qobject_cast<Element *>(source)) {
+        connect(element, &Element::fieldsChanged, this, changed);
+    } else if (FieldType *fieldType = qobject_cast<FieldType *>(source)) {
+        connect(fieldType, &FieldType::formulaChanged, this, changed);
+    }
+
+    connect(source, &QObject::destroyed, this, [this, source]() { forget(source); });
+}
+
+void ComputedFields::invalidate(QObject *source)
+{
+    const auto it = mDependants.constFind(source);
+    if (it == mDependants.constEnd() || it->isEmpty())
+        return;
+
+    for (Field *dependant : *it)
+        if (!mDirty.contains(dependant))
+            mDirty.append(dependant);
+
+    schedule();
+}
+
+void ComputedFields::schedule()
+{
+    if (mScheduled)
+        return;
+    mScheduled = true;
+    QMetaObject::invokeMethod(this, &ComputedFields::flush, Qt::QueuedConnection);
+}
+
+void ComputedFields::flush()
+{
+    // in the order they were marked, a field pulls the dirty fields it reads itself; what the
+    // recomputed fields mark is taken in the same flush
+    while (!mDirty.isEmpty())
+        compute(mDirty.first());
+    mScheduled = false;
+}
@@ -0,0 +1,76 @@
+#ifndef LIBNOVELIST_COMPUTEDFIELDS_H
+#define LIBNOVELIST_COMPUTEDFIELDS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVariant>
+
+#include "errorhandler.h"
+#include "formula.h"
+
+class Element;
+class Field;
+class Node;
+class Storage;
+
+// The values of the fields whose FieldType has a formula, computed on first read and kept until
+// something they read changes.
+//
+// An evaluation records what it reads: the element whose fields a path looks up, each field whose
+// values it walks, each value it takes, and the computed fields it pulls in. Those are the
+// sources of the field, and the field their dependant. A signal from a source (valueChanged,
+// valuesChanged, fieldsChanged, formulaChanged) marks only its dependants dirty, and one flush
+// per event loop turn recomputes them. A field whose result changed emits computedValueChanged and
+// marks its own dependants in turn; one that computed the same value stops there.
+//
+// A dirty field read before the flush is recomputed then and there, so a read is never stale.
+class ComputedFields : public QObject, public ErrorHandler
+{
+    Q_OBJECT
+
+public:
+    explicit ComputedFields(Storage* storage);
+
+    [[nodiscard]] QVariant value(Field* field);
+
+    // Drops what is known about node, for nodes that are recycled.
+    void forget(QObject* node);
+
+private:
+    struct Leaf
+    {
+        QVariant value;
+        QDateTime updatedAt;
+    };
+
+    QVariant compute(Field* field);
+    QVariant evaluate(const Formula& formula, int index, Element* element, Field* field);
+    QVariant call(const QString& function, const QList<Leaf>& leaves) const;
+    void collect(Element* element,
+                 const QStringList& path,
+                 int depth,
+                 Field* field,
+                 QList<Leaf>* leaves);
+    [[nodiscard]] Element* element(const QVariant& value, int valueType);
+    [[nodiscard]] const Formula& formula(const QString& text);
+
+    void read(QObject* source, Field* field);
+    void watch(QObject* source);
+    void invalidate(QObject* source);
+    void schedule();
+    void flush();
+
+    Storage* mStorage = nullptr;
+    QHash<QString, Formula> mFormulas;
+    QHash<Field*, QVariant> mValues;
+    QHash<QObject*, QSet<Field*>> mDependants;
+    QHash<Field*, QSet<QObject*>> mSources;
+    QSet<QObject*> mWatched;
+    QSet<Field*> mComputing;
+    QList<Field*> mDirty;
+    bool mScheduled = false;
+};
+
+#endif // LIBNOVELIST_COMPUTEDFIELDS_H
@@ -48,6 +48,12 @@ void Element::setNodeType(NodeType *nodeType, bool emitSignals)
         emitNodeTypeChanged(this->nodeType(), oldNodeType);
 }
 
+void Element::instantiate(ElementType *elementType, const QList<Field *> &fields)
+{
+    Node::setNodeType(elementType, false);
+    setFields(fields);
+}
+
 bool Element::updateFields()
 {
     if (rowid() <= 0 || isLoading() || isSaving())
@@ -55,6 +61,37 @@ bool Element::updateFields()
     return storage()->elementStorage()->updateFields(this);
 }
 
+bool Element::insertFieldLink(int index)
+{
+    if (rowid() <= 0 || isLoading() || isSaving() || !mPerformUpdateFields)
+        return false;
+    return storage()->elementStorage()->insertFieldLink(this, index);
+}
+
+bool Element::removeFieldLink(int index)
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->elementStorage()->removeFieldLink(this, index);
+}
+
+bool Element::moveFieldLink(int from, int to)
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->elementStorage()->moveFieldLink(this, from, to);
+}
+
+void Element::setCounts(int words, int characters, int elements)
+{
+    if (mWordCount == words && mCharacterCount == characters && mElementCount == elements)
+        return;
+    mWordCount = words;
+    mCharacterCount = characters;
+    mElementCount = elements;
+    emit countsChanged(QPrivateSignal{});
+}
+
 void Element::setFields(const QList<Field *> &fields)
 {
     if (mFields == fields)
@@ -107,7 +144,7 @@ bool Element::insertField(int index, Field *field)
     if (!qobject_cast<Element *>(field->parent()))
         field->setParent(this);
 
-    if (!updateFields())
+    if (!insertFieldLink(index))
         setModified(true);
 
     emit fieldsAdded(index, index, QPrivateSignal{});
@@ -132,7 +169,7 @@ bool Element::removeFieldAt(int index)
     field->disconnect(this);
     disconnect(field);
 
-    if (!updateFields())
+    if (!removeFieldLink(index))
         setModified(true);
 
     emit fieldsRemoved(index, index, QPrivateSignal{});
@@ -140,6 +177,23 @@ bool Element::removeFieldAt(int index)
     return true;
 }
 
+bool Element::moveField(int from, int to)
+{
+    if (from < 0 || from >= mFields.size() || to < 0 || to >= mFields.size())
+        return handleError(this, "moveField", "index out of range"), false;
+
+    if (from == to)
+        return true;
+
+    mFields.move(from, to);
+
+    if (!moveFieldLink(from, to))
+        setModified(true);
+
+    emit fieldsChanged(QPrivateSignal{});
+    return true;
+}
+
 FieldListModel *Element::fieldListModel()
 {
     if (!mFieldListModel)
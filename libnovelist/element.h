@@ -54,6 +54,7 @@ public:
         return true;
     }
     bool removeFieldAt(int index);
+    bool moveField(int from, int to);
     Field* takeFieldAt(int index)
     {
         if (index < 0 || index >= mFields.size())
@@ -66,12 +67,18 @@ public:
 
     [[nodiscard]] FieldListModel *fieldListModel();
 
+    // The totals of the element and everything below it, kept by Aggregates.
+    [[nodiscard]] int wordCount() const { return mWordCount; }
+    [[nodiscard]] int characterCount() const { return mCharacterCount; }
+    [[nodiscard]] int elementCount() const { return mElementCount; }
+
     using Node::setNodeType;
 
 signals:
     void fieldsChanged(QPrivateSignal);
     void fieldsAdded(int first, int last, QPrivateSignal);
     void fieldsRemoved(int first, int last, QPrivateSignal);
+    void countsChanged(QPrivateSignal);
 
 protected:
     bool readJson(const QJsonObject &json, QStringList *errors = nullptr) override;
@@ -80,15 +87,32 @@ protected:
     void setNodeType(NodeType *nodeType, bool emitSignals) override;
 
     bool updateFields();
+    bool insertFieldLink(int index);
+    bool removeFieldLink(int index);
+    bool moveFieldLink(int from, int to);
+    void setCounts(int words, int characters, int elements);
+    // Takes the type with fields made from its prototype, instead of creating them.
+    void instantiate(ElementType *elementType, const QList<Field *> &fields);
 
 private:
     QList<Field *> mFields;
     QMap<QString, Field *> mFieldsByName;
+    // The order keys of the fields' rows in Element_fields, kept by ElementStorage.
+    QStringList mFieldKeys;
     FieldListModel *mFieldListModel = nullptr;
     bool mPerformUpdateFields = true;
+    int mWordCount = 0;
+    int mCharacterCount = 0;
+    int mElementCount = 0;
+
+    friend class Aggregates;
+    friend class ElementStorage;
 
     Q_PROPERTY(QList<Field*> fields READ fields WRITE setFields NOTIFY fieldsChanged FINAL)
     Q_PROPERTY(FieldListModel *fieldListModel READ fieldListModel CONSTANT FINAL)
+    Q_PROPERTY(int wordCount READ wordCount NOTIFY countsChanged FINAL)
+    Q_PROPERTY(int characterCount READ characterCount NOTIFY countsChanged FINAL)
+    Q_PROPERTY(int elementCount READ elementCount NOTIFY countsChanged FINAL)
 };
 
 #endif // LIBNOVELIST_ELEMENT_H
@@ -0,0 +1,287 @@
+#include "elementquery.h"
+#include "elementtype.h"
+#include "node.h"
+#include "textcodec.h"
+#include "value.h"
+
+namespace {
+
+// the fields of an element are found through its rows in Element_fields, their values through
+// Field_values, each a lookup on a primary key
+const QString ValuesOf = QStringLiteral(
+    "SELECT %1 FROM `Element_fields` ef JOIN `Node` f ON f.`id`=ef.`field` JOIN `Field_values` "
+    "fv ON fv.`field`=ef.`field` JOIN `Value` v ON v.`id`=fv.`value` WHERE ef.`element`=e.`id` "
+    "AND f.`name`=?");
+
+// the column holds text, so a value is compared as a number only when it is stored as one; text
+// that is cast would compare as 0
+const QString NumericValue = QStringLiteral("v.`valueType` IN (%1,%2,%3)")
+                                 .arg(Value::Type_Int)
+                                 .arg(Value::Type_Float)
+                                 .arg(Value::Type_Double);
+
+bool isNumber(const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QString escapeLike(QString text)
+{
+    return text.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+}
+
+} // namespace
+
+ElementQuery &ElementQuery::ofType(ElementType *elementType)
+{
+    mElementType = elementType ? elementType->rowid() : 0;
+    return *this;
+}
+
+ElementQuery &ElementQuery::where(const QString &field, Operator op, const QVariant &value)
+{
+    // a node is stored as its rowid
+    if (const Node *node = value.value<Node *>())
+        mPredicates.append({field, op, node->rowid()});
+    else
+        mPredicates.append({field, op, value});
+    return *this;
+}
+
+ElementQuery &ElementQuery::orderBy(const QString &field, Qt::SortOrder order)
+{
+    mSortField = field;
+    mSortOrder = order;
+    return *this;
+}
+
+ElementQuery &ElementQuery::limit(int count, int offset)
+{
+    mLimit = count;
+    mOffset = offset;
+    return *this;
+}
+
+ElementQuery &ElementQuery::clear()
+{
+    *this = ElementQuery{};
+    return *this;
+}
+
+QList<int> ElementQuery::rowids(const QSqlDatabase &database)
+{
+    QSqlQuery query{database};
+    if (!exec(query, database, false))
+        return {};
+
+    QList<int> result;
+    while (query.next())
+        result.append(query.value(0).toInt());
+    return result;
+}
+
+int ElementQuery::count(const QSqlDatabase &database)
+{
+    QSqlQuery query{database};
+    if (!exec(query, database, true) || !query.next())
+        return 0;
+    return query.value(0).toInt();
+}
+
+QString ElementQuery::statement(QVariantList *bindings, bool counting) const
+{
+    // the placeholders are positional, so the bindings follow the order of the text
+    QStringList conditions;
+
+    if (mElementType > 0) {
+        conditions.append("n.`nodeType`=?");
+        bindings->append(mElementType);
+    }
+
+    for (const Predicate &p : mPredicates) {
+        bindings->append(p.field);
+
+        const bool number = isNumber(p.value);
+        const QString value = number ? NumericValue + " AND CAST(v.`value` AS REAL)"
+                                     : QStringLiteral("v.`value`");
+        const QVariant bound = number ? QVariant{p.value.toDouble()} : p.value;
+
+        QString test;
+        switch (p.op) {
+        case Equals:
+        case NotEquals:
+            test = value + "=?";
+            break;
+        case Contains:
+        case StartsWith:
+            test = "v.`value` LIKE ? ESCAPE '\\'";
+            break;
+        case Less:
+            test = value + "<?";
+            break;
+        case LessOrEqual:
+            test = value + "<=?";
+            break;
+        case Greater:
+            test = value + ">?";
+            break;
+        case GreaterOrEqual:
+            test = value + ">=?";
+            break;
+        case Exists:
+            break;
+        }
+
+        // the value column only holds the start of long text, matchText() had all of it
+        if (!number && !test.isEmpty()) {
+            test = "((v.`valueType`<>" + QString::number(Value::Type_Text) + " AND " + test + ')';
+            if (!p.texts.isEmpty())
+                test += " OR v.`id` IN (" + p.texts.join(',') + ')';
+            test += ')';
+        }
+
+        if (p.op == Contains)
+            bindings->append('%' + escapeLike(p.value.toString()) + '%');
+        else if (p.op == StartsWith)
+            bindings->append(escapeLike(p.value.toString()) + '%');
+        else if (p.op != Exists)
+            bindings->append(bound);
+
+        QString values = ValuesOf.arg(QStringLiteral("1"));
+        if (!test.isEmpty())
+            values += " AND " + test;
+        conditions.append((p.op == NotEquals ? "NOT EXISTS (" : "EXISTS (") + values + ')');
+    }
+
+    QString statement = counting ? QStringLiteral("SELECT COUNT(*)")
+                                 : QStringLiteral("SELECT e.`id`");
+    statement += " FROM `Element` e JOIN `Node` n ON n.`id`=e.`id`";
+    if (!conditions.isEmpty())
+        statement += " WHERE " + conditions.join(" AND ");
+
+    if (counting)
+        return statement;
+
+    const QString direction = mSortOrder == Qt::DescendingOrder ? QStringLiteral(" DESC")
+                                                                : QString{};
+    if (!mSortField.isEmpty()) {
+        // numbers sort by value and before text, which sorts as it is
+        const QString key = "CASE WHEN " + NumericValue
+                            + " THEN CAST(v.`value` AS REAL) ELSE v.`value` END";
+        statement += " ORDER BY (" + ValuesOf.arg(key)
+                     + " ORDER BY ef.`index`,fv.`index` LIMIT 1)" + direction + ",";
+        bindings->append(mSortField);
+    } else {
+        statement += " ORDER BY";
+    }
+    statement += " e.`id`" + direction;
+
+    if (mLimit >= 0 || mOffset > 0) {
+        statement += " LIMIT ? OFFSET ?";
+        bindings->append(mLimit);
+        bindings->append(mOffset);
+    }
+
+    return statement;
+}
+
+bool ElementQuery::exec(QSqlQuery &query, const QSqlDatabase &database, bool counting)
+{
+    if (!matchText(database))
+        return false;
+
+    QVariantList bindings;
+    query.setForwardOnly(true);
+    if (!query.prepare(statement(&bindings, counting)))
+        return handleError(nullptr, "ElementQuery", query), false;
+    for (const QVariant &binding : std::as_const(bindings))
+        query.addBindValue(binding);
+    if (!query.exec())
+        return handleError(nullptr, "ElementQuery", query), false;
+    return true;
+}
+
+bool ElementQuery::matchText(const QSqlDatabase &database)
+{
+    // the values of the field, of elements of the type if there is one
+    QString values = QStringLiteral("SELECT fv.`value` FROM `Node` f JOIN `Field_values` fv ON "
+                                    "fv.`field`=f.`id` WHERE f.`name`=?");
+    if (mElementType > 0)
+        values += " AND f.`id` IN (SELECT ef.`field` FROM `Element_fields` ef JOIN `Node` e ON "
+                  "e.`id`=ef.`element` WHERE e.`nodeType`=?)";
+
+    for (Predicate &p : mPredicates) {
+        p.texts.clear();
+
+        // long text is never a number, nor missing when its row is there
+        if (p.op == Exists || isNumber(p.value))
+            continue;
+
+        QSqlQuery query{database};
+        query.setForwardOnly(true);
+        if (!query.prepare("SELECT `value`,`text`,`packed` FROM `ValueChunk` WHERE `value` IN ("
+                           + values + ") ORDER BY `value`,`index`"))
+            return handleError(nullptr, "ElementQuery", query), false;
+        query.addBindValue(p.field);
+        if (mElementType > 0)
+            query.addBindValue(mElementType);
+        if (!query.exec())
+            return handleError(nullptr, "ElementQuery", query), false;
+
+        // one value at a time, its chunks in order
+        int current = 0;
+        QString text;
+        const auto test = [&] {
+            if (current > 0 && matches(text, p.op, p.value))
+                p.texts.append(QString::number(current));
+        };
+        while (query.next()) {
+            const int value = query.value(0).toInt();
+            if (value != current) {
+                test();
+                current = value;
+                text.clear();
+            }
+            text += query.isNull(2) ? query.value(1).toString()
+                                    : TextCodec::unpack(query.value(2).toByteArray());
+        }
+        test();
+    }
+
+    return true;
+}
+
+bool ElementQuery::matches(const QString &text, Operator op, const QVariant &value)
+{
+    const QString other = value.toString();
+    switch (op) {
+    case Equals:
+    case NotEquals:
+        return text == other;
+    case Contains:
+        return text.contains(other, Qt::CaseInsensitive);
+    case StartsWith:
+        return text.startsWith(other, Qt::CaseInsensitive);
+    case Less:
+        return text < other;
+    case LessOrEqual:
+        return text <= other;
+    case Greater:
+        return text > other;
+    case GreaterOrEqual:
+        return text >= other;
+    case Exists:
+        return true;
+    }
+    return false;
+}
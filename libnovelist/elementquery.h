@@ -0,0 +1,75 @@
+#ifndef LIBNOVELIST_ELEMENTQUERY_H
+#define LIBNOVELIST_ELEMENTQUERY_H
+
+#include <QList>
+#include <QSqlDatabase>
+#include <QVariant>
+
+#include "errorhandler.h"
+
+class ElementType;
+
+// Finds elements by the values of their fields without loading them: the type, the predicates
+// and the sort compile to one statement that walks Element_fields, Field_values and Value by
+// their primary keys, and only the rowids of the matches come back.
+//
+//     ElementQuery query;
+//     query.ofType(story).where("Title", ElementQuery::Contains, "dragon").orderBy("Title");
+//     const QList<Element*> stories = storage->loadElements(query.limit(20));
+//
+// A predicate holds when any value of the named field matches, NotEquals when none equals.
+// Numbers compare as numbers, everything else as the text the values are stored as, which
+// orders dates too. Long text is matched against its chunks, read and joined once per predicate
+// before the statement runs, and sorts by its start, see Value::TextPrefix.
+class ElementQuery : public ErrorHandler
+{
+public:
+    enum Operator {
+        Equals,
+        NotEquals,
+        Contains,   // case-insensitive for ASCII, like LIKE
+        StartsWith, // likewise
+        Less,
+        LessOrEqual,
+        Greater,
+        GreaterOrEqual,
+        Exists, // the field has a value at all
+    };
+
+    ElementQuery& ofType(ElementType* elementType);
+    ElementQuery& where(const QString& field, Operator op, const QVariant& value = {});
+    // By the first value of field, then by rowid. Without it the order is the rowid.
+    ElementQuery& orderBy(const QString& field, Qt::SortOrder order = Qt::AscendingOrder);
+    // A page of the matches, a negative count means all of them.
+    ElementQuery& limit(int count, int offset = 0);
+    ElementQuery& clear();
+
+    [[nodiscard]] QList<int> rowids(const QSqlDatabase& database);
+    [[nodiscard]] int count(const QSqlDatabase& database);
+
+    // With the long text matched by the last rowids() or count().
+    [[nodiscard]] QString statement(QVariantList* bindings, bool counting = false) const;
+
+private:
+    struct Predicate
+    {
+        QString field;
+        Operator op;
+        QVariant value;
+        // The rowids of the long text values that match, see matchText().
+        QStringList texts;
+    };
+
+    [[nodiscard]] bool exec(QSqlQuery& query, const QSqlDatabase& database, bool counting);
+    [[nodiscard]] bool matchText(const QSqlDatabase& database);
+    [[nodiscard]] static bool matches(const QString& text, Operator op, const QVariant& value);
+
+    int mElementType = 0;
+    QList<Predicate> mPredicates;
+    QString mSortField;
+    Qt::SortOrder mSortOrder = Qt::AscendingOrder;
+    int mLimit = -1;
+    int mOffset = 0;
+};
+
+#endif // LIBNOVELIST_ELEMENTQUERY_H
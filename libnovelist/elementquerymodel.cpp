@@ -0,0 +1,149 @@
+#include "elementquerymodel.h"
+#include "storage.h"
+
+QVariant ElementQueryModel::data(const QModelIndex &index, int role) const
+{
+    if (Element *element = mElements.value(index.row())) {
+        switch (role) {
+        case ElementRole:
+        case Qt::EditRole:
+            return QVariant::fromValue(element);
+        case NameRole:
+            return element->name();
+        case LabelRole:
+        case Qt::DisplayRole:
+            return element->label();
+        case InfoRole:
+            return element->info();
+        case IconRole:
+            return element->icon();
+        }
+    }
+    return {};
+}
+
+bool ElementQueryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && mElements.size() < mCount;
+}
+
+void ElementQueryModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || !mStorage)
+        return;
+
+    mQuery.limit(mPageSize, int(mElements.size()));
+    const QList<Element *> page = mStorage->loadElements(mQuery);
+
+    // fewer matches than counted, rows were removed since
+    if (page.isEmpty()) {
+        mCount = int(mElements.size());
+        emit countChanged(QPrivateSignal{});
+        return;
+    }
+
+    beginInsertRows({}, int(mElements.size()), int(mElements.size() + page.size()) - 1);
+    for (Element *element : page)
+        watch(element);
+    mElements.append(page);
+    endInsertRows();
+}
+
+void ElementQueryModel::setStorage(Storage *storage)
+{
+    if (mStorage == storage)
+        return;
+    mStorage = storage;
+    refresh();
+    emit storageChanged(QPrivateSignal{});
+}
+
+void ElementQueryModel::setElementType(ElementType *elementType)
+{
+    if (mElementType == elementType)
+        return;
+    mElementType = elementType;
+    refresh();
+    emit elementTypeChanged(QPrivateSignal{});
+}
+
+void ElementQueryModel::setPageSize(int pageSize)
+{
+    if (mPageSize == pageSize || pageSize <= 0)
+        return;
+    mPageSize = pageSize;
+    emit pageSizeChanged(QPrivateSignal{});
+}
+
+void ElementQueryModel::where(const QString &field, Operator op, const QVariant &value)
+{
+    mQuery.where(field, ElementQuery::Operator(op), value);
+    scheduleRefresh();
+}
+
+void ElementQueryModel::orderBy(const QString &field, Qt::SortOrder order)
+{
+    mQuery.orderBy(field, order);
+    scheduleRefresh();
+}
+
+void ElementQueryModel::clear()
+{
+    mQuery.clear();
+    scheduleRefresh();
+}
+
+void ElementQueryModel::refresh()
+{
+    mRefreshScheduled = false;
+
+    beginResetModel();
+
+    for (Element *element : std::as_const(mElements))
+        element->disconnect(this);
+    mElements.clear();
+
+    mQuery.ofType(mElementType);
+    mQuery.limit(-1);
+    mCount = mStorage ? mStorage->countElements(mQuery) : 0;
+
+    endResetModel();
+    emit countChanged(QPrivateSignal{});
+
+    if (canFetchMore({}))
+        fetchMore({});
+}
+
+void ElementQueryModel::scheduleRefresh()
+{
+    if (mRefreshScheduled)
+        return;
+    mRefreshScheduled = true;
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            if (mRefreshScheduled)
+                refresh();
+        },
+        Qt::QueuedConnection);
+}
+
+void ElementQueryModel::watch(Element *element)
+{
+    connect(element, &Node::nameChanged, this, [this, element]() {
+        const auto idx = index(mElements.indexOf(element), 0);
+        emit dataChanged(idx, idx, {NameRole});
+    });
+    connect(element, &Node::labelChanged, this, [this, element]() {
+        const auto idx = index(mElements.indexOf(element), 0);
+        emit dataChanged(idx, idx, {LabelRole, Qt::DisplayRole});
+    });
+    connect(element, &Node::infoChanged, this, [this, element]() {
+        const auto idx = index(mElements.indexOf(element), 0);
+        emit dataChanged(idx, idx, {InfoRole});
+    });
+    connect(element, &Node::iconChanged, this, [this, element]() {
+        const auto idx = index(mElements.indexOf(element), 0);
+        emit dataChanged(idx, idx, {IconRole});
+    });
+}
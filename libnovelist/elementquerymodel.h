@@ -0,0 +1,113 @@
+#ifndef LIBNOVELIST_ELEMENTQUERYMODEL_H
+#define LIBNOVELIST_ELEMENTQUERYMODEL_H
+
+#include <QAbstractListModel>
+#include <qqmlintegration.h>
+
+#include "elementquery.h"
+
+class Element;
+class ElementType;
+class Storage;
+
+Q_MOC_INCLUDE("element.h")
+Q_MOC_INCLUDE("elementtype.h")
+Q_MOC_INCLUDE("storage.h")
+
+// The matches of an ElementQuery a page at a time: the view asks for more rows through
+// fetchMore() as it scrolls, and only the elements of the fetched pages are loaded. count is
+// every match, rowCount() the ones fetched so far.
+//
+// storage and elementType refresh at once; a change of the predicates or the sort refreshes when
+// control returns to the event loop, so a query built in several calls runs once.
+class ElementQueryModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+public:
+    enum Role { ElementRole = Qt::UserRole, NameRole, LabelRole, InfoRole, IconRole, UserRole };
+    Q_ENUM(Role)
+
+    enum Operator {
+        Equals = ElementQuery::Equals,
+        NotEquals = ElementQuery::NotEquals,
+        Contains = ElementQuery::Contains,
+        StartsWith = ElementQuery::StartsWith,
+        Less = ElementQuery::Less,
+        LessOrEqual = ElementQuery::LessOrEqual,
+        Greater = ElementQuery::Greater,
+        GreaterOrEqual = ElementQuery::GreaterOrEqual,
+        Exists = ElementQuery::Exists,
+    };
+    Q_ENUM(Operator)
+
+    explicit ElementQueryModel(QObject *parent = nullptr)
+        : QAbstractListModel(parent)
+    {}
+
+    Q_INVOKABLE int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : mElements.size();
+    }
+
+    Q_INVOKABLE QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    QHash<int, QByteArray> roleNames() const override
+    {
+        QHash<int, QByteArray> roleNames = QAbstractListModel::roleNames();
+        roleNames[ElementRole] = "element";
+        roleNames[NameRole] = "name";
+        roleNames[LabelRole] = "label";
+        roleNames[InfoRole] = "info";
+        roleNames[IconRole] = "iconSource";
+        return roleNames;
+    }
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    [[nodiscard]] Storage *storage() const { return mStorage; }
+    void setStorage(Storage *storage);
+
+    [[nodiscard]] ElementType *elementType() const { return mElementType; }
+    void setElementType(ElementType *elementType);
+
+    [[nodiscard]] int pageSize() const { return mPageSize; }
+    void setPageSize(int pageSize);
+
+    [[nodiscard]] int count() const { return mCount; }
+
+    [[nodiscard]] Q_INVOKABLE Element *element(int index) const { return mElements.value(index); }
+
+    Q_INVOKABLE void where(const QString &field, Operator op, const QVariant &value = {});
+    Q_INVOKABLE void orderBy(const QString &field, Qt::SortOrder order = Qt::AscendingOrder);
+    Q_INVOKABLE void clear();
+    Q_INVOKABLE void refresh();
+
+signals:
+    void storageChanged(QPrivateSignal);
+    void elementTypeChanged(QPrivateSignal);
+    void pageSizeChanged(QPrivateSignal);
+    void countChanged(QPrivateSignal);
+
+private:
+    void scheduleRefresh();
+    void watch(Element *element);
+
+    ElementQuery mQuery;
+    QList<Element *> mElements;
+    Storage *mStorage = nullptr;
+    ElementType *mElementType = nullptr;
+    int mPageSize = 50;
+    int mCount = 0;
+    bool mRefreshScheduled = false;
+
+    Q_PROPERTY(Storage *storage READ storage WRITE setStorage NOTIFY storageChanged FINAL)
+    Q_PROPERTY(ElementType *elementType READ elementType WRITE setElementType NOTIFY
+                   elementTypeChanged FINAL)
+    Q_PROPERTY(int pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged FINAL)
+    Q_PROPERTY(int count READ count NOTIFY countChanged FINAL)
+};
+
+#endif // LIBNOVELIST_ELEMENTQUERYMODEL_H
@@ -1,4 +1,5 @@
 #include "elementstorage.h"
+#include "orderkey.h"
 #include "storage.h"
 
 void ElementStorage::setDatabase(const QSqlDatabase &database)
@@ -6,33 +7,36 @@ void ElementStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `Element` (\n"
-                     "  `id`	   INTEGER NOT NULL UNIQUE,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-        executeQuery("CREATE TABLE IF NOT EXISTS `Element_fields` (\n"
-                     "  `id`	        INTEGER NOT NULL UNIQUE,\n"
-                     "  `index`	    INTEGER NOT NULL,\n"
-                     "  `element`     INTEGER NOT NULL,\n"
-                     "  `field`       INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id` AUTOINCREMENT)\n"
-                     ")");
-        executeQuery(
-            "CREATE INDEX IF NOT EXISTS idx_Element_fields_element ON Element_fields(element)");
-        executeQuery(
-            "CREATE INDEX IF NOT EXISTS idx_Element_fields_field ON Element_fields(field)");
-
-        mReloadQuery = createQuery("SELECT * FROM `Element` WHERE `id`=:id");
-        mInsertQuery = createQuery("INSERT INTO `Element` (`id`) VALUES (:id)");
-        mUpdateQuery = createQuery("UPDATE `Element` SET `id`=:id WHERE `id`=:id");
-
-        mReloadFieldsQuery = createQuery(
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `Element` (\n"
+                         "  `id`	   INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+            executeQuery("CREATE TABLE IF NOT EXISTS `Element_fields` (\n"
+                         "  `element` INTEGER NOT NULL,\n"
+                         "  `index`   TEXT NOT NULL,\n"
+                         "  `field`   INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`element`,`index`)\n"
+                         ") WITHOUT ROWID");
+            executeQuery("CREATE INDEX IF NOT EXISTS idx_Element_fields_field ON "
+                         "`Element_fields`(`field`)");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `Element` WHERE `id`=:id");
+        mInsertQuery = lazyQuery("INSERT INTO `Element` (`id`) VALUES (:id)");
+        mUpdateQuery = lazyQuery("UPDATE `Element` SET `id`=:id WHERE `id`=:id");
+
+        mReloadFieldsQuery = lazyQuery(
             "SELECT * FROM `Element_fields` WHERE `element`=:element ORDER BY `index`");
-        mInsertFieldsQuery = createQuery(
+        mInsertFieldsQuery = lazyQuery(
             "INSERT INTO `Element_fields` (`index`,`element`,`field`) VALUES "
             "(:index,:element,:field)");
-        mRemoveFieldsQuery = createQuery("DELETE FROM `Element_fields` WHERE `element`=:element");
+        mRemoveFieldsQuery = lazyQuery("DELETE FROM `Element_fields` WHERE `element`=:element");
+        mRemoveFieldQuery = lazyQuery(
+            "DELETE FROM `Element_fields` WHERE `element`=:element AND `index`=:index");
+        mMoveFieldQuery = lazyQuery("UPDATE `Element_fields` SET `index`=:newIndex WHERE "
+                                    "`element`=:element AND `index`=:index");
     }
 
     emitDatabaseChanged();
@@ -58,9 +62,7 @@ bool ElementStorage::insertNode(Node *node)
 
     updateFields(e);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ElementStorage::updateNode(Node *node)
@@ -79,9 +81,7 @@ bool ElementStorage::updateNode(Node *node)
 
     updateFields(e);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ElementStorage::reloadNode(Node *node)
@@ -96,25 +96,29 @@ bool ElementStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {e->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
     if (!executeQuery(mReloadFieldsQuery, QVariantMap{{":element", e->rowid()}}))
         return handleError(this, "reloadNode", mReloadFieldsQuery), false;
 
     QList<Field *> fs;
-    while (mReloadFieldsQuery.next())
+    QStringList keys;
+    while (mReloadFieldsQuery->next())
         if (Field *f = qobject_cast<Field *>(
-                storage()->fieldStorage()->field(mReloadFieldsQuery.value("field").toInt())))
+                storage()->fieldStorage()->field(mReloadFieldsQuery->value("field").toInt()))) {
             fs.append(f);
-        else
+            keys.append(mReloadFieldsQuery->value("index").toString());
+        } else
             handleError(this, "updateNode", "could not load field");
 
     e->setFields(fs);
+    e->mFieldKeys = keys;
 
-    tx.commit();
+    const Aggregates::Totals totals = storage()->aggregates().totals(e->rowid());
+    e->setCounts(totals.words, totals.characters, totals.elements);
 
-    return true;
+    return tx.commit();
 }
 
 bool ElementStorage::removeNode(int rowid)
@@ -134,7 +138,432 @@ bool ElementStorage::removeNode(int rowid)
         return false;
     }
 
-    tx.commit();
+    return tx.commit();
+}
+
+const ElementStorage::Prototype &ElementStorage::prototype(ElementType *elementType)
+{
+    if (const auto it = mPrototypes.constFind(elementType); it != mPrototypes.constEnd())
+        return *it;
+
+    connect(elementType,
+            &ElementType::fieldTypesChanged,
+            this,
+            [this, elementType]() { mPrototypes.remove(elementType); });
+    connect(elementType, &QObject::destroyed, this, [this, elementType]() {
+        mPrototypes.remove(elementType);
+    });
+
+    return *mPrototypes.insert(elementType, Prototype{elementType->fieldTypes()});
+}
+
+QList<Element *> ElementStorage::createElements(ElementType *elementType, int count)
+{
+    if (!elementType || elementType->rowid() <= 0)
+        return handleError(this, "createElements", "elementType is not saved"), QList<Element *>{};
+    if (isReadOnly())
+        return handleError(this, "createElements", "storage is read-only"), QList<Element *>{};
+    if (count <= 0)
+        return {};
+
+    const QList<FieldType *> fieldTypes = prototype(elementType).fieldTypes;
+    for (FieldType *fieldType : fieldTypes)
+        if (!fieldType || fieldType->rowid() <= 0)
+            return handleError(this, "createElements", "fieldType is not saved"),
+                   QList<Element *>{};
+
+    Transaction tx{Transaction::Write, nullptr, storage()};
+
+    QSqlQuery maxId = createQuery("SELECT IFNULL(MAX(`id`),0) FROM `Storable`", true);
+    if (!executeQuery(maxId) || !maxId.next())
+        return handleError(this, "createElements", maxId), QList<Element *>{};
+    const int firstId = maxId.value(0).toInt() + 1;
+    maxId.finish();
+
+    // each element is followed by its fields, so the ids follow from the position
+    const int stride = int(fieldTypes.size()) + 1;
+    const int total = count * stride;
+
+    const QDateTime createdAt = QDateTime::currentDateTime();
+    const QString createdBy = storage()->stringPool().intern("tomas");
+
+    const QStringList keys = OrderKey::spread(fieldTypes.size());
+
+    QVariantList ids, types, nodeTypes, names, labels, infos, icons;
+    QVariantList elementIds, fieldIds, linkElements, linkIndexes, linkFields;
+    for (QVariantList *list : {&ids, &types, &nodeTypes, &names, &labels, &infos, &icons})
+        list->reserve(total);
+    elementIds.reserve(count);
+    for (QVariantList *list : {&fieldIds, &linkElements, &linkIndexes, &linkFields})
+        list->reserve(total - count);
+
+    for (int e = 0; e < count; ++e) {
+        const int elementId = firstId + e * stride;
+        elementIds.append(elementId);
+
+        for (int i = 0; i < stride; ++i) {
+            const NodeType *nodeType = i == 0 ? static_cast<NodeType *>(elementType)
+                                              : fieldTypes[i - 1];
+            ids.append(elementId + i);
+            types.append(i == 0 ? int(Storable::Type_Element) : int(Storable::Type_Field));
+            nodeTypes.append(nodeType->rowid());
+            names.append(nodeType->name());
+            labels.append(nodeType->label());
+            infos.append(nodeType->info());
+            icons.append(nodeType->icon());
+
+            if (i > 0) {
+                fieldIds.append(elementId + i);
+                linkElements.append(elementId);
+                linkIndexes.append(keys[i - 1]);
+                linkFields.append(elementId + i);
+            }
+        }
+    }
+
+    QSqlQuery storables = createQuery(
+        "INSERT INTO `Storable` (`id`,`type`,`version`,`createdAt`,`createdBy`) VALUES "
+        "(:id,:type,:version,:createdAt,:createdBy)");
+    QSqlQuery nodes = createQuery(
+        "INSERT INTO `Node` (`id`,`nodeType`,`name`,`label`,`info`,`icon`) VALUES "
+        "(:id,:nodeType,:name,:label,:info,:icon)");
+    QSqlQuery elements = createQuery("INSERT INTO `Element` (`id`) VALUES (:id)");
+    QSqlQuery fields = createQuery(
+        "INSERT INTO `Field` (`id`,`minOccurs`,`maxOccurs`) VALUES (:id,:minOccurs,:maxOccurs)");
+    QSqlQuery links = createQuery("INSERT INTO `Element_fields` (`element`,`index`,`field`) "
+                                  "VALUES (:element,:index,:field)");
+    // the new elements hold no values, each counts only itself
+    QSqlQuery aggregates = createQuery("INSERT OR REPLACE INTO `Aggregate` (`node`,`elements`) "
+                                       "VALUES (:node,:elements)");
+
+    if (!executeBatch(storables,
+                      QVariantMap{{":id", ids},
+                                  {":type", types},
+                                  {":version", QVariantList(total, 1)},
+                                  {":createdAt",
+                                   QVariantList(total, createdAt.toMSecsSinceEpoch())},
+                                  {":createdBy", QVariantList(total, createdBy)}})
+        || !executeBatch(nodes,
+                         QVariantMap{{":id", ids},
+                                     {":nodeType", nodeTypes},
+                                     {":name", names},
+                                     {":label", labels},
+                                     {":info", infos},
+                                     {":icon", icons}})
+        || !executeBatch(elements, QVariantMap{{":id", elementIds}})
+        || !executeBatch(aggregates,
+                         QVariantMap{{":node", elementIds},
+                                     {":elements", QVariantList(count, 1)}}))
+        return handleError(this, "createElements", "could not insert the elements"),
+               QList<Element *>{};
+
+    if (!fieldIds.isEmpty()
+        && (!executeBatch(fields,
+                          QVariantMap{{":id", fieldIds},
+                                      {":minOccurs", QVariantList(fieldIds.size(), -1)},
+                                      {":maxOccurs", QVariantList(fieldIds.size(), -1)}})
+            || !executeBatch(links,
+                             QVariantMap{{":element", linkElements},
+                                         {":index", linkIndexes},
+                                         {":field", linkFields}})))
+        return handleError(this, "createElements", "could not insert the fields"),
+               QList<Element *>{};
+
+    if (!tx.commit())
+        return QList<Element *>{};
+
+    // the rows are written, the objects are filled in as if they were loaded
+    FieldStorage *fieldStorage = storage()->fieldStorage();
+    const auto adopt = [&](Node *node, int rowid) {
+        node->setRowid(rowid);
+        node->setVersion(1);
+        node->setCreatedAt(createdAt);
+        node->setCreatedBy(createdBy);
+    };
+
+    QList<Element *> result;
+    result.reserve(count);
+    for (int e = 0; e < count; ++e) {
+        const int elementId = firstId + e * stride;
+
+        QList<Field *> elementFields;
+        elementFields.reserve(fieldTypes.size());
+        for (int i = 0; i < fieldTypes.size(); ++i) {
+            Field *field = fieldStorage->field();
+            field->setLoading(true);
+            field->setNodeType(fieldTypes[i]);
+            adopt(field, elementId + i + 1);
+            fieldStorage->mNodesByRowid.insert(field->rowid(), field);
+            elementFields.append(field);
+        }
+
+        Element *element = static_cast<Element *>(node());
+        element->setLoading(true);
+        adopt(element, elementId);
+        mNodesByRowid.insert(elementId, element);
+        element->instantiate(elementType, elementFields);
+        element->mFieldKeys = keys;
+        element->setCounts(0, 0, 1);
+
+        for (Field *field : std::as_const(elementFields)) {
+            field->setModified(false);
+            field->setLoading(false);
+        }
+        element->setModified(false);
+        element->setLoading(false);
+
+        result.append(element);
+    }
+
+    return result;
+}
+
+QList<int> ElementStorage::collectSubtree(int rowid)
+{
+    if (!executeQuery("CREATE TEMP TABLE IF NOT EXISTS `Subtree` (`id` INTEGER PRIMARY KEY)")
+        || !executeQuery("DELETE FROM temp.`Subtree`"))
+        return handleError(this, "collectSubtree", "could not prepare the subtree table"),
+               QList<int>{};
+
+    if (!executeQuery("CREATE TEMP TABLE IF NOT EXISTS `Shared` (`id` INTEGER PRIMARY KEY)")
+        || !executeQuery("DELETE FROM temp.`Shared`"))
+        return handleError(this, "collectSubtree", "could not prepare the shared table"),
+               QList<int>{};
+
+    // the element, its fields, their values, and the elements held by node values, recursively,
+    // except the shared ones
+    QSqlQuery closure = createQuery(
+        QStringLiteral(
+            "WITH RECURSIVE `closure`(`id`) AS (\n"
+            "  SELECT `id` FROM `Storable` WHERE `id`=:id AND `type`=%1\n"
+            "  UNION\n"
+            "  SELECT ef.`field` FROM `Element_fields` ef JOIN `closure` c ON ef.`element`=c.`id`\n"
+            "  UNION\n"
+            "  SELECT fv.`value` FROM `Field_values` fv JOIN `closure` c ON fv.`field`=c.`id`\n"
+            "  UNION\n"
+            "  SELECT s.`id` FROM `Value` v JOIN `closure` c ON v.`id`=c.`id` JOIN `Storable` s "
+            "ON s.`id`=CAST(v.`value` AS INTEGER) WHERE v.`valueType`=%2 AND s.`type`=%1 AND "
+            "s.`id` NOT IN (SELECT `id` FROM temp.`Shared`)\n"
+            ")\n"
+            "INSERT INTO temp.`Subtree` (`id`) SELECT `id` FROM `closure`")
+            .arg(Storable::Type_Element)
+            .arg(Value::Type_Node));
+
+    // an element below the root that a node value outside refers to as well is only referenced,
+    // e.g. a character linked from a scene; it stays, and so does what only it holds
+    QSqlQuery shared = createQuery(
+        QStringLiteral("INSERT OR IGNORE INTO temp.`Shared` (`id`) SELECT t.`id` FROM "
+                       "temp.`Subtree` t JOIN `Storable` s ON s.`id`=t.`id` AND s.`type`=%1 "
+                       "JOIN `Value` v ON v.`valueType`=%2 AND v.`value`=CAST(t.`id` AS TEXT) "
+                       "WHERE t.`id`<>:id AND v.`id` NOT IN (SELECT `id` FROM temp.`Subtree`)")
+            .arg(Storable::Type_Element)
+            .arg(Value::Type_Node));
+
+    // leaving a shared element out can leave another one referenced from outside only now
+    for (;;) {
+        if (!executeQuery("DELETE FROM temp.`Subtree`"))
+            return handleError(this, "collectSubtree", "could not clear the subtree table"),
+                   QList<int>{};
+        if (!executeQuery(closure, QVariantMap{{":id", rowid}}))
+            return handleError(this, "collectSubtree", closure), QList<int>{};
+        if (!executeQuery(shared, QVariantMap{{":id", rowid}}))
+            return handleError(this, "collectSubtree", shared), QList<int>{};
+        if (shared.numRowsAffected() <= 0)
+            break;
+    }
+
+    QSqlQuery ids = createQuery("SELECT `id` FROM temp.`Subtree`", true);
+    if (!executeQuery(ids))
+        return handleError(this, "collectSubtree", ids), QList<int>{};
+
+    QList<int> rowids;
+    while (ids.next())
+        rowids.append(ids.value(0).toInt());
+    ids.finish();
+
+    return rowids;
+}
+
+int ElementStorage::cloneSubtree(int rowid)
+{
+    if (rowid <= 0)
+        return handleError(this, "cloneSubtree", "rowid is invalid"), 0;
+    if (isReadOnly())
+        return handleError(this, "cloneSubtree", "storage is read-only"), 0;
+
+    Transaction tx{Transaction::Write, nullptr, storage()};
+
+    if (collectSubtree(rowid).isEmpty())
+        return handleError(this, "cloneSubtree", "rowid is not an element"), 0;
+
+    if (!executeQuery("CREATE TEMP TABLE IF NOT EXISTS `CloneMap` (\n"
+                      "  `oldId` INTEGER PRIMARY KEY,\n"
+                      "  `newId` INTEGER NOT NULL\n"
+                      ")")
+        || !executeQuery("DELETE FROM temp.`CloneMap`"))
+        return handleError(this, "cloneSubtree", "could not prepare the clone map"), 0;
+
+    // the copies take the ids after the highest one in use, in the order of the originals
+    if (!executeQuery("INSERT INTO temp.`CloneMap` (`oldId`,`newId`) SELECT `id`,(SELECT "
+                      "IFNULL(MAX(`id`),0) FROM `Storable`)+ROW_NUMBER() OVER (ORDER BY `id`) "
+                      "FROM temp.`Subtree`"))
+        return handleError(this, "cloneSubtree", "could not map the ids"), 0;
+
+    const qint64 createdAt = QDateTime::currentDateTime().toMSecsSinceEpoch();
+    const QString createdBy = storage()->stringPool().intern("tomas");
+
+    if (!executeQuery("INSERT INTO `Storable` (`id`,`type`,`version`,`createdAt`,`createdBy`) "
+                      "SELECT m.`newId`,s.`type`,1,:createdAt,:createdBy FROM temp.`CloneMap` m "
+                      "JOIN `Storable` s ON s.`id`=m.`oldId`",
+                      QVariantMap{{":createdAt", createdAt}, {":createdBy", createdBy}}))
+        return handleError(this, "cloneSubtree", "could not copy Storable"), 0;
+
+    // node values that hold an element of the subtree hold its copy
+    static const QStringList statements = {
+        "INSERT INTO `Node` (`id`,`nodeType`,`name`,`label`,`info`,`icon`) SELECT m.`newId`,"
+        "n.`nodeType`,n.`name`,n.`label`,n.`info`,n.`icon` FROM temp.`CloneMap` m JOIN `Node` n "
+        "ON n.`id`=m.`oldId`",
+        "INSERT INTO `Element` (`id`) SELECT m.`newId` FROM temp.`CloneMap` m JOIN `Element` e "
+        "ON e.`id`=m.`oldId`",
+        "INSERT INTO `Field` (`id`,`minOccurs`,`maxOccurs`) SELECT m.`newId`,f.`minOccurs`,"
+        "f.`maxOccurs` FROM temp.`CloneMap` m JOIN `Field` f ON f.`id`=m.`oldId`",
+        "INSERT INTO `Field_allowedTypes` (`field`,`index`,`type`) SELECT m.`newId`,a.`index`,"
+        "a.`type` FROM temp.`CloneMap` m JOIN `Field_allowedTypes` a ON a.`field`=m.`oldId`",
+        QStringLiteral("INSERT INTO `Value` (`id`,`valueType`,`value`) SELECT m.`newId`,"
+                       "v.`valueType`,IFNULL(r.`newId`,v.`value`) FROM temp.`CloneMap` m JOIN "
+                       "`Value` v ON v.`id`=m.`oldId` LEFT JOIN temp.`CloneMap` r ON "
+                       "v.`valueType`=%1 AND r.`oldId`=CAST(v.`value` AS INTEGER)")
+            .arg(Value::Type_Node),
+        "INSERT INTO `ValueChunk` (`value`,`index`,`text`,`packed`,`words`,`characters`) SELECT "
+        "m.`newId`,c.`index`,c.`text`,c.`packed`,c.`words`,c.`characters` FROM temp.`CloneMap` m "
+        "JOIN `ValueChunk` c ON c.`value`=m.`oldId`",
+        "INSERT INTO `Element_fields` (`element`,`index`,`field`) SELECT e.`newId`,ef.`index`,"
+        "f.`newId` FROM `Element_fields` ef JOIN temp.`CloneMap` e ON e.`oldId`=ef.`element` "
+        "JOIN temp.`CloneMap` f ON f.`oldId`=ef.`field`",
+        "INSERT INTO `Field_values` (`field`,`index`,`value`) SELECT f.`newId`,fv.`index`,"
+        "v.`newId` FROM `Field_values` fv JOIN temp.`CloneMap` f ON f.`oldId`=fv.`field` "
+        "JOIN temp.`CloneMap` v ON v.`oldId`=fv.`value`",
+        // a copy has the totals of its original, the subtree is closed under its links
+        "INSERT INTO `Aggregate` (`node`,`words`,`characters`,`elements`) SELECT m.`newId`,"
+        "a.`words`,a.`characters`,a.`elements` FROM temp.`CloneMap` m JOIN `Aggregate` a ON "
+        "a.`node`=m.`oldId`"};
+
+    for (const auto &statement : statements)
+        if (!executeQuery(statement))
+            return handleError(this, "cloneSubtree", statement), 0;
+
+    QSqlQuery root = createQuery("SELECT `newId` FROM temp.`CloneMap` WHERE `oldId`=:id", true);
+    if (!executeQuery(root, QVariantMap{{":id", rowid}}) || !root.next())
+        return handleError(this, "cloneSubtree", root), 0;
+    const int clone = root.value(0).toInt();
+    root.finish();
+
+    if (!executeQuery("DELETE FROM temp.`CloneMap`") || !executeQuery("DELETE FROM temp.`Subtree`")
+        || !executeQuery("DELETE FROM temp.`Shared`"))
+        return handleError(this, "cloneSubtree", "could not clear the clone map"), 0;
+
+    if (!tx.commit())
+        return 0;
+
+    return clone;
+}
+
+bool ElementStorage::removeSubtree(int rowid)
+{
+    if (rowid <= 0)
+        return handleError(this, "removeSubtree", "rowid is invalid"), false;
+    if (isReadOnly())
+        return handleError(this, "removeSubtree", "storage is read-only"), false;
+
+    Transaction tx{Transaction::Write, nullptr, storage()};
+
+    QList<int> rowids = collectSubtree(rowid);
+    if (rowids.isEmpty())
+        return handleError(this, "removeSubtree", "rowid is not an element"), false;
+
+    // the node values outside that hold the element, as its parent's does, would be left
+    // pointing at a rowid that can be handed out again; they go with the subtree
+    QSqlQuery references = createQuery(
+        QStringLiteral("SELECT `id` FROM `Value` WHERE `valueType`=%1 AND `value`=CAST(:id AS "
+                       "TEXT) AND `id` NOT IN (SELECT `id` FROM temp.`Subtree`)")
+            .arg(Value::Type_Node),
+        true);
+    if (!executeQuery(references, QVariantMap{{":id", rowid}}))
+        return handleError(this, "removeSubtree", references), false;
+    while (references.next())
+        rowids.append(references.value(0).toInt());
+    references.finish();
+
+    if (!executeQuery("INSERT OR IGNORE INTO temp.`Subtree` (`id`) SELECT `id` FROM `Value` "
+                      "WHERE `valueType`=:valueType AND `value`=CAST(:id AS TEXT)",
+                      QVariantMap{{":valueType", Value::Type_Node}, {":id", rowid}}))
+        return handleError(this, "removeSubtree", "could not collect the references"), false;
+
+    // the nodes outside that hold part of the subtree lose its totals
+    QSqlQuery outside = createQuery(
+        "SELECT `field` FROM `Field_values` WHERE `value` IN (SELECT `id` FROM temp.`Subtree`) "
+        "UNION SELECT `element` FROM `Element_fields` WHERE `field` IN (SELECT `id` FROM "
+        "temp.`Subtree`)",
+        true);
+    if (!executeQuery(outside))
+        return handleError(this, "removeSubtree", outside), false;
+
+    const QSet<int> removed{rowids.cbegin(), rowids.cend()};
+    QList<int> parents;
+    while (outside.next())
+        if (const int id = outside.value(0).toInt(); !removed.contains(id))
+            parents.append(id);
+    outside.finish();
+
+    // links from outside the subtree go too, the reverse indexes find them
+    static const QStringList statements = {
+        "DELETE FROM `Element_fields` WHERE `element` IN (SELECT `id` FROM temp.`Subtree`) OR "
+        "`field` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Field_values` WHERE `field` IN (SELECT `id` FROM temp.`Subtree`) OR "
+        "`value` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Field_allowedTypes` WHERE `field` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Value` WHERE `id` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `ValueChunk` WHERE `value` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Field` WHERE `id` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Element` WHERE `id` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Node` WHERE `id` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Storable` WHERE `id` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM `Aggregate` WHERE `node` IN (SELECT `id` FROM temp.`Subtree`)",
+        "DELETE FROM temp.`Subtree`",
+        "DELETE FROM temp.`Shared`"};
+
+    for (const auto &statement : statements)
+        if (!executeQuery(statement))
+            return handleError(this, "removeSubtree", statement), false;
+
+    for (const int parent : std::as_const(parents))
+        if (!storage()->aggregates().update(parent))
+            return false;
+
+    if (!tx.commit())
+        return false;
+
+    // the rows are gone, so the loaded nodes are only detached from their owners outside the
+    // subtree and recycled
+    QList<Node *> nodes;
+    for (const int id : std::as_const(rowids))
+        if (Node *node = storage()->loadedNode(id))
+            nodes.append(node);
+
+    for (Node *node : std::as_const(nodes)) {
+        if (Value *value = qobject_cast<Value *>(node)) {
+            for (Field *field : value->fields())
+                if (!removed.contains(field->rowid()))
+                    field->removeValue(value);
+        } else if (Field *field = qobject_cast<Field *>(node)) {
+            for (Element *element : field->elements())
+                if (!removed.contains(element->rowid()))
+                    element->removeField(field);
+        }
+    }
+
+    for (Node *node : std::as_const(nodes))
+        node->recycle();
 
     return true;
 }
@@ -149,6 +578,8 @@ bool ElementStorage::updateFields(Element *element)
     if (!executeQuery(mRemoveFieldsQuery, QVariantMap{{":element", element->rowid()}}))
         return handleError(this, "updateNode", mRemoveFieldsQuery), false;
 
+    const QStringList keys = OrderKey::spread(element->mFields.size());
+
     int index = 0;
     for (Field *field : element->fields()) {
         if (!field->save(true)) {
@@ -157,7 +588,7 @@ bool ElementStorage::updateFields(Element *element)
         }
 
         if (!executeQuery(mInsertFieldsQuery,
-                          QVariantMap{{":index", index},
+                          QVariantMap{{":index", keys[index]},
                                       {":element", element->rowid()},
                                       {":field", field->rowid()}}))
             return handleError(this, "updateNode", mInsertFieldsQuery), false;
@@ -165,7 +596,108 @@ bool ElementStorage::updateFields(Element *element)
         ++index;
     }
 
-    tx.commit();
+    if (!storage()->aggregates().update(element->rowid()))
+        return false;
+
+    if (!tx.commit())
+        return false;
+
+    element->mFieldKeys = keys;
+
+    return true;
+}
+
+bool ElementStorage::insertFieldLink(Element *element, int position)
+{
+    if (element->rowid() <= 0)
+        return false;
+
+    QStringList &keys = element->mFieldKeys;
+    if (keys.size() != element->mFields.size() - 1)
+        return updateFields(element);
+
+    const QString key = OrderKey::between(keys.value(position - 1), keys.value(position));
+    if (!OrderKey::isUsable(key))
+        return updateFields(element);
+
+    Transaction tx{Transaction::Write, element, storage()};
+
+    Field *field = element->mFields[position];
+    if (!field->save(true))
+        return handleError(this, "insertFieldLink", "field could not be saved"), false;
+
+    if (!executeQuery(mInsertFieldsQuery,
+                      QVariantMap{{":index", key},
+                                  {":element", element->rowid()},
+                                  {":field", field->rowid()}}))
+        return handleError(this, "insertFieldLink", mInsertFieldsQuery), false;
+
+    if (!storage()->aggregates().update(element->rowid()))
+        return false;
+
+    if (!tx.commit())
+        return false;
+
+    keys.insert(position, key);
+
+    return true;
+}
+
+bool ElementStorage::removeFieldLink(Element *element, int position)
+{
+    if (element->rowid() <= 0)
+        return false;
+
+    QStringList &keys = element->mFieldKeys;
+    if (keys.size() != element->mFields.size() + 1)
+        return updateFields(element);
+
+    Transaction tx{Transaction::Write, element, storage()};
+
+    if (!executeQuery(mRemoveFieldQuery,
+                      QVariantMap{{":element", element->rowid()}, {":index", keys[position]}}))
+        return handleError(this, "removeFieldLink", mRemoveFieldQuery), false;
+
+    if (!storage()->aggregates().update(element->rowid()))
+        return false;
+
+    if (!tx.commit())
+        return false;
+
+    keys.removeAt(position);
+
+    return true;
+}
+
+bool ElementStorage::moveFieldLink(Element *element, int from, int to)
+{
+    if (element->rowid() <= 0)
+        return false;
+
+    QStringList &keys = element->mFieldKeys;
+    if (keys.size() != element->mFields.size())
+        return updateFields(element);
+
+    // the key between the neighbours at to, once the moved field is out of the list
+    QStringList others = keys;
+    const QString oldKey = others.takeAt(from);
+    const QString key = OrderKey::between(others.value(to - 1), others.value(to));
+    if (!OrderKey::isUsable(key))
+        return updateFields(element);
+
+    Transaction tx{Transaction::Write, element, storage()};
+
+    if (!executeQuery(mMoveFieldQuery,
+                      QVariantMap{{":newIndex", key},
+                                  {":element", element->rowid()},
+                                  {":index", oldKey}}))
+        return handleError(this, "moveFieldLink", mMoveFieldQuery), false;
+
+    if (!tx.commit())
+        return false;
+
+    others.insert(to, key);
+    keys = others;
 
     return true;
 }
@@ -28,7 +28,7 @@ public:
                                                      const QString& info = {},
                                                      const QString& icon = {})
     {
-        if (Element* e = static_cast<Element*>(createNode())) {
+        if (Element* e = static_cast<Element*>(newNode())) {
             e->setNodeType(nodeType);
             e->setLabel(label);
             e->setInfo(info);
@@ -38,6 +38,18 @@ public:
         return nullptr;
     }
 
+    // Creates count elements of elementType with their fields, with one batched INSERT per
+    // table. The elements are saved, elementType and its field types have to be saved too.
+    Q_INVOKABLE QList<Element*> createElements(ElementType* elementType, int count);
+
+    // Deletes the element with everything below it, its fields, their values and the elements
+    // of node values, with a few set-based statements instead of a removeNode() per row. The node
+    // values outside that hold the element go too, the loaded ones are taken out of their fields.
+    Q_INVOKABLE bool removeSubtree(int rowid);
+    // Copies the element with everything below it with one INSERT ... SELECT per table, and
+    // returns the rowid of the copy, 0 if it failed.
+    Q_INVOKABLE int cloneSubtree(int rowid);
+
 protected:
     [[nodiscard]] Node* createNode() override;
     bool insertNode(Node* node) override;
@@ -45,18 +57,39 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
+    // Rewrites all the rows of the element's fields, with freshly spread order keys.
     bool updateFields(Element* element);
+    // Write the one row of the field inserted, removed or moved at a position, and fall back to
+    // updateFields() when the keys are out of step or there's no short key left between two.
+    bool insertFieldLink(Element* element, int position);
+    bool removeFieldLink(Element* element, int position);
+    bool moveFieldLink(Element* element, int from, int to);
+    // Fills temp.Subtree with the rowids below the element rowid, and returns them. An element
+    // that a node value outside the subtree refers to as well is shared, not owned: it is left
+    // out with what only it holds, and the node values inside keep referring to it.
+    QList<int> collectSubtree(int rowid);
 
     friend class Element;
     friend class Storage;
     friend class ProjectStorage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
-    QSqlQuery mReloadFieldsQuery;
-    QSqlQuery mInsertFieldsQuery;
-    QSqlQuery mRemoveFieldsQuery;
+    // The field layout an element of a type starts with, kept until the field types change.
+    struct Prototype
+    {
+        QList<FieldType*> fieldTypes;
+    };
+    const Prototype& prototype(ElementType* elementType);
+
+    QHash<ElementType*, Prototype> mPrototypes;
+
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
+    PreparedQuery mReloadFieldsQuery;
+    PreparedQuery mInsertFieldsQuery;
+    PreparedQuery mRemoveFieldsQuery;
+    PreparedQuery mRemoveFieldQuery;
+    PreparedQuery mMoveFieldQuery;
 };
 
 #endif // LIBNOVELIST_ELEMENTSTORAGE_H
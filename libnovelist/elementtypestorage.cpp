@@ -7,36 +7,35 @@ void ElementTypeStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `ElementType` (\n"
-                     "  `id`          INTEGER NOT NULL UNIQUE,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-        executeQuery("CREATE TABLE IF NOT EXISTS `ElementType_fieldTypes` (\n"
-                     "  `id`	        INTEGER NOT NULL UNIQUE,\n"
-                     "  `index`	    INTEGER NOT NULL,\n"
-                     "  `elementType` INTEGER NOT NULL,\n"
-                     "  `fieldType`   INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id` AUTOINCREMENT)\n"
-                     ")");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_ElementType_fieldTypes_elementType ON "
-                     "ElementType_fieldTypes(elementType)");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_ElementType_fieldTypes_fieldType ON "
-                     "ElementType_fieldTypes(fieldType)");
-
-        mReloadQuery = createQuery("SELECT * FROM `ElementType` WHERE `id`=:id");
-        mInsertQuery = createQuery("INSERT INTO `ElementType` (`id`) VALUES (:id)");
-        mUpdateQuery = createQuery("UPDATE `ElementType` SET `id`=:id WHERE `id`=:id");
-
-        mReloadFieldTypesQuery = createQuery("SELECT * FROM `ElementType_fieldTypes` WHERE "
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `ElementType` (\n"
+                         "  `id`          INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+            executeQuery("CREATE TABLE IF NOT EXISTS `ElementType_fieldTypes` (\n"
+                         "  `elementType` INTEGER NOT NULL,\n"
+                         "  `index`       INTEGER NOT NULL,\n"
+                         "  `fieldType`   INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`elementType`,`index`)\n"
+                         ") WITHOUT ROWID");
+            executeQuery("CREATE INDEX IF NOT EXISTS idx_ElementType_fieldTypes_fieldType ON "
+                         "`ElementType_fieldTypes`(`fieldType`)");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `ElementType` WHERE `id`=:id");
+        mInsertQuery = lazyQuery("INSERT INTO `ElementType` (`id`) VALUES (:id)");
+        mUpdateQuery = lazyQuery("UPDATE `ElementType` SET `id`=:id WHERE `id`=:id");
+
+        mReloadFieldTypesQuery = lazyQuery("SELECT * FROM `ElementType_fieldTypes` WHERE "
                                              "`elementType`=:elementType ORDER BY `index`");
-        mInsertFieldTypesQuery = createQuery(
+        mInsertFieldTypesQuery = lazyQuery(
             "INSERT INTO `ElementType_fieldTypes` (`index`,`elementType`,`fieldType`) VALUES "
             "(:index,:elementType,:fieldType)");
-        mUpdateFieldTypesQuery = createQuery(
-            "UPDATE `ElementType_fieldTypes` SET "
-            "`index`=:index,`elementType`=:elementType,`fieldType`=:fieldType WHERE `id`=:id");
-        mRemoveFieldTypesQuery = createQuery(
+        mUpdateFieldTypesQuery = lazyQuery(
+            "UPDATE `ElementType_fieldTypes` SET `fieldType`=:fieldType WHERE "
+            "`elementType`=:elementType AND `index`=:index");
+        mRemoveFieldTypesQuery = lazyQuery(
             "DELETE FROM `ElementType_fieldTypes` WHERE `elementType`=:elementType");
     }
 }
@@ -65,9 +64,7 @@ bool ElementTypeStorage::insertNode(Node *node)
 
     updateFieldTypes(elementType);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ElementTypeStorage::updateNode(Node *node)
@@ -86,9 +83,7 @@ bool ElementTypeStorage::updateNode(Node *node)
 
     updateFieldTypes(elementType);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ElementTypeStorage::reloadNode(Node *node)
@@ -103,15 +98,15 @@ bool ElementTypeStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {elementType->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
     if (!executeQuery(mReloadFieldTypesQuery, QVariantMap{{":elementType", elementType->rowid()}}))
         return handleError(this, "reloadNode", mReloadFieldTypesQuery), false;
 
     QList<FieldType *> fieldTypes;
-    while (mReloadFieldTypesQuery.next()) {
-        const int rowid = mReloadFieldTypesQuery.value("fieldType").toInt();
+    while (mReloadFieldTypesQuery->next()) {
+        const int rowid = mReloadFieldTypesQuery->value("fieldType").toInt();
         if (FieldType *fieldType = qobject_cast<FieldType *>(
                 storage()->fieldTypeStorage()->fieldType(rowid)))
             fieldTypes.append(fieldType);
@@ -120,9 +115,7 @@ bool ElementTypeStorage::reloadNode(Node *node)
     }
     elementType->setFieldTypes(fieldTypes);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ElementTypeStorage::removeNode(int rowid)
@@ -140,9 +133,7 @@ bool ElementTypeStorage::removeNode(int rowid)
     if (!executeQuery(mRemoveFieldTypesQuery, QVariantMap{{":elementType", rowid}}))
         return handleError(this, "removeNode", mRemoveFieldTypesQuery), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ElementTypeStorage::updateFieldTypes(ElementType *elementType)
@@ -174,7 +165,45 @@ bool ElementTypeStorage::updateFieldTypes(ElementType *elementType)
         ++index;
     }
 
-    tx.commit();
+    return tx.commit();
+}
+
+bool ElementTypeStorage::loadTypes()
+{
+    return loadTypeTable("ElementType", Storable::Type_ElementType);
+}
+
+bool ElementTypeStorage::loadFieldTypes()
+{
+    QSqlQuery query = createQuery("SELECT `elementType`,`fieldType` FROM `ElementType_fieldTypes` "
+                                  "ORDER BY `elementType`,`index`",
+                                  true);
+    if (!executeQuery(query))
+        return handleError(this, "loadFieldTypes", query), false;
+
+    QHash<int, QList<FieldType *>> fieldTypes;
+    while (query.next()) {
+        const int rowid = query.value("fieldType").toInt();
+        if (FieldType *fieldType = storage()->fieldTypeStorage()->fieldType(rowid))
+            fieldTypes[query.value("elementType").toInt()].append(fieldType);
+        else
+            handleError(this, "loadFieldTypes", "could not load fieldType");
+    }
+
+    for (auto it = fieldTypes.constBegin(); it != fieldTypes.constEnd(); ++it) {
+        // project types keep their field types in the same table
+        ElementType *elementType = qobject_cast<ElementType *>(mNodesByRowid.value(it.key()));
+        if (!elementType)
+            elementType = storage()->projectTypeStorage()->projectType(it.key());
+        if (!elementType) {
+            handleError(this, "loadFieldTypes", "could not load elementType");
+            continue;
+        }
+
+        Transaction tx{Transaction::ReadModified, elementType, storage()};
+        elementType->setFieldTypes(it.value());
+        tx.commit();
+    }
 
     return true;
 }
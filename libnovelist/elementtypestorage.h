@@ -36,19 +36,19 @@ public:
         if (name.isEmpty())
             return handleError(this, "removeNode", "name is empty"), nullptr;
 
-        if (mNodesByName.contains(name))
+        if (nodeType(name))
             return handleError(
                        this,
                        "removeNode",
                        QStringLiteral("storage already contains a type with name '%1'").arg(name)),
                    nullptr;
 
-        if (ElementType* elementType = static_cast<ElementType*>(createNode())) {
-            mNodesByName.insert(name, elementType);
+        if (ElementType* elementType = static_cast<ElementType*>(newNode())) {
             elementType->setName(name);
             elementType->setLabel(label);
             elementType->setInfo(info);
             elementType->setIcon(icon);
+            rebuildCatalog();
             return elementType;
         }
 
@@ -64,19 +64,23 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
+    bool loadTypes();
+    // Links the field types of all element and project types, after loadTypes().
+    bool loadFieldTypes();
+
     bool updateFieldTypes(ElementType* elementType);
 
     friend class ElementType;
     friend class Storage;
     friend class ProjectTypeStorage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
-    QSqlQuery mReloadFieldTypesQuery;
-    QSqlQuery mInsertFieldTypesQuery;
-    QSqlQuery mUpdateFieldTypesQuery;
-    QSqlQuery mRemoveFieldTypesQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
+    PreparedQuery mReloadFieldTypesQuery;
+    PreparedQuery mInsertFieldTypesQuery;
+    PreparedQuery mUpdateFieldTypesQuery;
+    PreparedQuery mRemoveFieldTypesQuery;
 };
 
 #endif // LIBNOVELIST_ELEMENTTYPESTORAGE_H
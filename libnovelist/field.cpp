@@ -62,7 +62,7 @@ bool Field::insertValue(int index, Value *value)
     if (!qobject_cast<Field *>(value->parent()))
         value->setParent(this);
 
-    if (!updateValues())
+    if (!insertValueLink(index))
         setModified(true);
 
     emit valuesAdded(index, index, QPrivateSignal{});
@@ -97,7 +97,7 @@ bool Field::removeValueAt(int index)
     if (value->parent() == this)
         value->recycle();
 
-    if (!updateValues())
+    if (!removeValueLink(index))
         setModified(true);
 
     emit valuesRemoved(index, index, QPrivateSignal{});
@@ -105,11 +105,40 @@ bool Field::removeValueAt(int index)
     return true;
 }
 
+bool Field::moveValue(int from, int to)
+{
+    if (from < 0 || from >= mValues.size() || to < 0 || to >= mValues.size())
+        return handleError(this, "moveValue", "index out of range"), false;
+
+    if (from == to)
+        return true;
+
+    mValues.move(from, to);
+
+    if (!moveValueLink(from, to))
+        setModified(true);
+
+    emit valuesChanged(QPrivateSignal{});
+    return true;
+}
+
 int Field::indexIn(Element *element) const
 {
     return element->fields().indexOf(this);
 }
 
+int Field::conversion(int typeId) const
+{
+    if (!mAllowedTypes.isEmpty() || !fieldType())
+        return Value::conversion(mAllowedTypes, typeId);
+    return fieldType()->conversion(typeId);
+}
+
+QVariant Field::computedValue() const
+{
+    return storage()->computedFields()->value(const_cast<Field *>(this));
+}
+
 ValueListModel *Field::valueListModel()
 {
     if (!mValueListModel) {
@@ -178,6 +207,27 @@ bool Field::updateValues()
     return storage()->fieldStorage()->updateValues(this);
 }
 
+bool Field::insertValueLink(int index)
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->fieldStorage()->insertValueLink(this, index);
+}
+
+bool Field::removeValueLink(int index)
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->fieldStorage()->removeValueLink(this, index);
+}
+
+bool Field::moveValueLink(int from, int to)
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->fieldStorage()->moveValueLink(this, from, to);
+}
+
 bool Field::updateAllowedTypes()
 {
     if (rowid() <= 0 || isLoading() || isSaving())
@@ -98,6 +98,7 @@ public:
         return true;
     }
     bool removeValueAt(int index);
+    bool moveValue(int from, int to);
     Value* takeValueAt(int index)
     {
         if (index < 0 || index >= mValues.size())
@@ -144,6 +145,10 @@ public:
         setAllowedTypes(allowedTypes);
     }
 
+    // The conversion plan entry for a value of metatype typeId, see Value::conversion(). A field
+    // with allowed types of its own works it out each time, the others share their type's plan.
+    [[nodiscard]] int conversion(int typeId) const;
+
     [[nodiscard]] int minOccurs() const
     {
         return mMinOccurs < 0 ? fieldType()->minOccurs() : mMinOccurs;
@@ -180,6 +185,10 @@ public:
 
     [[nodiscard]] Q_INVOKABLE int indexIn(Element *element) const;
 
+    // The value a field whose type has a formula computes, kept by ComputedFields.
+    [[nodiscard]] QVariant computedValue() const;
+    [[nodiscard]] bool isComputed() const { return fieldType() && fieldType()->isComputed(); }
+
     [[nodiscard]] ValueListModel *valueListModel();
 
 signals:
@@ -190,12 +199,16 @@ signals:
     void allowedTypesChanged(QPrivateSignal);
     void minOccursChanged(QPrivateSignal);
     void maxOccursChanged(QPrivateSignal);
+    void computedValueChanged(QPrivateSignal);
 
 protected:
     bool readJson(const QJsonObject &json, QStringList *errors = nullptr) override;
     bool writeJson(QJsonObject &json, QStringList *errors = nullptr) const override;
 
     bool updateValues();
+    bool insertValueLink(int index);
+    bool removeValueLink(int index);
+    bool moveValueLink(int from, int to);
     bool updateAllowedTypes();
     bool updateMinOccurs();
     bool updateMaxOccurs();
@@ -203,11 +216,14 @@ protected:
 private:
     QList<Element*> mElements;
     QList<Value*> mValues;
+    // The order keys of the values' rows in Field_values, kept by FieldStorage.
+    QStringList mValueKeys;
     QList<int> mAllowedTypes;
     ValueListModel *mValueListModel = nullptr;
     int mMinOccurs = -1;
     int mMaxOccurs = -1;
 
+    friend class ComputedFields;
     friend class Element;
     friend class FieldStorage;
     friend StorageImpl<Field, Storage>;
@@ -221,6 +237,7 @@ private:
     Q_PROPERTY(int minOccurs READ minOccurs WRITE setMinOccurs NOTIFY minOccursChanged FINAL)
     Q_PROPERTY(int maxOccurs READ maxOccurs WRITE setMaxOccurs NOTIFY maxOccursChanged FINAL)
     Q_PROPERTY(ValueListModel *valueListModel READ valueListModel CONSTANT FINAL)
+    Q_PROPERTY(QVariant computedValue READ computedValue NOTIFY computedValueChanged FINAL)
 };
 
 #endif // LIBNOVELIST_FIELD_H
@@ -1,4 +1,5 @@
 #include "fieldstorage.h"
+#include "orderkey.h"
 #include "storage.h"
 #include "value.h"
 
@@ -7,56 +8,56 @@ void FieldStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `Field` (\n"
-                     "  `id`	      INTEGER NOT NULL UNIQUE,\n"
-                     "  `minOccurs` INTEGER NOT NULL,\n"
-                     "  `maxOccurs` INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-        executeQuery("CREATE TABLE IF NOT EXISTS `Field_values` (\n"
-                     "  `id`	        INTEGER NOT NULL UNIQUE,\n"
-                     "  `index`	    INTEGER NOT NULL,\n"
-                     "  `field`       INTEGER NOT NULL,\n"
-                     "  `value`       INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id` AUTOINCREMENT)\n"
-                     ")");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_Field_values_field ON Field_values(field)");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_Field_values_value ON Field_values(value)");
-        executeQuery("CREATE TABLE IF NOT EXISTS `Field_allowedTypes` (\n"
-                     "  `id`	        INTEGER NOT NULL UNIQUE,\n"
-                     "  `index`	    INTEGER NOT NULL,\n"
-                     "  `field`       INTEGER NOT NULL,\n"
-                     "  `type`        INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id` AUTOINCREMENT)\n"
-                     ")");
-        executeQuery(
-            "CREATE INDEX IF NOT EXISTS idx_Field_allowedTypes_field ON Field_allowedTypes(field)");
-        executeQuery(
-            "CREATE INDEX IF NOT EXISTS idx_Field_allowedTypes_type ON Field_allowedTypes(type)");
-
-        mReloadQuery = createQuery("SELECT * FROM `Field` WHERE `id`=:id");
-        mInsertQuery = createQuery("INSERT INTO `Field` (`id`,`minOccurs`,`maxOccurs`) VALUES "
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `Field` (\n"
+                         "  `id`	      INTEGER NOT NULL,\n"
+                         "  `minOccurs` INTEGER NOT NULL,\n"
+                         "  `maxOccurs` INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+            executeQuery("CREATE TABLE IF NOT EXISTS `Field_values` (\n"
+                         "  `field` INTEGER NOT NULL,\n"
+                         "  `index` TEXT NOT NULL,\n"
+                         "  `value` INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`field`,`index`)\n"
+                         ") WITHOUT ROWID");
+            executeQuery("CREATE INDEX IF NOT EXISTS idx_Field_values_value ON "
+                         "`Field_values`(`value`)");
+            executeQuery("CREATE TABLE IF NOT EXISTS `Field_allowedTypes` (\n"
+                         "  `field` INTEGER NOT NULL,\n"
+                         "  `index` INTEGER NOT NULL,\n"
+                         "  `type`  INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`field`,`index`)\n"
+                         ") WITHOUT ROWID");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `Field` WHERE `id`=:id");
+        mInsertQuery = lazyQuery("INSERT INTO `Field` (`id`,`minOccurs`,`maxOccurs`) VALUES "
                                    "(:id,:minOccurs,:maxOccurs)");
-        mUpdateQuery = createQuery(
+        mUpdateQuery = lazyQuery(
             "UPDATE `Field` SET `minOccurs`=:minOccurs,`maxOccurs`=:maxOccurs WHERE `id`=:id");
 
-        mReloadElementsQuery = createQuery(
+        mReloadElementsQuery = lazyQuery(
             "SELECT * FROM `Element_fields` WHERE `field`=:field ORDER BY `index`");
 
-        mReloadValuesQuery = createQuery(
+        mReloadValuesQuery = lazyQuery(
             "SELECT * FROM `Field_values` WHERE `field`=:field ORDER BY `index`");
-        mInsertValuesQuery = createQuery(
+        mInsertValuesQuery = lazyQuery(
             "INSERT INTO `Field_values` (`index`,`field`,`value`) VALUES "
             "(:index,:field,:value)");
-        mRemoveValuesQuery = createQuery("DELETE FROM `Field_values` WHERE `field`=:field");
+        mRemoveValuesQuery = lazyQuery("DELETE FROM `Field_values` WHERE `field`=:field");
+        mRemoveValueQuery = lazyQuery(
+            "DELETE FROM `Field_values` WHERE `field`=:field AND `index`=:index");
+        mMoveValueQuery = lazyQuery("UPDATE `Field_values` SET `index`=:newIndex WHERE "
+                                    "`field`=:field AND `index`=:index");
 
-        mReloadAllowedTypesQuery = createQuery(
+        mReloadAllowedTypesQuery = lazyQuery(
             "SELECT * FROM `Field_allowedTypes` WHERE `field`=:field ORDER BY `index`");
-        mInsertAllowedTypesQuery = createQuery(
+        mInsertAllowedTypesQuery = lazyQuery(
             "INSERT INTO `Field_allowedTypes` (`index`,`field`,`type`) VALUES "
             "(:index,:field,:type)");
-        mRemoveAllowedTypesQuery = createQuery(
+        mRemoveAllowedTypesQuery = lazyQuery(
             "DELETE FROM `Field_allowedTypes` WHERE `field`=:field");
     }
 
@@ -91,9 +92,7 @@ bool FieldStorage::insertNode(Node *node)
     updateValues(field);
     updateAllowedTypes(field);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldStorage::updateNode(Node *node)
@@ -114,9 +113,7 @@ bool FieldStorage::updateNode(Node *node)
     updateValues(field);
     updateAllowedTypes(field);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldStorage::reloadNode(Node *node)
@@ -131,18 +128,18 @@ bool FieldStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {field->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "empty result set"), false;
 
-    field->setMinOccurs(mReloadQuery.value("minOccurs").toInt());
-    field->setMaxOccurs(mReloadQuery.value("maxOccurs").toInt());
+    field->setMinOccurs(mReloadQuery->value("minOccurs").toInt());
+    field->setMaxOccurs(mReloadQuery->value("maxOccurs").toInt());
 
     if (!executeQuery(mReloadElementsQuery, QVariantMap{{":field", field->rowid()}}))
         return handleError(this, "reloadNode", mReloadElementsQuery), false;
 
     QList<Element *> elements;
-    while (mReloadElementsQuery.next()) {
-        const int rowid = mReloadElementsQuery.value("element").toInt();
+    while (mReloadElementsQuery->next()) {
+        const int rowid = mReloadElementsQuery->value("element").toInt();
         if (Element *element = qobject_cast<Element *>(storage()->elementStorage()->element(rowid)))
             elements.append(element);
         else
@@ -157,14 +154,17 @@ bool FieldStorage::reloadNode(Node *node)
     }
 
     QList<Value *> vs;
-    while (mReloadValuesQuery.next())
+    QStringList keys;
+    while (mReloadValuesQuery->next())
         if (Value *v = qobject_cast<Value *>(
-                storage()->valueStorage()->value(mReloadValuesQuery.value("value").toInt())))
+                storage()->valueStorage()->value(mReloadValuesQuery->value("value").toInt()))) {
             vs.append(v);
-        else
+            keys.append(mReloadValuesQuery->value("index").toString());
+        } else
             handleError("!!!");
 
     field->setValues(vs);
+    field->mValueKeys = keys;
 
     if (!executeQuery(mReloadAllowedTypesQuery, QVariantMap{{":field", field->rowid()}})) {
         handleError(this, "reloadNode", mReloadAllowedTypesQuery);
@@ -172,8 +172,8 @@ bool FieldStorage::reloadNode(Node *node)
     }
 
     QList<int> ts;
-    while (mReloadAllowedTypesQuery.next()) {
-        if (int t = mReloadAllowedTypesQuery.value("type").toInt(); t > 0)
+    while (mReloadAllowedTypesQuery->next()) {
+        if (int t = mReloadAllowedTypesQuery->value("type").toInt(); t > 0)
             ts.append(t);
         else
             handleError(QStringLiteral("allowedtype '%1' is invalid").arg(t));
@@ -181,9 +181,7 @@ bool FieldStorage::reloadNode(Node *node)
 
     field->setAllowedTypes(ts);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldStorage::removeNode(int rowid)
@@ -208,9 +206,7 @@ bool FieldStorage::removeNode(int rowid)
         return false;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldStorage::updateValues(Field *field)
@@ -225,6 +221,8 @@ bool FieldStorage::updateValues(Field *field)
         return false;
     }
 
+    const QStringList keys = OrderKey::spread(field->mValues.size());
+
     int index = 0;
     for (Value *value : std::as_const(field->mValues)) {
         if (!value->save(true)) {
@@ -232,7 +230,7 @@ bool FieldStorage::updateValues(Field *field)
             return false;
         }
         if (!executeQuery(mInsertValuesQuery,
-                          QVariantMap{{":index", index},
+                          QVariantMap{{":index", keys[index]},
                                       {":field", field->rowid()},
                                       {":value", value->rowid()}})) {
             handleError(this, "updateValues", mInsertValuesQuery);
@@ -241,7 +239,107 @@ bool FieldStorage::updateValues(Field *field)
         ++index;
     }
 
-    tx.commit();
+    if (!storage()->aggregates().update(field->rowid()))
+        return false;
+
+    if (!tx.commit())
+        return false;
+
+    field->mValueKeys = keys;
+
+    return true;
+}
+
+bool FieldStorage::insertValueLink(Field *field, int position)
+{
+    if (field->rowid() <= 0)
+        return false;
+
+    QStringList &keys = field->mValueKeys;
+    if (keys.size() != field->mValues.size() - 1)
+        return updateValues(field);
+
+    const QString key = OrderKey::between(keys.value(position - 1), keys.value(position));
+    if (!OrderKey::isUsable(key))
+        return updateValues(field);
+
+    Transaction tx{Transaction::Write, field, storage()};
+
+    Value *value = field->mValues[position];
+    if (!value->save(true))
+        return handleError(this, "insertValueLink", "value could not be saved"), false;
+
+    if (!executeQuery(mInsertValuesQuery,
+                      QVariantMap{{":index", key},
+                                  {":field", field->rowid()},
+                                  {":value", value->rowid()}}))
+        return handleError(this, "insertValueLink", mInsertValuesQuery), false;
+
+    if (!storage()->aggregates().update(field->rowid()))
+        return false;
+
+    if (!tx.commit())
+        return false;
+
+    keys.insert(position, key);
+
+    return true;
+}
+
+bool FieldStorage::removeValueLink(Field *field, int position)
+{
+    if (field->rowid() <= 0)
+        return false;
+
+    QStringList &keys = field->mValueKeys;
+    if (keys.size() != field->mValues.size() + 1)
+        return updateValues(field);
+
+    Transaction tx{Transaction::Write, field, storage()};
+
+    if (!executeQuery(mRemoveValueQuery,
+                      QVariantMap{{":field", field->rowid()}, {":index", keys[position]}}))
+        return handleError(this, "removeValueLink", mRemoveValueQuery), false;
+
+    if (!storage()->aggregates().update(field->rowid()))
+        return false;
+
+    if (!tx.commit())
+        return false;
+
+    keys.removeAt(position);
+
+    return true;
+}
+
+bool FieldStorage::moveValueLink(Field *field, int from, int to)
+{
+    if (field->rowid() <= 0)
+        return false;
+
+    QStringList &keys = field->mValueKeys;
+    if (keys.size() != field->mValues.size())
+        return updateValues(field);
+
+    QStringList others = keys;
+    const QString oldKey = others.takeAt(from);
+    const QString key = OrderKey::between(others.value(to - 1), others.value(to));
+    if (!OrderKey::isUsable(key))
+        return updateValues(field);
+
+    Transaction tx{Transaction::Write, field, storage()};
+
+    if (!executeQuery(mMoveValueQuery,
+                      QVariantMap{{":newIndex", key},
+                                  {":field", field->rowid()},
+                                  {":index", oldKey}}))
+        return handleError(this, "moveValueLink", mMoveValueQuery), false;
+
+    if (!tx.commit())
+        return false;
+
+    others.insert(to, key);
+    keys = others;
 
     return true;
 }
@@ -268,9 +366,7 @@ bool FieldStorage::updateAllowedTypes(Field *field)
         ++index;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldStorage::updateMinOccurs(Field *field)
@@ -286,9 +382,7 @@ bool FieldStorage::updateMinOccurs(Field *field)
         return false;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldStorage::updateMaxOccurs(Field *field)
@@ -304,7 +398,5 @@ bool FieldStorage::updateMaxOccurs(Field *field)
         return false;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
@@ -23,7 +23,7 @@ public:
                                                  const QString& info = {},
                                                  const QString& icon = {})
     {
-        if (Field* e = static_cast<Field*>(createNode())) {
+        if (Field* e = static_cast<Field*>(newNode())) {
             e->setNodeType(nodeType);
             e->setLabel(label);
             e->setInfo(info);
@@ -40,25 +40,34 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
+    // Rewrites all the rows of the field's values, with freshly spread order keys.
     bool updateValues(Field* field);
+    // Write the one row of the value inserted, removed or moved at a position, like the field
+    // links of ElementStorage.
+    bool insertValueLink(Field* field, int position);
+    bool removeValueLink(Field* field, int position);
+    bool moveValueLink(Field* field, int from, int to);
     bool updateAllowedTypes(Field* field);
     bool updateMinOccurs(Field* field);
     bool updateMaxOccurs(Field* field);
 
     friend class Field;
     friend class Storage;
+    friend class ElementStorage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
-    QSqlQuery mReloadElementsQuery;
-    QSqlQuery mInsertElementsQuery;
-    QSqlQuery mReloadValuesQuery;
-    QSqlQuery mInsertValuesQuery;
-    QSqlQuery mRemoveValuesQuery;
-    QSqlQuery mReloadAllowedTypesQuery;
-    QSqlQuery mInsertAllowedTypesQuery;
-    QSqlQuery mRemoveAllowedTypesQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
+    PreparedQuery mReloadElementsQuery;
+    PreparedQuery mInsertElementsQuery;
+    PreparedQuery mReloadValuesQuery;
+    PreparedQuery mInsertValuesQuery;
+    PreparedQuery mRemoveValuesQuery;
+    PreparedQuery mRemoveValueQuery;
+    PreparedQuery mMoveValueQuery;
+    PreparedQuery mReloadAllowedTypesQuery;
+    PreparedQuery mInsertAllowedTypesQuery;
+    PreparedQuery mRemoveAllowedTypesQuery;
 };
 
 #endif // LIBNOVELIST_FIELDSTORAGE_H
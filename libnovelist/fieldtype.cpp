@@ -1,5 +1,6 @@
 #include "fieldtype.h"
 #include "storage.h"
+#include "validator.h"
 
 #include <QJsonArray>
 
@@ -100,6 +101,21 @@ bool FieldType::removeValueTypeAt(int index)
     return true;
 }
 
+QSharedPointer<const novelist::Validator> FieldType::compiledValidator() const
+{
+    if (!mCompiledValidator && !mValidator.isEmpty())
+        mCompiledValidator = novelist::Validator::fromJson(mValidator);
+    return mCompiledValidator;
+}
+
+int FieldType::conversion(int typeId) const
+{
+    auto it = mConversions.constFind(typeId);
+    if (it == mConversions.constEnd())
+        it = mConversions.insert(typeId, Value::conversion(mAllowedTypes, typeId));
+    return *it;
+}
+
 ValueTypeListModel *FieldType::valueTypeListModel()
 {
     if (!mValueTypeListModel) {
@@ -113,6 +129,12 @@ bool FieldType::readJson(const QJsonObject &json, QStringList *errors)
     if (!NodeType::readJson(json, errors))
         return false;
 
+    if (const auto v = json.value(QStringLiteral("formula")); v.isString())
+        setFormula(v.toString());
+
+    if (const auto v = json.value(QStringLiteral("validator")); v.isObject())
+        setValidator(v.toObject());
+
     if (const auto v = json.value(QStringLiteral("valueTypes")); v.isArray()) {
         const auto a = v.toArray();
         int index = -1;
@@ -144,6 +166,12 @@ bool FieldType::writeJson(QJsonObject &json, QStringList *errors) const
     if (mMaxOccurs >= 0)
         json.insert(QStringLiteral("maxOccurs"), mMaxOccurs);
 
+    if (!mFormula.isEmpty())
+        json.insert(QStringLiteral("formula"), mFormula);
+
+    if (!mValidator.isEmpty())
+        json.insert(QStringLiteral("validator"), mValidator);
+
     if (!mAllowedTypes.isEmpty())
         json.insert(QStringLiteral("allowedTypes"), allowedTypeNames().join('\n'));
 
@@ -186,3 +214,17 @@ bool FieldType::updateMaxOccurs()
         return false;
     return storage()->fieldTypeStorage()->updateMaxOccurs(this);
 }
+
+bool FieldType::updateFormula()
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->fieldTypeStorage()->updateFormula(this);
+}
+
+bool FieldType::updateValidator()
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->fieldTypeStorage()->updateValidator(this);
+}
@@ -1,9 +1,17 @@
 #ifndef LIBNOVELIST_FIELDTYPE_H
 #define LIBNOVELIST_FIELDTYPE_H
 
+#include <QHash>
+#include <QJsonObject>
+#include <QSharedPointer>
+
 #include "nodetype.h"
 #include "valuetypelistmodel.h"
 
+namespace novelist {
+class Validator;
+}
+
 class ElementType;
 class ValueType;
 class Field;
@@ -111,6 +119,7 @@ public:
             return;
 
         mAllowedTypes = allowedTypes;
+        mConversions.clear();
 
         if (!updateAllowedTypes())
             setModified(true);
@@ -135,6 +144,10 @@ public:
         setAllowedTypes(allowedTypes);
     }
 
+    // What Value::setValue() does with a value of metatype typeId in a field of this type, see
+    // Value::conversion(). Worked out once per metatype and kept until the allowed types change.
+    [[nodiscard]] int conversion(int typeId) const;
+
     [[nodiscard]] int minOccurs() const { return mMinOccurs; }
     void setMinOccurs(int minOccurs)
     {
@@ -163,6 +176,43 @@ public:
         emit maxOccursChanged(QPrivateSignal{});
     }
 
+    // The formula the fields of this type are computed with, see Formula. Empty for fields
+    // that hold values.
+    [[nodiscard]] QString formula() const { return mFormula; }
+    void setFormula(const QString& formula)
+    {
+        if (mFormula == formula)
+            return;
+
+        mFormula = formula;
+
+        if (!updateFormula())
+            setModified(true);
+
+        emit formulaChanged(QPrivateSignal{});
+    }
+    [[nodiscard]] bool isComputed() const { return !mFormula.isEmpty(); }
+
+    // The checks on the values of fields of this type, see novelist::Validator. Empty when any
+    // value goes.
+    [[nodiscard]] QJsonObject validator() const { return mValidator; }
+    void setValidator(const QJsonObject& validator)
+    {
+        if (mValidator == validator)
+            return;
+
+        mValidator = validator;
+        mCompiledValidator.reset();
+
+        if (!updateValidator())
+            setModified(true);
+
+        emit validatorChanged(QPrivateSignal{});
+    }
+    // The validator compiled from validator(), once per change; null when there is none or it
+    // doesn't parse. Const and shared, BatchValidator hands it to its worker threads.
+    [[nodiscard]] QSharedPointer<const novelist::Validator> compiledValidator() const;
+
     [[nodiscard]] ValueTypeListModel* valueTypeListModel();
 
 signals:
@@ -173,6 +223,8 @@ signals:
     void allowedTypesChanged(QPrivateSignal);
     void minOccursChanged(QPrivateSignal);
     void maxOccursChanged(QPrivateSignal);
+    void formulaChanged(QPrivateSignal);
+    void validatorChanged(QPrivateSignal);
 
 protected:
     bool readJson(const QJsonObject& json, QStringList* errors = nullptr) override;
@@ -182,15 +234,22 @@ protected:
     bool updateAllowedTypes();
     bool updateMinOccurs();
     bool updateMaxOccurs();
+    bool updateFormula();
+    bool updateValidator();
 
 private:
     QList<ElementType*> mElementTypes;
     QList<ValueType*> mValueTypes;
     QMap<QString, ValueType*> mValueTypesByName;
     QList<int> mAllowedTypes;
+    // The conversion plan, by source metatype.
+    mutable QHash<int, int> mConversions;
     ValueTypeListModel* mValueTypeListModel = nullptr;
     int mMinOccurs = 0;
     int mMaxOccurs = 0;
+    QString mFormula;
+    QJsonObject mValidator;
+    mutable QSharedPointer<const novelist::Validator> mCompiledValidator;
 
     friend class ElementType;
     friend class FieldTypeStorage;
@@ -205,6 +264,10 @@ private:
                    allowedTypesChanged)
     Q_PROPERTY(int minOccurs READ minOccurs WRITE setMinOccurs NOTIFY minOccursChanged)
     Q_PROPERTY(int maxOccurs READ maxOccurs WRITE setMaxOccurs NOTIFY maxOccursChanged)
+    Q_PROPERTY(QString formula READ formula WRITE setFormula NOTIFY formulaChanged)
+    Q_PROPERTY(bool computed READ isComputed NOTIFY formulaChanged)
+    Q_PROPERTY(
+        QJsonObject validator READ validator WRITE setValidator NOTIFY validatorChanged)
     Q_PROPERTY(ValueTypeListModel* valueTypeListModel READ valueTypeListModel CONSTANT FINAL)
 };
 
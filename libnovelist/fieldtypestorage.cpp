@@ -2,65 +2,82 @@
 #include "storage.h"
 #include "valuetypestorage.h"
 
+#include <QJsonDocument>
+
+namespace {
+
+// The validator column holds compact JSON, NULL when the field type has none.
+QVariant validatorText(const FieldType *fieldType)
+{
+    const QJsonObject validator = fieldType->validator();
+    if (validator.isEmpty())
+        return QVariant{QMetaType::fromType<QString>()};
+    return QString::fromUtf8(QJsonDocument{validator}.toJson(QJsonDocument::Compact));
+}
+
+QJsonObject validatorObject(const QVariant &text)
+{
+    return QJsonDocument::fromJson(text.toString().toUtf8()).object();
+}
+
+} // namespace
+
 void FieldTypeStorage::setDatabase(const QSqlDatabase &database)
 {
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `FieldType` (\n"
-                     "  `id` INTEGER NOT NULL UNIQUE,\n"
-                     "  `minOccurs` INTEGER NOT NULL,\n"
-                     "  `maxOccurs` INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-        executeQuery("CREATE TABLE IF NOT EXISTS `FieldType_valueTypes` (\n"
-                     "  `id`	        INTEGER NOT NULL UNIQUE,\n"
-                     "  `index`	    INTEGER NOT NULL,\n"
-                     "  `fieldType` INTEGER NOT NULL,\n"
-                     "  `valueType`   INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id` AUTOINCREMENT)\n"
-                     ")");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_FieldType_valueTypes_fieldType ON "
-                     "FieldType_valueTypes(fieldType)");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_FieldType_valueTypes_valueType ON "
-                     "FieldType_valueTypes(valueType)");
-        executeQuery("CREATE TABLE IF NOT EXISTS `FieldType_allowedTypes` (\n"
-                     "  `id`	        INTEGER NOT NULL UNIQUE,\n"
-                     "  `index`	    INTEGER NOT NULL,\n"
-                     "  `fieldType`   INTEGER NOT NULL,\n"
-                     "  `type`        INTEGER NOT NULL,\n"
-                     "  PRIMARY KEY(`id` AUTOINCREMENT)\n"
-                     ")");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_FieldType_allowedTypes_field ON "
-                     "FieldType_allowedTypes(fieldType)");
-        executeQuery("CREATE INDEX IF NOT EXISTS idx_FieldType_allowedTypes_type ON "
-                     "FieldType_allowedTypes(type)");
-
-        mReloadQuery = createQuery("SELECT * FROM `FieldType` WHERE `id`=:id");
-        mInsertQuery = createQuery("INSERT INTO `FieldType` (`id`,`minOccurs`,`maxOccurs`) "
-                                   "VALUES (:id,:minOccurs,:maxOccurs)");
-        mUpdateQuery = createQuery(
-            "UPDATE `FieldType` SET `minOccurs`=:minOccurs,`maxOccurs`=:maxOccurs WHERE "
-            "`id`=:id");
-
-        mReloadElementTypesQuery = createQuery(
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `FieldType` (\n"
+                         "  `id` INTEGER NOT NULL,\n"
+                         "  `minOccurs` INTEGER NOT NULL,\n"
+                         "  `maxOccurs` INTEGER NOT NULL,\n"
+                         "  `formula`   TEXT,\n"
+                         "  `validator` TEXT,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+            executeQuery("CREATE TABLE IF NOT EXISTS `FieldType_valueTypes` (\n"
+                         "  `fieldType` INTEGER NOT NULL,\n"
+                         "  `index`     INTEGER NOT NULL,\n"
+                         "  `valueType` INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`fieldType`,`index`)\n"
+                         ") WITHOUT ROWID");
+            executeQuery("CREATE INDEX IF NOT EXISTS idx_FieldType_valueTypes_valueType ON "
+                         "`FieldType_valueTypes`(`valueType`)");
+            executeQuery("CREATE TABLE IF NOT EXISTS `FieldType_allowedTypes` (\n"
+                         "  `fieldType` INTEGER NOT NULL,\n"
+                         "  `index`     INTEGER NOT NULL,\n"
+                         "  `type`      INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`fieldType`,`index`)\n"
+                         ") WITHOUT ROWID");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `FieldType` WHERE `id`=:id");
+        mInsertQuery = lazyQuery(
+            "INSERT INTO `FieldType` (`id`,`minOccurs`,`maxOccurs`,`formula`,`validator`) "
+            "VALUES (:id,:minOccurs,:maxOccurs,:formula,:validator)");
+        mUpdateQuery = lazyQuery(
+            "UPDATE `FieldType` SET `minOccurs`=:minOccurs,`maxOccurs`=:maxOccurs,"
+            "`formula`=:formula,`validator`=:validator WHERE `id`=:id");
+
+        mReloadElementTypesQuery = lazyQuery(
             "SELECT * FROM `ElementType_fieldTypes` WHERE `fieldType`=:fieldType ORDER BY `index`");
 
-        mReloadValueTypesQuery = createQuery(
+        mReloadValueTypesQuery = lazyQuery(
             "SELECT * FROM `FieldType_valueTypes` WHERE `fieldType`=:fieldType ORDER BY `index`");
-        mInsertValueTypesQuery = createQuery(
+        mInsertValueTypesQuery = lazyQuery(
             "INSERT INTO `FieldType_valueTypes` (`index`,`fieldType`,`valueType`) VALUES "
             "(:index,:fieldType,:valueType)");
-        mRemoveValueTypesQuery = createQuery(
+        mRemoveValueTypesQuery = lazyQuery(
             "DELETE FROM `FieldType_valueTypes` WHERE `fieldType`=:fieldType");
 
-        mReloadAllowedTypesQuery = createQuery(
+        mReloadAllowedTypesQuery = lazyQuery(
             "SELECT * FROM `FieldType_allowedTypes` WHERE `fieldType`=:fieldType ORDER BY `index`");
-        mInsertAllowedTypesQuery = createQuery(
+        mInsertAllowedTypesQuery = lazyQuery(
             "INSERT INTO `FieldType_allowedTypes` (`index`,`fieldType`,`type`) VALUES "
             "(:index,:fieldType,:type)");
-        mRemoveAllowedTypesQuery = createQuery(
+        mRemoveAllowedTypesQuery = lazyQuery(
             "DELETE FROM `FieldType_allowedTypes` WHERE `fieldType`=:fieldType");
     }
 
@@ -85,7 +102,9 @@ bool FieldTypeStorage::insertNode(Node *node)
     if (!executeQuery(mInsertQuery,
                       QVariantMap{{":id", fieldType->rowid()},
                                   {":minOccurs", fieldType->mMinOccurs},
-                                  {":maxOccurs", fieldType->mMaxOccurs}}))
+                                  {":maxOccurs", fieldType->mMaxOccurs},
+                                  {":formula", fieldType->mFormula},
+                                  {":validator", validatorText(fieldType)}}))
         return handleError(this, "insertNode", mInsertQuery), false;
 
     int index = 0;
@@ -113,9 +132,7 @@ bool FieldTypeStorage::insertNode(Node *node)
         ++index;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldTypeStorage::updateNode(Node *node)
@@ -130,6 +147,8 @@ bool FieldTypeStorage::updateNode(Node *node)
     if (!executeQuery(mUpdateQuery,
                       QVariantMap{{":minOccurs", fieldType->mMinOccurs},
                                   {":maxOccurs", fieldType->mMaxOccurs},
+                                  {":formula", fieldType->mFormula},
+                                  {":validator", validatorText(fieldType)},
                                   {":id", fieldType->rowid()}}))
         return handleError(this, "updateNode", mUpdateQuery), false;
 
@@ -164,9 +183,7 @@ bool FieldTypeStorage::updateNode(Node *node)
         ++index;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldTypeStorage::reloadNode(Node *node)
@@ -181,18 +198,20 @@ bool FieldTypeStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {fieldType->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
-    fieldType->setMinOccurs(mReloadQuery.value("minOccurs").toInt());
-    fieldType->setMaxOccurs(mReloadQuery.value("maxOccurs").toInt());
+    fieldType->setMinOccurs(mReloadQuery->value("minOccurs").toInt());
+    fieldType->setMaxOccurs(mReloadQuery->value("maxOccurs").toInt());
+    fieldType->setFormula(mReloadQuery->value("formula").toString());
+    fieldType->setValidator(validatorObject(mReloadQuery->value("validator")));
 
     if (!executeQuery(mReloadElementTypesQuery, QVariantMap{{":fieldType", fieldType->rowid()}}))
         return handleError(this, "reloadNode", mReloadElementTypesQuery), false;
 
     QList<ElementType *> ets;
-    while (mReloadElementTypesQuery.next()) {
-        const int rowid = mReloadElementTypesQuery.value("elementType").toInt();
+    while (mReloadElementTypesQuery->next()) {
+        const int rowid = mReloadElementTypesQuery->value("elementType").toInt();
         if (ElementType *et = qobject_cast<ElementType *>(
                 storage()->elementTypeStorage()->elementType(rowid)))
             ets.append(et);
@@ -206,8 +225,8 @@ bool FieldTypeStorage::reloadNode(Node *node)
         return handleError(this, "reloadNode", mReloadValueTypesQuery), false;
 
     QList<ValueType *> valueTypes;
-    while (mReloadValueTypesQuery.next()) {
-        const int rowid = mReloadValueTypesQuery.value("valueType").toInt();
+    while (mReloadValueTypesQuery->next()) {
+        const int rowid = mReloadValueTypesQuery->value("valueType").toInt();
         if (ValueType *vt = qobject_cast<ValueType *>(
                 storage()->valueTypeStorage()->valueType(rowid)))
             valueTypes.append(vt);
@@ -221,8 +240,8 @@ bool FieldTypeStorage::reloadNode(Node *node)
         return handleError(this, "reloadNode", mReloadAllowedTypesQuery), false;
 
     QList<int> allowedTypes;
-    while (mReloadAllowedTypesQuery.next()) {
-        if (int allowedType = mReloadAllowedTypesQuery.value("type").toInt(); allowedType > 0)
+    while (mReloadAllowedTypesQuery->next()) {
+        if (int allowedType = mReloadAllowedTypesQuery->value("type").toInt(); allowedType > 0)
             allowedTypes.append(allowedType);
         else
             handleError(this,
@@ -232,9 +251,7 @@ bool FieldTypeStorage::reloadNode(Node *node)
 
     fieldType->setAllowedTypes(allowedTypes);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldTypeStorage::removeNode(int rowid)
@@ -253,9 +270,7 @@ bool FieldTypeStorage::removeNode(int rowid)
     if (!executeQuery(mRemoveAllowedTypesQuery, QVariantMap{{":fieldType", rowid}}))
         return handleError(this, "removeNode", mRemoveAllowedTypesQuery), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldTypeStorage::updateValueTypes(FieldType *fieldType)
@@ -282,9 +297,7 @@ bool FieldTypeStorage::updateValueTypes(FieldType *fieldType)
         ++index;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldTypeStorage::updateAllowedTypes(FieldType *fieldType)
@@ -308,9 +321,7 @@ bool FieldTypeStorage::updateAllowedTypes(FieldType *fieldType)
         ++index;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldTypeStorage::updateMinOccurs(FieldType *fieldType)
@@ -324,9 +335,7 @@ bool FieldTypeStorage::updateMinOccurs(FieldType *fieldType)
     if (!executeQuery(q, {fieldType->mMinOccurs, fieldType->rowid()}))
         return handleError(this, "updateMinOccurs", q), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool FieldTypeStorage::updateMaxOccurs(FieldType *fieldType)
@@ -340,7 +349,112 @@ bool FieldTypeStorage::updateMaxOccurs(FieldType *fieldType)
     if (!executeQuery(q, {fieldType->mMaxOccurs, fieldType->rowid()}))
         return handleError(this, "updateMaxOccurs", q), false;
 
-    tx.commit();
+    return tx.commit();
+}
+
+bool FieldTypeStorage::updateFormula(FieldType *fieldType)
+{
+    if (fieldType->rowid() <= 0)
+        return false;
+
+    Transaction tx{Transaction::Write, fieldType, storage()};
+
+    QSqlQuery q = createQuery("UPDATE FieldType SET formula=? WHERE id=?");
+    if (!executeQuery(q, {fieldType->mFormula, fieldType->rowid()}))
+        return handleError(this, "updateFormula", q), false;
+
+    return tx.commit();
+}
+
+bool FieldTypeStorage::updateValidator(FieldType *fieldType)
+{
+    if (fieldType->rowid() <= 0)
+        return false;
+
+    Transaction tx{Transaction::Write, fieldType, storage()};
+
+    QSqlQuery q = createQuery("UPDATE FieldType SET validator=? WHERE id=?");
+    if (!executeQuery(q, {validatorText(fieldType), fieldType->rowid()}))
+        return handleError(this, "updateValidator", q), false;
+
+    return tx.commit();
+}
+
+bool FieldTypeStorage::loadTypes()
+{
+    return loadTypeTable("FieldType", Storable::Type_FieldType);
+}
+
+void FieldTypeStorage::readType(Node *node, const QSqlQuery &query)
+{
+    FieldType *fieldType = static_cast<FieldType *>(node);
+    fieldType->setMinOccurs(query.value("minOccurs").toInt());
+    fieldType->setMaxOccurs(query.value("maxOccurs").toInt());
+    fieldType->setFormula(query.value("formula").toString());
+    fieldType->setValidator(validatorObject(query.value("validator")));
+}
+
+bool FieldTypeStorage::loadValueTypes()
+{
+    QSqlQuery query = createQuery("SELECT `fieldType`,`valueType` FROM `FieldType_valueTypes` "
+                                  "ORDER BY `fieldType`,`index`",
+                                  true);
+    if (!executeQuery(query))
+        return handleError(this, "loadValueTypes", query), false;
+
+    QHash<int, QList<ValueType *>> valueTypes;
+    while (query.next()) {
+        const int rowid = query.value("valueType").toInt();
+        if (ValueType *valueType = storage()->valueTypeStorage()->valueType(rowid))
+            valueTypes[query.value("fieldType").toInt()].append(valueType);
+        else
+            handleError(this, "loadValueTypes", "could not load valuetype");
+    }
+
+    for (auto it = valueTypes.constBegin(); it != valueTypes.constEnd(); ++it) {
+        FieldType *fieldType = qobject_cast<FieldType *>(mNodesByRowid.value(it.key()));
+        if (!fieldType) {
+            handleError(this, "loadValueTypes", "could not load fieldtype");
+            continue;
+        }
+
+        Transaction tx{Transaction::ReadModified, fieldType, storage()};
+        fieldType->setValueTypes(it.value());
+        tx.commit();
+    }
+
+    return true;
+}
+
+bool FieldTypeStorage::loadAllowedTypes()
+{
+    QSqlQuery query = createQuery("SELECT `fieldType`,`type` FROM `FieldType_allowedTypes` "
+                                  "ORDER BY `fieldType`,`index`",
+                                  true);
+    if (!executeQuery(query))
+        return handleError(this, "loadAllowedTypes", query), false;
+
+    QHash<int, QList<int>> allowedTypes;
+    while (query.next()) {
+        if (int allowedType = query.value("type").toInt(); allowedType > 0)
+            allowedTypes[query.value("fieldType").toInt()].append(allowedType);
+        else
+            handleError(this,
+                        "loadAllowedTypes",
+                        QStringLiteral("invalid allowedtype: '%1'").arg(allowedType));
+    }
+
+    for (auto it = allowedTypes.constBegin(); it != allowedTypes.constEnd(); ++it) {
+        FieldType *fieldType = qobject_cast<FieldType *>(mNodesByRowid.value(it.key()));
+        if (!fieldType) {
+            handleError(this, "loadAllowedTypes", "could not load fieldtype");
+            continue;
+        }
+
+        Transaction tx{Transaction::ReadModified, fieldType, storage()};
+        fieldType->setAllowedTypes(it.value());
+        tx.commit();
+    }
 
     return true;
 }
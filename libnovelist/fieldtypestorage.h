@@ -33,19 +33,19 @@ public:
         if (name.isEmpty())
             return handleError(this, "removeNode", "name is empty"), nullptr;
 
-        if (mNodesByName.contains(name))
+        if (nodeType(name))
             return handleError(
                        this,
                        "removeNode",
                        QStringLiteral("storage already contains a type with name '%1'").arg(name)),
                    nullptr;
 
-        if (FieldType* fieldType = static_cast<FieldType*>(createNode())) {
-            mNodesByName.insert(name, fieldType);
+        if (FieldType* fieldType = static_cast<FieldType*>(newNode())) {
             fieldType->setName(name);
             fieldType->setLabel(label);
             fieldType->setInfo(info);
             fieldType->setIcon(icon);
+            rebuildCatalog();
             return fieldType;
         }
 
@@ -61,25 +61,33 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
+    bool loadTypes();
+    void readType(Node* node, const QSqlQuery& query) override;
+    // Link the value types and allowed types of all field types, after loadTypes().
+    bool loadValueTypes();
+    bool loadAllowedTypes();
+
     bool updateValueTypes(FieldType* fieldType);
     bool updateAllowedTypes(FieldType* fieldType);
     bool updateMinOccurs(FieldType* fieldType);
     bool updateMaxOccurs(FieldType* fieldType);
+    bool updateFormula(FieldType* fieldType);
+    bool updateValidator(FieldType* fieldType);
 
     friend class FieldType;
     friend class Storage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
-    QSqlQuery mReloadElementTypesQuery;
-    QSqlQuery mInsertElementTypesQuery;
-    QSqlQuery mReloadValueTypesQuery;
-    QSqlQuery mInsertValueTypesQuery;
-    QSqlQuery mRemoveValueTypesQuery;
-    QSqlQuery mReloadAllowedTypesQuery;
-    QSqlQuery mInsertAllowedTypesQuery;
-    QSqlQuery mRemoveAllowedTypesQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
+    PreparedQuery mReloadElementTypesQuery;
+    PreparedQuery mInsertElementTypesQuery;
+    PreparedQuery mReloadValueTypesQuery;
+    PreparedQuery mInsertValueTypesQuery;
+    PreparedQuery mRemoveValueTypesQuery;
+    PreparedQuery mReloadAllowedTypesQuery;
+    PreparedQuery mInsertAllowedTypesQuery;
+    PreparedQuery mRemoveAllowedTypesQuery;
 };
 
 #endif // LIBNOVELIST_FIELDTYPESTORAGE_H
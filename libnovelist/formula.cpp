@@ -0,0 +1,153 @@
+#include "formula.h"
+
+namespace {
+
+const QStringList Functions = {QStringLiteral("value"),
+                               QStringLiteral("count"),
+                               QStringLiteral("sum"),
+                               QStringLiteral("min"),
+                               QStringLiteral("max"),
+                               QStringLiteral("words"),
+                               QStringLiteral("characters"),
+                               QStringLiteral("latest")};
+
+} // namespace
+
+Formula Formula::parse(const QString &text)
+{
+    Formula formula;
+    formula.mText = text;
+
+    const int root = formula.expression();
+    formula.skipSpace();
+    if (root >= 0 && formula.mPos < text.size())
+        formula.fail(QStringLiteral("unexpected '%1'").arg(text[formula.mPos]));
+    if (root < 0 && formula.mError.isEmpty())
+        formula.fail(QStringLiteral("empty formula"));
+
+    return formula;
+}
+
+bool Formula::isFunction(const QString &name)
+{
+    return Functions.contains(name);
+}
+
+int Formula::expression()
+{
+    int left = term();
+    while (left >= 0) {
+        if (accept('+'))
+            left = add({Term::Add, 0, {}, {}, left, term()});
+        else if (accept('-'))
+            left = add({Term::Subtract, 0, {}, {}, left, term()});
+        else
+            break;
+    }
+    return left;
+}
+
+int Formula::term()
+{
+    int left = factor();
+    while (left >= 0) {
+        if (accept('*'))
+            left = add({Term::Multiply, 0, {}, {}, left, factor()});
+        else if (accept('/'))
+            left = add({Term::Divide, 0, {}, {}, left, factor()});
+        else
+            break;
+    }
+    return left;
+}
+
+int Formula::factor()
+{
+    skipSpace();
+    if (mPos >= mText.size())
+        return fail(QStringLiteral("unexpected end"));
+
+    if (accept('-'))
+        return add({Term::Negate, 0, {}, {}, factor(), -1});
+
+    if (accept('(')) {
+        const int inner = expression();
+        if (inner < 0)
+            return -1;
+        if (!accept(')'))
+            return fail(QStringLiteral("expected ')'"));
+        return inner;
+    }
+
+    if (mText[mPos].isDigit() || mText[mPos] == '.') {
+        const qsizetype start = mPos;
+        while (mPos < mText.size() && (mText[mPos].isDigit() || mText[mPos] == '.'))
+            ++mPos;
+        bool ok = false;
+        const double number = mText.mid(start, mPos - start).toDouble(&ok);
+        if (!ok)
+            return fail(QStringLiteral("invalid number '%1'").arg(mText.mid(start, mPos - start)));
+        return add({Term::Number, number, {}, {}, -1, -1});
+    }
+
+    const QString function = name();
+    if (function.isEmpty())
+        return fail(QStringLiteral("unexpected '%1'").arg(mText[mPos]));
+    if (!isFunction(function))
+        return fail(QStringLiteral("unknown function '%1'").arg(function));
+    if (!accept('('))
+        return fail(QStringLiteral("expected '(' after '%1'").arg(function));
+
+    QStringList path{name()};
+    while (!path.last().isEmpty() && accept('.'))
+        path.append(name());
+    if (path.contains(QString{}))
+        return fail(QStringLiteral("expected a field name in '%1'").arg(function));
+    if (!accept(')'))
+        return fail(QStringLiteral("expected ')' after '%1'").arg(path.join('.')));
+
+    return add({Term::Call, 0, function, path, -1, -1});
+}
+
+int Formula::add(Term term)
+{
+    // an operand that failed fails the whole term
+    if ((term.kind != Term::Number && term.kind != Term::Call && term.left < 0)
+        || (term.kind > Term::Negate && term.right < 0))
+        return -1;
+    mTerms.append(term);
+    return root();
+}
+
+QString Formula::name()
+{
+    skipSpace();
+    const qsizetype start = mPos;
+    while (mPos < mText.size() && (mText[mPos].isLetterOrNumber() || mText[mPos] == '_'))
+        ++mPos;
+    return mText.mid(start, mPos - start);
+}
+
+void Formula::skipSpace()
+{
+    while (mPos < mText.size() && mText[mPos].isSpace())
+        ++mPos;
+}
+
+bool Formula::accept(QChar c)
+{
+    skipSpace();
+    if (mPos < mText.size() && mText[mPos] == c) {
+        ++mPos;
+        return true;
+    }
+    return false;
+}
+
+int Formula::fail(const QString &error)
+{
+    // the first error is the one that explains the rest
+    if (mError.isEmpty())
+        mError = QStringLiteral("%1 at %2").arg(error).arg(mPos);
+    return -1;
+}
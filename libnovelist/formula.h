@@ -0,0 +1,57 @@
+#ifndef LIBNOVELIST_FORMULA_H
+#define LIBNOVELIST_FORMULA_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// The parsed formula of a computed FieldType, e.g. "words(text) / 250" or "sum(scenes.length)".
+//
+// A formula is arithmetic (+ - * / and parentheses) over numbers and calls. A call applies a
+// function to the values a path reaches: the first name is a field of the element the computed
+// field belongs to, each further name a field of the elements that field's node values refer to.
+// The functions are value, count, sum, min, max, words, characters and latest, the last being
+// when the values reached were last updated. ComputedFields evaluates them.
+//
+// The terms are kept in a flat list, operands before the terms that use them, the root last.
+class Formula
+{
+public:
+    struct Term
+    {
+        enum Kind { Number, Call, Negate, Add, Subtract, Multiply, Divide };
+
+        Kind kind = Number;
+        double number = 0;
+        QString function;
+        QStringList path;
+        int left = -1;
+        int right = -1;
+    };
+
+    [[nodiscard]] static Formula parse(const QString& text);
+
+    [[nodiscard]] bool isValid() const { return mError.isEmpty() && !mTerms.isEmpty(); }
+    [[nodiscard]] QString error() const { return mError; }
+    [[nodiscard]] const QList<Term>& terms() const { return mTerms; }
+    [[nodiscard]] int root() const { return int(mTerms.size()) - 1; }
+
+    [[nodiscard]] static bool isFunction(const QString& name);
+
+private:
+    int expression();
+    int term();
+    int factor();
+    int add(Term term);
+    [[nodiscard]] QString name();
+    void skipSpace();
+    bool accept(QChar c);
+    int fail(const QString& error);
+
+    QString mText;
+    qsizetype mPos = 0;
+    QList<Term> mTerms;
+    QString mError;
+};
+
+#endif // LIBNOVELIST_FORMULA_H
@@ -10,31 +10,35 @@ void NodeStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `Storable` (\n"
-                     "  `id`	    INTEGER NOT NULL UNIQUE,\n"
-                     "  `type`	    INTEGER NOT NULL,\n"
-                     "  `typeName`  TEXT NOT NULL,\n"
-                     "  `version`	INTEGER NOT NULL,\n"
-                     "  `createdAt` INTEGER,\n"
-                     "  `updatedAt` INTEGER,\n"
-                     "  `createdBy` TEXT,\n"
-                     "  `updatedBy` TEXT,\n"
-                     "  PRIMARY KEY(`id` AUTOINCREMENT)\n"
-                     ")");
-
-        executeQuery("CREATE TABLE IF NOT EXISTS `Node` (\n"
-                     "  `id`	     INTEGER NOT NULL UNIQUE,\n"
-                     "  `nodeType` INTEGER NOT NULL,\n"
-                     "  `name`     TEXT,\n"
-                     "  `label`    TEXT,\n"
-                     "  `info`     TEXT,\n"
-                     "  `icon`     TEXT,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE,\n"
-                     "  FOREIGN KEY(`nodeType`) REFERENCES Storable(`id`) ON DELETE NO ACTION\n"
-                     ")");
-
-        mReloadQuery = createQuery(
+        if (needsSchema()) {
+            // the type is stored as its Storable::Type, typeToString() names it
+            executeQuery("CREATE TABLE IF NOT EXISTS `Storable` (\n"
+                         "  `id`	    INTEGER NOT NULL,\n"
+                         "  `type`	    INTEGER NOT NULL,\n"
+                         "  `version`	INTEGER NOT NULL,\n"
+                         "  `createdAt` INTEGER,\n"
+                         "  `updatedAt` INTEGER,\n"
+                         "  `createdBy` TEXT,\n"
+                         "  `updatedBy` TEXT,\n"
+                         "  PRIMARY KEY(`id`)\n"
+                         ")");
+
+            executeQuery("CREATE TABLE IF NOT EXISTS `Node` (\n"
+                         "  `id`	     INTEGER NOT NULL,\n"
+                         "  `nodeType` INTEGER NOT NULL,\n"
+                         "  `name`     TEXT,\n"
+                         "  `label`    TEXT,\n"
+                         "  `info`     TEXT,\n"
+                         "  `icon`     TEXT,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE,\n"
+                         "  FOREIGN KEY(`nodeType`) REFERENCES Storable(`id`) ON DELETE NO ACTION\n"
+                         ")");
+            // where an ElementQuery for one type starts
+            executeQuery("CREATE INDEX IF NOT EXISTS idx_Node_nodeType ON `Node`(`nodeType`)");
+        }
+
+        mReloadQuery = lazyQuery(
             "SELECT "
             "s.`id` AS `id`,s.`type` AS `type`,s.`version` AS `version`,s.`createdAt` AS "
             "`createdAt`,s.`createdBy` AS `createdBy`,s.`updatedAt` AS "
@@ -43,24 +47,24 @@ void NodeStorage::setDatabase(const QSqlDatabase &database)
             "`label`,n.`info` AS `info`,n.`icon` AS `icon` FROM `Storable` s JOIN `Node` n ON "
             "s.`id`=n.`id` WHERE s.`id`=:id");
 
-        mInsertStorableQuery = createQuery(
-            "INSERT INTO `Storable` (`type`,`typeName`,`version`,`createdAt`,`createdBy`) VALUES "
-            "(:type,:typeName,:version,:createdAt,:createdBy)");
-        mInsertNodeQuery = createQuery(
+        mInsertStorableQuery = lazyQuery(
+            "INSERT INTO `Storable` (`type`,`version`,`createdAt`,`createdBy`) VALUES "
+            "(:type,:version,:createdAt,:createdBy)");
+        mInsertNodeQuery = lazyQuery(
             "INSERT INTO `Node` (`id`,`nodeType`,`name`,`label`,`info`,`icon`) VALUES "
             "(:id,:nodeType,:name,:label,:info,:icon)");
 
-        mUpdateStorableQuery = createQuery(
+        mUpdateStorableQuery = lazyQuery(
             "UPDATE `Storable` SET "
-            "`type`=:type,`typeName`=:typeName,`version`=:version,`createdAt`=:createdAt,`"
+            "`type`=:type,`version`=:version,`createdAt`=:createdAt,`"
             "createdBy`=:createdBy,`updatedAt`=:updatedAt,`"
             "updatedBy`=:updatedBy WHERE `id`=:id");
-        mUpdateNodeQuery = createQuery("UPDATE `Node` SET "
+        mUpdateNodeQuery = lazyQuery("UPDATE `Node` SET "
                                        "`nodeType=:nodeType`,`name`=:name,`label`=:label,`info`=:"
                                        "info,`icon`=:icon WHERE `id`=:id");
 
-        mRemoveStorableQuery = createQuery("DELETE FROM `Storable` WHERE `id`=:id");
-        mRemoveNodeQuery = createQuery("DELETE FROM `Node` WHERE `id`=:id");
+        mRemoveStorableQuery = lazyQuery("DELETE FROM `Storable` WHERE `id`=:id");
+        mRemoveNodeQuery = lazyQuery("DELETE FROM `Node` WHERE `id`=:id");
     }
 
     emitDatabaseChanged();
@@ -82,29 +86,28 @@ bool NodeStorage::insertNode(Node *node)
     Transaction tx{Transaction::WriteModified, node, storage()};
 
     const QDateTime createdAt = QDateTime::currentDateTime();
-    const QString createdBy = "tomas";
+    const QString createdBy = storage()->stringPool().intern("tomas");
     const int version = node->version() + 1;
 
     if (!executeQuery(mInsertStorableQuery,
                       QVariantMap{{":type", node->type()},
-                                  {":typeName", node->typeName()},
                                   {":version", version},
                                   {":createdAt", createdAt.toMSecsSinceEpoch()},
                                   {":createdBy", createdBy}})) {
         handleError(this,
                     "insertNode",
-                    {mInsertStorableQuery.lastError().text(), mInsertStorableQuery.lastQuery()});
+                    {mInsertStorableQuery->lastError().text(), mInsertStorableQuery->lastQuery()});
         return false;
     }
 
-    if (!mInsertStorableQuery.lastInsertId().isValid()) {
+    if (!mInsertStorableQuery->lastInsertId().isValid()) {
         handleError(this,
                     "insertNode",
-                    {"lastInsertId is invalid", mInsertStorableQuery.lastQuery()});
+                    {"lastInsertId is invalid", mInsertStorableQuery->lastQuery()});
         return false;
     }
 
-    const int rowid = mInsertStorableQuery.lastInsertId().toInt();
+    const int rowid = mInsertStorableQuery->lastInsertId().toInt();
 
     if (!executeQuery(mInsertNodeQuery,
                       QVariantMap{{":id", rowid},
@@ -115,7 +118,7 @@ bool NodeStorage::insertNode(Node *node)
                                   {":icon", node->icon()}})) {
         handleError(this,
                     "insertNode",
-                    {mInsertNodeQuery.lastError().text(), mInsertNodeQuery.lastQuery()});
+                    {mInsertNodeQuery->lastError().text(), mInsertNodeQuery->lastQuery()});
         return false;
     }
 
@@ -124,9 +127,7 @@ bool NodeStorage::insertNode(Node *node)
     node->setCreatedBy(createdBy);
     node->setVersion(version);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool NodeStorage::updateNode(Node *node)
@@ -143,7 +144,6 @@ bool NodeStorage::updateNode(Node *node)
 
     if (!executeQuery(mUpdateStorableQuery,
                       QVariantMap{{":type", node->type()},
-                                  {":typeName", node->typeName()},
                                   {":version", version},
                                   {":createdAt", node->createdAt().toMSecsSinceEpoch()},
                                   {":updatedAt", updatedAt.toMSecsSinceEpoch()},
@@ -152,7 +152,7 @@ bool NodeStorage::updateNode(Node *node)
                                   {":id", node->rowid()}})) {
         handleError(this,
                     "updateNode",
-                    {mUpdateStorableQuery.lastError().text(), mUpdateStorableQuery.lastQuery()});
+                    {mUpdateStorableQuery->lastError().text(), mUpdateStorableQuery->lastQuery()});
         return false;
     }
 
@@ -165,16 +165,14 @@ bool NodeStorage::updateNode(Node *node)
                                   {":id", node->rowid()}})) {
         handleError(this,
                     "updateNode",
-                    {mUpdateNodeQuery.lastError().text(), mUpdateNodeQuery.lastQuery()});
+                    {mUpdateNodeQuery->lastError().text(), mUpdateNodeQuery->lastQuery()});
         return false;
     }
 
     node->setUpdatedAt(updatedAt);
     node->setVersion(version);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool NodeStorage::reloadNode(Node *node)
@@ -190,30 +188,33 @@ bool NodeStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, QVariantMap{{":id", node->rowid()}}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
-    node->setRowid(mReloadQuery.value("id").toInt());
-    node->setType(mReloadQuery.value("type").toInt());
-    node->setVersion(mReloadQuery.value("version").toInt());
-    node->setCreatedAt(
-        QDateTime::fromMSecsSinceEpoch(mReloadQuery.value("createdAt").value<qint64>()));
-    node->setUpdatedAt(
-        QDateTime::fromMSecsSinceEpoch(mReloadQuery.value("updatedAt").value<qint64>()));
-    node->setCreatedBy(mReloadQuery.value("createdBy").toString());
-    node->setUpdatedBy(mReloadQuery.value("updatedBy").toString());
-
-    // node->setNodeType(qobject_cast<NodeType*>(storage().nodeType(node->type(), "")));
-    node->setName(mReloadQuery.value("name").toString());
-    node->setLabel(mReloadQuery.value("label").toString());
-    node->setInfo(mReloadQuery.value("info").toString());
-    node->setIcon(mReloadQuery.value("icon").toString());
+    readNode(node, mReloadQuery);
 
     mNodesByRowid.insert(node->rowid(), node);
 
-    tx.commit();
+    return tx.commit();
+}
+
+void NodeStorage::readNode(Node *node, const QSqlQuery &query)
+{
+    node->setRowid(query.value("id").toInt());
+    node->setType(query.value("type").toInt());
+    node->setVersion(query.value("version").toInt());
+    node->setCreatedAt(QDateTime::fromMSecsSinceEpoch(query.value("createdAt").value<qint64>()));
+    node->setUpdatedAt(QDateTime::fromMSecsSinceEpoch(query.value("updatedAt").value<qint64>()));
+    // low-cardinality columns share one instance per value, info is free text
+    StringPool &pool = storage()->stringPool();
+    node->setCreatedBy(pool.intern(query.value("createdBy").toString()));
+    node->setUpdatedBy(pool.intern(query.value("updatedBy").toString()));
 
-    return true;
+    // node->setNodeType(qobject_cast<NodeType*>(storage().nodeType(node->type(), "")));
+    node->setName(pool.intern(query.value("name").toString()));
+    node->setLabel(pool.intern(query.value("label").toString()));
+    node->setInfo(query.value("info").toString());
+    node->setIcon(pool.intern(query.value("icon").toString()));
 }
 
 bool NodeStorage::removeNode(int rowid)
@@ -223,25 +224,27 @@ bool NodeStorage::removeNode(int rowid)
         return false;
     }
 
+    // every storage removes its rows through this one
+    if (isReadOnly())
+        return handleError(this, "removeNode", "storage is read-only"), false;
+
     Transaction tx{Transaction::WriteModified, mNodesByRowid.value(rowid), storage()};
 
     if (!executeQuery(mRemoveStorableQuery, QVariantMap{{":id", rowid}})) {
         handleError(this,
                     "removeNode",
-                    {mRemoveStorableQuery.lastError().text(), mRemoveStorableQuery.lastQuery()});
+                    {mRemoveStorableQuery->lastError().text(), mRemoveStorableQuery->lastQuery()});
         return false;
     }
 
     if (!executeQuery(mRemoveNodeQuery, QVariantMap{{":id", rowid}})) {
         handleError(this,
                     "removeNode",
-                    {mRemoveNodeQuery.lastError().text(), mRemoveNodeQuery.lastQuery()});
+                    {mRemoveNodeQuery->lastError().text(), mRemoveNodeQuery->lastQuery()});
         return false;
     }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool NodeStorage::updateName(Node *node)
@@ -31,20 +31,23 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
+    // Reads the Storable and Node columns of the current row of query into node.
+    void readNode(Node* node, const QSqlQuery& query);
+
     bool updateName(Node* node);
     bool updateLabel(Node* node);
     bool updateInfo(Node* node);
     bool updateIcon(Node* node);
     bool updateNodeType(Node* node);
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mReloadNodeQuery;
-    QSqlQuery mInsertStorableQuery;
-    QSqlQuery mInsertNodeQuery;
-    QSqlQuery mUpdateStorableQuery;
-    QSqlQuery mUpdateNodeQuery;
-    QSqlQuery mRemoveStorableQuery;
-    QSqlQuery mRemoveNodeQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mReloadNodeQuery;
+    PreparedQuery mInsertStorableQuery;
+    PreparedQuery mInsertNodeQuery;
+    PreparedQuery mUpdateStorableQuery;
+    PreparedQuery mUpdateNodeQuery;
+    PreparedQuery mRemoveStorableQuery;
+    PreparedQuery mRemoveNodeQuery;
 
     friend class Node;
     friend class ElementStorage;
@@ -52,6 +55,7 @@ protected:
     friend class ValueStorage;
     friend class ProjectStorage;
     friend class NodeTypeStorage;
+    friend class BaseTypeStorage;
     friend class Storage;
 };
 
@@ -6,15 +6,17 @@ void NodeTypeStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `NodeType` (\n"
-                     "  `id`	   INTEGER NOT NULL UNIQUE,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-
-        mReloadQuery = createQuery("SELECT * FROM `NodeType` WHERE `id`=:id");
-        mInsertQuery = createQuery("INSERT INTO `NodeType` (`id`) VALUES (:id)");
-        mUpdateQuery = createQuery("UPDATE `NodeType` SET `id`=:id WHERE `id`=:id");
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `NodeType` (\n"
+                         "  `id`	   INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `NodeType` WHERE `id`=:id");
+        mInsertQuery = lazyQuery("INSERT INTO `NodeType` (`id`) VALUES (:id)");
+        mUpdateQuery = lazyQuery("UPDATE `NodeType` SET `id`=:id WHERE `id`=:id");
     }
 
     emitDatabaseChanged();
@@ -38,9 +40,7 @@ bool NodeTypeStorage::insertNode(Node *node)
     if (!executeQuery(mInsertQuery, QVariantMap{{":id", nodeType->rowid()}}))
         return handleError(this, "insertNode", mInsertQuery), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool NodeTypeStorage::updateNode(Node *node)
@@ -55,9 +55,7 @@ bool NodeTypeStorage::updateNode(Node *node)
     // if (!executeQuery(mUpdateQuery, QVariantMap{{":id", nodeType->rowid()}}))
     //     return handleError(this, "updateNode", mUpdateQuery), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool NodeTypeStorage::reloadNode(Node *node)
@@ -72,12 +70,10 @@ bool NodeTypeStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {nodeType->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool NodeTypeStorage::removeNode(int rowid)
@@ -92,7 +88,5 @@ bool NodeTypeStorage::removeNode(int rowid)
     if (!storage()->nodeStorage()->removeNode(rowid))
         return false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
@@ -18,21 +18,22 @@ public:
 
     [[nodiscard]] NodeType* nodeType() { return static_cast<NodeType*>(node()); }
     [[nodiscard]] NodeType* nodeType(int rowid) { return static_cast<NodeType*>(node(rowid)); }
-    [[nodiscard]] NodeType* nodeType(const QString& name) { return mNodesByName.value(name); }
+    [[nodiscard]] NodeType* nodeType(const QString& name) { return mCatalog->nodeType(name); }
     [[nodiscard]] NodeType* createNodeType(const QString& name)
     {
         if (name.isEmpty())
             return handleError(this, "removeNode", "name is empty"), nullptr;
 
-        if (mNodesByName.contains(name))
+        if (nodeType(name))
             return handleError(
                        this,
                        "removeNode",
                        QStringLiteral("storage already contains a type with name '%1'").arg(name)),
                    nullptr;
 
-        if (NodeType* nodeType = static_cast<NodeType*>(createNode())) {
-            mNodesByName.insert(name, nodeType);
+        if (NodeType* nodeType = static_cast<NodeType*>(newNode())) {
+            nodeType->setName(name);
+            rebuildCatalog();
             return nodeType;
         }
 
@@ -56,9 +57,9 @@ protected:
     friend class ProjectTypeStorage;
     friend class Storage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
 };
 
 #endif // LIBNOVELIST_NODETYPESTORAGE_H
@@ -0,0 +1,69 @@
+#include "orderkey.h"
+
+namespace {
+
+// in ASCII order, so the keys compare the same as text in SQLite
+const QString Digits = QStringLiteral(
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
+
+} // namespace
+
+QString OrderKey::between(const QString &before, const QString &after)
+{
+    if (!after.isEmpty() && before >= after)
+        return {};
+
+    // the shared prefix, before read as padded with the lowest digit
+    qsizetype n = 0;
+    while (n < after.size() && (n < before.size() ? before[n] : Digits[0]) == after[n])
+        ++n;
+    if (n > 0)
+        return after.left(n) + between(before.mid(n), after.mid(n));
+
+    const int low = before.isEmpty() ? 0 : value(before[0]);
+    const int high = after.isEmpty() ? Base : value(after[0]);
+    if (high - low > 1)
+        return QString{digit((low + high) / 2)};
+
+    // adjacent digits: the first digit of a longer after is already past before
+    if (after.size() > 1)
+        return after.left(1);
+    return digit(low) + between(before.mid(1), {});
+}
+
+QStringList OrderKey::spread(qsizetype count)
+{
+    if (count <= 0)
+        return {};
+
+    // one digit more than count needs, so the first inserts around each key stay short
+    int width = 1;
+    qint64 range = Base;
+    while (range < (count + 1) * Base && width < 10) {
+        range *= Base;
+        ++width;
+    }
+    const qint64 step = range / (count + 1);
+
+    QStringList keys;
+    keys.reserve(count);
+    for (qsizetype i = 1; i <= count; ++i) {
+        QString key(width, Digits[0]);
+        for (qint64 v = i * step, d = width - 1; d >= 0; v /= Base, --d)
+            key[d] = digit(int(v % Base));
+        while (key.endsWith(Digits[0]))
+            key.chop(1);
+        keys.append(key);
+    }
+    return keys;
+}
+
+QChar OrderKey::digit(int value)
+{
+    return Digits[value];
+}
+
+int OrderKey::value(QChar digit)
+{
+    return int(Digits.indexOf(digit));
+}
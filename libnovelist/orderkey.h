@@ -0,0 +1,38 @@
+#ifndef LIBNOVELIST_ORDERKEY_H
+#define LIBNOVELIST_ORDERKEY_H
+
+#include <QString>
+#include <QStringList>
+
+// Order keys for the rows of Element_fields and Field_values, in the manner of LexoRank: strings
+// of base 62 digits read as a fraction, which sort as plain text in the (owner, index) primary
+// key. There is always a key between two others, so inserting or moving a child writes one row
+// instead of renumbering its siblings.
+//
+// No key ends in the lowest digit, which is what guarantees the room. Keys grow by a digit every
+// few inserts at the same spot; past MaxLength the owner's list is rewritten with spread() keys.
+class OrderKey
+{
+public:
+    static constexpr int Base = 62;
+    static constexpr qsizetype MaxLength = 32;
+
+    // A key between before and after, where an empty before is the start of the list and an
+    // empty after its end. Empty when after doesn't sort after before.
+    [[nodiscard]] static QString between(const QString& before, const QString& after);
+
+    // count keys spaced evenly over the whole range, the shortest that leave room around each.
+    [[nodiscard]] static QStringList spread(qsizetype count);
+
+    // False for the empty key between() gives up with, and for keys due for a rebalance.
+    [[nodiscard]] static bool isUsable(const QString& key)
+    {
+        return !key.isEmpty() && key.size() <= MaxLength;
+    }
+
+private:
+    [[nodiscard]] static QChar digit(int value);
+    [[nodiscard]] static int value(QChar digit);
+};
+
+#endif // LIBNOVELIST_ORDERKEY_H
@@ -6,15 +6,17 @@ void ProjectStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `Project` (\n"
-                     "  `id`	   INTEGER NOT NULL UNIQUE,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-
-        mReloadQuery = createQuery("SELECT * FROM `Project` WHERE `id`=:id");
-        mInsertQuery = createQuery("INSERT INTO `Project` (`id`) VALUES (:id)");
-        mUpdateQuery = createQuery("UPDATE `Project` SET `id`=:id WHERE `id`=:id");
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `Project` (\n"
+                         "  `id`	   INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `Project` WHERE `id`=:id");
+        mInsertQuery = lazyQuery("INSERT INTO `Project` (`id`) VALUES (:id)");
+        mUpdateQuery = lazyQuery("UPDATE `Project` SET `id`=:id WHERE `id`=:id");
     }
 
     emitDatabaseChanged();
@@ -42,9 +44,7 @@ bool ProjectStorage::insertNode(Node *node)
 
     // Project *project = static_cast<Project *>(node);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ProjectStorage::updateNode(Node *node)
@@ -61,9 +61,7 @@ bool ProjectStorage::updateNode(Node *node)
     //     return false;
     // }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ProjectStorage::reloadNode(Node *node)
@@ -78,12 +76,10 @@ bool ProjectStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {project->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ProjectStorage::removeNode(int rowid)
@@ -96,7 +92,5 @@ bool ProjectStorage::removeNode(int rowid)
     if (!storage()->nodeStorage()->removeNode(rowid))
         return false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
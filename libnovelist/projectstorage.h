@@ -24,7 +24,7 @@ public:
     [[nodiscard]] Q_INVOKABLE Project* createProject(const QString& type);
     [[nodiscard]] Q_INVOKABLE Project* createProject(ProjectType* nodeType = nullptr)
     {
-        if (Project* e = static_cast<Project*>(createNode())) {
+        if (Project* e = static_cast<Project*>(newNode())) {
             e->setNodeType(nodeType);
             return e;
         }
@@ -41,9 +41,9 @@ protected:
     friend class Project;
     friend class Storage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
 };
 
 #endif // LIBNOVELIST_PROJECTSTORAGE_H
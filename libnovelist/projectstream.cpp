@@ -0,0 +1,202 @@
+#include "projectstream.h"
+#include "storage.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+
+const QString Format = QStringLiteral("novelist");
+
+// JSON has no integers, the rowids and versions would go back as REAL and the ids of Type_Node
+// values as "12.0"
+QVariant toVariant(const QJsonValue &value)
+{
+    if (value.isNull() || value.isUndefined())
+        return {};
+    if (value.isDouble()) {
+        const double d = value.toDouble();
+        const qint64 i = qint64(d);
+        return double(i) == d ? QVariant{i} : QVariant{d};
+    }
+    if (value.isObject())
+        return QByteArray::fromBase64(value[QLatin1String("base64")].toString().toLatin1());
+    return value.toVariant();
+}
+
+// nor bytes, a BLOB such as a packed chunk goes as {"base64":"..."}
+QJsonValue toJson(const QVariant &value)
+{
+    if (value.typeId() == QMetaType::QByteArray)
+        return QJsonObject{{"base64", QString::fromLatin1(value.toByteArray().toBase64())}};
+    return QJsonValue::fromVariant(value);
+}
+
+} // namespace
+
+ProjectStream::Result ProjectStream::write(QIODevice *device)
+{
+    Result result;
+
+    const QSqlDatabase database = mStorage->database();
+    ChangeLog log{database};
+
+    const QJsonObject header{{"format", Format},
+                             {"version", FormatVersion},
+                             {"schema", SchemaMigrator::CurrentVersion}};
+    if (!writeLine(device, QJsonDocument{header}.toJson(QJsonDocument::Compact), &result))
+        return result;
+
+    for (const ChangeLog::Table &table : ChangeLog::Tables) {
+        const QString name = QString::fromLatin1(table.name);
+        const QStringList columns = log.columns(name);
+        if (columns.isEmpty())
+            continue;
+
+        const QJsonObject start{{"table", name}, {"columns", QJsonArray::fromStringList(columns)}};
+        if (!writeLine(device, QJsonDocument{start}.toJson(QJsonDocument::Compact), &result))
+            return result;
+
+        QSqlQuery query{database};
+        query.setForwardOnly(true);
+        if (!query.exec(QStringLiteral("SELECT %1 FROM `%2`")
+                            .arg('`' + columns.join("`,`") + '`', name)))
+            return handleError(nullptr, "ProjectStream::write", query), result;
+
+        while (query.next()) {
+            QJsonArray row;
+            for (int i = 0; i < columns.size(); ++i)
+                row.append(query.isNull(i) ? QJsonValue{} : toJson(query.value(i)));
+
+            if (!writeLine(device, QJsonDocument{row}.toJson(QJsonDocument::Compact), &result))
+                return result;
+            ++result.rows;
+        }
+    }
+
+    result.ok = true;
+    return result;
+}
+
+ProjectStream::Result ProjectStream::read(QIODevice *device)
+{
+    Result result;
+
+    const QSqlDatabase database = mStorage->database();
+    ChangeLog log{database};
+
+    QByteArray line = device->readLine();
+    result.bytes += line.size();
+    const QJsonObject header = QJsonDocument::fromJson(line).object();
+    if (header.value("format").toString() != Format
+        || header.value("version").toInt() != FormatVersion)
+        return handleError("ProjectStream::read: not a project export"), result;
+
+    // the table the rows are for: its statement, the columns of a row it takes and the key
+    QSqlQuery insert{database};
+    QList<qsizetype> shared;
+    qsizetype key = -1;
+    qint64 lineNumber = 1;
+
+    // the import is kept whole or not at all, the nodes are reloaded once it is in
+    Transaction import{Transaction::Write, nullptr, mStorage};
+    QSet<int> loaded;
+
+    while (!device->atEnd()) {
+        Transaction tx{Transaction::Write, nullptr, mStorage};
+
+        for (int batch = 0; batch < BatchSize && !device->atEnd();) {
+            line = device->readLine();
+            result.bytes += line.size();
+            ++lineNumber;
+            if (line.trimmed().isEmpty())
+                continue;
+
+            QJsonParseError error;
+            const QJsonDocument document = QJsonDocument::fromJson(line, &error);
+            if (error.error != QJsonParseError::NoError)
+                return handleError(QStringLiteral("ProjectStream::read: line %1: %2")
+                                       .arg(lineNumber)
+                                       .arg(error.errorString())),
+                       result;
+
+            if (document.isObject()) {
+                const QString name = document.object().value("table").toString();
+                const auto table = std::find_if(ChangeLog::Tables.cbegin(),
+                                                ChangeLog::Tables.cend(),
+                                                [&](const ChangeLog::Table &t) {
+                                                    return name == QLatin1String(t.name);
+                                                });
+                if (table == ChangeLog::Tables.cend())
+                    return handleError("ProjectStream::read: unknown table " + name), result;
+
+                QStringList columns;
+                for (const auto c : document.object().value("columns").toArray())
+                    columns.append(c.toString());
+
+                // an export of another schema version only gives the columns both know
+                const QStringList localColumns = log.columns(name);
+                QStringList names;
+                shared.clear();
+                for (qsizetype i = 0; i < columns.size(); ++i)
+                    if (localColumns.contains(columns[i])) {
+                        shared.append(i);
+                        names.append('`' + columns[i] + '`');
+                    }
+
+                key = columns.indexOf(table->key);
+                if (key < 0)
+                    return handleError("ProjectStream::read: " + name + " has no key"), result;
+
+                insert = QSqlQuery{database};
+                if (!insert.prepare(
+                        QStringLiteral("INSERT OR REPLACE INTO `%1` (%2) VALUES (%3)")
+                            .arg(name,
+                                 names.join(','),
+                                 QStringList(names.size(), QStringLiteral("?")).join(','))))
+                    return handleError(nullptr, "ProjectStream::read", insert), result;
+                continue;
+            }
+
+            if (key < 0)
+                return handleError(QStringLiteral("ProjectStream::read: line %1: a row before "
+                                                  "its table")
+                                       .arg(lineNumber)),
+                       result;
+
+            const QJsonArray row = document.array();
+            for (const qsizetype i : std::as_const(shared))
+                insert.addBindValue(toVariant(row.at(i)));
+            if (!insert.exec())
+                return handleError(nullptr, "ProjectStream::read", insert), result;
+
+            // only the keys of loaded nodes, so that memory doesn't grow with the import
+            if (const int rowid = row.at(key).toInt(); mStorage->loadedNode(rowid))
+                loaded.insert(rowid);
+            ++result.rows;
+            ++batch;
+        }
+
+        if (!tx.commit())
+            return result;
+    }
+
+    if (!import.commit())
+        return result;
+
+    for (const int rowid : std::as_const(loaded))
+        if (Node *node = mStorage->loadedNode(rowid))
+            node->reload();
+
+    result.ok = true;
+    return result;
+}
+
+bool ProjectStream::writeLine(QIODevice *device, const QByteArray &line, Result *result)
+{
+    if (device->write(line) != line.size() || !device->putChar('\n'))
+        return handleError("ProjectStream::write: " + device->errorString()), false;
+    result->bytes += line.size() + 1;
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef LIBNOVELIST_PROJECTSTREAM_H
+#define LIBNOVELIST_PROJECTSTREAM_H
+
+#include <QIODevice>
+
+#include "errorhandler.h"
+
+class Storage;
+
+// Exports a whole project as NDJSON and imports it back, a row at a time, so that memory stays
+// the same whatever the size of the project.
+//
+// The rows are read from the tables of ChangeLog::Tables with a forward-only cursor and written
+// one line each, as an array of the column values, a BLOB as an object with its base64; a line
+// with an object starts a table and names its columns. The first line is the header:
+//
+//   {"format":"novelist","version":1,"schema":8}
+//   {"table":"Storable","columns":["id","type","version",...]}
+//   [1,6,3,...]
+//
+// Importing reads a line at a time and inserts the rows in savepoints of BatchSize rows, over
+// the rows with the same keys, all of them in one transaction: a failed import rolls back
+// completely and leaves the file as it was. Only the columns both schemas know are written, like
+// ChangeLog::apply(). The loaded nodes the rows belong to are reloaded once the import is in.
+class ProjectStream : public ErrorHandler
+{
+public:
+    struct Result
+    {
+        bool ok = false;
+        qint64 rows = 0;
+        qint64 bytes = 0;
+    };
+
+    static constexpr int FormatVersion = 1;
+    static constexpr int BatchSize = 10000;
+
+    explicit ProjectStream(Storage* storage)
+        : mStorage{storage}
+    {}
+
+    Result write(QIODevice* device);
+    Result read(QIODevice* device);
+
+private:
+    bool writeLine(QIODevice* device, const QByteArray& line, Result* result);
+
+    Storage* mStorage = nullptr;
+};
+
+#endif // LIBNOVELIST_PROJECTSTREAM_H
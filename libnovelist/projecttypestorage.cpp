@@ -7,15 +7,17 @@ void ProjectTypeStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `ProjectType` (\n"
-                     "  `id`          INTEGER NOT NULL UNIQUE,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-
-        mReloadQuery = createQuery("SELECT * FROM `ProjectType` WHERE `id`=:id");
-        mInsertQuery = createQuery("INSERT INTO `ProjectType` (`id`) VALUES (:id)");
-        mUpdateQuery = createQuery("UPDATE `ProjectType` SET `id`=:id WHERE `id`=:id");
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `ProjectType` (\n"
+                         "  `id`          INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `ProjectType` WHERE `id`=:id");
+        mInsertQuery = lazyQuery("INSERT INTO `ProjectType` (`id`) VALUES (:id)");
+        mUpdateQuery = lazyQuery("UPDATE `ProjectType` SET `id`=:id WHERE `id`=:id");
     }
 
     emitDatabaseChanged();
@@ -39,9 +41,7 @@ bool ProjectTypeStorage::insertNode(Node *node)
     if (!executeQuery(mInsertQuery, QVariantMap{{":id", projectType->rowid()}}))
         return handleError(this, "insertNode", mInsertQuery), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ProjectTypeStorage::updateNode(Node *node)
@@ -58,9 +58,7 @@ bool ProjectTypeStorage::updateNode(Node *node)
     //     return false;
     // }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ProjectTypeStorage::reloadNode(Node *node)
@@ -75,12 +73,10 @@ bool ProjectTypeStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {projectType->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ProjectTypeStorage::removeNode(int rowid)
@@ -93,7 +89,10 @@ bool ProjectTypeStorage::removeNode(int rowid)
     if (!storage()->elementTypeStorage()->removeNode(rowid))
         return false;
 
-    tx.commit();
+    return tx.commit();
+}
 
-    return true;
+bool ProjectTypeStorage::loadTypes()
+{
+    return loadTypeTable("ProjectType", Storable::Type_ProjectType);
 }
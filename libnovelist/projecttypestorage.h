@@ -36,19 +36,19 @@ public:
         if (name.isEmpty())
             return handleError(this, "removeNode", "name is empty"), nullptr;
 
-        if (mNodesByName.contains(name))
+        if (nodeType(name))
             return handleError(
                        this,
                        "removeNode",
                        QStringLiteral("storage already contains a type with name '%1'").arg(name)),
                    nullptr;
 
-        if (ProjectType* projectType = static_cast<ProjectType*>(createNode())) {
-            mNodesByName.insert(name, projectType);
+        if (ProjectType* projectType = static_cast<ProjectType*>(newNode())) {
             projectType->setName(name);
             projectType->setLabel(label);
             projectType->setInfo(info);
             projectType->setIcon(icon);
+            rebuildCatalog();
             return projectType;
         }
 
@@ -64,12 +64,14 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
+    bool loadTypes();
+
     friend class ProjectType;
     friend class Storage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
 };
 
 #endif // LIBNOVELIST_PROJECTTYPESTORAGE_H
@@ -0,0 +1,252 @@
+#include "prose.h"
+#include "orderkey.h"
+#include "textcodec.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+// a fixed random number per byte, the same in every build so that chunks stay where they are
+constexpr std::array<quint32, 256> gear()
+{
+    std::array<quint32, 256> table{};
+    quint64 state = 0x9e3779b97f4a7c15;
+    for (quint32 &entry : table) {
+        state += 0x9e3779b97f4a7c15;
+        quint64 z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        entry = quint32(z ^ (z >> 31));
+    }
+    return table;
+}
+
+constexpr std::array<quint32, 256> Gear = gear();
+
+} // namespace
+
+QStringList Prose::split(QStringView text)
+{
+    QStringList pieces;
+    quint32 hash = 0;
+    qsizetype start = 0;
+    qsizetype space = -1;
+
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar c = text[i];
+        hash = (hash << 1) + Gear[c.unicode() & 0xff];
+
+        const bool isSpace = c.isSpace();
+        if (isSpace)
+            space = i;
+
+        const qsizetype size = i + 1 - start;
+        qsizetype cut = -1;
+        if (isSpace && size >= MinSize && (hash & Mask) == 0)
+            cut = i + 1;
+        else if (size >= MaxSize)
+            // after the last space if there is one, never between the halves of a surrogate pair
+            cut = space >= start ? space + 1 : c.isHighSurrogate() ? i : i + 1;
+
+        if (cut > start) {
+            pieces.append(text.mid(start, cut - start).toString());
+            start = cut;
+        }
+    }
+
+    if (start < text.size())
+        pieces.append(text.mid(start).toString());
+
+    return pieces;
+}
+
+Prose::Prose(const QString &text)
+{
+    const QStringList pieces = split(text);
+    const QStringList keys = OrderKey::spread(pieces.size());
+    for (qsizetype i = 0; i < pieces.size(); ++i)
+        mChunks.append({keys[i], pieces[i]});
+    updateOffsets();
+}
+
+QList<Prose::Chunk> Prose::chunks() const
+{
+    for (qsizetype i = 0; i < mChunks.size(); ++i)
+        textAt(i);
+    return mChunks;
+}
+
+Prose::Chunk Prose::chunk(const QString &key) const
+{
+    for (qsizetype i = 0; i < mChunks.size(); ++i)
+        if (mChunks[i].key == key)
+            return {key, textAt(i), {}, mChunks[i].size};
+    return {};
+}
+
+void Prose::setChunks(const QList<Chunk> &chunks)
+{
+    mChunks = chunks;
+    updateOffsets();
+}
+
+bool Prose::hasChunks(const QList<Chunk> &chunks) const
+{
+    if (chunks.size() != mChunks.size())
+        return false;
+
+    for (qsizetype i = 0; i < chunks.size(); ++i) {
+        const Chunk &chunk = chunks[i];
+        const Chunk &own = mChunks[i];
+        if (chunk.key != own.key)
+            return false;
+        if (!chunk.packed.isEmpty() && !own.packed.isEmpty()) {
+            if (chunk.packed != own.packed)
+                return false;
+        } else if (chunk.packed.isEmpty() ? chunk.text != textAt(i)
+                                          : TextCodec::unpack(chunk.packed) != own.text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString Prose::text() const
+{
+    QString text;
+    text.reserve(mSize);
+    for (qsizetype i = 0; i < mChunks.size(); ++i)
+        text.append(textAt(i));
+    return text;
+}
+
+QString Prose::mid(qsizetype position, qsizetype length) const
+{
+    position = std::clamp<qsizetype>(position, 0, mSize);
+    length = std::clamp<qsizetype>(length, 0, mSize - position);
+
+    QString text;
+    text.reserve(length);
+    for (qsizetype i = chunkAt(position); i < mChunks.size() && length > 0; ++i) {
+        const QString &chunk = textAt(i);
+        const qsizetype from = position - mOffsets[i];
+        const qsizetype n = std::min(length, chunk.size() - from);
+        text.append(QStringView{chunk}.mid(from, n));
+        position += n;
+        length -= n;
+    }
+    return text;
+}
+
+Prose::Edit Prose::replace(qsizetype position, qsizetype length, const QString &text)
+{
+    position = std::clamp<qsizetype>(position, 0, mSize);
+    length = std::clamp<qsizetype>(length, 0, mSize - position);
+
+    Edit edit;
+    edit.position = position;
+
+    if (mChunks.isEmpty()) {
+        *this = Prose{text};
+        edit.inserted = mChunks;
+        return edit;
+    }
+
+    qsizetype first = chunkAt(position);
+    qsizetype last = chunkAt(std::max(position, position + length - 1));
+
+    QString local;
+    for (qsizetype i = first; i <= last; ++i)
+        local.append(textAt(i));
+    local.replace(position - mOffsets[first], length, text);
+
+    // a chunk that gets too small takes a neighbour in, so that deletions don't leave crumbs
+    if (local.size() < MinSize && mChunks.size() > last - first + 1) {
+        if (last + 1 < mChunks.size()) {
+            ++last;
+            local.append(textAt(last));
+        } else {
+            --first;
+            local.prepend(textAt(first));
+        }
+    }
+
+    const QStringList pieces = split(local);
+    const qsizetype old = last - first + 1;
+    const qsizetype kept = std::min(old, pieces.size());
+
+    QList<Chunk> chunks;
+    for (qsizetype i = 0; i < kept; ++i) {
+        const Chunk &chunk = mChunks[first + i];
+        chunks.append({chunk.key, pieces[i]});
+        if (chunk.text != pieces[i])
+            edit.updated.append(chunks.last());
+    }
+    for (qsizetype i = kept; i < old; ++i)
+        edit.removed.append(mChunks[first + i].key);
+
+    QString before = kept > 0 ? chunks.last().key : first > 0 ? mChunks[first - 1].key : QString{};
+    const QString after = last + 1 < mChunks.size() ? mChunks[last + 1].key : QString{};
+    for (qsizetype i = kept; i < pieces.size(); ++i) {
+        before = OrderKey::between(before, after);
+        if (!OrderKey::isUsable(before)) {
+            edit.rewritten = true;
+            break;
+        }
+        chunks.append({before, pieces[i]});
+        edit.inserted.append(chunks.last());
+    }
+
+    if (edit.rewritten) {
+        QList<Chunk> all = mChunks.mid(0, first);
+        for (qsizetype i = 0; i < pieces.size(); ++i)
+            all.append({QString{}, pieces[i]});
+        all.append(mChunks.mid(last + 1));
+
+        const QStringList keys = OrderKey::spread(all.size());
+        for (qsizetype i = 0; i < all.size(); ++i)
+            all[i].key = keys[i];
+
+        mChunks = all;
+        updateOffsets();
+        return Edit{{}, {}, {}, true, position};
+    }
+
+    mChunks.remove(first, old);
+    for (qsizetype i = 0; i < chunks.size(); ++i)
+        mChunks.insert(first + i, chunks[i]);
+    updateOffsets();
+
+    return edit;
+}
+
+qsizetype Prose::chunkAt(qsizetype position) const
+{
+    if (mOffsets.isEmpty())
+        return 0;
+    // the last chunk that starts at or before position
+    const auto it = std::upper_bound(mOffsets.cbegin(), mOffsets.cend(), position);
+    return std::max<qsizetype>(0, std::min(it - mOffsets.cbegin() - 1, mChunks.size() - 1));
+}
+
+const QString &Prose::textAt(qsizetype index) const
+{
+    Chunk &chunk = mChunks[index];
+    if (!chunk.packed.isEmpty()) {
+        chunk.text = TextCodec::unpack(chunk.packed);
+        chunk.packed.clear();
+    }
+    return chunk.text;
+}
+
+void Prose::updateOffsets()
+{
+    mOffsets.resize(mChunks.size());
+    mSize = 0;
+    for (qsizetype i = 0; i < mChunks.size(); ++i) {
+        mOffsets[i] = mSize;
+        const Chunk &chunk = mChunks[i];
+        mSize += chunk.packed.isEmpty() ? chunk.text.size() : chunk.size;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef LIBNOVELIST_PROSE_H
+#define LIBNOVELIST_PROSE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// The text of a Value::Type_Text value as a list of chunks, each a row of the ValueChunk table
+// under an OrderKey, so that an edit rewrites the chunks it touches instead of the whole text.
+//
+// The chunks are content defined: split() cuts after a whitespace character where a gear hash of
+// the characters before it has its low bits clear, between MinSize and MaxSize characters apart.
+// A cut never falls inside a word, so the word counts of the chunks add up to that of the text.
+// replace() splits only the chunks the edit touches again, merging one that gets too small with
+// a neighbour, and keeps the keys of the chunks it rewrites in place.
+//
+// Chunks read back packed (see TextCodec) stay packed until their text is first asked for, so a
+// chapter that is opened but not read is never unpacked.
+class Prose
+{
+public:
+    // A packed chunk has its text in packed and its length in size, the text is null until then.
+    struct Chunk
+    {
+        QString key;
+        QString text;
+        QByteArray packed;
+        qsizetype size = 0;
+    };
+
+    // The rows an edit changes. When the keys between two chunks run out, every chunk gets a new
+    // one and rewritten is set instead.
+    struct Edit
+    {
+        QList<Chunk> updated;
+        QList<Chunk> inserted;
+        QStringList removed;
+        bool rewritten = false;
+        // Where in the text the edit starts.
+        qsizetype position = 0;
+    };
+
+    static constexpr qsizetype MinSize = 512;
+    static constexpr qsizetype MaxSize = 8192;
+    // A cut every 256 whitespace characters on average, about one in 1500 characters of prose.
+    static constexpr quint32 Mask = 0xff;
+
+    [[nodiscard]] static QStringList split(QStringView text);
+
+    Prose() = default;
+    explicit Prose(const QString& text);
+
+    // The chunks, all of them unpacked.
+    [[nodiscard]] QList<Chunk> chunks() const;
+    // The chunk under key unpacked, one without a key if there is none.
+    [[nodiscard]] Chunk chunk(const QString& key) const;
+    void setChunks(const QList<Chunk>& chunks);
+    // Whether chunks hold the same keys and text, unpacking only to compare with a plain chunk.
+    [[nodiscard]] bool hasChunks(const QList<Chunk>& chunks) const;
+
+    [[nodiscard]] qsizetype size() const { return mSize; }
+    [[nodiscard]] QString text() const;
+    [[nodiscard]] QString mid(qsizetype position, qsizetype length) const;
+
+    Edit replace(qsizetype position, qsizetype length, const QString& text);
+
+private:
+    // The chunk that holds position, the last one for the end of the text.
+    [[nodiscard]] qsizetype chunkAt(qsizetype position) const;
+    [[nodiscard]] const QString& textAt(qsizetype index) const;
+    void updateOffsets();
+
+    mutable QList<Chunk> mChunks;
+    QList<qsizetype> mOffsets;
+    qsizetype mSize = 0;
+};
+
+#endif // LIBNOVELIST_PROSE_H
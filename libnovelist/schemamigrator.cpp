@@ -0,0 +1,252 @@
+#include "schemamigrator.h"
+#include "orderkey.h"
+#include "value.h"
+
+namespace {
+
+const QString OldSuffix = QStringLiteral("_old");
+
+} // namespace
+
+int SchemaMigrator::userVersion(const QSqlDatabase &database)
+{
+    QSqlQuery query{database};
+    if (!query.exec("PRAGMA user_version") || !query.next())
+        return 0;
+    return query.value(0).toInt();
+}
+
+bool SchemaMigrator::prepare()
+{
+    mVersion = userVersion(mDatabase);
+
+    if (mVersion > CurrentVersion)
+        return handleError(QStringLiteral("SchemaMigrator: database has schema version %1, "
+                                          "this build only knows up to %2")
+                               .arg(mVersion)
+                               .arg(CurrentVersion)),
+               false;
+
+    if (mVersion == CurrentVersion)
+        return true;
+
+    const auto tables = names("SELECT `name` FROM `sqlite_master` WHERE `type`='table' AND "
+                              "`name` NOT LIKE 'sqlite_%'");
+
+    // a new file, the storages create the current schema and finish() stamps it
+    if (tables.isEmpty())
+        return true;
+
+    if (!mDatabase.transaction())
+        return handleError("SchemaMigrator: could not begin transaction"), false;
+    mTransaction = true;
+
+    // the triggers of the change log would follow the tables they log, ChangeLog creates them anew
+    const auto triggers = names("SELECT `name` FROM `sqlite_master` WHERE `type`='trigger'");
+    for (const auto &trigger : triggers)
+        if (!exec(QStringLiteral("DROP TRIGGER `%1`").arg(trigger)))
+            return rollback();
+
+    // version 1 changed the layout of every table, its rows are copied into the current one;
+    // later versions only change the order keys of two link tables, the rest is done in place
+    QStringList moved = tables;
+    if (mVersion >= 2)
+        moved = mVersion < 4 ? QStringList{"Element_fields", "Field_values"} : QStringList{};
+
+    // the indexes of a moved table carry the names of the current ones, but would stay with it
+    for (const auto &table : std::as_const(moved)) {
+        const auto indexes = names(QStringLiteral("SELECT `name` FROM `sqlite_master` WHERE "
+                                                  "`type`='index' AND `sql` IS NOT NULL AND "
+                                                  "`tbl_name`='%1'")
+                                       .arg(table));
+        for (const auto &index : indexes)
+            if (!exec(QStringLiteral("DROP INDEX `%1`").arg(index)))
+                return rollback();
+
+        if (!exec(QStringLiteral("ALTER TABLE `%1` RENAME TO `%1%2`").arg(table, OldSuffix)))
+            return rollback();
+        mMovedTables.append(table);
+    }
+
+    if (mVersion < 2)
+        return true;
+
+    // new columns; new tables and indexes are created by the storages, see needsSchema()
+    if (mVersion < 7 && !exec("ALTER TABLE `FieldType` ADD COLUMN `formula` TEXT"))
+        return rollback();
+    if (mVersion < 8 && !exec("ALTER TABLE `FieldType` ADD COLUMN `validator` TEXT"))
+        return rollback();
+    if (mVersion < 10 && tables.contains("ValueChunk")
+        && !exec("ALTER TABLE `ValueChunk` ADD COLUMN `packed` BLOB"))
+        return rollback();
+
+    // version 11 kept long text whole in the value column, older ones are left to
+    // ValueStorage::migrateText()
+    if (mVersion == 11
+        && !exec(QStringLiteral("UPDATE `Value` SET `value`=substr(`value`,1,%1) WHERE "
+                                "`valueType`=%2 AND length(`value`)>%1")
+                     .arg(Value::TextPrefix)
+                     .arg(Value::Type_Text)))
+        return rollback();
+
+    return true;
+}
+
+bool SchemaMigrator::finish()
+{
+    if (mVersion == CurrentVersion)
+        return true;
+
+    for (const auto &table : std::as_const(mMovedTables)) {
+        const QString old = table + OldSuffix;
+        const auto target = columns(table);
+        const auto source = columns(old);
+
+        // copies the columns both layouts have, e.g. drops the surrogate id of the link tables
+        QStringList common;
+        for (const auto &column : target)
+            if (source.contains(column))
+                common.append(QStringLiteral("`%1`").arg(column));
+
+        const bool link = target.size() == 3 && target.at(1) == "index" && source.contains("index");
+        const bool ordered = table == "Element_fields" || table == "Field_values";
+
+        // the positions of the children before version 4 become order keys
+        if (ordered && mVersion < 4) {
+            if (!copyPositions(table, old, true, false))
+                return rollback();
+        } else if (link && hasDuplicates(table, old)) {
+            // two children at one position are both kept, numbered again in the order they had
+            if (!copyPositions(table, old, ordered, true))
+                return rollback();
+        } else if (!common.isEmpty()) {
+            // a row that clashes with another fails the migration, it never replaces it
+            const auto list = common.join(',');
+            if (!exec(QStringLiteral("INSERT INTO `%1` (%2) SELECT %2 FROM `%3`")
+                          .arg(table, list, old)))
+                return rollback();
+        }
+
+        if (!exec(QStringLiteral("DROP TABLE `%1`").arg(old)))
+            return rollback();
+    }
+
+    if (!exec(QStringLiteral("PRAGMA user_version = %1").arg(CurrentVersion)))
+        return rollback();
+
+    if (mTransaction) {
+        if (!mDatabase.commit())
+            return handleError("SchemaMigrator: could not commit"), rollback();
+        mTransaction = false;
+
+        // hands the pages of the old layout, or of the long text version 11 kept in the value
+        // column next to its packed chunks, back to the file system; the steps of other versions
+        // leave too little behind to be worth rewriting the whole file
+        if (mVersion < 2 || mVersion == 11)
+            exec("VACUUM");
+    }
+
+    mVersion = CurrentVersion;
+    return true;
+}
+
+bool SchemaMigrator::hasDuplicates(const QString &table, const QString &old)
+{
+    const QString owner = columns(table).first();
+    return !names(QStringLiteral("SELECT `%1` FROM `%2` GROUP BY `%1`,`index` HAVING COUNT(*)>1 "
+                                 "LIMIT 1")
+                      .arg(owner, old))
+                .isEmpty();
+}
+
+bool SchemaMigrator::copyPositions(const QString &table,
+                                   const QString &old,
+                                   bool orderKeys,
+                                   bool byRowid)
+{
+    // the owner is the first column of the link tables, the child the last
+    const QStringList names = columns(table);
+    if (names.size() != 3)
+        return handleError("SchemaMigrator: unexpected layout of " + table), false;
+    const QString &owner = names.first();
+    const QString &child = names.last();
+
+    QSqlQuery select{mDatabase};
+    select.setForwardOnly(true);
+    if (!select.exec(QStringLiteral("SELECT `%1`,`%2` FROM `%3` ORDER BY `%1`,`index`%4")
+                         .arg(owner, child, old, byRowid ? QStringLiteral(",rowid") : QString{})))
+        return handleError(nullptr, "SchemaMigrator", select), false;
+
+    QSqlQuery insert{mDatabase};
+    insert.prepare(QStringLiteral("INSERT INTO `%1` (`%2`,`index`,`%3`) VALUES (?,?,?)")
+                       .arg(table, owner, child));
+
+    const auto write = [&](const QVariant &ownerId, const QVariantList &children) {
+        const QStringList keys = orderKeys ? OrderKey::spread(children.size()) : QStringList{};
+        for (qsizetype i = 0; i < children.size(); ++i) {
+            insert.addBindValue(ownerId);
+            insert.addBindValue(orderKeys ? QVariant{keys[i]} : QVariant{i});
+            insert.addBindValue(children[i]);
+            if (!insert.exec())
+                return handleError(nullptr, "SchemaMigrator", insert), false;
+        }
+        return true;
+    };
+
+    QVariant ownerId;
+    QVariantList children;
+    while (select.next()) {
+        if (select.value(0) != ownerId) {
+            if (!write(ownerId, children))
+                return false;
+            ownerId = select.value(0);
+            children.clear();
+        }
+        children.append(select.value(1));
+    }
+    return write(ownerId, children);
+}
+
+bool SchemaMigrator::exec(const QString &statement)
+{
+    QSqlQuery query{mDatabase};
+    if (!query.exec(statement))
+        return handleError(nullptr, "SchemaMigrator", query), false;
+    return true;
+}
+
+QStringList SchemaMigrator::names(const QString &statement)
+{
+    QSqlQuery query{mDatabase};
+    query.setForwardOnly(true);
+    if (!query.exec(statement))
+        return handleError(nullptr, "SchemaMigrator", query), QStringList{};
+
+    QStringList result;
+    while (query.next())
+        result.append(query.value(0).toString());
+    return result;
+}
+
+QStringList SchemaMigrator::columns(const QString &table)
+{
+    QSqlQuery query{mDatabase};
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("PRAGMA table_info(`%1`)").arg(table)))
+        return handleError(nullptr, "SchemaMigrator", query), QStringList{};
+
+    QStringList result;
+    while (query.next())
+        result.append(query.value("name").toString());
+    return result;
+}
+
+bool SchemaMigrator::rollback()
+{
+    if (mTransaction) {
+        mDatabase.rollback();
+        mTransaction = false;
+    }
+    mMovedTables.clear();
+    return false;
+}
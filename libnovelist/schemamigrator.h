@@ -0,0 +1,68 @@
+#ifndef LIBNOVELIST_SCHEMAMIGRATOR_H
+#define LIBNOVELIST_SCHEMAMIGRATOR_H
+
+#include <QSqlDatabase>
+#include <QStringList>
+
+#include "errorhandler.h"
+
+// Brings a project database to the current schema, version 12:
+//  - link tables keyed on (owner, index), WITHOUT ROWID, with one index for reverse lookups
+//  - no AUTOINCREMENT, and no redundant UNIQUE on the INTEGER PRIMARY KEY ids
+//  - Storable without the typeName column, the integer type is enough
+//  - the ChangeLog table and its triggers, see ChangeLog
+//  - text order keys instead of positions in Element_fields and Field_values, see OrderKey
+//  - an index on Node.nodeType, for ElementQuery
+//  - the Aggregate table of word and element counts, see Aggregates
+//  - the formula of computed field types, see ComputedFields
+//  - the validator of field types, see BatchValidator
+//  - the ValueChunk table of long text values, see Prose, and its packed column, see TextCodec
+//  - the start of long text in the value column, see Value::TextPrefix
+//
+// The table definitions belong to the storages, so a migration runs around
+// Storage::setDatabase(). A database of version 1 has its whole layout replaced: prepare() moves
+// every table aside, the storages create the current ones, and finish() copies the rows across,
+// drops the old tables and vacuums the file. Later versions are brought up step by step in place:
+// prepare() adds the new columns with ALTER TABLE and moves aside only the link tables whose order
+// keys are rewritten, the storages and ChangeLog add the new tables, indexes and triggers. All of
+// it runs in one transaction, so a migration that fails leaves the file as it was.
+//
+// The version is kept in PRAGMA user_version. Version 1 is the original layout, which never
+// stamped it and so reads as 0.
+class SchemaMigrator : public ErrorHandler
+{
+public:
+    static constexpr int CurrentVersion = 12;
+
+    explicit SchemaMigrator(const QSqlDatabase& database)
+        : mDatabase{database}
+    {}
+
+    // The version stamped in database, 0 when it has none or can't be read.
+    [[nodiscard]] static int userVersion(const QSqlDatabase& database);
+
+    // The version found by prepare().
+    [[nodiscard]] int version() const { return mVersion; }
+    [[nodiscard]] bool isMigrating() const { return mTransaction; }
+
+    bool prepare();
+    bool finish();
+
+private:
+    // Whether the old rows of a link table put two children at one position of an owner.
+    [[nodiscard]] bool hasDuplicates(const QString& table, const QString& old);
+    // Copies a link table with the children of each owner numbered again in order, as order keys
+    // or as positions; byRowid keeps the order of rows at the same position.
+    bool copyPositions(const QString& table, const QString& old, bool orderKeys, bool byRowid);
+    bool exec(const QString& statement);
+    [[nodiscard]] QStringList names(const QString& statement);
+    [[nodiscard]] QStringList columns(const QString& table);
+    bool rollback();
+
+    QSqlDatabase mDatabase;
+    QStringList mMovedTables;
+    int mVersion = 0;
+    bool mTransaction = false;
+};
+
+#endif // LIBNOVELIST_SCHEMAMIGRATOR_H
@@ -0,0 +1,288 @@
+#include "snapshot.h"
+#include "textcodec.h"
+#include "value.h"
+
+#include <QHash>
+#include <QSqlQuery>
+
+#include <algorithm>
+
+namespace {
+
+constexpr quint16 ByteOrder = 0x0102;
+
+// every section starts on 8 bytes, so the columns can be read in place
+qint64 align(qint64 offset)
+{
+    return (offset + 7) & ~qint64(7);
+}
+
+// Each text once, in one UTF-16 buffer.
+class StringTable
+{
+public:
+    quint32 add(const QString &text)
+    {
+        if (text.isNull())
+            return Snapshot::None;
+
+        const auto it = mIndex.constFind(text);
+        if (it != mIndex.constEnd())
+            return *it;
+
+        const quint32 index = quint32(mOffsets.size() - 1);
+        mIndex.insert(text, index);
+        mCharacters.append(text);
+        mOffsets.append(quint32(mCharacters.size()));
+        return index;
+    }
+
+    QList<quint32> mOffsets{0};
+    QString mCharacters;
+    QHash<QString, quint32> mIndex;
+};
+
+} // namespace
+
+bool Snapshot::write(const QSqlDatabase &database, QIODevice *device)
+{
+    QList<qint32> ids;
+    QList<qint32> types;
+    QList<qint32> versions;
+    QList<qint32> nodeTypes;
+    QList<quint32> names;
+    QList<quint32> labels;
+    QList<qint32> valueTypes;
+    QList<quint32> values;
+    StringTable strings;
+
+    const auto text = [](const QSqlQuery &query, int i) {
+        return query.isNull(i) ? QString{} : query.value(i).toString();
+    };
+
+    QSqlQuery query{database};
+    query.setForwardOnly(true);
+
+    // long text is joined from its chunks, unpacked, the snapshot holds it whole
+    QHash<qint32, QString> prose;
+    if (!query.exec("SELECT `value`,`text`,`packed` FROM `ValueChunk` ORDER BY `value`,`index`"))
+        return handleError(nullptr, "Snapshot::write", query), false;
+    while (query.next())
+        prose[query.value(0).toInt()].append(query.isNull(2)
+                                                 ? query.value(1).toString()
+                                                 : TextCodec::unpack(query.value(2).toByteArray()));
+
+    if (!query.exec("SELECT s.`id`,s.`type`,s.`version`,n.`nodeType`,n.`name`,n.`label`,"
+                    "v.`valueType`,v.`value` FROM `Storable` s "
+                    "LEFT JOIN `Node` n ON n.`id`=s.`id` "
+                    "LEFT JOIN `Value` v ON v.`id`=s.`id` ORDER BY s.`id`"))
+        return handleError(nullptr, "Snapshot::write", query), false;
+
+    while (query.next()) {
+        const qint32 id = query.value(0).toInt();
+        ids.append(id);
+        types.append(query.value(1).toInt());
+        versions.append(query.value(2).toInt());
+        nodeTypes.append(query.value(3).toInt());
+        names.append(strings.add(text(query, 4)));
+        labels.append(strings.add(text(query, 5)));
+        valueTypes.append(query.value(6).toInt());
+        values.append(strings.add(query.value(6).toInt() == Value::Type_Text ? prose.take(id)
+                                                                              : text(query, 7)));
+    }
+    prose.clear();
+
+    // an element's children are its fields, a field's its values, in the order of their keys
+    QHash<qint32, QList<qint32>> links;
+    for (const char *sql :
+         {"SELECT `element`,`field` FROM `Element_fields` ORDER BY `element`,`index`",
+          "SELECT `field`,`value` FROM `Field_values` ORDER BY `field`,`index`"}) {
+        if (!query.exec(QString::fromLatin1(sql)))
+            return handleError(nullptr, "Snapshot::write", query), false;
+        while (query.next())
+            links[query.value(0).toInt()].append(query.value(1).toInt());
+    }
+
+    QList<quint32> childOffsets{0};
+    QList<qint32> children;
+    childOffsets.reserve(ids.size() + 1);
+    for (const qint32 id : std::as_const(ids)) {
+        children.append(links.value(id));
+        childOffsets.append(quint32(children.size()));
+    }
+    links.clear();
+
+    const std::pair<const void *, qint64> sections[SectionCount] = {
+        {ids.constData(), ids.size() * qint64(sizeof(qint32))},
+        {types.constData(), types.size() * qint64(sizeof(qint32))},
+        {versions.constData(), versions.size() * qint64(sizeof(qint32))},
+        {nodeTypes.constData(), nodeTypes.size() * qint64(sizeof(qint32))},
+        {names.constData(), names.size() * qint64(sizeof(quint32))},
+        {labels.constData(), labels.size() * qint64(sizeof(quint32))},
+        {valueTypes.constData(), valueTypes.size() * qint64(sizeof(qint32))},
+        {values.constData(), values.size() * qint64(sizeof(quint32))},
+        {childOffsets.constData(), childOffsets.size() * qint64(sizeof(quint32))},
+        {children.constData(), children.size() * qint64(sizeof(qint32))},
+        {strings.mOffsets.constData(), strings.mOffsets.size() * qint64(sizeof(quint32))},
+        {strings.mCharacters.utf16(), strings.mCharacters.size() * qint64(sizeof(char16_t))},
+    };
+
+    Header header{};
+    header.magic = Magic;
+    header.version = FormatVersion;
+    header.byteOrder = ByteOrder;
+    header.rows = quint32(ids.size());
+    header.links = quint32(children.size());
+    header.strings = quint32(strings.mOffsets.size() - 1);
+    header.characters = quint32(strings.mCharacters.size());
+
+    qint64 position = align(sizeof(Header));
+    for (int s = 0; s < SectionCount; ++s) {
+        header.offsets[s] = quint64(position);
+        position = align(position + sections[s].second);
+    }
+    header.size = quint64(position);
+
+    const QByteArray padding(8, '\0');
+    const auto put = [&](const void *data, qint64 bytes) {
+        if (device->write(static_cast<const char *>(data), bytes) != bytes)
+            return false;
+        const qint64 pad = align(bytes) - bytes;
+        return pad == 0 || device->write(padding.constData(), pad) == pad;
+    };
+
+    if (!put(&header, sizeof(Header)))
+        return handleError("Snapshot::write: " + device->errorString()), false;
+    for (const auto &[data, bytes] : sections)
+        if (!put(data, bytes))
+            return handleError("Snapshot::write: " + device->errorString()), false;
+
+    return true;
+}
+
+bool Snapshot::open(const QString &fileName)
+{
+    close();
+
+    mFile.setFileName(fileName);
+    if (!mFile.open(QIODevice::ReadOnly))
+        return handleError("Snapshot::open: " + mFile.errorString()), false;
+
+    const auto fail = [this](const QString &message) {
+        close();
+        handleError("Snapshot::open: " + message);
+        return false;
+    };
+
+    const qint64 size = mFile.size();
+    if (size < qint64(sizeof(Header)))
+        return fail(fileName + " is not a snapshot");
+
+    const uchar *data = mFile.map(0, size);
+    if (!data)
+        return fail(mFile.errorString());
+
+    const Header *header = reinterpret_cast<const Header *>(data);
+    if (header->magic != Magic || header->version != FormatVersion || header->size != quint64(size))
+        return fail(fileName + " is not a snapshot");
+    if (header->byteOrder != ByteOrder)
+        return fail(fileName + " was written on a machine of the other byte order");
+
+    const quint64 lengths[SectionCount] = {header->rows,
+                                           header->rows,
+                                           header->rows,
+                                           header->rows,
+                                           header->rows,
+                                           header->rows,
+                                           header->rows,
+                                           header->rows,
+                                           quint64(header->rows) + 1,
+                                           header->links,
+                                           quint64(header->strings) + 1,
+                                           header->characters};
+    const quint64 widths[SectionCount] = {4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 2};
+
+    for (int s = 0; s < SectionCount; ++s)
+        if (header->offsets[s] % 8 || header->offsets[s] + lengths[s] * widths[s] > quint64(size))
+            return fail(fileName + " is truncated");
+
+    const auto section = [&]<typename T>(Section s, std::span<const T> *span) {
+        *span = {reinterpret_cast<const T *>(data + header->offsets[s]), size_t(lengths[s])};
+    };
+    section(Ids, &mIds);
+    section(Types, &mTypes);
+    section(Versions, &mVersions);
+    section(NodeTypes, &mNodeTypes);
+    section(Names, &mNames);
+    section(Labels, &mLabels);
+    section(ValueTypes, &mValueTypes);
+    section(Values, &mValues);
+    section(ChildOffsets, &mChildOffsets);
+    section(Children, &mChildren);
+    section(StringOffsets, &mStringOffsets);
+    section(Strings, &mStrings);
+
+    if (mChildOffsets.back() != header->links || mStringOffsets.back() != header->characters)
+        return fail(fileName + " is corrupt");
+
+    mHeader = header;
+    return true;
+}
+
+void Snapshot::close()
+{
+    if (mHeader)
+        mFile.unmap(const_cast<uchar *>(reinterpret_cast<const uchar *>(mHeader)));
+    mFile.close();
+
+    mHeader = nullptr;
+    mIds = {};
+    mTypes = {};
+    mVersions = {};
+    mNodeTypes = {};
+    mNames = {};
+    mLabels = {};
+    mValueTypes = {};
+    mValues = {};
+    mChildOffsets = {};
+    mChildren = {};
+    mStringOffsets = {};
+    mStrings = {};
+}
+
+int Snapshot::count() const
+{
+    return int(mIds.size());
+}
+
+int Snapshot::indexOf(int rowid) const
+{
+    const auto it = std::lower_bound(mIds.begin(), mIds.end(), rowid);
+    return it != mIds.end() && *it == rowid ? int(it - mIds.begin()) : -1;
+}
+
+std::span<const qint32> Snapshot::children(int rowid) const
+{
+    const int index = indexOf(rowid);
+    if (index < 0)
+        return {};
+
+    // open() only checks the ends, a damaged offset gives no children instead of a crash
+    const quint32 begin = mChildOffsets[index];
+    const quint32 end = mChildOffsets[index + 1];
+    if (begin > end || end > mChildren.size())
+        return {};
+    return mChildren.subspan(begin, end - begin);
+}
+
+QStringView Snapshot::string(quint32 index) const
+{
+    if (index == None || index + 1 >= mStringOffsets.size())
+        return {};
+
+    const quint32 begin = mStringOffsets[index];
+    const quint32 end = mStringOffsets[index + 1];
+    if (begin > end || end > mStrings.size())
+        return {};
+    return QStringView{mStrings.data() + begin, qsizetype(end - begin)};
+}
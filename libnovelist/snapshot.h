@@ -0,0 +1,156 @@
+#ifndef LIBNOVELIST_SNAPSHOT_H
+#define LIBNOVELIST_SNAPSHOT_H
+
+#include <QFile>
+#include <QIODevice>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QStringView>
+#include <qqmlintegration.h>
+
+#include <span>
+
+#include "errorhandler.h"
+
+// A read-only copy of a project in one file that is mapped instead of read, for reading and
+// review sessions on projects too big to load.
+//
+// The file is a Header followed by sections of fixed-size columns, one entry per Storable row in
+// rowid order: the rowid, the Storable type and version, the node type, name and label, and the
+// value type and value of Value rows. The links of Element_fields and Field_values are one array
+// of children, indexed by an array of offsets per row. Text is kept once in a string table of
+// UTF-16 so that name(), label() and value() point into the mapping.
+//
+// open() maps the file and checks the header and the bounds of the sections, the time it takes
+// doesn't depend on the size of the project. Nothing is parsed: a lookup is a binary search on the
+// rowids and reads from the columns. The file is written in the byte order of the machine, which
+// the header records; a snapshot from a machine of the other order doesn't open.
+//
+// QML reads it through Storage.snapshot while the storage is read-only, with copies of the text.
+class Snapshot : public QObject, public ErrorHandler
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Snapshot is opened by Storage")
+
+public:
+    static constexpr quint32 Magic = 0x53535654; // NVSS
+    static constexpr quint16 FormatVersion = 1;
+    static constexpr quint32 None = 0xffffffff;
+
+    explicit Snapshot(QObject* parent = nullptr)
+        : QObject{parent}
+    {}
+    ~Snapshot() override { close(); }
+
+    // Writes the project in database to device.
+    bool write(const QSqlDatabase& database, QIODevice* device);
+
+    bool open(const QString& fileName);
+    void close();
+    [[nodiscard]] bool isOpen() const { return mHeader != nullptr; }
+    [[nodiscard]] QString fileName() const { return mFile.fileName(); }
+
+    // The number of Storable rows, and all of them by index.
+    [[nodiscard]] Q_INVOKABLE int count() const;
+    [[nodiscard]] std::span<const qint32> rowids() const { return mIds; }
+    // The index of rowid in the columns, -1 if the snapshot doesn't hold it.
+    [[nodiscard]] Q_INVOKABLE int indexOf(int rowid) const;
+    [[nodiscard]] Q_INVOKABLE bool contains(int rowid) const { return indexOf(rowid) >= 0; }
+
+    // The Storable type and version of rowid, Storable::Type_Unknown and 0 if there is none.
+    [[nodiscard]] Q_INVOKABLE int type(int rowid) const { return column(mTypes, rowid); }
+    [[nodiscard]] Q_INVOKABLE int version(int rowid) const { return column(mVersions, rowid); }
+
+    // The Node columns, 0 and empty for rows without one.
+    [[nodiscard]] Q_INVOKABLE int nodeType(int rowid) const { return column(mNodeTypes, rowid); }
+    [[nodiscard]] QStringView name(int rowid) const
+    {
+        return string(column(mNames, rowid, None));
+    }
+    [[nodiscard]] QStringView label(int rowid) const
+    {
+        return string(column(mLabels, rowid, None));
+    }
+
+    // The Value columns: the Value::Type and the stored text, Type_Unknown and null for the rows
+    // of other tables.
+    [[nodiscard]] Q_INVOKABLE int valueType(int rowid) const
+    {
+        return column(mValueTypes, rowid);
+    }
+    [[nodiscard]] QStringView value(int rowid) const
+    {
+        return string(column(mValues, rowid, None));
+    }
+
+    // The fields of an element and the values of a field, in order.
+    [[nodiscard]] std::span<const qint32> children(int rowid) const;
+    [[nodiscard]] std::span<const qint32> fields(int element) const { return children(element); }
+    [[nodiscard]] std::span<const qint32> values(int field) const { return children(field); }
+
+    // The same for QML, which can't hold a view into the mapping.
+    [[nodiscard]] Q_INVOKABLE QString nameOf(int rowid) const { return name(rowid).toString(); }
+    [[nodiscard]] Q_INVOKABLE QString labelOf(int rowid) const { return label(rowid).toString(); }
+    [[nodiscard]] Q_INVOKABLE QString valueOf(int rowid) const { return value(rowid).toString(); }
+    [[nodiscard]] Q_INVOKABLE QList<int> childrenOf(int rowid) const
+    {
+        const auto ids = children(rowid);
+        return {ids.begin(), ids.end()};
+    }
+
+private:
+    enum Section {
+        Ids,
+        Types,
+        Versions,
+        NodeTypes,
+        Names,
+        Labels,
+        ValueTypes,
+        Values,
+        ChildOffsets,
+        Children,
+        StringOffsets,
+        Strings,
+        SectionCount
+    };
+
+    struct Header
+    {
+        quint32 magic;
+        quint16 version;
+        quint16 byteOrder;
+        quint32 rows;
+        quint32 links;
+        quint32 strings;
+        quint32 characters;
+        quint64 size;
+        quint64 offsets[SectionCount];
+    };
+
+    template<typename T>
+    [[nodiscard]] T column(std::span<const T> column, int rowid, T none = {}) const
+    {
+        const int index = indexOf(rowid);
+        return index < 0 ? none : column[index];
+    }
+    [[nodiscard]] QStringView string(quint32 index) const;
+
+    QFile mFile;
+    const Header* mHeader = nullptr;
+    std::span<const qint32> mIds;
+    std::span<const qint32> mTypes;
+    std::span<const qint32> mVersions;
+    std::span<const qint32> mNodeTypes;
+    std::span<const quint32> mNames;
+    std::span<const quint32> mLabels;
+    std::span<const qint32> mValueTypes;
+    std::span<const quint32> mValues;
+    std::span<const quint32> mChildOffsets;
+    std::span<const qint32> mChildren;
+    std::span<const quint32> mStringOffsets;
+    std::span<const char16_t> mStrings;
+};
+
+#endif // LIBNOVELIST_SNAPSHOT_H
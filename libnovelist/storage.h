@@ -1,14 +1,29 @@
 #ifndef LIBNOVELIST_STORAGE_H
 #define LIBNOVELIST_STORAGE_H
 
+#include <QElapsedTimer>
+#include <QFile>
 #include <QObject>
-
+#include <QSaveFile>
+#include <QSet>
+
+#include "aggregates.h"
+#include "backupservice.h"
+#include "changelog.h"
+#include "computedfields.h"
+#include "elementquery.h"
 #include "elementstorage.h"
 #include "elementtypestorage.h"
 #include "fieldstorage.h"
 #include "fieldtypestorage.h"
+#include "logging.h"
 #include "projectstorage.h"
+#include "projectstream.h"
 #include "projecttypestorage.h"
+#include "schemamigrator.h"
+#include "snapshot.h"
+#include "stringpool.h"
+#include "textcodec.h"
 #include "valuestorage.h"
 #include "valuetypestorage.h"
 
@@ -30,11 +45,16 @@ public:
         , mValueTypeStorage{new ValueTypeStorage{this}}
         , mProjectStorage{new ProjectStorage{this}}
         , mProjectTypeStorage{new ProjectTypeStorage{this}}
+        , mBackupService{new BackupService{this}}
+        , mComputedFields{new ComputedFields{this}}
+        , mSnapshot{new Snapshot{this}}
     {}
     [[nodiscard]] QSqlDatabase database() const { return mDatabase; }
     void setDatabase(const QSqlDatabase& database)
     {
         mDatabase = database;
+        mSchemaVersion = mDatabase.isOpen() ? SchemaMigrator::userVersion(mDatabase) : 0;
+        mPrepareStats = {};
 
         mNodeStorage->setDatabase(mDatabase);
         mNodeTypeStorage->setDatabase(mDatabase);
@@ -46,6 +66,13 @@ public:
         mValueTypeStorage->setDatabase(mDatabase);
         mProjectStorage->setDatabase(mDatabase);
         mProjectTypeStorage->setDatabase(mDatabase);
+        mAggregates.setDatabase(mDatabase);
+
+        // after the storages, the triggers need their tables
+        if (mDatabase.isOpen() && mSchemaVersion != SchemaMigrator::CurrentVersion) {
+            ChangeLog{mDatabase}.createSchema();
+            mAggregates.createSchema();
+        }
 
         emit databaseChanged(QPrivateSignal{});
     }
@@ -75,6 +102,8 @@ public:
 
     bool openDatabase(const QString& databaseName = {})
     {
+        closeSnapshot();
+
         bool databaseNameHasChanged = false;
         if (!databaseName.isEmpty() && mDatabaseName != databaseName) {
             databaseNameHasChanged = true;
@@ -87,16 +116,58 @@ public:
         if (QSqlDatabase::contains(mDatabaseConnectionName))
             QSqlDatabase::removeDatabase(mDatabaseConnectionName);
 
+        QElapsedTimer timer;
+        timer.start();
+
         mDatabase = QSqlDatabase::addDatabase("QSQLITE", mDatabaseConnectionName);
         mDatabase.setDatabaseName(mDatabaseName);
         if (!mDatabase.open())
             return false;
+        const qint64 opened = timer.nsecsElapsed();
 
         // QSqlQuery pragma{mDatabase};
         // pragma.exec("PRAGMA foreign_keys = ON");
 
+        // an older schema is moved aside before the storages create theirs
+        SchemaMigrator migrator{mDatabase};
+        if (!migrator.prepare()) {
+            mDatabase.close();
+            return false;
+        }
+        // a file of version 1 reads as 0 too, like a new one, but has tables to migrate
+        const bool migrating = migrator.isMigrating();
+
         setDatabase(mDatabase);
 
+        if (!migrator.finish()) {
+            mDatabase.close();
+            return false;
+        }
+        // the rows of an older schema have no totals yet, and maybe no chunks
+        if (migrating) {
+            mValueStorage->migrateText();
+            rebuildAggregates();
+        }
+        const qint64 schemaReady = timer.nsecsElapsed();
+
+        loadTypes();
+        const qint64 loaded = timer.nsecsElapsed();
+
+        const auto ms = [](qint64 nsecs) { return QString::number(nsecs / 1e6, 'f', 2); };
+        qCDebug(projectStorage).noquote()
+            << QStringLiteral("startup: open %1 ms, schema %2 ms (%3), prepare %4 ms (%5 of %6 "
+                              "statements), first query %7 ms")
+                   .arg(ms(opened),
+                        ms(schemaReady - opened),
+                        mSchemaVersion == SchemaMigrator::CurrentVersion ? QStringLiteral("current")
+                                                                        : QStringLiteral("created"),
+                        ms(mPrepareStats.nsecs))
+                   .arg(mPrepareStats.prepared)
+                   .arg(mPrepareStats.statements)
+                   .arg(ms(loaded - schemaReady));
+
+        mBackupService->setDatabaseName(mDatabaseName);
+
         if (databaseNameHasChanged)
             emit databaseNameChanged(QPrivateSignal{});
 
@@ -107,6 +178,15 @@ public:
         if (!mDatabase.isValid())
             return;
         if (mDatabase.isOpen()) {
+            qCDebug(projectStorage).noquote() << "string pool:" << mStringPool.report();
+            qCDebug(projectStorage).noquote()
+                << QStringLiteral("statements: %1 of %2 prepared in %3 ms")
+                       .arg(mPrepareStats.prepared)
+                       .arg(mPrepareStats.statements)
+                       .arg(mPrepareStats.nsecs / 1e6, 0, 'f', 2);
+            mStringPool.clear();
+            mAggregates.setDatabase({});
+
             const auto name = mDatabase.connectionName();
             mDatabase.close();
             QSqlDatabase::removeDatabase(name);
@@ -115,6 +195,169 @@ public:
         }
     }
 
+    // Types are few and read constantly, so they are all loaded up front with one query per
+    // table and then resolved through the catalogs of the type storages, without queries.
+    bool loadTypes()
+    {
+        if (!mValueTypeStorage->loadTypes() || !mFieldTypeStorage->loadTypes()
+            || !mElementTypeStorage->loadTypes() || !mProjectTypeStorage->loadTypes())
+            return false;
+
+        if (!mFieldTypeStorage->loadValueTypes() || !mFieldTypeStorage->loadAllowedTypes()
+            || !mElementTypeStorage->loadFieldTypes())
+            return false;
+
+        mValueTypeStorage->rebuildCatalog();
+        mFieldTypeStorage->rebuildCatalog();
+        mElementTypeStorage->rebuildCatalog();
+        mProjectTypeStorage->rebuildCatalog();
+
+        // linking marks the other end of each relation as modified, yet it is as stored
+        for (const BaseTypeStorage* s : QList<BaseTypeStorage*>{mValueTypeStorage,
+                                                                mFieldTypeStorage,
+                                                                mElementTypeStorage,
+                                                                mProjectTypeStorage})
+            for (NodeType* nodeType : s->catalog()->nodeTypes())
+                if (nodeType->rowid() > 0)
+                    nodeType->setModified(false);
+
+        return true;
+    }
+
+    // Closes the database, copies fileName over it on the backup thread and opens it again, then
+    // reloads the loaded nodes from it and recycles those it doesn't have.
+    Q_INVOKABLE bool restoreBackup(const QString& fileName)
+    {
+        if (mDatabaseName.isEmpty() || mBackupService->isRunning())
+            return false;
+
+        closeDatabase();
+
+        connect(
+            mBackupService,
+            &BackupService::restored,
+            this,
+            [this](bool ok) {
+                if (openDatabase() && ok)
+                    reloadLoadedNodes();
+            },
+            Qt::SingleShotConnection);
+
+        if (!mBackupService->restore(fileName)) {
+            disconnect(mBackupService, &BackupService::restored, this, nullptr);
+            openDatabase();
+            return false;
+        }
+        return true;
+    }
+
+    // The change version of the file, what exportChanges() takes to resume from it later.
+    [[nodiscard]] Q_INVOKABLE qint64 changeVersion() { return ChangeLog{mDatabase}.version(); }
+    // The rows changed after version since, for applyChanges() on another replica.
+    [[nodiscard]] Q_INVOKABLE QByteArray exportChanges(qint64 since)
+    {
+        return ChangeLog{mDatabase}.changes(since);
+    }
+    // Writes a changeset from exportChanges() in one transaction, then reloads the loaded nodes
+    // it touched. resolution is a ChangeLog::Resolution.
+    Q_INVOKABLE bool applyChanges(const QByteArray& changeset,
+                                  int resolution = ChangeLog::KeepNewer)
+    {
+        Transaction tx{Transaction::Write, nullptr, this};
+        const ChangeLog::Result result
+            = ChangeLog{mDatabase}.apply(changeset, ChangeLog::Resolution(resolution));
+        if (!result.ok)
+            return false;
+        // the changed rows come without their totals
+        if (result.applied > 0 && !mAggregates.rebuild())
+            return false;
+        if (!tx.commit())
+            return false;
+
+        if (result.typesChanged)
+            loadTypes();
+        for (const int id : result.changed)
+            if (Node* node = loadedNode(id))
+                node->reload();
+        for (const int id : result.removed)
+            if (Node* node = loadedNode(id))
+                node->recycle();
+
+        emit changesApplied(result.applied, result.conflicts, QPrivateSignal{});
+        return true;
+    }
+
+    // Writes the whole project to fileName as NDJSON, see ProjectStream. The file is replaced once
+    // the export is complete.
+    Q_INVOKABLE bool exportProject(const QString& fileName)
+    {
+        QSaveFile file{fileName};
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        const ProjectStream::Result result = ProjectStream{this}.write(&file);
+        if (!result.ok || !file.commit())
+            return false;
+        return true;
+    }
+    // Reads an export from exportProject() into the open database, over the rows with the same
+    // ids, then reloads the types and recomputes the totals.
+    Q_INVOKABLE bool importProject(const QString& fileName)
+    {
+        QFile file{fileName};
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        const ProjectStream::Result result = ProjectStream{this}.read(&file);
+        if (!result.ok)
+            return false;
+
+        loadTypes();
+        return rebuildAggregates();
+    }
+
+    // Writes the project to fileName as a Snapshot, for openSnapshot().
+    Q_INVOKABLE bool writeSnapshot(const QString& fileName)
+    {
+        QSaveFile file{fileName};
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        return mSnapshot->write(mDatabase, &file) && file.commit();
+    }
+    // Closes the database and maps a snapshot from writeSnapshot() instead. The storage is
+    // read-only until openDatabase(): the storages neither load, create, save nor remove nodes,
+    // the project is read through snapshot(), in QML too.
+    Q_INVOKABLE bool openSnapshot(const QString& fileName)
+    {
+        closeDatabase();
+        closeSnapshot();
+
+        if (!mSnapshot->open(fileName))
+            return false;
+
+        emit readOnlyChanged(QPrivateSignal{});
+        return true;
+    }
+    void closeSnapshot()
+    {
+        if (!mSnapshot->isOpen())
+            return;
+        mSnapshot->close();
+        emit readOnlyChanged(QPrivateSignal{});
+    }
+    [[nodiscard]] bool isReadOnly() const { return mSnapshot->isOpen(); }
+    [[nodiscard]] Snapshot* snapshot() const { return mSnapshot; }
+
+    // Recomputes the totals of every node, for a table that can't be trusted.
+    Q_INVOKABLE bool rebuildAggregates()
+    {
+        Transaction tx{Transaction::Write, nullptr, this};
+        if (!mAggregates.rebuild())
+            return false;
+        return tx.commit();
+    }
+
     [[nodiscard]] Node* node() { return mNodeStorage->node(); }
     [[nodiscard]] Node* node(int rowid) { return mNodeStorage->node(rowid); }
 
@@ -142,6 +385,74 @@ public:
     [[nodiscard]] ValueType* valueType() { return mValueTypeStorage->valueType(); }
     [[nodiscard]] ValueType* valueType(int rowid) { return mValueTypeStorage->valueType(rowid); }
 
+    [[nodiscard]] Q_INVOKABLE QList<Element*> createElements(ElementType* elementType, int count)
+    {
+        return mElementStorage->createElements(elementType, count);
+    }
+    Q_INVOKABLE bool removeSubtree(int rowid)
+    {
+        return mElementStorage->removeSubtree(rowid);
+    }
+    Q_INVOKABLE int cloneSubtree(int rowid) { return mElementStorage->cloneSubtree(rowid); }
+
+    // The rowids of the elements query matches, in its order, without loading any.
+    [[nodiscard]] QList<int> findElements(ElementQuery& query) { return query.rowids(mDatabase); }
+    [[nodiscard]] int countElements(ElementQuery& query) { return query.count(mDatabase); }
+    // Loads only the elements query matches.
+    [[nodiscard]] QList<Element*> loadElements(ElementQuery& query)
+    {
+        QList<Element*> elements;
+        for (const int rowid : findElements(query))
+            if (Element* e = mElementStorage->element(rowid))
+                elements.append(e);
+        return elements;
+    }
+
+    // Brings the loaded nodes in step with a file that changed under them, as applyChanges() does
+    // for the rows it touched: those still in the file are reloaded, the others recycled.
+    void reloadLoadedNodes()
+    {
+        QStringList ids;
+        for (const BaseStorage* s : QList<BaseStorage*>{mNodeStorage,
+                                                        mElementStorage,
+                                                        mFieldStorage,
+                                                        mValueStorage,
+                                                        mProjectStorage})
+            for (const int id : s->loadedRowids())
+                ids.append(QString::number(id));
+        if (ids.isEmpty())
+            return;
+
+        QSet<int> kept;
+        QSqlQuery query{mDatabase};
+        query.setForwardOnly(true);
+        if (!query.exec(QStringLiteral("SELECT `id` FROM `Storable` WHERE `id` IN (%1)")
+                            .arg(ids.join(',')))) {
+            ErrorHandler{}.handleError(this, "reloadLoadedNodes", query);
+            return;
+        }
+        while (query.next())
+            kept.insert(query.value(0).toInt());
+
+        // recycling a node can take others with it, so each is looked up again
+        for (const QString& id : std::as_const(ids))
+            if (Node* node = loadedNode(id.toInt()))
+                kept.contains(id.toInt()) ? node->reload() : node->recycle();
+    }
+
+    // The loaded node with rowid from whichever storage holds it, nullptr if none does.
+    [[nodiscard]] Node* loadedNode(int rowid) const
+    {
+        for (const BaseStorage* s : QList<BaseStorage*>{mNodeStorage,
+                                                        mElementStorage,
+                                                        mFieldStorage,
+                                                        mValueStorage,
+                                                        mProjectStorage})
+            if (Node* node = s->loadedNode(rowid))
+                return node;
+        return nullptr;
+    }
+
     [[nodiscard]] NodeStorage* nodeStorage() const { return mNodeStorage; }
     [[nodiscard]] NodeTypeStorage* nodeTypeStorage() const { return mNodeTypeStorage; }
     [[nodiscard]] ElementStorage* elementStorage() const { return mElementStorage; }
@@ -152,14 +463,32 @@ public:
     [[nodiscard]] ValueTypeStorage* valueTypeStorage() const { return mValueTypeStorage; }
     [[nodiscard]] ProjectStorage* projectStorage() const { return mProjectStorage; }
     [[nodiscard]] ProjectTypeStorage* projectTypeStorage() const { return mProjectTypeStorage; }
+    [[nodiscard]] BackupService* backupService() const { return mBackupService; }
+    [[nodiscard]] Aggregates& aggregates() { return mAggregates; }
+    [[nodiscard]] ComputedFields* computedFields() const { return mComputedFields; }
 
     [[nodiscard]] int& transactionDepth() { return mTransactionDepth; }
+    // Set when a nested scope of the open transaction could not be opened or closed.
+    [[nodiscard]] bool& transactionFailed() { return mTransactionFailed; }
+
+    // The schema version the file carried when the storages were given the database.
+    [[nodiscard]] int schemaVersion() const { return mSchemaVersion; }
+    [[nodiscard]] PrepareStats& prepareStats() { return mPrepareStats; }
+
+    // Shared by the storages for the names, labels, icons and users of the nodes they load.
+    [[nodiscard]] StringPool& stringPool() { return mStringPool; }
+    [[nodiscard]] Q_INVOKABLE QString stringPoolReport() const { return mStringPool.report(); }
+    // The chunks of long text packed and unpacked so far, see TextCodec.
+    [[nodiscard]] Q_INVOKABLE QString textCodecReport() const { return TextCodec::report(); }
 
 signals:
     void databaseChanged(QPrivateSignal);
     void databaseNameChanged(QPrivateSignal);
     void databaseConnectionNameChanged(QPrivateSignal);
 
+    void changesApplied(int applied, int conflicts, QPrivateSignal);
+    void readOnlyChanged(QPrivateSignal);
+
 private:
     QSqlDatabase mDatabase;
     QString mDatabaseName;
@@ -175,8 +504,18 @@ private:
     ValueTypeStorage* mValueTypeStorage = nullptr;
     ProjectStorage* mProjectStorage = nullptr;
     ProjectTypeStorage* mProjectTypeStorage = nullptr;
+    BackupService* mBackupService = nullptr;
+    ComputedFields* mComputedFields = nullptr;
+    Snapshot* mSnapshot = nullptr;
+
+    StringPool mStringPool;
+    PrepareStats mPrepareStats;
+    Aggregates mAggregates{this};
+
+    int mSchemaVersion = 0;
 
-    int mTransactionDepth = -1;
+    int mTransactionDepth = 0;
+    bool mTransactionFailed = false;
 
     Q_PROPERTY(ElementStorage* elementStorage READ elementStorage CONSTANT FINAL)
     Q_PROPERTY(ElementTypeStorage* elementTypeStorage READ elementTypeStorage CONSTANT FINAL)
@@ -186,6 +525,9 @@ private:
     Q_PROPERTY(ValueTypeStorage* valueTypeStorage READ valueTypeStorage CONSTANT FINAL)
     Q_PROPERTY(ProjectStorage* projectStorage READ projectStorage CONSTANT FINAL)
     Q_PROPERTY(ProjectTypeStorage* projectTypeStorage READ projectTypeStorage CONSTANT FINAL)
+    Q_PROPERTY(BackupService* backupService READ backupService CONSTANT FINAL)
+    Q_PROPERTY(Snapshot* snapshot READ snapshot CONSTANT FINAL)
+    Q_PROPERTY(bool readOnly READ isReadOnly NOTIFY readOnlyChanged FINAL)
     Q_PROPERTY(QString databaseName READ databaseName WRITE setDatabaseName NOTIFY
                    databaseNameChanged FINAL)
     Q_PROPERTY(QString databaseConnectionName READ databaseConnectionName WRITE
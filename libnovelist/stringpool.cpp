@@ -0,0 +1,11 @@
+#include "stringpool.h"
+
+#include <QLocale>
+
+QString StringPool::report() const
+{
+    return QStringLiteral("%1 pooled strings, %2 copies shared, %3 saved")
+        .arg(mStrings.size())
+        .arg(mHits)
+        .arg(QLocale::c().formattedDataSize(mSavedBytes));
+}
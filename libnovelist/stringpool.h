@@ -0,0 +1,65 @@
+#ifndef LIBNOVELIST_STRINGPOOL_H
+#define LIBNOVELIST_STRINGPOOL_H
+
+#include <QSet>
+#include <QString>
+
+// Hands out one shared QString per distinct value of the low-cardinality columns (names, labels,
+// icons, users), so tens of thousands of loaded nodes don't each own a copy of "Title".
+//
+// Long strings are unlikely to repeat and are returned as is, and the pool stops growing at
+// maxSize so a column that turns out to be unique can't make it hold everything.
+class StringPool
+{
+public:
+    explicit StringPool(qsizetype maxSize = 1 << 16, qsizetype maxLength = 256)
+        : mMaxSize{maxSize}
+        , mMaxLength{maxLength}
+    {}
+
+    [[nodiscard]] QString intern(const QString& string)
+    {
+        if (string.isEmpty() || string.size() > mMaxLength)
+            return string;
+
+        if (const auto it = mStrings.constFind(string); it != mStrings.constEnd()) {
+            if (!it->isSharedWith(string)) {
+                ++mHits;
+                mSavedBytes += allocationSize(string);
+            }
+            return *it;
+        }
+
+        if (mStrings.size() < mMaxSize)
+            mStrings.insert(string);
+        return string;
+    }
+
+    void clear()
+    {
+        mStrings.clear();
+        mHits = 0;
+        mSavedBytes = 0;
+    }
+
+    [[nodiscard]] qsizetype size() const { return mStrings.size(); }
+    // Strings that were replaced by a pooled instance, and the heap they would have used.
+    [[nodiscard]] qsizetype hits() const { return mHits; }
+    [[nodiscard]] qint64 savedBytes() const { return mSavedBytes; }
+
+    [[nodiscard]] QString report() const;
+
+private:
+    static qint64 allocationSize(const QString& string)
+    {
+        return qint64(sizeof(QArrayData)) + (string.size() + 1) * qint64(sizeof(char16_t));
+    }
+
+    QSet<QString> mStrings;
+    qsizetype mMaxSize = 0;
+    qsizetype mMaxLength = 0;
+    qsizetype mHits = 0;
+    qint64 mSavedBytes = 0;
+};
+
+#endif // LIBNOVELIST_STRINGPOOL_H
@@ -0,0 +1,94 @@
+#include "textcodec.h"
+
+#include <QElapsedTimer>
+#include <QLocale>
+
+#include <atomic>
+
+namespace {
+
+// the workers of ChunkCompressor pack next to the thread that reads
+struct Stats
+{
+    std::atomic<qint64> packed = 0;
+    std::atomic<qint64> plainBytes = 0;
+    std::atomic<qint64> packedBytes = 0;
+    std::atomic<qint64> packNsecs = 0;
+    std::atomic<qint64> unpacked = 0;
+    std::atomic<qint64> unpackNsecs = 0;
+};
+
+Stats stats;
+
+} // namespace
+
+QByteArray TextCodec::pack(const QString &text)
+{
+    if (text.size() < Threshold)
+        return {};
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QByteArray utf8 = text.toUtf8();
+    QByteArray packed = qCompress(utf8, Level);
+    packed.prepend(char(Current));
+
+    stats.packNsecs += timer.nsecsElapsed();
+
+    if (packed.size() >= utf8.size())
+        return {};
+
+    ++stats.packed;
+    stats.plainBytes += utf8.size();
+    stats.packedBytes += packed.size();
+    return packed;
+}
+
+QString TextCodec::unpack(const QByteArray &packed)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QString text;
+    switch (codec(packed)) {
+    case Codec_Plain:
+        return {};
+    case Codec_Zlib: {
+        const QByteArray utf8 = qUncompress(packed.mid(1));
+        if (utf8.isEmpty())
+            return {};
+        text = QString::fromUtf8(utf8);
+        break;
+    }
+    default:
+        return {};
+    }
+
+    ++stats.unpacked;
+    stats.unpackNsecs += timer.nsecsElapsed();
+    return text;
+}
+
+QString TextCodec::report()
+{
+    const qint64 plain = stats.plainBytes;
+    const qint64 packed = stats.packedBytes;
+    return QStringLiteral("%1 chunks packed, %2 to %3 (%4%) in %5 ms, %6 unpacked in %7 ms")
+        .arg(stats.packed.load())
+        .arg(QLocale::c().formattedDataSize(plain), QLocale::c().formattedDataSize(packed))
+        .arg(plain > 0 ? 100.0 * packed / plain : 100.0, 0, 'f', 1)
+        .arg(stats.packNsecs / 1e6, 0, 'f', 2)
+        .arg(stats.unpacked.load())
+        .arg(stats.unpackNsecs / 1e6, 0, 'f', 2);
+}
+
+void TextCodec::clearStats()
+{
+    stats.packed = 0;
+    stats.plainBytes = 0;
+    stats.packedBytes = 0;
+    stats.packNsecs = 0;
+    stats.unpacked = 0;
+    stats.unpackNsecs = 0;
+}
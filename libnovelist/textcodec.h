@@ -0,0 +1,38 @@
+#ifndef LIBNOVELIST_TEXTCODEC_H
+#define LIBNOVELIST_TEXTCODEC_H
+
+#include <QByteArray>
+#include <QString>
+
+// Packs the chunks of long text (see Prose) for the `packed` column of ValueChunk.
+//
+// A packed chunk is a codec tag byte followed by the compressed UTF-8 of the text. Chunks shorter
+// than Threshold, and those that don't get smaller, stay plain: pack() returns an empty array for
+// them and the text goes in the `text` column. unpack() reads every codec it knows, so a project
+// written with an older one keeps opening; ChunkCompressor packs such chunks again.
+//
+// The time spent and the bytes saved are counted for the whole process, report() sums them up.
+class TextCodec
+{
+public:
+    enum Codec : quint8 { Codec_Plain = 0, Codec_Zlib = 1 };
+
+    // The codec pack() writes.
+    static constexpr Codec Current = Codec_Zlib;
+    static constexpr qsizetype Threshold = 256;
+    // zlib's default, most of the ratio of 9 at a third of the time.
+    static constexpr int Level = 6;
+
+    [[nodiscard]] static QByteArray pack(const QString& text);
+    // The text of a packed chunk, a null string if it is damaged or of an unknown codec.
+    [[nodiscard]] static QString unpack(const QByteArray& packed);
+    [[nodiscard]] static Codec codec(const QByteArray& packed)
+    {
+        return packed.isEmpty() ? Codec_Plain : Codec(quint8(packed.front()));
+    }
+
+    [[nodiscard]] static QString report();
+    static void clearStats();
+};
+
+#endif // LIBNOVELIST_TEXTCODEC_H
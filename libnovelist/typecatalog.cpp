@@ -0,0 +1,108 @@
+#include "typecatalog.h"
+#include "nodetype.h"
+
+#include <QSet>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+constexpr size_t BucketSeed = 0x9e3779b9;
+constexpr quint32 MaxDisplacement = 1 << 16;
+
+} // namespace
+
+TypeCatalog::TypeCatalog(const QList<NodeType *> &nodeTypes)
+{
+    mNodeTypes.reserve(nodeTypes.size());
+    mNames.reserve(nodeTypes.size());
+
+    for (NodeType *nodeType : nodeTypes) {
+        if (!nodeType)
+            continue;
+        const int id = int(mNodeTypes.size());
+        mNodeTypes.append(nodeType);
+        mNames.append(nodeType->name());
+        if (nodeType->rowid() > 0)
+            mIdsByRowid.insert(nodeType->rowid(), id);
+    }
+
+    // a table of twice the number of names keeps the displacement search short
+    qsizetype tableSize = 1;
+    while (tableSize < 2 * mNames.size())
+        tableSize *= 2;
+    while (!build(tableSize))
+        tableSize *= 2;
+}
+
+int TypeCatalog::id(QStringView name) const
+{
+    if (mSlots.isEmpty())
+        return -1;
+
+    const auto bucket = qHash(name, BucketSeed) % size_t(mDisplacements.size());
+    const auto slot = qHash(name, mDisplacements[bucket]) & size_t(mSlots.size() - 1);
+    const int id = mSlots[slot];
+    return id >= 0 && mNames[id] == name ? id : -1;
+}
+
+bool TypeCatalog::build(qsizetype tableSize)
+{
+    const qsizetype bucketCount = mNames.size() / 4 + 1;
+    QList<QList<int>> buckets(bucketCount);
+
+    // the first type with a name wins, an unnamed type is only found by id
+    QSet<QStringView> seen;
+    for (int id = 0; id < mNames.size(); ++id) {
+        const QStringView name = mNames[id];
+        if (name.isEmpty() || seen.contains(name))
+            continue;
+        seen.insert(name);
+        buckets[qHash(name, BucketSeed) % size_t(bucketCount)].append(id);
+    }
+
+    // the largest buckets are placed first, while the table is still empty
+    QList<int> order(bucketCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](int a, int b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    mSlots.fill(-1, tableSize);
+    mDisplacements.fill(0, bucketCount);
+    const size_t mask = size_t(tableSize - 1);
+
+    QVarLengthArray<size_t, 8> placed;
+    for (const int b : std::as_const(order)) {
+        const auto &bucket = buckets[b];
+        if (bucket.isEmpty())
+            break;
+
+        quint32 displacement = 0;
+        for (; displacement < MaxDisplacement; ++displacement) {
+            placed.clear();
+            bool free = true;
+            for (const int id : bucket) {
+                const size_t slot = qHash(QStringView{mNames[id]}, displacement) & mask;
+                if (mSlots[slot] >= 0 || placed.contains(slot)) {
+                    free = false;
+                    break;
+                }
+                placed.append(slot);
+            }
+            if (free)
+                break;
+        }
+
+        if (displacement == MaxDisplacement)
+            return false;
+
+        mDisplacements[b] = displacement;
+        for (qsizetype i = 0; i < bucket.size(); ++i)
+            mSlots[placed[i]] = bucket[i];
+    }
+
+    return true;
+}
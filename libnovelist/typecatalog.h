@@ -0,0 +1,52 @@
+#ifndef LIBNOVELIST_TYPECATALOG_H
+#define LIBNOVELIST_TYPECATALOG_H
+
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+
+class NodeType;
+
+// An immutable snapshot of the types of a type storage. Types get dense ids in load order and
+// are found by name through a perfect hash (hash and displace), so a lookup costs two hashes
+// and one string compare, and never a query.
+//
+// The storage replaces its catalog whenever its types change; a snapshot that was handed out
+// stays valid and unchanged for as long as it is held.
+class TypeCatalog
+{
+public:
+    using Pointer = QSharedPointer<const TypeCatalog>;
+
+    TypeCatalog() = default;
+    explicit TypeCatalog(const QList<NodeType*>& nodeTypes);
+
+    [[nodiscard]] qsizetype size() const { return mNodeTypes.size(); }
+    [[nodiscard]] const QList<NodeType*>& nodeTypes() const { return mNodeTypes; }
+
+    [[nodiscard]] NodeType* nodeType(int id) const { return mNodeTypes.value(id); }
+    [[nodiscard]] NodeType* nodeType(QStringView name) const
+    {
+        return mNodeTypes.value(id(name));
+    }
+    [[nodiscard]] NodeType* nodeTypeByRowid(int rowid) const
+    {
+        return mNodeTypes.value(mIdsByRowid.value(rowid, -1));
+    }
+
+    // Returns the dense id of the type, or -1.
+    [[nodiscard]] int id(QStringView name) const;
+    [[nodiscard]] int id(int rowid) const { return mIdsByRowid.value(rowid, -1); }
+
+private:
+    bool build(qsizetype tableSize);
+
+    QList<NodeType*> mNodeTypes;
+    QList<QString> mNames;
+    QList<quint32> mDisplacements;
+    QList<int> mSlots;
+    QHash<int, int> mIdsByRowid;
+};
+
+#endif // LIBNOVELIST_TYPECATALOG_H
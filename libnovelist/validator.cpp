@@ -1,97 +1,40 @@
 #include "validator.h"
-#include "element.h"
-#include "field.h"
 
 namespace novelist {
 
-/*
-QJsonObject StringValidator::toSchema(bool *error) const
-{
-    auto schema = Field::typeSchema("string");
-
-    schema["minLength"] = minLength;
-    schema["maxLength"] = maxLength;
-
-    if (error)
-        *error = false;
-
-    return schema;
-}
+namespace {
 
-QJsonObject IntValidator::toSchema(bool *error) const
+template<typename T>
+QSharedPointer<const Validator> compile(const QJsonObject &json)
 {
-    auto schema = Field::typeSchema("int");
-
-    schema["min"] = min;
-    schema["max"] = max;
-
-    if (error)
-        *error = false;
-
-    return schema;
+    auto validator = QSharedPointer<T>::create();
+    if (!validator->setJson(json))
+        return {};
+    return validator;
 }
 
-QJsonObject DoubleValidator::toSchema(bool *error) const
-{
-    auto schema = Field::typeSchema("double");
+} // namespace
 
-    schema["min"] = min;
-    schema["max"] = max;
-
-    if (error)
-        *error = false;
-
-    return schema;
-}
-
-QJsonObject BoolValidator::toSchema(bool *error) const
+QSharedPointer<const Validator> Validator::fromJson(const QJsonObject &json)
 {
-    auto schema = Field::typeSchema("bool");
-
-    if (error)
-        *error = false;
-
-    return schema;
-}
-
-QJsonObject DateValidator::toSchema(bool *error) const
-{
-    auto schema = Field::typeSchema("date");
-
-    schema["min"] = min.toString();
-    schema["max"] = max.toString();
-
-    if (error)
-        *error = false;
-
-    return schema;
-}
-
-QJsonObject TimeValidator::toSchema(bool *error) const
-{
-    auto schema = Field::typeSchema("time");
-
-    schema["min"] = min.toString();
-    schema["max"] = max.toString();
-
-    if (error)
-        *error = false;
-
-    return schema;
-}
-
-QJsonObject DateTimeValidator::toSchema(bool *error) const
-{
-    auto schema = Field::typeSchema("datetime");
-
-    schema["min"] = min.toString();
-    schema["max"] = max.toString();
-
-    if (error)
-        *error = false;
-
-    return schema;
+    const QString type = json.value("type").toString();
+
+    if (type == "StringValidator")
+        return compile<StringValidator>(json);
+    if (type == "IntValidator")
+        return compile<IntValidator>(json);
+    if (type == "DoubleValidator")
+        return compile<DoubleValidator>(json);
+    if (type == "BoolValidator")
+        return compile<BoolValidator>(json);
+    if (type == "DateValidator")
+        return compile<DateValidator>(json);
+    if (type == "TimeValidator")
+        return compile<TimeValidator>(json);
+    if (type == "DateTimeValidator")
+        return compile<DateTimeValidator>(json);
+
+    return {};
 }
-*/
 
 } // namespace novelist
@@ -1,21 +1,32 @@
 #ifndef LIBNOVELIST_VALIDATOR_H
 #define LIBNOVELIST_VALIDATOR_H
 
+#include <QDateTime>
 #include <QJsonObject>
-#include <QObject>
-#include "field.h"
+#include <QLocale>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVariant>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
 
 namespace novelist {
 
-/*
-class Validator : public QObject
+// The checks a FieldType puts on the values of its fields, described by a JSON object with a
+// "type" of StringValidator, IntValidator, DoubleValidator, BoolValidator, DateValidator,
+// TimeValidator or DateTimeValidator and the limits of that type.
+//
+// A validator is compiled once from its JSON by fromJson() and not changed after, so one instance
+// is shared by every thread of a BatchValidator run; validate() and fixup() are const and keep no
+// state of their own.
+class Validator
 {
-    Q_OBJECT
-
 public:
-    Validator(QObject *parent = nullptr)
-        : QObject{parent}
-    {}
+    virtual ~Validator() = default;
+
+    [[nodiscard]] static QSharedPointer<const Validator> fromJson(const QJsonObject &json);
 
     QLocale locale() const { return mLocale; }
     void setLocale(const QLocale &locale)
@@ -25,14 +36,12 @@ public:
         mLocale = locale;
     }
 
-    virtual bool fixup(FieldRow &row, QStringList *messages = nullptr) const = 0;
-    virtual bool validate(FieldRow &row, QStringList *messages = nullptr) const = 0;
+    virtual bool fixup(QVariant &value, QStringList *messages = nullptr) const = 0;
+    virtual bool validate(QVariant &value, QStringList *messages = nullptr) const = 0;
 
     [[nodiscard]] virtual QJsonObject toJson(bool *error = nullptr) const = 0;
     virtual bool setJson(const QJsonObject &json) = 0;
 
-    [[nodiscard]] virtual QJsonObject toSchema(bool *error = nullptr) const = 0;
-
     [[nodiscard]] bool required() const { return mRequired; }
     void setRequired(bool required)
     {
@@ -41,6 +50,20 @@ public:
         mRequired = required;
     }
 
+protected:
+    void readCommon(const QJsonObject &json)
+    {
+        if (const auto v = json.value("locale"); v.isString())
+            setLocale(QLocale{v.toString()});
+        setRequired(json.value("required").toBool());
+    }
+    void writeCommon(QJsonObject &json) const
+    {
+        json["locale"] = locale().name();
+        if (required())
+            json["required"] = true;
+    }
+
 private:
     QLocale mLocale;
     bool mRequired = false;
@@ -49,18 +72,17 @@ private:
 class StringValidator : public Validator
 {
 public:
-    StringValidator(QObject *parent = nullptr)
-        : StringValidator{-1, -1, parent}
+    StringValidator()
+        : StringValidator{-1, -1}
     {}
-    StringValidator(int minLength, int maxLength, QObject *parent = nullptr)
-        : Validator{parent}
-        , minLength{minLength}
+    StringValidator(int minLength, int maxLength)
+        : minLength{minLength}
         , maxLength{maxLength}
     {}
 
-    bool fixup(FieldRow &row, QStringList *messages = nullptr) const override
+    bool fixup(QVariant &value, QStringList *messages = nullptr) const override
     {
-        auto string = row.value.toString();
+        auto string = value.toString();
 
         bool valid = true;
 
@@ -72,19 +94,18 @@ public:
         }
 
         if (maxLength >= 0 && string.size() > maxLength) {
-            string.resize(maxLength);
             if (messages)
                 messages->append("Too long: enforced maxLength");
             string.resize(maxLength);
         }
 
-        row.value = string;
+        value = string;
 
         return valid;
     }
-    bool validate(FieldRow &row, QStringList *messages = nullptr) const override
+    bool validate(QVariant &value, QStringList *messages = nullptr) const override
     {
-        auto string = row.value.toString().trimmed();
+        auto string = value.toString().trimmed();
 
         if (minLength >= 0 && string.size() < minLength) {
             if (messages)
@@ -105,7 +126,7 @@ public:
             return false;
         }
 
-        row.value = string;
+        value = string;
         return true;
     }
 
@@ -116,7 +137,7 @@ public:
         json["type"] = "StringValidator";
         json["minLength"] = minLength;
         json["maxLength"] = maxLength;
-        json["locale"] = locale().name();
+        writeCommon(json);
 
         if (error)
             *error = false;
@@ -138,14 +159,11 @@ public:
         else
             maxLength = -1;
 
-        if (const auto v = json.value("locale"); v.isString())
-            setLocale(QLocale{v.toString()});
+        readCommon(json);
 
         return true;
     }
 
-    [[nodiscard]] QJsonObject toSchema(bool *error = nullptr) const override;
-
     int minLength = -1;
     int maxLength = -1;
 };
@@ -153,53 +171,63 @@ public:
 class IntValidator : public Validator
 {
 public:
-    IntValidator(QObject *parent = nullptr)
-        : IntValidator{-1, -1, parent}
+    IntValidator()
+        : IntValidator{std::numeric_limits<int>::min(), std::numeric_limits<int>::max()}
     {}
-    IntValidator(int minLength, int maxLength, QObject *parent = nullptr)
-        : Validator{parent}
-        , min{minLength}
-        , max{maxLength}
+    IntValidator(int min, int max)
+        : min{min}
+        , max{max}
     {}
 
-    bool fixup(FieldRow &row, QStringList *messages = nullptr) const override
+    bool fixup(QVariant &value, QStringList *messages = nullptr) const override
     {
-        int value = row.value.toInt();
-        bool valid = true;
+        int number = value.toInt();
 
-        if (value < min) {
+        if (number < min) {
             if (messages)
                 messages->append("Enforced minimum");
-            value = min;
+            number = min;
         }
 
-        if (value > max) {
+        if (number > max) {
             if (messages)
                 messages->append("Enforced maximum");
-            value = max;
+            number = max;
         }
 
-        row.value = value;
+        value = number;
 
-        return valid;
+        return true;
     }
-    bool validate(FieldRow &row, QStringList *messages = nullptr) const override
+    bool validate(QVariant &value, QStringList *messages = nullptr) const override
     {
-        int value = row.value.toInt();
+        if (required() && !value.isValid()) {
+            if (messages)
+                messages->append(QStringLiteral("Required."));
+            return false;
+        }
 
-        if (value < min) {
+        bool ok = false;
+        const int number = value.toInt(&ok);
+        if (value.isValid() && !ok) {
+            if (messages)
+                messages->append(QStringLiteral("Not a whole number."));
+            return false;
+        }
+
+        if (number < min) {
             if (messages)
                 messages->append(QStringLiteral("Too low, minimum is %1.").arg(min));
             return false;
         }
 
-        if (value > max) {
+        if (number > max) {
             if (messages)
                 messages->append(QStringLiteral("Too high, maximum is %1.").arg(max));
             return false;
         }
 
-        row.value = value;
+        value = number;
         return true;
     }
 
@@ -210,7 +238,7 @@ public:
         json["type"] = "IntValidator";
         json["min"] = min;
         json["max"] = max;
-        json["locale"] = locale().name();
+        writeCommon(json);
 
         if (error)
             *error = false;
@@ -232,14 +260,11 @@ public:
         else
             max = std::numeric_limits<int>::max();
 
-        if (const auto v = json.value("locale"); v.isString())
-            setLocale(QLocale{v.toString()});
+        readCommon(json);
 
         return true;
     }
 
-    [[nodiscard]] QJsonObject toSchema(bool *error = nullptr) const override;
-
     int min = std::numeric_limits<int>::min();
     int max = std::numeric_limits<int>::max();
 };
@@ -247,54 +272,63 @@ public:
 class DoubleValidator : public Validator
 {
 public:
-    DoubleValidator(QObject *parent = nullptr)
-        : DoubleValidator{-1, -1, parent}
+    DoubleValidator()
+        : DoubleValidator{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::max()}
     {}
-    DoubleValidator(double minLength, double maxLength, QObject *parent = nullptr)
-        : Validator{parent}
-        , min{minLength}
-        , max{maxLength}
+    DoubleValidator(double min, double max)
+        : min{min}
+        , max{max}
     {}
 
-    bool fixup(FieldRow &row, QStringList *messages = nullptr) const override
+    bool fixup(QVariant &value, QStringList *messages = nullptr) const override
     {
-        double value = row.value.toDouble();
-        bool valid = false;
+        double number = value.toDouble();
 
-        if (value < min) {
-            value = min;
+        if (number < min) {
             if (messages)
                 messages->append("Enforced minimum");
-            value = min;
+            number = min;
         }
 
-        if (value > max) {
+        if (number > max) {
             if (messages)
                 messages->append("Enforced maximum");
-            value = max;
+            number = max;
         }
 
-        row.value = value;
+        value = number;
 
-        return valid;
+        return true;
     }
-    bool validate(FieldRow &row, QStringList *messages = nullptr) const override
+    bool validate(QVariant &value, QStringList *messages = nullptr) const override
     {
-        double value = row.value.toDouble();
+        if (required() && !value.isValid()) {
+            if (messages)
+                messages->append(QStringLiteral("Required."));
+            return false;
+        }
 
-        if (value < min) {
+        bool ok = false;
+        const double number = value.toDouble(&ok);
+        if (value.isValid() && !ok) {
+            if (messages)
+                messages->append(QStringLiteral("Not a number."));
+            return false;
+        }
+
+        if (number < min) {
             if (messages)
                 messages->append(QStringLiteral("Too low, minimum is %1.").arg(min));
             return false;
         }
 
-        if (value > max) {
+        if (number > max) {
             if (messages)
                 messages->append(QStringLiteral("Too high, maximum is %1.").arg(max));
             return false;
         }
 
-        row.value = value;
+        value = number;
         return true;
     }
 
@@ -305,7 +339,7 @@ public:
         json["type"] = "DoubleValidator";
         json["min"] = min;
         json["max"] = max;
-        json["locale"] = locale().name();
+        writeCommon(json);
 
         if (error)
             *error = false;
@@ -320,61 +354,51 @@ public:
         if (const auto v = json.value("min"); v.isDouble())
             min = v.toDouble();
         else
-            min = std::numeric_limits<double>::min();
+            min = std::numeric_limits<double>::lowest();
 
         if (const auto v = json.value("max"); v.isDouble())
             max = v.toDouble();
         else
             max = std::numeric_limits<double>::max();
 
-        if (const auto v = json.value("locale"); v.isString())
-            setLocale(QLocale{v.toString()});
+        readCommon(json);
 
         return true;
     }
 
-    [[nodiscard]] QJsonObject toSchema(bool *error = nullptr) const override;
-
-    double min = -1;
-    double max = -1;
+    double min = std::numeric_limits<double>::lowest();
+    double max = std::numeric_limits<double>::max();
 };
 
 class BoolValidator : public Validator
 {
 public:
-    BoolValidator(QObject *parent = nullptr)
-        : Validator{parent}
-    {}
-
-    bool fixup(FieldRow &row, QStringList *messages = nullptr) const override
+    bool fixup(QVariant &value, QStringList *messages = nullptr) const override
     {
-        if (required() && !row.value.isValid()) {
+        if (required() && !value.isValid()) {
             if (messages)
                 messages->append(QStringLiteral("Required."));
-            row.value = false;
+            value = false;
         }
 
-        if (row.value.typeId() != qMetaTypeId<bool>()) {
+        if (value.typeId() != qMetaTypeId<bool>()) {
             if (messages)
                 messages->append(QStringLiteral("Converted."));
-            row.value = row.value.toBool();
+            value = value.toBool();
         }
 
         return true;
     }
-    bool validate(FieldRow &row, QStringList *messages = nullptr) const override
+    bool validate(QVariant &value, QStringList *messages = nullptr) const override
     {
-        if (required() && !row.value.isValid()) {
+        if (required() && !value.isValid()) {
             if (messages)
                 messages->append(QStringLiteral("Required."));
             return false;
         }
 
-        if (row.value.typeId() != qMetaTypeId<bool>()) {
-            if (messages)
-                messages->append(QStringLiteral("Converted."));
-            row.value = row.value.toBool();
-        }
+        if (value.typeId() != qMetaTypeId<bool>())
+            value = value.toBool();
 
         return true;
     }
@@ -384,7 +408,7 @@ public:
         QJsonObject json;
 
         json["type"] = "BoolValidator";
-        json["locale"] = locale().name();
+        writeCommon(json);
 
         if (error)
             *error = false;
@@ -396,66 +420,62 @@ public:
         if (json.value("type").toString() != "BoolValidator")
             return false;
 
-        if (const auto v = json.value("locale"); v.isString())
-            setLocale(QLocale{v.toString()});
+        readCommon(json);
 
         return true;
     }
-
-    [[nodiscard]] QJsonObject toSchema(bool *error = nullptr) const override;
 };
 
-class DateValidator : public Validator
+// Date, time and date time only differ in their type, T is QDate, QTime or QDateTime.
+template<typename T>
+class RangeValidator : public Validator
 {
 public:
-    DateValidator(QObject *parent = nullptr)
-        : DateValidator{{}, {}, parent}
-    {}
-    DateValidator(const QDate &min, const QDate &max, QObject *parent = nullptr)
-        : Validator{parent}
-        , min{min}
+    RangeValidator() = default;
+    RangeValidator(const T &min, const T &max)
+        : min{min}
         , max{max}
     {}
 
-    bool fixup(FieldRow &row, QStringList *messages = nullptr) const override
+    bool fixup(QVariant &value, QStringList *messages = nullptr) const override
     {
-        QDate date = row.value.toDate();
+        const T t = value.value<T>();
 
-        if (date.isNull()) {
+        if (t.isNull()) {
             if (required()) {
                 if (messages)
-                    messages->append(QStringLiteral("Date is required."));
+                    messages->append(QStringLiteral("%1 is required.").arg(name()));
                 return false;
             }
             return true;
         }
 
-        if (!date.isValid()) {
+        if (!t.isValid()) {
             if (messages)
-                messages->append("Date is invalid: clearing date.");
-            row.value = {};
+                messages->append(QStringLiteral("%1 is invalid: clearing it.").arg(name()));
+            value = {};
             return true;
         }
 
-        if (min.isValid() && date < min) {
+        if (min.isValid() && t < min) {
             if (messages)
                 messages->append(QStringLiteral("Too low, minimum is %1.").arg(min.toString()));
-            row.value = min;
+            value = min;
         }
 
-        if (max.isValid() && date > max) {
+        if (max.isValid() && t > max) {
             if (messages)
                 messages->append(QStringLiteral("Too high, maximum is %1.").arg(max.toString()));
-            row.value = max;
+            value = max;
         }
 
         return true;
     }
-    bool validate(FieldRow &row, QStringList *messages = nullptr) const override
+    bool validate(QVariant &value, QStringList *messages = nullptr) const override
     {
-        QDate date = row.value.toDate();
+        const T t = value.value<T>();
 
-        if (date.isNull()) {
+        if (t.isNull()) {
             if (required()) {
                 if (messages)
                     messages->append(QStringLiteral("Required."));
@@ -464,19 +484,19 @@ public:
             return true;
         }
 
-        if (!date.isValid()) {
+        if (!t.isValid()) {
             if (messages)
-                messages->append("Date is invalid.");
+                messages->append(QStringLiteral("%1 is invalid.").arg(name()));
             return false;
         }
 
-        if (min.isValid() && date < min) {
+        if (min.isValid() && t < min) {
             if (messages)
                 messages->append(QStringLiteral("Too low, minimum is %1.").arg(min.toString()));
             return false;
         }
 
-        if (max.isValid() && date > max) {
+        if (max.isValid() && t > max) {
             if (messages)
                 messages->append(QStringLiteral("Too high, maximum is %1.").arg(max.toString()));
             return false;
@@ -489,14 +509,14 @@ public:
     {
         QJsonObject json;
 
-        json["type"] = "DateValidator";
-        json["locale"] = locale().name();
+        json["type"] = name() + "Validator";
+        writeCommon(json);
 
         if (min.isValid())
-            json["min"] = min.toString();
+            json["min"] = min.toString(Qt::ISODate);
 
         if (max.isValid())
-            json["max"] = max.toString();
+            json["max"] = max.toString(Qt::ISODate);
 
         if (error)
             *error = false;
@@ -505,269 +525,37 @@ public:
     }
     bool setJson(const QJsonObject &json) override
     {
-        if (json.value("type").toString() != "DateValidator")
+        if (json.value("type").toString() != name() + "Validator")
             return false;
 
-        if (const auto v = json.value("locale"); v.isString())
-            setLocale(QLocale{v.toString()});
+        readCommon(json);
 
         if (const auto v = json.value("min"); v.isString())
-            min = QDate::fromString(v.toString());
+            min = T::fromString(v.toString(), Qt::ISODate);
 
         if (const auto v = json.value("max"); v.isString())
-            max = QDate::fromString(v.toString());
+            max = T::fromString(v.toString(), Qt::ISODate);
 
         return true;
     }
 
-    [[nodiscard]] QJsonObject toSchema(bool *error = nullptr) const override;
-
-    QDate min;
-    QDate max;
-};
-
-class TimeValidator : public Validator
-{
-public:
-    TimeValidator(QObject *parent = nullptr)
-        : TimeValidator{{}, {}, parent}
-    {}
-    TimeValidator(const QTime &min, const QTime &max, QObject *parent = nullptr)
-        : Validator{parent}
-        , min{min}
-        , max{max}
-    {}
-
-    bool fixup(FieldRow &row, QStringList *messages = nullptr) const override
+    [[nodiscard]] static QString name()
     {
-        QTime time = row.value.toTime();
-
-        if (time.isNull()) {
-            if (required()) {
-                if (messages)
-                    messages->append(QStringLiteral("Time is required."));
-                return false;
-            }
-            return true;
-        }
-
-        if (!time.isValid()) {
-            if (messages)
-                messages->append("Time is invalid: clearing time.");
-            row.value = {};
-            return true;
-        }
-
-        if (min.isValid() && time < min) {
-            if (messages)
-                messages->append(QStringLiteral("Too low, minimum is %1.").arg(min.toString()));
-            row.value = min;
-        }
-
-        if (max.isValid() && time > max) {
-            if (messages)
-                messages->append(QStringLiteral("Too high, maximum is %1.").arg(max.toString()));
-            row.value = max;
-        }
-
-        return true;
-    }
-    bool validate(FieldRow &row, QStringList *messages = nullptr) const override
-    {
-        QTime time = row.value.toTime();
-
-        if (time.isNull()) {
-            if (required()) {
-                if (messages)
-                    messages->append(QStringLiteral("Required."));
-                return false;
-            }
-            return true;
-        }
-
-        if (!time.isValid()) {
-            if (messages)
-                messages->append("Time is invalid.");
-            return false;
-        }
-
-        if (min.isValid() && time < min) {
-            if (messages)
-                messages->append(QStringLiteral("Too low, minimum is %1.").arg(min.toString()));
-            return false;
-        }
-
-        if (max.isValid() && time > max) {
-            if (messages)
-                messages->append(QStringLiteral("Too high, maximum is %1.").arg(max.toString()));
-            return false;
-        }
-
-        return true;
-    }
-
-    [[nodiscard]] QJsonObject toJson(bool *error = nullptr) const override
-    {
-        QJsonObject json;
-
-        json["type"] = "TimeValidator";
-        json["locale"] = locale().name();
-
-        if (min.isValid())
-            json["min"] = min.toString();
-
-        if (max.isValid())
-            json["max"] = max.toString();
-
-        if (error)
-            *error = false;
-
-        return json;
-    }
-    bool setJson(const QJsonObject &json) override
-    {
-        if (json.value("type").toString() != "TimeValidator")
-            return false;
-
-        if (const auto v = json.value("locale"); v.isString())
-            setLocale(QLocale{v.toString()});
-
-        if (const auto v = json.value("min"); v.isString())
-            min = QTime::fromString(v.toString());
-
-        if (const auto v = json.value("max"); v.isString())
-            max = QTime::fromString(v.toString());
-
-        return true;
+        if constexpr (std::is_same_v<T, QDate>)
+            return QStringLiteral("Date");
+        else if constexpr (std::is_same_v<T, QTime>)
+            return QStringLiteral("Time");
+        else
+            return QStringLiteral("DateTime");
     }
 
-    [[nodiscard]] QJsonObject toSchema(bool *error = nullptr) const override;
-
-    QTime min;
-    QTime max;
+    T min;
+    T max;
 };
 
-class DateTimeValidator : public Validator
-{
-public:
-    DateTimeValidator(QObject *parent = nullptr)
-        : DateTimeValidator{{}, {}, parent}
-    {}
-    DateTimeValidator(const QDateTime &min, const QDateTime &max, QObject *parent = nullptr)
-        : Validator{parent}
-        , min{min}
-        , max{max}
-    {}
-
-    bool fixup(FieldRow &row, QStringList *messages = nullptr) const override
-    {
-        QDateTime dateTime = row.value.toDateTime();
-
-        if (dateTime.isNull()) {
-            if (required()) {
-                if (messages)
-                    messages->append(QStringLiteral("DateTime is required."));
-                return false;
-            }
-            return true;
-        }
-
-        if (!dateTime.isValid()) {
-            if (messages)
-                messages->append("DateTime is invalid: clearing dateTime.");
-            row.value = {};
-            return true;
-        }
-
-        if (min.isValid() && dateTime < min) {
-            if (messages)
-                messages->append(QStringLiteral("Too low, minimum is %1.").arg(min.toString()));
-            row.value = min;
-        }
-
-        if (max.isValid() && dateTime > max) {
-            if (messages)
-                messages->append(QStringLiteral("Too high, maximum is %1.").arg(max.toString()));
-            row.value = max;
-        }
-
-        return true;
-    }
-    bool validate(FieldRow &row, QStringList *messages = nullptr) const override
-    {
-        QDateTime dateTime = row.value.toDateTime();
-
-        if (dateTime.isNull()) {
-            if (required()) {
-                if (messages)
-                    messages->append(QStringLiteral("Required."));
-                return false;
-            }
-            return true;
-        }
-
-        if (!dateTime.isValid()) {
-            if (messages)
-                messages->append("DateTime is invalid.");
-            return false;
-        }
-
-        if (min.isValid() && dateTime < min) {
-            if (messages)
-                messages->append(QStringLiteral("Too low, minimum is %1.").arg(min.toString()));
-            return false;
-        }
-
-        if (max.isValid() && dateTime > max) {
-            if (messages)
-                messages->append(QStringLiteral("Too high, maximum is %1.").arg(max.toString()));
-            return false;
-        }
-
-        return true;
-    }
-
-    [[nodiscard]] QJsonObject toJson(bool *error = nullptr) const override
-    {
-        QJsonObject json;
-
-        json["type"] = "DateTimeValidator";
-        json["locale"] = locale().name();
-
-        if (min.isValid())
-            json["min"] = min.toString();
-
-        if (max.isValid())
-            json["max"] = max.toString();
-
-        if (error)
-            *error = false;
-
-        return json;
-    }
-    bool setJson(const QJsonObject &json) override
-    {
-        if (json.value("type").toString() != "DateTimeValidator")
-            return false;
-
-        if (const auto v = json.value("locale"); v.isString())
-            setLocale(QLocale{v.toString()});
-
-        if (const auto v = json.value("min"); v.isString())
-            min = QDateTime::fromString(v.toString());
-
-        if (const auto v = json.value("max"); v.isString())
-            max = QDateTime::fromString(v.toString());
-
-        return true;
-    }
-
-    [[nodiscard]] QJsonObject toSchema(bool *error = nullptr) const override;
-
-    QDateTime min;
-    QDateTime max;
-};
-*/
+using DateValidator = RangeValidator<QDate>;
+using TimeValidator = RangeValidator<QTime>;
+using DateTimeValidator = RangeValidator<QDateTime>;
 
 } // namespace novelist
 
@@ -1,6 +1,8 @@
 #include "value.h"
 #include "storage.h"
 
+#include <algorithm>
+
 bool Value::reload()
 {
     return storage()->valueStorage()->reloadNode(this);
@@ -16,30 +18,53 @@ bool Value::recycle()
     return storage()->valueStorage()->recycleNode(this);
 }
 
+int Value::conversion(const QList<int> &allowedTypes, int typeId)
+{
+    if (allowedTypes.contains(typeIdToType(typeId)))
+        return typeId;
+    for (const int t : allowedTypes)
+        if (QMetaType::canConvert(QMetaType{typeId}, QMetaType{typeToTypeId(t)}))
+            return typeToTypeId(t);
+    return Refused;
+}
+
+QVariant Value::value() const
+{
+    if (mStale) {
+        mValue = mProse->text();
+        mStale = false;
+    }
+    return mValue;
+}
+
 void Value::setValue(const QVariant &value)
 {
+    // long text stays long text, the whole of it replaced
+    if (isText()) {
+        const QString text = value.toString();
+        if (text == this->value().toString())
+            return;
+        replaceText(0, textLength(), text);
+        emit valueChanged(QPrivateSignal{});
+        return;
+    }
+
     QVariant v = value;
-    bool ok = false;
-    if (!mValue.isValid() || !QMetaType::canConvert(v.metaType(), mValue.metaType())) {
-        if (mFields.isEmpty())
-            ok = true;
-        else if (mFields.front()->allowedTypes().contains(typeIdToType(v.typeId()))) {
-            ok = true;
-        } else {
-            for (auto t : mFields.front()->allowedTypes()) {
-                if (QMetaType::canConvert(v.metaType(), QMetaType{typeToTypeId(t)})) {
-                    v.convert(QMetaType{typeToTypeId(t)});
-                    ok = true;
-                    break;
-                }
-            }
+
+    // an edit of the same type as the value it replaces, the common case, needs no conversion
+    if (!mValue.isValid() || v.metaType() != mValue.metaType()) {
+        if (mValue.isValid() && QMetaType::canConvert(v.metaType(), mValue.metaType())) {
+            v.convert(mValue.metaType());
+        } else if (!mFields.isEmpty()) {
+            const int target = mFields.front()->conversion(v.typeId());
+            if (target == Refused)
+                return;
+            if (target != v.typeId())
+                v.convert(QMetaType{target});
         }
-    } else {
-        ok = true;
-        v.convert(mValue.metaType());
     }
 
-    if (!ok || mValue == v)
+    if (mValue == v)
         return;
 
     mValue = v;
@@ -52,6 +77,112 @@ void Value::setValue(const QVariant &value)
     emit valueChanged(QPrivateSignal{});
 }
 
+void Value::setStoredValue(const QVariant &value, int valueType)
+{
+    QVariant v = value;
+    if (typeIdToType(v.typeId()) != valueType) {
+        // e.g. a number from a TEXT column, or a node stored as its rowid, which stays as it is
+        const QMetaType target{typeToTypeId(valueType)};
+        if (QMetaType::canConvert(v.metaType(), target))
+            v.convert(target);
+    }
+
+    // the stored value replaces the text, setValueType() must not move it back
+    mProse.reset();
+    mStale = false;
+    mChunksRewritten = false;
+    mDirtyChunks.clear();
+
+    const bool changed = mValue != v;
+    mValue = v;
+
+    setValueType(valueType);
+
+    if (changed)
+        emit valueChanged(QPrivateSignal{});
+}
+
+void Value::setValueType(int valueType)
+{
+    if (mValueType == valueType)
+        return;
+
+    const bool text = valueType == Type_Text || mValueType == Type_Text;
+
+    // the text moves between the value and the chunks
+    if (valueType == Type_Text) {
+        mProse = std::make_unique<Prose>(value().toString());
+        mValue = mProse->text();
+    } else if (mProse) {
+        mValue = value();
+        mProse.reset();
+    }
+    mStale = false;
+
+    mValueType = valueType;
+
+    if (!updateValueType()) {
+        mChunksRewritten = mChunksRewritten || text;
+        setModified(true);
+    }
+
+    emit valueTypeChanged(QPrivateSignal{});
+}
+
+int Value::textLength() const
+{
+    return mProse ? int(mProse->size()) : 0;
+}
+
+QString Value::textRange(int position, int length) const
+{
+    return mProse ? mProse->mid(position, length) : QString{};
+}
+
+bool Value::replaceText(int position, int length, const QString &text)
+{
+    if (!mProse)
+        return handleError(this, "replaceText", "value is not of type Text"), false;
+
+    const qsizetype from = std::clamp<qsizetype>(position, 0, mProse->size());
+    const qsizetype removed = std::clamp<qsizetype>(length, 0, mProse->size() - from);
+    if (removed == 0 && text.isEmpty())
+        return true;
+
+    const Prose::Edit edit = mProse->replace(from, removed, text);
+    mStale = true;
+
+    if (!updateText(edit)) {
+        if (edit.rewritten)
+            mChunksRewritten = true;
+        for (const Prose::Chunk &chunk : edit.updated)
+            mDirtyChunks.insert(chunk.key);
+        for (const Prose::Chunk &chunk : edit.inserted)
+            mDirtyChunks.insert(chunk.key);
+        for (const QString &key : edit.removed)
+            mDirtyChunks.insert(key);
+        setModified(true);
+    }
+
+    emit textChanged(int(from), int(removed), int(text.size()), QPrivateSignal{});
+    return true;
+}
+
+void Value::setStoredText(const QList<Prose::Chunk> &chunks)
+{
+    setValueType(Type_Text);
+    mChunksRewritten = false;
+    mDirtyChunks.clear();
+
+    if (mProse->hasChunks(chunks))
+        return;
+
+    mProse->setChunks(chunks);
+    mStale = true;
+
+    emit valueChanged(QPrivateSignal{});
+}
+
 int Value::indexIn(Field *field) const
 {
     return field->values().indexOf(this);
@@ -79,7 +210,7 @@ bool Value::writeJson(QJsonObject &json, QStringList *errors) const
         return false;
 
     json.insert(QStringLiteral("valueType"), mValueType);
-    json.insert(QStringLiteral("value"), QJsonValue::fromVariant(mValue));
+    json.insert(QStringLiteral("value"), QJsonValue::fromVariant(value()));
 
     return true;
 
@@ -93,6 +224,13 @@ bool Value::updateValue()
     return storage()->valueStorage()->updateValue(this);
 }
 
+bool Value::updateText(const Prose::Edit &edit)
+{
+    if (rowid() <= 0 || isLoading() || isSaving())
+        return false;
+    return storage()->valueStorage()->updateText(this, edit);
+}
+
 bool Value::updateValueType()
 {
     if (rowid() <= 0 || isLoading() || isSaving())
@@ -1,8 +1,11 @@
 #ifndef LIBNOVELIST_VALUE_H
 #define LIBNOVELIST_VALUE_H
 
+#include <QSet>
 #include <QVariant>
+#include <memory>
 #include "node.h"
+#include "prose.h"
 #include "valuetype.h"
 
 class Field;
@@ -25,11 +28,38 @@ public:
         Type_Time,
         Type_DateTime,
         Type_Node,
-        Type_NodeList
+        Type_NodeList,
+        Type_Text
     };
     Q_ENUM(Type)
 
-    static int typeIdToType(int typeId) { return mTypeIdToType.value(typeId, Type_Unknown); }
+    // What a conversion plan holds for a metatype that none of the allowed types can take.
+    static constexpr int Refused = -1;
+
+    static int typeIdToType(int typeId)
+    {
+        // the builtin metatypes are constants, only Node* and NodeList need the map
+        switch (typeId) {
+        case QMetaType::QString:
+            return Type_String;
+        case QMetaType::Int:
+            return Type_Int;
+        case QMetaType::Float:
+            return Type_Float;
+        case QMetaType::Double:
+            return Type_Double;
+        case QMetaType::Bool:
+            return Type_Bool;
+        case QMetaType::QDate:
+            return Type_Date;
+        case QMetaType::QTime:
+            return Type_Time;
+        case QMetaType::QDateTime:
+            return Type_DateTime;
+        default:
+            return mTypeIdToType.value(typeId, Type_Unknown);
+        }
+    }
     static int typeToTypeId(int type)
     {
         switch (type) {
@@ -54,11 +84,18 @@ public:
             return qMetaTypeId<Node *>();
         case Type_NodeList:
             return qMetaTypeId<NodeList>();
+        case Type_Text:
+            return qMetaTypeId<QString>();
         }
     }
     static QString typeToString(int type) { return mTypeToString.value(type, "Unknown"); }
     static int stringToType(const QString &type) { return mTypeToString.key(type, Type_Unknown); }
 
+    // The metatype a value of metatype typeId becomes in a field that allows allowedTypes: typeId
+    // itself when it is allowed, else the first allowed type it converts to, else Refused.
+    // FieldType keeps the answers in its conversion plan.
+    static int conversion(const QList<int> &allowedTypes, int typeId);
+
     explicit Value(Storage *storage, QObject *parent = nullptr)
         : Value{Type_Value, storage, parent}
     {}
@@ -108,22 +145,23 @@ public:
         return true;
     }
 
-    [[nodiscard]] QVariant value() const { return mValue; }
+    [[nodiscard]] QVariant value() const;
     void setValue(const QVariant &value);
 
     [[nodiscard]] int valueType() const { return mValueType; }
-    void setValueType(int valueType)
-    {
-        if (mValueType == valueType)
-            return;
-
-        mValueType = valueType;
-
-        if (!updateValueType())
-            setModified(true);
-
-        emit valueTypeChanged(QPrivateSignal{});
-    }
+    void setValueType(int valueType);
+
+    // Long text, a value of Type_Text: kept as Prose chunks and edited by range. value() joins
+    // the chunks when it is asked for; an editor reads textRange() and follows textChanged(),
+    // range edits don't emit valueChanged().
+    [[nodiscard]] bool isText() const { return mValueType == Type_Text; }
+    // How much of long text the value column keeps, enough to sort by; the rest is only in the
+    // chunks.
+    static constexpr int TextPrefix = 256;
+    [[nodiscard]] Q_INVOKABLE int textLength() const;
+    [[nodiscard]] Q_INVOKABLE QString textRange(int position, int length) const;
+    // Replaces length characters at position with text, writing only the chunks it touches.
+    Q_INVOKABLE bool replaceText(int position, int length, const QString &text);
 
     [[nodiscard]] Q_INVOKABLE int indexIn(Field *field) const;
 
@@ -131,6 +169,7 @@ signals:
     void fieldsChanged(QPrivateSignal);
     void valueChanged(QPrivateSignal);
     void valueTypeChanged(QPrivateSignal);
+    void textChanged(int position, int removed, int added, QPrivateSignal);
 
 protected:
     bool readJson(const QJsonObject &json, QStringList *errors = nullptr) override;
@@ -138,10 +177,24 @@ protected:
 
     bool updateValue();
     bool updateValueType();
+    bool updateText(const Prose::Edit &edit);
+
+    // The value and type as read from storage, converted only if the value came back as another
+    // type than it was written with.
+    void setStoredValue(const QVariant &value, int valueType);
+    void setStoredText(const QList<Prose::Chunk> &chunks);
 
 private:
     QList<Field *> mFields;
-    QVariant mValue;
+    // For Type_Text the joined chunks, joined again by value() after an edit or a reload, which
+    // is when packed chunks are unpacked.
+    mutable QVariant mValue;
+    mutable bool mStale = false;
+    std::unique_ptr<Prose> mProse;
+    // The chunks changed since the value was last written that the next save writes: every one
+    // of them after a change of type, else those under the keys.
+    bool mChunksRewritten = false;
+    QSet<QString> mDirtyChunks;
     int mValueType = 0;
 
     inline static const QMap<int, int> mTypeIdToType = {{qMetaTypeId<QString>(), Type_String},
@@ -163,9 +216,11 @@ private:
                                                             {Type_Time, "Time"},
                                                             {Type_DateTime, "DateTime"},
                                                             {Type_Node, "Node"},
-                                                            {Type_NodeList, "NodeList"}};
+                                                            {Type_NodeList, "NodeList"},
+                                                            {Type_Text, "Text"}};
 
     friend class Field;
+    friend class ValueStorage;
 
     Q_PROPERTY(QList<Field *> fields READ fields WRITE setFields NOTIFY fieldsChanged FINAL)
     Q_PROPERTY(QVariant value READ value WRITE setValue NOTIFY valueChanged FINAL)
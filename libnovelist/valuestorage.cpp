@@ -1,30 +1,77 @@
 #include "valuestorage.h"
 #include "storage.h"
+#include "textcodec.h"
+
+namespace {
+
+// What goes in the value column: a node as its rowid, and the start of long text, for the
+// statements that sort by the value column; the whole of it is only in the chunks
+QVariant storedValue(const Value *value)
+{
+    if (value->isText())
+        return value->textRange(0, Value::TextPrefix);
+
+    QVariant v = value->value();
+    if (Node *node = v.value<Node *>())
+        v = node->rowid();
+    return v;
+}
+
+} // namespace
 
 void ValueStorage::setDatabase(const QSqlDatabase &database)
 {
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `Value` (\n"
-                     "  `id`	      INTEGER NOT NULL UNIQUE,\n"
-                     "  `valueType` INTEGER NOT NULL,\n"
-                     "  `value`     TEXT,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-
-        mReloadQuery = createQuery("SELECT * FROM `Value` WHERE `id`=:id");
-        mInsertQuery = createQuery(
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `Value` (\n"
+                         "  `id`	      INTEGER NOT NULL,\n"
+                         "  `valueType` INTEGER NOT NULL,\n"
+                         "  `value`     TEXT,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+            // the chunks of long text values, see Prose; their counts add up to the value's.
+            // A chunk is either text or packed, see TextCodec
+            executeQuery("CREATE TABLE IF NOT EXISTS `ValueChunk` (\n"
+                         "  `value`      INTEGER NOT NULL,\n"
+                         "  `index`      TEXT NOT NULL,\n"
+                         "  `text`       TEXT,\n"
+                         "  `packed`     BLOB,\n"
+                         "  `words`      INTEGER NOT NULL,\n"
+                         "  `characters` INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`value`,`index`)\n"
+                         ") WITHOUT ROWID");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `Value` WHERE `id`=:id");
+        mInsertQuery = lazyQuery(
             "INSERT INTO `Value` (`id`,`valueType`,`value`) VALUES (:id,:valueType,:value)");
-        mUpdateQuery = createQuery(
+        mUpdateQuery = lazyQuery(
             "UPDATE `Value` SET `valueType`=:valueType,`value`=:value WHERE `id`=:id");
+        mUpdateTextQuery = lazyQuery("UPDATE `Value` SET `value`=:value WHERE `id`=:id");
 
-        mReloadFieldsQuery = createQuery(
+        mReloadFieldsQuery = lazyQuery(
             "SELECT * FROM `Field_values` WHERE `value`=:value ORDER BY `index`");
-        mUpdateFieldQuery = createQuery(
-            "UPDATE `Field_values` SET `value`=:newValue,`index`=:index "
-            "WHERE `field`=:field AND `value`=:oldValue");
+        mUpdateFieldQuery = lazyQuery(
+            "UPDATE `Field_values` SET `value`=:newValue WHERE `field`=:field AND "
+            "`value`=:oldValue");
+
+        mReloadChunksQuery = lazyQuery("SELECT `index`,`text`,`packed`,`characters` FROM "
+                                       "`ValueChunk` WHERE `value`=:value ORDER BY `index`");
+        mInsertChunkQuery = lazyQuery(
+            "INSERT INTO `ValueChunk` (`value`,`index`,`text`,`packed`,`words`,`characters`) "
+            "VALUES (:value,:index,:text,:packed,:words,:characters)");
+        mUpdateChunkQuery = lazyQuery(
+            "UPDATE `ValueChunk` SET `text`=:text,`packed`=:packed,`words`=:words,`characters`="
+            ":characters WHERE `value`=:value AND `index`=:index");
+        mReplaceChunkQuery = lazyQuery(
+            "INSERT OR REPLACE INTO `ValueChunk` (`value`,`index`,`text`,`packed`,`words`,"
+            "`characters`) VALUES (:value,:index,:text,:packed,:words,:characters)");
+        mRemoveChunkQuery = lazyQuery(
+            "DELETE FROM `ValueChunk` WHERE `value`=:value AND `index`=:index");
+        mRemoveChunksQuery = lazyQuery("DELETE FROM `ValueChunk` WHERE `value`=:value");
     }
 
     emitDatabaseChanged();
@@ -47,28 +94,27 @@ bool ValueStorage::insertNode(Node *node)
 
     Value *value = static_cast<Value *>(node);
 
-    QVariant valueValue = value->value();
-    if (Node *node = valueValue.value<Node *>())
-        valueValue = node->rowid();
-
     if (!executeQuery(mInsertQuery,
                       QVariantMap{{":id", value->rowid()},
-                                  {":value", valueValue},
+                                  {":value", storedValue(value)},
                                   {":valueType", value->valueType()}}))
         return handleError(this, "insertNode", mInsertQuery), false;
 
+    if (value->isText() && !writeChunks(value))
+        return false;
+
     for (Field *field : value->fields()) {
         if (!executeQuery(mUpdateFieldQuery,
                           QVariantMap{{":oldValue", oldRowid},
                                       {":newValue", value->rowid()},
-                                      {":index", value->indexIn(field)},
                                       {":field", field->rowid()}}))
             return handleError(this, "insertNode", mUpdateFieldQuery), false;
     }
 
-    tx.commit();
+    if (!storage()->aggregates().update(value->rowid()))
+        return false;
 
-    return true;
+    return tx.commit();
 }
 
 bool ValueStorage::updateNode(Node *node)
@@ -81,14 +127,20 @@ bool ValueStorage::updateNode(Node *node)
     Value *v = static_cast<Value *>(node);
 
     if (!executeQuery(mUpdateQuery,
-                      QVariantMap{{":value", v->value()},
+                      QVariantMap{{":value", storedValue(v)},
                                   {":id", v->rowid()},
                                   {":valueType", v->valueType()}}))
         return handleError(this, "updateNode", mUpdateQuery), false;
 
-    tx.commit();
+    // ranged edits are written as they are made, only those made while that wasn't possible
+    // are left, and all of the chunks after a change of type
+    if (v->mChunksRewritten ? !writeChunks(v) : !writeDirtyChunks(v))
+        return false;
 
-    return true;
+    if (!storage()->aggregates().update(v->rowid()))
+        return false;
+
+    return tx.commit();
 }
 
 bool ValueStorage::reloadNode(Node *node)
@@ -103,18 +155,32 @@ bool ValueStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {value->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
-    value->setValue(mReloadQuery.value("value"));
-    value->setValueType(mReloadQuery.value("valueType").toInt());
+    const int valueType = mReloadQuery->value("valueType").toInt();
+    if (valueType == Value::Type_Text) {
+        if (!executeQuery(mReloadChunksQuery, QVariantMap{{":value", value->rowid()}}))
+            return handleError(this, "reloadNode", mReloadChunksQuery), false;
+
+        // packed chunks are unpacked when their text is read, see Prose
+        QList<Prose::Chunk> chunks;
+        while (mReloadChunksQuery->next())
+            chunks.append({mReloadChunksQuery->value(0).toString(),
+                           mReloadChunksQuery->value(1).toString(),
+                           mReloadChunksQuery->value(2).toByteArray(),
+                           mReloadChunksQuery->value(3).toLongLong()});
+        value->setStoredText(chunks);
+    } else {
+        value->setStoredValue(mReloadQuery->value("value"), valueType);
+    }
 
     if (!executeQuery(mReloadFieldsQuery, QVariantMap{{":value", value->rowid()}}))
         return handleError(this, "reloadNode", mReloadFieldsQuery), false;
 
     QList<Field *> fields;
-    while (mReloadFieldsQuery.next()) {
-        const int rowid = mReloadFieldsQuery.value("field").toInt();
+    while (mReloadFieldsQuery->next()) {
+        const int rowid = mReloadFieldsQuery->value("field").toInt();
         if (Field *field = qobject_cast<Field *>(storage()->fieldStorage()->field(rowid)))
             fields.append(field);
         else
@@ -123,9 +189,7 @@ bool ValueStorage::reloadNode(Node *node)
 
     value->setFields(fields);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ValueStorage::removeNode(int rowid)
@@ -138,7 +202,213 @@ bool ValueStorage::removeNode(int rowid)
     if (!storage()->nodeStorage()->removeNode(rowid))
         return false;
 
-    tx.commit();
+    if (!executeQuery(mRemoveChunksQuery, QVariantMap{{":value", rowid}}))
+        return handleError(this, "removeNode", mRemoveChunksQuery), false;
+
+    return tx.commit();
+}
+
+bool ValueStorage::updateValue(Value *value)
+{
+    if (!value || value->rowid() <= 0)
+        return false;
+
+    Transaction tx{Transaction::Write, value, storage()};
+
+    if (value->isText() && !writeChunks(value))
+        return false;
+
+    QSqlQuery q = createQuery("UPDATE Value SET value=? WHERE id=?");
+    if (!executeQuery(q, {storedValue(value), value->rowid()})) {
+        handleError(this, "updateValue", q);
+        return false;
+    }
+
+    if (!storage()->aggregates().update(value->rowid()))
+        return false;
+
+    return tx.commit();
+}
+
+bool ValueStorage::updateValueType(Value *value)
+{
+    if (!value || value->rowid() <= 0)
+        return false;
+
+    Transaction tx{Transaction::Write, value, storage()};
+
+    // the text moves between the value column and the chunks when long text comes or goes
+    QSqlQuery q = createQuery("UPDATE Value SET valueType=?,value=? WHERE id=?");
+    if (!executeQuery(q, {value->valueType(), storedValue(value), value->rowid()})) {
+        handleError(this, "updateValueType", q);
+        return false;
+    }
+
+    if (!writeChunks(value))
+        return false;
+
+    if (!storage()->aggregates().update(value->rowid()))
+        return false;
+
+    return tx.commit();
+}
+
+bool ValueStorage::updateText(Value *value, const Prose::Edit &edit)
+{
+    if (!value || value->rowid() <= 0)
+        return false;
+
+    Transaction tx{Transaction::Write, value, storage()};
+
+    if (edit.rewritten && !writeChunks(value))
+        return false;
+
+    for (const QString &key : edit.removed)
+        if (!executeQuery(mRemoveChunkQuery,
+                          QVariantMap{{":value", value->rowid()}, {":index", key}}))
+            return handleError(this, "updateText", mRemoveChunkQuery), false;
+
+    for (const Prose::Chunk &chunk : edit.updated)
+        if (!writeChunk(mUpdateChunkQuery, value, chunk))
+            return false;
 
+    for (const Prose::Chunk &chunk : edit.inserted)
+        if (!writeChunk(mInsertChunkQuery, value, chunk))
+            return false;
+
+    if (edit.position < Value::TextPrefix
+        && !executeQuery(mUpdateTextQuery,
+                         QVariantMap{{":value", storedValue(value)}, {":id", value->rowid()}}))
+        return handleError(this, "updateText", mUpdateTextQuery), false;
+
+    if (!storage()->aggregates().update(value->rowid()))
+        return false;
+
+    return tx.commit();
+}
+
+bool ValueStorage::writeChunks(Value *value)
+{
+    Transaction tx{Transaction::Write, value, storage()};
+
+    if (!executeQuery(mRemoveChunksQuery, QVariantMap{{":value", value->rowid()}}))
+        return handleError(this, "writeChunks", mRemoveChunksQuery), false;
+
+    if (value->mProse)
+        for (const Prose::Chunk &chunk : value->mProse->chunks())
+            if (!writeChunk(mInsertChunkQuery, value, chunk))
+                return false;
+
+    if (!tx.commit())
+        return false;
+
+    value->mChunksRewritten = false;
+    value->mDirtyChunks.clear();
+    return true;
+}
+
+bool ValueStorage::writeDirtyChunks(Value *value)
+{
+    if (value->mDirtyChunks.isEmpty())
+        return true;
+
+    Transaction tx{Transaction::Write, value, storage()};
+
+    for (const QString &key : std::as_const(value->mDirtyChunks)) {
+        const Prose::Chunk chunk = value->mProse ? value->mProse->chunk(key) : Prose::Chunk{};
+        if (chunk.key.isEmpty()) {
+            if (!executeQuery(mRemoveChunkQuery,
+                              QVariantMap{{":value", value->rowid()}, {":index", key}}))
+                return handleError(this, "writeDirtyChunks", mRemoveChunkQuery), false;
+        } else if (!writeChunk(mReplaceChunkQuery, value, chunk)) {
+            return false;
+        }
+    }
+
+    if (!tx.commit())
+        return false;
+
+    value->mDirtyChunks.clear();
+    return true;
+}
+
+bool ValueStorage::migrateText()
+{
+    Transaction tx{Transaction::Write, nullptr, storage()};
+
+    // before version 9 long text had no chunks, it was whole in the value column
+    QSqlQuery query = createQuery(
+        QStringLiteral("SELECT v.`id`,v.`value` FROM `Value` v WHERE v.`valueType`=%1 AND "
+                       "v.`value` IS NOT NULL AND NOT EXISTS (SELECT 1 FROM `ValueChunk` c "
+                       "WHERE c.`value`=v.`id`)")
+            .arg(Value::Type_Text),
+        true);
+    if (!executeQuery(query))
+        return handleError(this, "migrateText", query), false;
+
+    QMap<int, QString> unchunked;
+    while (query.next())
+        unchunked.insert(query.value(0).toInt(), query.value(1).toString());
+    query.finish();
+
+    for (auto it = unchunked.constBegin(); it != unchunked.constEnd(); ++it) {
+        for (const Prose::Chunk &chunk : Prose{it.value()}.chunks())
+            if (!writeChunk(mInsertChunkQuery, it.key(), chunk))
+                return false;
+        if (!executeQuery(mUpdateTextQuery,
+                          QVariantMap{{":value", it.value().left(Value::TextPrefix)},
+                                      {":id", it.key()}}))
+            return handleError(this, "migrateText", mUpdateTextQuery), false;
+    }
+
+    // in 9 and 10 it had nothing but its chunks, the first one holds the start
+    query = createQuery(QStringLiteral("SELECT c.`value`,c.`text`,c.`packed` FROM `Value` v JOIN "
+                                       "`ValueChunk` c ON c.`value`=v.`id` WHERE v.`valueType`=%1 "
+                                       "AND v.`value` IS NULL AND c.`index`=(SELECT MIN(`index`) "
+                                       "FROM `ValueChunk` WHERE `value`=v.`id`)")
+                            .arg(Value::Type_Text),
+                        true);
+    if (!executeQuery(query))
+        return handleError(this, "migrateText", query), false;
+
+    QMap<int, QString> prefixes;
+    while (query.next())
+        prefixes.insert(query.value(0).toInt(),
+                        (query.isNull(2) ? query.value(1).toString()
+                                         : TextCodec::unpack(query.value(2).toByteArray()))
+                            .left(Value::TextPrefix));
+    query.finish();
+
+    for (auto it = prefixes.constBegin(); it != prefixes.constEnd(); ++it)
+        if (!executeQuery(mUpdateTextQuery, QVariantMap{{":value", it.value()}, {":id", it.key()}}))
+            return handleError(this, "migrateText", mUpdateTextQuery), false;
+
+    return tx.commit();
+}
+
+bool ValueStorage::writeChunk(PreparedQuery &query, Value *value, const Prose::Chunk &chunk)
+{
+    return writeChunk(query, value->rowid(), chunk);
+}
+
+bool ValueStorage::writeChunk(PreparedQuery &query, int rowid, const Prose::Chunk &chunk)
+{
+    // one of the two columns, the other NULL
+    const QByteArray packed = TextCodec::pack(chunk.text);
+    QVariant text{QMetaType::fromType<QString>()};
+    QVariant blob{QMetaType::fromType<QByteArray>()};
+    if (packed.isEmpty())
+        text = chunk.text;
+    else
+        blob = packed;
+
+    if (!executeQuery(query,
+                      QVariantMap{{":value", rowid},
+                                  {":index", chunk.key},
+                                  {":text", text},
+                                  {":packed", blob},
+                                  {":words", Aggregates::countWords(chunk.text)},
+                                  {":characters", int(chunk.text.size())}}))
+        return handleError(this, "writeChunk", query), false;
     return true;
 }
@@ -23,7 +23,7 @@ public:
                                                  const QString& info = {},
                                                  const QString& icon = {})
     {
-        if (Value* e = static_cast<Value*>(createNode())) {
+        if (Value* e = static_cast<Value*>(newNode())) {
             e->setNodeType(nodeType);
             e->setLabel(label);
             e->setInfo(info);
@@ -40,50 +40,34 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
-    bool updateValue(Value* value)
-    {
-        if (!value || value->rowid() <= 0)
-            return false;
-
-        Transaction tx{Transaction::Write, value, storage()};
-
-        QSqlQuery q = createQuery("UPDATE Value SET value=? WHERE id=?");
-        if (!executeQuery(q, {value->value(), value->rowid()})) {
-            handleError(this, "updateValue", q);
-            return false;
-        }
-
-        tx.commit();
-
-        return true;
-    }
-    bool updateValueType(Value* value)
-    {
-        if (!value || value->rowid() <= 0)
-            return false;
-
-        Transaction tx{Transaction::Write, value, storage()};
-
-        QSqlQuery q = createQuery("UPDATE Value SET valueType=? WHERE id=?");
-        if (!executeQuery(q, {value->valueType(), value->rowid()})) {
-            handleError(this, "updateValueType", q);
-            return false;
-        }
-
-        tx.commit();
-
-        return true;
-    }
+    bool updateValue(Value* value);
+    bool updateValueType(Value* value);
+    bool updateText(Value* value, const Prose::Edit& edit);
+    // Replaces the chunks of value with its current ones, none unless it is long text.
+    bool writeChunks(Value* value);
+    // Writes the chunks value was edited in while it couldn't write them, see Value.
+    bool writeDirtyChunks(Value* value);
+    bool writeChunk(PreparedQuery& query, Value* value, const Prose::Chunk& chunk);
+    bool writeChunk(PreparedQuery& query, int rowid, const Prose::Chunk& chunk);
+    // Puts the long text of an older file into chunks, and its start into the value column.
+    bool migrateText();
 
     friend class Value;
     friend class Storage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
-    QSqlQuery mReloadFieldsQuery;
-    QSqlQuery mInsertFieldsQuery;
-    QSqlQuery mUpdateFieldQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
+    PreparedQuery mUpdateTextQuery;
+    PreparedQuery mReloadFieldsQuery;
+    PreparedQuery mInsertFieldsQuery;
+    PreparedQuery mUpdateFieldQuery;
+    PreparedQuery mReloadChunksQuery;
+    PreparedQuery mInsertChunkQuery;
+    PreparedQuery mUpdateChunkQuery;
+    PreparedQuery mReplaceChunkQuery;
+    PreparedQuery mRemoveChunkQuery;
+    PreparedQuery mRemoveChunksQuery;
 };
 
 #endif // LIBNOVELIST_VALUESTORAGE_H
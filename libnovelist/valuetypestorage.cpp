@@ -7,17 +7,19 @@ void ValueTypeStorage::setDatabase(const QSqlDatabase &database)
     mDatabase = database;
 
     if (mDatabase.isOpen()) {
-        executeQuery("CREATE TABLE IF NOT EXISTS `ValueType` (\n"
-                     "  `id` INTEGER NOT NULL UNIQUE,\n"
-                     "  PRIMARY KEY(`id`),\n"
-                     "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
-                     ")");
-
-        mReloadQuery = createQuery("SELECT * FROM `ValueType` WHERE `id`=:id");
-        mReloadFieldTypesQuery = createQuery(
+        if (needsSchema()) {
+            executeQuery("CREATE TABLE IF NOT EXISTS `ValueType` (\n"
+                         "  `id` INTEGER NOT NULL,\n"
+                         "  PRIMARY KEY(`id`),\n"
+                         "  FOREIGN KEY(`id`) REFERENCES Storable(`id`) ON DELETE CASCADE\n"
+                         ")");
+        }
+
+        mReloadQuery = lazyQuery("SELECT * FROM `ValueType` WHERE `id`=:id");
+        mReloadFieldTypesQuery = lazyQuery(
             "SELECT * FROM `FieldType_valueTypes` WHERE `valueType`=:valueType ORDER BY `index`");
-        mInsertQuery = createQuery("INSERT INTO `ValueType` (`id`) VALUES (:id)");
-        mUpdateQuery = createQuery("UPDATE `ValueType` SET `id`=:id WHERE `id`=:id");
+        mInsertQuery = lazyQuery("INSERT INTO `ValueType` (`id`) VALUES (:id)");
+        mUpdateQuery = lazyQuery("UPDATE `ValueType` SET `id`=:id WHERE `id`=:id");
     }
 
     emitDatabaseChanged();
@@ -41,9 +43,7 @@ bool ValueTypeStorage::insertNode(Node *node)
     if (!executeQuery(mInsertQuery, QVariantMap{{":id", valueType->rowid()}}))
         return handleError(this, "insertNode", mInsertQuery), false;
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ValueTypeStorage::updateNode(Node *node)
@@ -60,9 +60,7 @@ bool ValueTypeStorage::updateNode(Node *node)
     //     return false;
     // }
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ValueTypeStorage::reloadNode(Node *node)
@@ -77,15 +75,15 @@ bool ValueTypeStorage::reloadNode(Node *node)
     if (!executeQuery(mReloadQuery, {valueType->rowid()}))
         return handleError(this, "reloadNode", mReloadQuery), false;
 
-    if (!mReloadQuery.next())
+    if (!mReloadQuery->next())
         return handleError(this, "reloadNode", "result set is empty"), false;
 
     if (!executeQuery(mReloadFieldTypesQuery, QVariantMap{{":valueType", valueType->rowid()}}))
         return handleError(this, "reloadNode", mReloadFieldTypesQuery), false;
 
     QList<FieldType *> fts;
-    while (mReloadFieldTypesQuery.next()) {
-        const int rowid = mReloadFieldTypesQuery.value("fieldType").toInt();
+    while (mReloadFieldTypesQuery->next()) {
+        const int rowid = mReloadFieldTypesQuery->value("fieldType").toInt();
         if (FieldType *ft = qobject_cast<FieldType *>(
                 storage()->fieldTypeStorage()->fieldType(rowid)))
             fts.append(ft);
@@ -95,9 +93,7 @@ bool ValueTypeStorage::reloadNode(Node *node)
 
     valueType->setFieldTypes(fts);
 
-    tx.commit();
-
-    return true;
+    return tx.commit();
 }
 
 bool ValueTypeStorage::removeNode(int rowid)
@@ -110,7 +106,10 @@ bool ValueTypeStorage::removeNode(int rowid)
     if (!storage()->nodeTypeStorage()->removeNode(rowid))
         return false;
 
-    tx.commit();
+    return tx.commit();
+}
 
-    return true;
+bool ValueTypeStorage::loadTypes()
+{
+    return loadTypeTable("ValueType", Storable::Type_ValueType);
 }
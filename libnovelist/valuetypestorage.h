@@ -33,19 +33,19 @@ public:
         if (name.isEmpty())
             return handleError(this, "removeNode", "name is empty"), nullptr;
 
-        if (mNodesByName.contains(name))
+        if (nodeType(name))
             return handleError(
                        this,
                        "removeNode",
                        QStringLiteral("storage already contains a type with name '%1'").arg(name)),
                    nullptr;
 
-        if (ValueType* valueType = static_cast<ValueType*>(createNode())) {
-            mNodesByName.insert(name, valueType);
+        if (ValueType* valueType = static_cast<ValueType*>(newNode())) {
             valueType->setName(name);
             valueType->setLabel(label);
             valueType->setInfo(info);
             valueType->setIcon(icon);
+            rebuildCatalog();
             return valueType;
         }
 
@@ -61,14 +61,16 @@ protected:
     bool reloadNode(Node* node) override;
     bool removeNode(int rowid) override;
 
+    bool loadTypes();
+
     friend class ValueType;
     friend class Storage;
 
-    QSqlQuery mReloadQuery;
-    QSqlQuery mInsertQuery;
-    QSqlQuery mUpdateQuery;
-    QSqlQuery mReloadFieldTypesQuery;
-    QSqlQuery mInsertFieldTypesQuery;
+    PreparedQuery mReloadQuery;
+    PreparedQuery mInsertQuery;
+    PreparedQuery mUpdateQuery;
+    PreparedQuery mReloadFieldTypesQuery;
+    PreparedQuery mInsertFieldTypesQuery;
 };
 
 #endif // LIBNOVELIST_VALUETYPESTORAGE_H
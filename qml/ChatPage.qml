@@ -12,6 +12,7 @@ Page {
     property alias inputText: inputTextArea.text
     property responsesRequest request
     property ResponsesResponse response
+    property ConversationManager conversation
 
     signal addPressed
     signal speakPressed
@@ -82,6 +83,20 @@ Page {
         }
     }
 
+    footer: Label {
+        visible: page.conversation
+        leftPadding: 32
+        rightPadding: 32
+        bottomPadding: 8
+        horizontalAlignment: Text.AlignRight
+        opacity: .6
+        text: page.conversation ? qsTr("Context: %1 of %2 tokens%3").arg(
+                                      page.conversation.contextTokens).arg(
+                                      page.conversation.tokenBudget).arg(
+                                      page.conversation.summarizing ? qsTr(
+                                                                          ", summarizing...") : "") : ""
+    }
+
     SquareBubble {}
 
     Action {
@@ -23,6 +23,12 @@ ApplicationWindow {
         //                          }
     }
 
+    readonly property ConversationManager conversationManager: ConversationManager {
+        id: conversationManager
+
+        client: aiClient
+    }
+
     StackLayout {
         anchors.fill: parent
         currentIndex: tabBar.currentIndex
@@ -32,10 +38,15 @@ ApplicationWindow {
             Layout.fillWidth: true
             Layout.fillHeight: true
 
+            conversation: conversationManager
+
             onSendPressed: text => {
                                chatPage.chatOutput.addUserMessage(
                                    `<p>${text}</p>`)
-                               response = aiClient.post(request)
+                               conversationManager.addUserMessage(text)
+                               response = aiClient.post(
+                                   conversationManager.prepare(request))
+                               conversationManager.addResponse(response)
                                response.textGenerated.connect(text => {
                                                                   chatPage.chatOutput.addAssistantMessage(
                                                                       `<p>${text}</p>`)
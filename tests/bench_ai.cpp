@@ -0,0 +1,156 @@
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTest>
+
+#include "libai/responsesrequest.h"
+#include "libai/responsesresponseutils.h"
+
+#include <atomic>
+
+class AiBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void requestJson_data();
+    void requestJson();
+    void requestJsonAllocations_data();
+    void requestJsonAllocations();
+    void outputItems();
+};
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+}
+
+namespace {
+
+// the allocations of any thread, read before and after a measurement
+std::atomic<qint64> allocations = 0;
+
+} // namespace
+
+// counted here rather than in operator new, Qt's containers allocate with malloc(); declared
+// noexcept like glibc has them
+extern "C" void *malloc(size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+#endif
+
+namespace {
+
+ai::ResponsesRequest request(int messages)
+{
+    ai::ResponsesRequest request;
+    QList<ai::InputItem> items;
+    for (int i = 0; i < messages; ++i)
+        items.append(
+            ai::InputMessage{QStringLiteral("Message %1, \"quoted\", ünïcödé").arg(i)});
+    request.setInput(ai::Input{items});
+    request.setInstructions(QStringLiteral("Keep the story consistent."));
+    request.setTools({ai::ImageGenerationTool{}});
+    return request;
+}
+
+QByteArray serialize(const ai::ResponsesRequest &request, bool writer)
+{
+    return writer ? request.toUtf8Json(false, 16384)
+                  : QJsonDocument{request.toJson()}.toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
+void AiBenchmark::requestJson_data()
+{
+    QTest::addColumn<bool>("writer");
+
+    QTest::newRow("QJsonDocument") << false;
+    QTest::newRow("writer") << true;
+}
+
+void AiBenchmark::requestJson()
+{
+    QFETCH(bool, writer);
+    const ai::ResponsesRequest r = request(50);
+
+    QByteArray json;
+    QBENCHMARK {
+        json = serialize(r, writer);
+    }
+
+    // both write the same request
+    QCOMPARE(QJsonDocument::fromJson(json).object(), r.toJson());
+}
+
+void AiBenchmark::requestJsonAllocations_data()
+{
+    requestJson_data();
+}
+
+void AiBenchmark::requestJsonAllocations()
+{
+#if defined(__GLIBC__)
+    QFETCH(bool, writer);
+    const ai::ResponsesRequest r = request(50);
+
+    const auto count = [&r](bool writer) {
+        const qint64 before = allocations.load();
+        const QByteArray json = serialize(r, writer);
+        const qint64 after = allocations.load();
+        return json.isEmpty() ? 0 : after - before;
+    };
+
+    // a first run, so that what is allocated once isn't counted
+    count(writer);
+    const qint64 n = count(writer);
+    QTest::setBenchmarkResult(qreal(n), QTest::Events);
+
+    // the writer only grows its one buffer, a tree has a node per value
+    if (writer)
+        QVERIFY2(n < count(false), qPrintable(QString::number(n)));
+#else
+    QSKIP("allocations are counted through glibc");
+#endif
+}
+
+void AiBenchmark::outputItems()
+{
+    // a reply the way the server sends it, read back item by item
+    QList<ai::OutputItem> items;
+    QJsonArray output;
+    for (int i = 0; i < 50; ++i) {
+        items.append(ai::OutputMessage{QStringLiteral("Reply %1, \"quoted\", ünïcödé").arg(i),
+                                       QStringLiteral("msg_%1").arg(i),
+                                       ai::OutputMessage::Role_Assistant});
+        output.append(items.back().toJson());
+    }
+
+    QList<ai::OutputItem> read;
+    QBENCHMARK {
+        read.clear();
+        for (const auto o : output)
+            read.append(ai::OutputItem::fromJson(o.toObject()));
+    }
+
+    QCOMPARE(read, items);
+}
+
+QTEST_GUILESS_MAIN(AiBenchmark)
+#include "bench_ai.moc"
@@ -0,0 +1,168 @@
+#include "testproject.h"
+
+#include <QSignalSpy>
+
+#include "libnovelist/batchvalidator.h"
+
+class StorageBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void valueConversion_data();
+    void valueConversion();
+    void valueReload();
+    void batchValidator();
+    void snapshot();
+    void textCodec();
+
+private:
+    std::unique_ptr<TestProject> test;
+};
+
+void StorageBenchmark::init()
+{
+    test = std::make_unique<TestProject>();
+    QVERIFY(test->isValid());
+}
+
+void StorageBenchmark::cleanup()
+{
+    test.reset();
+}
+
+void StorageBenchmark::valueConversion_data()
+{
+    QTest::addColumn<bool>("mixed");
+
+    // typing: every keystroke sets a string over a string
+    QTest::newRow("typing") << false;
+    // pasting or spin boxes: the type differs from the value it replaces every other time
+    QTest::newRow("mixed") << true;
+}
+
+void StorageBenchmark::valueConversion()
+{
+    QFETCH(bool, mixed);
+
+    const auto input = [mixed](int i) {
+        if (mixed)
+            return i % 2 ? QVariant{i} : QVariant{double(i) / 2};
+        return QVariant{QStringLiteral("Chapter %1").arg(i)};
+    };
+
+    Field *field = (mixed ? test->count : test->name)->createField();
+    Value *value = test->storage()->valueStorage()->createValue();
+    QVERIFY(field->appendValue(value));
+    value->setValue(input(1));
+    const QMetaType type = value->value().metaType();
+
+    int i = 0;
+    QBENCHMARK {
+        value->setValue(input(i++));
+    }
+
+    // every later value is converted to the type of the first one
+    QCOMPARE(value->value().metaType(), type);
+    if (!mixed)
+        QCOMPARE(value->value().toString(), QStringLiteral("Chapter %1").arg(i - 1));
+}
+
+void StorageBenchmark::valueReload()
+{
+    Element *chapter = test->addElement(test->chapterType, "One");
+    QVERIFY(chapter);
+    Value *value = test->storage()->valueStorage()->createValue();
+    value->setValue(42);
+    QVERIFY(chapter->field("Count")->appendValue(value));
+    QVERIFY(chapter->save());
+
+    QBENCHMARK {
+        value->reload();
+    }
+
+    QCOMPARE(value->value().toInt(), 42);
+}
+
+void StorageBenchmark::batchValidator()
+{
+    // a tenth of the values are out of range
+    const int count = 10000;
+    test->count->setValidator({{"type", "IntValidator"}, {"min", 0}, {"max", 1000}});
+    QVERIFY(test->count->save());
+
+    Field *field = test->count->createField();
+    for (int i = 0; i < count; ++i) {
+        Value *value = test->storage()->valueStorage()->createValue();
+        value->setValue(i % 10 ? i % 1000 : -1 - i);
+        QVERIFY(field->appendValue(value));
+    }
+    QVERIFY(field->save());
+
+    BatchValidator validator;
+    validator.setStorage(test->storage());
+    QSignalSpy finished{&validator, &BatchValidator::finished};
+
+    QBENCHMARK {
+        QVERIFY(validator.validateFieldType(test->count));
+        QVERIFY(finished.wait());
+    }
+
+    QCOMPARE(validator.checked(), count);
+    QCOMPARE(validator.invalidCount(), count / 10);
+}
+
+void StorageBenchmark::snapshot()
+{
+    const int count = 1000;
+    for (int i = 0; i < count; ++i)
+        QVERIFY(test->addElement(test->characterType, QStringLiteral("Character %1").arg(i)));
+
+    // the storage is read-only on the snapshot afterwards
+    const QString fileName = test->fileName() + ".snapshot";
+    QVERIFY(test->storage()->writeSnapshot(fileName));
+    QVERIFY(test->storage()->openSnapshot(fileName));
+
+    const Snapshot *snapshot = test->storage()->snapshot();
+    int names = 0;
+    QBENCHMARK {
+        names = 0;
+        for (const int element : snapshot->rowids())
+            for (const int field : snapshot->fields(element))
+                if (snapshot->nameOf(field) == "Name")
+                    for (const int value : snapshot->values(field))
+                        names += snapshot->value(value).startsWith(u"Character ");
+    }
+
+    QCOMPARE(names, count);
+}
+
+void StorageBenchmark::textCodec()
+{
+    // a chapter of prose, saved once and reloaded
+    QString text;
+    for (int i = 0; i < 2000; ++i)
+        text += QStringLiteral("She looked out over the harbour for the %1th time that "
+                               "morning, and the ships were still not there.\n")
+                    .arg(i);
+
+    Value *value = test->storage()->valueStorage()->createValue();
+    value->setValueType(Value::Type_Text);
+    value->setValue(text);
+    QVERIFY(value->save(false));
+
+    qsizetype characters = 0;
+    QBENCHMARK {
+        value->reload();
+        characters = value->value().toString().size();
+    }
+
+    QCOMPARE(characters, text.size());
+    QCOMPARE(value->value().toString(), text);
+}
+
+QTEST_GUILESS_MAIN(StorageBenchmark)
+#include "bench_storage.moc"
@@ -0,0 +1,117 @@
+#ifndef TESTS_TESTPROJECT_H
+#define TESTS_TESTPROJECT_H
+
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+#include "libnovelist/project.h"
+#include "libnovelist/storage.h"
+
+// A project database in a temporary directory with a small set of types:
+//  - Chapter: Name (String), Body (Text), Count (Int) and Characters (node values)
+//  - Character: Name
+//  - Project: Chapters and Characters (node values)
+class TestProject
+{
+public:
+    TestProject()
+    {
+        mStorage = std::make_unique<Storage>();
+        if (!mDir.isValid() || !mStorage->openDatabase(fileName()))
+            return;
+
+        FieldTypeStorage *fieldTypes = mStorage->fieldTypeStorage();
+        ValueTypeStorage *valueTypes = mStorage->valueTypeStorage();
+        ElementTypeStorage *elementTypes = mStorage->elementTypeStorage();
+
+        ValueType *string = valueTypes->createValueType("String", "String");
+        ValueType *text = valueTypes->createValueType("Text", "Text");
+        ValueType *integer = valueTypes->createValueType("Int", "Int");
+        ValueType *chapter = valueTypes->createValueType("Chapter", "Chapter");
+        ValueType *character = valueTypes->createValueType("Character", "Character");
+
+        name = fieldTypes->createFieldType("Name", "Name");
+        name->setAllowedTypes({Value::Type_String});
+        name->appendValueType(string);
+        body = fieldTypes->createFieldType("Body", "Body");
+        body->setAllowedTypes({Value::Type_Text, Value::Type_String});
+        body->appendValueType(text);
+        count = fieldTypes->createFieldType("Count", "Count");
+        count->setAllowedTypes({Value::Type_Int});
+        count->appendValueType(integer);
+        chapters = fieldTypes->createFieldType("Chapters", "Chapters");
+        chapters->setAllowedTypes({Value::Type_Node});
+        chapters->appendValueType(chapter);
+        characters = fieldTypes->createFieldType("Characters", "Characters");
+        characters->setAllowedTypes({Value::Type_Node});
+        characters->appendValueType(character);
+
+        chapterType = elementTypes->createElementType("Chapter", "Chapter");
+        for (FieldType *fieldType : {name, body, count, characters})
+            chapterType->appendFieldType(fieldType);
+        characterType = elementTypes->createElementType("Character", "Character");
+        characterType->appendFieldType(name);
+
+        ProjectType *projectType = mStorage->projectTypeStorage()->createProjectType("Project",
+                                                                                   "Project");
+        projectType->appendFieldType(chapters);
+        projectType->appendFieldType(characters);
+
+        chapterType->save();
+        characterType->save();
+        projectType->save();
+
+        project = mStorage->projectStorage()->createProject(projectType);
+        if (project)
+            project->save();
+    }
+
+    [[nodiscard]] bool isValid() const { return project && project->rowid() > 0; }
+    [[nodiscard]] Storage *storage() const { return mStorage.get(); }
+    [[nodiscard]] QString fileName() const { return mDir.filePath("project.sqlite"); }
+
+    // A saved element of elementType.
+    Element *addElement(ElementType *elementType, const QString &elementName = {})
+    {
+        Element *element = project->addElement(elementType);
+        if (!element)
+            return nullptr;
+        if (!elementName.isEmpty())
+            element->field("Name")->appendValue("String", elementName);
+        element->save();
+        return element;
+    }
+
+    // Appends a node value that holds element to field.
+    static bool link(Field *field, const QString &valueType, Element *element)
+    {
+        return field && field->appendValue(valueType, QVariant::fromValue(element));
+    }
+
+    // The first column of the first row of sql, -1 if it fails.
+    [[nodiscard]] qint64 scalar(const QString &sql) const
+    {
+        QSqlQuery query{mStorage->database()};
+        if (!query.exec(sql) || !query.next())
+            return -1;
+        return query.value(0).toLongLong();
+    }
+
+    FieldType *name = nullptr;
+    FieldType *body = nullptr;
+    FieldType *count = nullptr;
+    FieldType *chapters = nullptr;
+    FieldType *characters = nullptr;
+    ElementType *chapterType = nullptr;
+    ElementType *characterType = nullptr;
+    Project *project = nullptr;
+
+private:
+    QTemporaryDir mDir;
+    std::unique_ptr<Storage> mStorage;
+};
+
+#endif // TESTS_TESTPROJECT_H
@@ -0,0 +1,56 @@
+#include "testproject.h"
+
+#include <QBuffer>
+
+class ProjectStreamTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void failedImportRollsBack();
+
+private:
+    std::unique_ptr<TestProject> test;
+};
+
+void ProjectStreamTest::init()
+{
+    test = std::make_unique<TestProject>();
+    QVERIFY(test->isValid());
+}
+
+void ProjectStreamTest::cleanup()
+{
+    test.reset();
+}
+
+void ProjectStreamTest::failedImportRollsBack()
+{
+    Element *chapter = test->addElement(test->chapterType, "One");
+    QVERIFY(chapter);
+
+    QBuffer exported;
+    QVERIFY(exported.open(QIODevice::WriteOnly));
+    QVERIFY(ProjectStream{test->storage()}.write(&exported).ok);
+
+    chapter->field("Name")->values().front()->setValue("Two");
+    QCOMPARE(test->scalar("SELECT COUNT(*) FROM `Value` WHERE `value`='Two'"), 1);
+
+    // every row but the broken last line is read, and none of them is kept
+    QByteArray data = exported.data() + "[1,2\n";
+    QBuffer broken{&data};
+    QVERIFY(broken.open(QIODevice::ReadOnly));
+    const ProjectStream::Result result = ProjectStream{test->storage()}.read(&broken);
+    QVERIFY(!result.ok);
+    QVERIFY(result.rows > 0);
+
+    QCOMPARE(test->scalar("SELECT COUNT(*) FROM `Value` WHERE `value`='Two'"), 1);
+    QCOMPARE(test->scalar("SELECT COUNT(*) FROM `Value` WHERE `value`='One'"), 0);
+    QCOMPARE(chapter->field("Name")->values().front()->value().toString(), QStringLiteral("Two"));
+}
+
+QTEST_GUILESS_MAIN(ProjectStreamTest)
+#include "tst_projectstream.moc"
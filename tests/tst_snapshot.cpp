@@ -0,0 +1,57 @@
+#include "testproject.h"
+
+class SnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readsThroughSnapshot();
+    void refusesWrites();
+};
+
+void SnapshotTest::readsThroughSnapshot()
+{
+    TestProject test;
+    QVERIFY(test.isValid());
+    Element *chapter = test.addElement(test.chapterType, "One");
+    QVERIFY(chapter);
+    const int chapterId = chapter->rowid();
+
+    const QString fileName = test.fileName() + ".snapshot";
+    QVERIFY(test.storage()->writeSnapshot(fileName));
+    QVERIFY(test.storage()->openSnapshot(fileName));
+    QVERIFY(test.storage()->isReadOnly());
+
+    // the element's Name field holds one value, read from the mapping
+    const Snapshot *snapshot = test.storage()->snapshot();
+    QVERIFY(snapshot->contains(chapterId));
+    QCOMPARE(snapshot->type(chapterId), int(Storable::Type_Element));
+    QString name;
+    for (const int field : snapshot->childrenOf(chapterId))
+        if (snapshot->nameOf(field) == "Name")
+            for (const int value : snapshot->childrenOf(field))
+                name = snapshot->valueOf(value);
+    QCOMPARE(name, QStringLiteral("One"));
+}
+
+void SnapshotTest::refusesWrites()
+{
+    TestProject test;
+    QVERIFY(test.isValid());
+    Element *chapter = test.addElement(test.chapterType, "One");
+    QVERIFY(chapter);
+
+    const QString fileName = test.fileName() + ".snapshot";
+    QVERIFY(test.storage()->writeSnapshot(fileName));
+    QVERIFY(test.storage()->openSnapshot(fileName));
+
+    QCOMPARE(test.storage()->elementStorage()->createElement(test.chapterType), nullptr);
+    QVERIFY(!test.storage()->elementStorage()->removeSubtree(chapter->rowid()));
+    QVERIFY(test.storage()->elementStorage()->createElements(test.chapterType, 2).isEmpty());
+
+    chapter->setModified(true);
+    QVERIFY(!chapter->save());
+}
+
+QTEST_GUILESS_MAIN(SnapshotTest)
+#include "tst_snapshot.moc"
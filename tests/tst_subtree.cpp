@@ -0,0 +1,113 @@
+#include "testproject.h"
+
+class SubtreeTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void removeKeepsSharedElements();
+    void removeDropsReferences();
+    void cloneReferencesSharedElements();
+};
+
+void SubtreeTest::removeKeepsSharedElements()
+{
+    TestProject test;
+    QVERIFY(test.isValid());
+
+    Element *chapter = test.addElement(test.chapterType, "One");
+    Element *shared = test.addElement(test.characterType, "Ann");
+    Element *owned = test.addElement(test.characterType, "Bob");
+    QVERIFY(chapter && shared && owned);
+
+    // Ann is listed by the project as well, Bob only by the chapter
+    QVERIFY(TestProject::link(test.project->field("Chapters"), "Chapter", chapter));
+    QVERIFY(TestProject::link(test.project->field("Characters"), "Character", shared));
+    QVERIFY(TestProject::link(chapter->field("Characters"), "Character", shared));
+    QVERIFY(TestProject::link(chapter->field("Characters"), "Character", owned));
+    QVERIFY(test.project->save());
+    QVERIFY(chapter->save());
+
+    const int chapterId = chapter->rowid();
+    const int sharedId = shared->rowid();
+    const int ownedId = owned->rowid();
+    QVERIFY(test.storage()->removeSubtree(chapterId));
+
+    const auto exists = [&](int id) {
+        return test.scalar(QStringLiteral("SELECT COUNT(*) FROM `Storable` WHERE `id`=%1").arg(id));
+    };
+    QCOMPARE(exists(chapterId), 0);
+    QCOMPARE(exists(ownedId), 0);
+    QCOMPARE(exists(sharedId), 1);
+
+    // the shared element keeps its own fields and the project's link to it
+    QCOMPARE(test.scalar(QStringLiteral("SELECT COUNT(*) FROM `Element_fields` WHERE `element`=%1")
+                             .arg(sharedId)),
+             1);
+    QCOMPARE(test.scalar(QStringLiteral("SELECT COUNT(*) FROM `Value` WHERE `valueType`=%1 AND "
+                                        "`value`='%2'")
+                             .arg(Value::Type_Node)
+                             .arg(sharedId)),
+             1);
+}
+
+void SubtreeTest::removeDropsReferences()
+{
+    TestProject test;
+    QVERIFY(test.isValid());
+
+    Element *chapter = test.addElement(test.chapterType, "One");
+    QVERIFY(chapter);
+    Field *chapters = test.project->field("Chapters");
+    QVERIFY(TestProject::link(chapters, "Chapter", chapter));
+    QVERIFY(test.project->save());
+
+    const int chapterId = chapter->rowid();
+    QVERIFY(test.storage()->removeSubtree(chapterId));
+
+    // neither a row nor the loaded field holds the removed chapter's id
+    QCOMPARE(test.scalar(QStringLiteral("SELECT COUNT(*) FROM `Value` WHERE `valueType`=%1 AND "
+                                        "`value`='%2'")
+                             .arg(Value::Type_Node)
+                             .arg(chapterId)),
+             0);
+    QCOMPARE(test.scalar(QStringLiteral("SELECT COUNT(*) FROM `Field_values` WHERE `field`=%1")
+                             .arg(chapters->rowid())),
+             0);
+    QCOMPARE(chapters->values().size(), 0);
+}
+
+void SubtreeTest::cloneReferencesSharedElements()
+{
+    TestProject test;
+    QVERIFY(test.isValid());
+
+    Element *chapter = test.addElement(test.chapterType, "One");
+    Element *shared = test.addElement(test.characterType, "Ann");
+    QVERIFY(chapter && shared);
+    QVERIFY(TestProject::link(test.project->field("Characters"), "Character", shared));
+    QVERIFY(TestProject::link(chapter->field("Characters"), "Character", shared));
+    QVERIFY(test.project->save());
+    QVERIFY(chapter->save());
+
+    const int clone = test.storage()->cloneSubtree(chapter->rowid());
+    QVERIFY(clone > 0);
+
+    // one Ann, referred to by the chapter and by its copy
+    QCOMPARE(test.scalar(QStringLiteral("SELECT COUNT(*) FROM `Node` n JOIN `Storable` s ON "
+                                        "s.`id`=n.`id` WHERE s.`type`=%1 AND n.`nodeType`=%2")
+                             .arg(Storable::Type_Element)
+                             .arg(test.characterType->rowid())),
+             1);
+    QCOMPARE(test.scalar(QStringLiteral("SELECT COUNT(*) FROM `Element_fields` ef JOIN "
+                                        "`Field_values` fv ON fv.`field`=ef.`field` JOIN `Value` v "
+                                        "ON v.`id`=fv.`value` WHERE ef.`element`=%1 AND "
+                                        "v.`valueType`=%2 AND v.`value`='%3'")
+                             .arg(clone)
+                             .arg(Value::Type_Node)
+                             .arg(shared->rowid())),
+             1);
+}
+
+QTEST_GUILESS_MAIN(SubtreeTest)
+#include "tst_subtree.moc"
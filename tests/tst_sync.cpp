@@ -0,0 +1,97 @@
+#include "testproject.h"
+
+#include <QFile>
+
+class SyncTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void echoWritesNothing();
+    void clashKeepsLocalRows();
+
+private:
+    std::unique_ptr<TestProject> test;
+    std::unique_ptr<Storage> replica;
+    QTemporaryDir dir;
+    qint64 since = 0;
+};
+
+namespace {
+
+qint64 scalar(Storage *storage, const QString &sql)
+{
+    QSqlQuery query{storage->database()};
+    if (!query.exec(sql) || !query.next())
+        return -1;
+    return query.value(0).toLongLong();
+}
+
+} // namespace
+
+void SyncTest::init()
+{
+    test = std::make_unique<TestProject>();
+    QVERIFY(test->isValid());
+    since = test->storage()->changeVersion();
+
+    // the replica starts as a copy of the file
+    const QString copy = dir.filePath("replica.sqlite");
+    QFile::remove(copy);
+    QVERIFY(QFile::copy(test->fileName(), copy));
+    replica = std::make_unique<Storage>();
+    replica->setDatabaseConnectionName("replica");
+    QVERIFY(replica->openDatabase(copy));
+}
+
+void SyncTest::cleanup()
+{
+    replica.reset();
+    test.reset();
+}
+
+void SyncTest::echoWritesNothing()
+{
+    QVERIFY(test->addElement(test->characterType, "Ann"));
+    QVERIFY(replica->applyChanges(test->storage()->exportChanges(since)));
+    QCOMPARE(scalar(replica.get(), "SELECT COUNT(*) FROM `Value` WHERE `value`='Ann'"), 1);
+
+    // the rows come back at the versions they have, none of them is written again
+    const qint64 version = test->storage()->changeVersion();
+    QVERIFY(test->storage()->applyChanges(replica->exportChanges(since)));
+    QCOMPARE(test->storage()->changeVersion(), version);
+}
+
+void SyncTest::clashKeepsLocalRows()
+{
+    Element *ann = test->addElement(test->characterType, "Ann");
+    QVERIFY(ann);
+
+    // the same next id on the replica, a moment later
+    QTest::qSleep(5);
+    Project *project = replica->projectStorage()->project(test->project->rowid());
+    ElementType *character = replica->elementTypeStorage()->elementType(
+        test->characterType->rowid());
+    QVERIFY(project && character);
+    Element *bob = project->addElement(character);
+    QVERIFY(bob);
+    QVERIFY(bob->field("Name")->appendValue("String", "Bob"));
+    QVERIFY(bob->save());
+    QCOMPARE(bob->rowid(), ann->rowid());
+
+    QVERIFY(replica->applyChanges(test->storage()->exportChanges(since)));
+
+    // Bob and all of his rows stay, none of Ann's take their place
+    QCOMPARE(scalar(replica.get(), "SELECT COUNT(*) FROM `Value` WHERE `value`='Bob'"), 1);
+    QCOMPARE(scalar(replica.get(), "SELECT COUNT(*) FROM `Value` WHERE `value`='Ann'"), 0);
+    QCOMPARE(scalar(replica.get(),
+                    QStringLiteral("SELECT COUNT(*) FROM `Element_fields` WHERE `element`=%1")
+                        .arg(bob->rowid())),
+             1);
+}
+
+QTEST_GUILESS_MAIN(SyncTest)
+#include "tst_sync.moc"
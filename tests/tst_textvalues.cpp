@@ -0,0 +1,183 @@
+#include "testproject.h"
+
+#include <QSignalSpy>
+
+#include "libnovelist/batchvalidator.h"
+#include "libnovelist/elementquery.h"
+#include "libnovelist/elementquerymodel.h"
+
+class TextValuesTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void queryMatchesChunkedText();
+    void queryFollowsRangedEdits();
+    void valueColumnKeepsStart();
+    void numbersSkipText();
+    void modelRunsChangedQuery();
+    void validatorChecksChunkedText();
+
+private:
+    // A chapter whose Body is a Type_Text value holding text.
+    Element *addChapter(const QString &name, const QString &text);
+
+    std::unique_ptr<TestProject> test;
+    Element *longChapter = nullptr;
+    Element *shortChapter = nullptr;
+};
+
+namespace {
+
+// Long enough for several chunks, each of them packed, with the word to find in the last.
+QString prose(const QString &last)
+{
+    QString text;
+    for (int i = 0; i < 200; ++i)
+        text += QStringLiteral("She looked out over the harbour for the %1th time that morning, "
+                               "and the ships were still not there.\n")
+                    .arg(i);
+    return text + last;
+}
+
+} // namespace
+
+void TextValuesTest::init()
+{
+    test = std::make_unique<TestProject>();
+    QVERIFY(test->isValid());
+
+    longChapter = addChapter("Long", prose("Then the lighthouse went dark."));
+    shortChapter = addChapter("Short", "A harbour");
+    QVERIFY(longChapter && shortChapter);
+
+    // the long text is in packed chunks, not in one plain one
+    QVERIFY(test->scalar("SELECT COUNT(*) FROM `ValueChunk` WHERE `packed` IS NOT NULL") > 1);
+}
+
+void TextValuesTest::cleanup()
+{
+    test.reset();
+}
+
+Element *TextValuesTest::addChapter(const QString &name, const QString &text)
+{
+    Element *chapter = test->addElement(test->chapterType, name);
+    if (!chapter)
+        return nullptr;
+
+    Value *value = test->storage()->valueStorage()->createValue(
+        test->storage()->valueTypeStorage()->valueType("Text"));
+    value->setValueType(Value::Type_Text);
+    value->setValue(text);
+    if (!chapter->field("Body")->appendValue(value) || !chapter->save())
+        return nullptr;
+    return chapter;
+}
+
+void TextValuesTest::queryMatchesChunkedText()
+{
+    ElementQuery contains;
+    contains.ofType(test->chapterType).where("Body", ElementQuery::Contains, "lighthouse");
+    QCOMPARE(test->storage()->findElements(contains), QList<int>{longChapter->rowid()});
+
+    ElementQuery equals;
+    equals.ofType(test->chapterType).where("Body", ElementQuery::Equals, "A harbour");
+    QCOMPARE(test->storage()->findElements(equals), QList<int>{shortChapter->rowid()});
+
+    // "A harbour" sorts before "She looked ..."
+    ElementQuery ordered;
+    ordered.ofType(test->chapterType).orderBy("Body");
+    QCOMPARE(test->storage()->findElements(ordered),
+             (QList<int>{shortChapter->rowid(), longChapter->rowid()}));
+}
+
+void TextValuesTest::queryFollowsRangedEdits()
+{
+    Value *value = longChapter->field("Body")->values().front();
+    const int at = value->textLength() - int(QStringLiteral("dark.").size());
+    QVERIFY(value->replaceText(at, 4, "bright"));
+
+    ElementQuery bright;
+    bright.ofType(test->chapterType).where("Body", ElementQuery::Contains, "went bright.");
+    QCOMPARE(test->storage()->findElements(bright), QList<int>{longChapter->rowid()});
+
+    ElementQuery dark;
+    dark.ofType(test->chapterType).where("Body", ElementQuery::Contains, "went dark");
+    QCOMPARE(test->storage()->countElements(dark), 0);
+}
+
+void TextValuesTest::valueColumnKeepsStart()
+{
+    // the whole text is only in the chunks
+    QCOMPARE(test->scalar(QStringLiteral("SELECT MAX(length(`value`)) FROM `Value` WHERE "
+                                         "`valueType`=%1")
+                              .arg(Value::Type_Text)),
+             Value::TextPrefix);
+
+    Value *value = longChapter->field("Body")->values().front();
+    QVERIFY(value->replaceText(0, 3, "He"));
+    QCOMPARE(test->scalar(QStringLiteral("SELECT `value` LIKE 'He looked%' FROM `Value` WHERE "
+                                         "`id`=%1")
+                              .arg(value->rowid())),
+             1);
+
+    // yet the whole of it is matched
+    ElementQuery equals;
+    equals.ofType(test->chapterType).where("Body", ElementQuery::Equals, value->value());
+    QCOMPARE(test->storage()->findElements(equals), QList<int>{longChapter->rowid()});
+}
+
+void TextValuesTest::numbersSkipText()
+{
+    // text does not compare as 0
+    ElementQuery less;
+    less.ofType(test->chapterType).where("Body", ElementQuery::Less, 5);
+    QCOMPARE(test->storage()->countElements(less), 0);
+
+    Value *count = test->storage()->valueStorage()->createValue();
+    count->setValue(3);
+    QVERIFY(shortChapter->field("Count")->appendValue(count));
+    QVERIFY(shortChapter->save());
+
+    ElementQuery counted;
+    counted.ofType(test->chapterType).where("Count", ElementQuery::Less, 5);
+    QCOMPARE(test->storage()->findElements(counted), QList<int>{shortChapter->rowid()});
+}
+
+void TextValuesTest::modelRunsChangedQuery()
+{
+    ElementQueryModel model;
+    model.setStorage(test->storage());
+    model.setElementType(test->chapterType);
+    QCOMPARE(model.count(), 2);
+
+    model.where("Body", ElementQueryModel::Contains, "lighthouse");
+    QTRY_COMPARE(model.count(), 1);
+    QCOMPARE(model.element(0)->rowid(), longChapter->rowid());
+
+    model.clear();
+    QTRY_COMPARE(model.count(), 2);
+}
+
+void TextValuesTest::validatorChecksChunkedText()
+{
+    test->body->setValidator({{"type", "StringValidator"}, {"minLength", 300}});
+
+    BatchValidator validator;
+    validator.setStorage(test->storage());
+    QSignalSpy finished{&validator, &BatchValidator::finished};
+    QVERIFY(validator.validateProject());
+    QTRY_COMPARE(finished.count(), 1);
+
+    // only the short body is too short, the long one is read whole
+    QCOMPARE(validator.checked(), 2);
+    QCOMPARE(validator.invalidValues(),
+             QList<int>{shortChapter->field("Body")->values().front()->rowid()});
+}
+
+QTEST_GUILESS_MAIN(TextValuesTest)
+#include "tst_textvalues.moc"